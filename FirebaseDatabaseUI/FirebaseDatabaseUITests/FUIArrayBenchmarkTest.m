@@ -0,0 +1,555 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import <mach/mach.h>
+#import <malloc/malloc.h>
+
+#import "FUIDatabaseTestUtils.h"
+
+// Benchmarks for FUIArray, FUISortedArray and FUIIndexArray. They're skipped unless
+// the FUI_RUN_BENCHMARKS environment variable is set, since they take minutes and
+// their timings only mean something on a quiet machine. When running through
+// xcodebuild, prefix each variable with TEST_RUNNER_ to pass it to the test process.
+//
+//   FUI_RUN_BENCHMARKS        Set to 1 to run the benchmarks.
+//   FUI_BENCHMARK_SIZES       Comma separated collection sizes. Defaults to 1000,10000.
+//                             Larger sizes (up to 1000000) work, but are slow on the
+//                             current linear-time key lookups.
+//   FUI_BENCHMARK_ITERATIONS  Runs per workload; the median is attached to the test
+//                             result. Defaults to 3.
+//   FUI_BENCHMARK_BASELINE    Path of a JSON file with results to compare against.
+//   FUI_BENCHMARK_TOLERANCE   Allowed growth over the baseline of the time per event,
+//                             peak footprint and retained memory. Defaults to 0.25.
+//   FUI_BENCHMARK_RECORD      Set to 1 to write the results to the baseline file
+//                             instead of comparing against it.
+//   FUI_BENCHMARK_REPORT      Path to write a JSON report of every result to.
+//
+// Each workload is a script of database events generated up front from a fixed seed,
+// so that only the collection's work is timed and every run sees the same events.
+
+typedef NS_ENUM(NSInteger, FUIBenchmarkWorkload) {
+  // Every child is added in order, as when a query is first observed.
+  FUIBenchmarkWorkloadInitialLoad,
+  // Children are appended to a loaded collection, as in a chat.
+  FUIBenchmarkWorkloadAppend,
+  // Children are alternately inserted at and removed from random positions.
+  FUIBenchmarkWorkloadRandomInsertRemove,
+  // Children are moved between random positions.
+  FUIBenchmarkWorkloadMoveStorm,
+  // Random children change value.
+  FUIBenchmarkWorkloadChangeStorm,
+};
+
+typedef NS_ENUM(NSInteger, FUIBenchmarkCollection) {
+  FUIBenchmarkCollectionArray,
+  FUIBenchmarkCollectionSortedArray,
+  FUIBenchmarkCollectionIndexArray,
+};
+
+static NSString *FUIBenchmarkWorkloadName(FUIBenchmarkWorkload workload) {
+  switch (workload) {
+    case FUIBenchmarkWorkloadInitialLoad: return @"initialLoad";
+    case FUIBenchmarkWorkloadAppend: return @"append";
+    case FUIBenchmarkWorkloadRandomInsertRemove: return @"randomInsertRemove";
+    case FUIBenchmarkWorkloadMoveStorm: return @"moveStorm";
+    case FUIBenchmarkWorkloadChangeStorm: return @"changeStorm";
+  }
+}
+
+static NSString *FUIBenchmarkCollectionName(FUIBenchmarkCollection collection) {
+  switch (collection) {
+    case FUIBenchmarkCollectionArray: return @"FUIArray";
+    case FUIBenchmarkCollectionSortedArray: return @"FUISortedArray";
+    case FUIBenchmarkCollectionIndexArray: return @"FUIIndexArray";
+  }
+}
+
+static NSString *FUIBenchmarkEnvironment(NSString *name) {
+  NSString *value = NSProcessInfo.processInfo.environment[name];
+  return value.length > 0 ? value : nil;
+}
+
+// xorshift64*, so that scripts are identical across runs and platforms.
+static uint64_t FUIBenchmarkRandom(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static NSUInteger FUIBenchmarkRandomIndex(uint64_t *state, NSUInteger bound) {
+  return bound == 0 ? 0 : (NSUInteger)(FUIBenchmarkRandom(state) % bound);
+}
+
+static uint64_t FUIBenchmarkFootprint(void) {
+  task_vm_info_data_t info;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  kern_return_t result = task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count);
+  return result == KERN_SUCCESS ? info.phys_footprint : 0;
+}
+
+static malloc_statistics_t FUIBenchmarkMallocStatistics(void) {
+  malloc_statistics_t statistics;
+  malloc_zone_statistics(NULL, &statistics);
+  return statistics;
+}
+
+@interface FUIBenchmarkEvent : NSObject
+@property (nonatomic, assign) FIRDataEventType type;
+@property (nonatomic, strong) FUIFakeSnapshot *snapshot;
+@property (nonatomic, copy, nullable) NSString *previousKey;
+@end
+
+@implementation FUIBenchmarkEvent
+@end
+
+@interface FUIBenchmarkScript : NSObject
+// Brings the collection to its starting size. Not timed.
+@property (nonatomic, strong) NSMutableArray<FUIBenchmarkEvent *> *setupEvents;
+// The events being measured.
+@property (nonatomic, strong) NSMutableArray<FUIBenchmarkEvent *> *measuredEvents;
+// The latest value of every child the script mentions, for FUIIndexArray's data node.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *data;
+@end
+
+@implementation FUIBenchmarkScript
+@end
+
+@interface FUIBenchmarkResult : NSObject
+@property (nonatomic, assign) NSUInteger eventCount;
+@property (nonatomic, assign) double nanosecondsPerEvent;
+// Growth of the process' physical footprint over the measured events, sampled
+// periodically while they're sent.
+@property (nonatomic, assign) int64_t peakFootprintGrowth;
+// Heap bytes and blocks still in use once the measured events have been sent.
+@property (nonatomic, assign) int64_t retainedBytes;
+@property (nonatomic, assign) int64_t retainedAllocations;
+@end
+
+@implementation FUIBenchmarkResult
+
+- (NSDictionary<NSString *, NSNumber *> *)dictionaryRepresentation {
+  return @{
+    @"events": @(self.eventCount),
+    @"nsPerEvent": @(self.nanosecondsPerEvent),
+    @"peakFootprintGrowthBytes": @(self.peakFootprintGrowth),
+    @"retainedBytes": @(self.retainedBytes),
+    @"retainedAllocations": @(self.retainedAllocations),
+  };
+}
+
+@end
+
+// How many events are sent between samples of the physical footprint.
+static const NSUInteger FUIBenchmarkFootprintSampleInterval = 1024;
+
+// Footprint is measured in pages, so small growths are noise.
+static const int64_t FUIBenchmarkFootprintSlack = 1024 * 1024;
+
+// Heap statistics include allocations made by the runtime and XCTest while the events
+// are sent, so small growths in retained memory are noise too.
+static const int64_t FUIBenchmarkRetainedBytesSlack = 64 * 1024;
+static const int64_t FUIBenchmarkRetainedAllocationsSlack = 256;
+
+// Results from every test in the class, written out once they've all run.
+static NSMutableDictionary<NSString *, NSDictionary *> *FUIBenchmarkResults;
+
+@interface FUIArrayBenchmarkTest : XCTestCase
+@end
+
+@implementation FUIArrayBenchmarkTest
+
++ (void)setUp {
+  [super setUp];
+  FUIBenchmarkResults = [NSMutableDictionary dictionary];
+}
+
++ (void)tearDown {
+  if (FUIBenchmarkResults.count > 0) {
+    NSString *baselinePath = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_BASELINE");
+    if (baselinePath != nil && FUIBenchmarkEnvironment(@"FUI_BENCHMARK_RECORD") != nil) {
+      // Merge, so that recording a subset of sizes keeps the rest of the baseline.
+      NSMutableDictionary *baseline = [[self baselineAtPath:baselinePath] mutableCopy];
+      [baseline addEntriesFromDictionary:FUIBenchmarkResults];
+      [self writeJSONObject:baseline toPath:baselinePath];
+    }
+    NSString *reportPath = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_REPORT");
+    if (reportPath != nil) {
+      NSDictionary *report = @{
+        @"os": NSProcessInfo.processInfo.operatingSystemVersionString,
+        @"processorCount": @(NSProcessInfo.processInfo.activeProcessorCount),
+        @"results": FUIBenchmarkResults,
+      };
+      [self writeJSONObject:report toPath:reportPath];
+    }
+  }
+  FUIBenchmarkResults = nil;
+  [super tearDown];
+}
+
++ (NSDictionary<NSString *, NSDictionary *> *)baselineAtPath:(NSString *)path {
+  NSData *data = [NSData dataWithContentsOfFile:path];
+  if (data == nil) { return @{}; }
+  id baseline = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+  return [baseline isKindOfClass:[NSDictionary class]] ? baseline : @{};
+}
+
++ (void)writeJSONObject:(id)object toPath:(NSString *)path {
+  NSData *data = [NSJSONSerialization dataWithJSONObject:object
+                                                 options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                   error:NULL];
+  [data writeToFile:path atomically:YES];
+}
+
+- (BOOL)setUpWithError:(NSError *__autoreleasing *)error {
+  XCTSkipUnless(FUIBenchmarkEnvironment(@"FUI_RUN_BENCHMARKS") != nil,
+                @"Set FUI_RUN_BENCHMARKS=1 to run benchmarks");
+  return YES;
+}
+
+#pragma mark - FUIArray
+
+- (void)testArrayInitialLoad {
+  [self runWorkload:FUIBenchmarkWorkloadInitialLoad collection:FUIBenchmarkCollectionArray];
+}
+
+- (void)testArrayAppend {
+  [self runWorkload:FUIBenchmarkWorkloadAppend collection:FUIBenchmarkCollectionArray];
+}
+
+- (void)testArrayRandomInsertRemove {
+  [self runWorkload:FUIBenchmarkWorkloadRandomInsertRemove collection:FUIBenchmarkCollectionArray];
+}
+
+- (void)testArrayMoveStorm {
+  [self runWorkload:FUIBenchmarkWorkloadMoveStorm collection:FUIBenchmarkCollectionArray];
+}
+
+- (void)testArrayChangeStorm {
+  [self runWorkload:FUIBenchmarkWorkloadChangeStorm collection:FUIBenchmarkCollectionArray];
+}
+
+#pragma mark - FUISortedArray
+
+- (void)testSortedArrayInitialLoad {
+  [self runWorkload:FUIBenchmarkWorkloadInitialLoad collection:FUIBenchmarkCollectionSortedArray];
+}
+
+- (void)testSortedArrayAppend {
+  [self runWorkload:FUIBenchmarkWorkloadAppend collection:FUIBenchmarkCollectionSortedArray];
+}
+
+- (void)testSortedArrayRandomInsertRemove {
+  [self runWorkload:FUIBenchmarkWorkloadRandomInsertRemove
+         collection:FUIBenchmarkCollectionSortedArray];
+}
+
+- (void)testSortedArrayMoveStorm {
+  [self runWorkload:FUIBenchmarkWorkloadMoveStorm collection:FUIBenchmarkCollectionSortedArray];
+}
+
+- (void)testSortedArrayChangeStorm {
+  [self runWorkload:FUIBenchmarkWorkloadChangeStorm collection:FUIBenchmarkCollectionSortedArray];
+}
+
+#pragma mark - FUIIndexArray
+
+- (void)testIndexArrayInitialLoad {
+  [self runWorkload:FUIBenchmarkWorkloadInitialLoad collection:FUIBenchmarkCollectionIndexArray];
+}
+
+- (void)testIndexArrayAppend {
+  [self runWorkload:FUIBenchmarkWorkloadAppend collection:FUIBenchmarkCollectionIndexArray];
+}
+
+- (void)testIndexArrayRandomInsertRemove {
+  [self runWorkload:FUIBenchmarkWorkloadRandomInsertRemove
+         collection:FUIBenchmarkCollectionIndexArray];
+}
+
+- (void)testIndexArrayMoveStorm {
+  [self runWorkload:FUIBenchmarkWorkloadMoveStorm collection:FUIBenchmarkCollectionIndexArray];
+}
+
+- (void)testIndexArrayChangeStorm {
+  [self runWorkload:FUIBenchmarkWorkloadChangeStorm collection:FUIBenchmarkCollectionIndexArray];
+}
+
+#pragma mark - Running
+
+- (NSArray<NSNumber *> *)sizes {
+  NSString *sizes = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_SIZES") ?: @"1000,10000";
+  NSMutableArray<NSNumber *> *result = [NSMutableArray array];
+  for (NSString *size in [sizes componentsSeparatedByString:@","]) {
+    NSInteger value = [size stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet].integerValue;
+    if (value > 0) {
+      [result addObject:@(value)];
+    }
+  }
+  return result;
+}
+
+- (NSUInteger)iterations {
+  NSInteger iterations = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_ITERATIONS").integerValue;
+  return iterations > 0 ? (NSUInteger)iterations : 3;
+}
+
+- (void)runWorkload:(FUIBenchmarkWorkload)workload collection:(FUIBenchmarkCollection)collection {
+  NSString *baselinePath = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_BASELINE");
+  BOOL recording = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_RECORD") != nil;
+  NSDictionary<NSString *, NSDictionary *> *baseline =
+      (baselinePath != nil && !recording) ? [[self class] baselineAtPath:baselinePath] : @{};
+
+  for (NSNumber *size in [self sizes]) {
+    NSString *name = [NSString stringWithFormat:@"%@/%@/%@",
+                      FUIBenchmarkCollectionName(collection), FUIBenchmarkWorkloadName(workload), size];
+    FUIBenchmarkScript *script = [self scriptForWorkload:workload size:size.unsignedIntegerValue];
+
+    NSMutableArray<FUIBenchmarkResult *> *results = [NSMutableArray array];
+    for (NSUInteger i = 0; i < [self iterations]; i++) {
+      [results addObject:[self runScript:script collection:collection]];
+    }
+    [results sortUsingComparator:^NSComparisonResult(FUIBenchmarkResult *left, FUIBenchmarkResult *right) {
+      return [@(left.nanosecondsPerEvent) compare:@(right.nanosecondsPerEvent)];
+    }];
+    FUIBenchmarkResult *median = results[results.count / 2];
+    FUIBenchmarkResults[name] = [median dictionaryRepresentation];
+    // Attached to the test's result, where it's kept with the run, unlike console output.
+    NSString *summary =
+        [NSString stringWithFormat:@"%.0f ns/event over %lu events, peak footprint +%lld bytes, "
+                                   @"%lld bytes in %lld allocations retained",
+                                   median.nanosecondsPerEvent, (unsigned long)median.eventCount,
+                                   median.peakFootprintGrowth, median.retainedBytes,
+                                   median.retainedAllocations];
+    [XCTContext runActivityNamed:name block:^(id<XCTActivity> activity) {
+      XCTAttachment *attachment = [XCTAttachment attachmentWithString:summary];
+      attachment.name = name;
+      attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+      [activity addAttachment:attachment];
+    }];
+
+    NSDictionary *expected = baseline[name];
+    if (expected != nil) {
+      [self checkResult:median againstBaseline:expected name:name];
+    }
+  }
+}
+
+- (void)checkResult:(FUIBenchmarkResult *)result
+    againstBaseline:(NSDictionary *)baseline
+               name:(NSString *)name {
+  NSString *toleranceString = FUIBenchmarkEnvironment(@"FUI_BENCHMARK_TOLERANCE");
+  double tolerance = toleranceString != nil ? toleranceString.doubleValue : 0.25;
+
+  double expectedTime = [baseline[@"nsPerEvent"] doubleValue];
+  if (expectedTime > 0) {
+    XCTAssertLessThanOrEqual(result.nanosecondsPerEvent, expectedTime * (1 + tolerance),
+                             @"%@ regressed from %.0f to %.0f ns/event",
+                             name, expectedTime, result.nanosecondsPerEvent);
+  }
+
+  int64_t expectedFootprint = [baseline[@"peakFootprintGrowthBytes"] longLongValue];
+  XCTAssertLessThanOrEqual(result.peakFootprintGrowth,
+                           (int64_t)(expectedFootprint * (1 + tolerance)) + FUIBenchmarkFootprintSlack,
+                           @"%@ peak footprint growth regressed from %lld to %lld bytes",
+                           name, expectedFootprint, result.peakFootprintGrowth);
+
+  // Retained memory is compared with the same tolerance, plus slack for allocations
+  // the runtime and test harness make on their own.
+  if (baseline[@"retainedBytes"] != nil) {
+    int64_t expectedBytes = [baseline[@"retainedBytes"] longLongValue];
+    XCTAssertLessThanOrEqual(result.retainedBytes,
+                             (int64_t)(MAX(expectedBytes, 0) * (1 + tolerance)) + FUIBenchmarkRetainedBytesSlack,
+                             @"%@ retained memory regressed from %lld to %lld bytes",
+                             name, expectedBytes, result.retainedBytes);
+  }
+  if (baseline[@"retainedAllocations"] != nil) {
+    int64_t expectedAllocations = [baseline[@"retainedAllocations"] longLongValue];
+    XCTAssertLessThanOrEqual(result.retainedAllocations,
+                             (int64_t)(MAX(expectedAllocations, 0) * (1 + tolerance)) +
+                                 FUIBenchmarkRetainedAllocationsSlack,
+                             @"%@ retained allocations regressed from %lld to %lld",
+                             name, expectedAllocations, result.retainedAllocations);
+  }
+}
+
+- (FUIBenchmarkResult *)runScript:(FUIBenchmarkScript *)script
+                       collection:(FUIBenchmarkCollection)kind {
+  FUIBenchmarkResult *result = [[FUIBenchmarkResult alloc] init];
+  result.eventCount = script.measuredEvents.count;
+
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUITestObservable *data = [[FUITestObservable alloc] initWithDictionary:script.data];
+  // Delegates are attached so each event pays for delegate dispatch, as it would
+  // with a data source, but they don't do any work.
+  FUIArrayTestDelegate *arrayDelegate = [[FUIArrayTestDelegate alloc] init];
+  FUIIndexArrayTestDelegate *indexDelegate = [[FUIIndexArrayTestDelegate alloc] init];
+
+  id collection;
+  switch (kind) {
+    case FUIBenchmarkCollectionArray:
+      collection = [[FUIArray alloc] initWithQuery:observable delegate:arrayDelegate];
+      break;
+    case FUIBenchmarkCollectionSortedArray:
+      collection = [[FUISortedArray alloc] initWithQuery:observable
+                                                delegate:arrayDelegate
+                                          sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                             FIRDataSnapshot *right) {
+        return [(NSString *)left.value compare:(NSString *)right.value];
+      }];
+      break;
+    case FUIBenchmarkCollectionIndexArray:
+      collection = [[FUIIndexArray alloc] initWithIndex:observable data:data delegate:indexDelegate];
+      break;
+  }
+  [collection observeQuery];
+
+  @autoreleasepool {
+    [self sendEvents:script.setupEvents toObservable:observable footprintPeak:NULL];
+  }
+
+  malloc_statistics_t before = FUIBenchmarkMallocStatistics();
+  uint64_t footprintBefore = FUIBenchmarkFootprint();
+  uint64_t footprintPeak = footprintBefore;
+
+  uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+  @autoreleasepool {
+    [self sendEvents:script.measuredEvents toObservable:observable footprintPeak:&footprintPeak];
+  }
+  uint64_t end = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+
+  malloc_statistics_t after = FUIBenchmarkMallocStatistics();
+  footprintPeak = MAX(footprintPeak, FUIBenchmarkFootprint());
+
+  result.nanosecondsPerEvent = result.eventCount > 0 ? (double)(end - start) / result.eventCount : 0;
+  result.peakFootprintGrowth = (int64_t)footprintPeak - (int64_t)footprintBefore;
+  result.retainedBytes = (int64_t)after.size_in_use - (int64_t)before.size_in_use;
+  result.retainedAllocations = (int64_t)after.blocks_in_use - (int64_t)before.blocks_in_use;
+
+  [collection invalidate];
+  [observable removeAllObservers];
+  return result;
+}
+
+- (void)sendEvents:(NSArray<FUIBenchmarkEvent *> *)events
+      toObservable:(FUITestObservable *)observable
+     footprintPeak:(uint64_t *)footprintPeak {
+  NSUInteger sent = 0;
+  for (FUIBenchmarkEvent *event in events) {
+    [observable sendEvent:event.type
+               withObject:event.snapshot
+              previousKey:event.previousKey
+                    error:nil];
+    sent++;
+    if (footprintPeak != NULL && sent % FUIBenchmarkFootprintSampleInterval == 0) {
+      *footprintPeak = MAX(*footprintPeak, FUIBenchmarkFootprint());
+    }
+  }
+}
+
+#pragma mark - Scripts
+
+- (FUIBenchmarkScript *)scriptForWorkload:(FUIBenchmarkWorkload)workload size:(NSUInteger)size {
+  FUIBenchmarkScript *script = [[FUIBenchmarkScript alloc] init];
+  script.setupEvents = [NSMutableArray array];
+  script.measuredEvents = [NSMutableArray array];
+  script.data = [NSMutableDictionary dictionary];
+
+  // Tracks the order of the children as the events are generated, so that each
+  // event carries the previous key the database would send.
+  NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:size];
+  __block NSUInteger nextKey = 0;
+  __block uint64_t seed = 0x9E3779B97F4A7C15ULL ^ size ^ ((uint64_t)workload << 32);
+
+  FUIBenchmarkEvent *(^event)(FIRDataEventType, NSString *, NSUInteger) =
+      ^FUIBenchmarkEvent *(FIRDataEventType type, NSString *key, NSUInteger index) {
+    NSString *value = [NSString stringWithFormat:@"value-%010llu", FUIBenchmarkRandom(&seed) % 10000000000ULL];
+    script.data[key] = @{ @"value": value };
+    FUIBenchmarkEvent *scripted = [[FUIBenchmarkEvent alloc] init];
+    scripted.type = type;
+    scripted.snapshot = [FUIFakeSnapshot snapWithKey:key value:value];
+    scripted.previousKey = index > 0 ? keys[index - 1] : nil;
+    return scripted;
+  };
+  FUIBenchmarkEvent *(^append)(void) = ^FUIBenchmarkEvent *{
+    NSString *key = [NSString stringWithFormat:@"key-%010lu", (unsigned long)nextKey++];
+    FUIBenchmarkEvent *added = event(FIRDataEventTypeChildAdded, key, keys.count);
+    [keys addObject:key];
+    return added;
+  };
+
+  if (workload == FUIBenchmarkWorkloadInitialLoad) {
+    for (NSUInteger i = 0; i < size; i++) {
+      [script.measuredEvents addObject:append()];
+    }
+    return script;
+  }
+
+  for (NSUInteger i = 0; i < size; i++) {
+    [script.setupEvents addObject:append()];
+  }
+
+  // Mutations are a tenth of the collection's size, within limits that keep small
+  // sizes meaningful and large ones from taking hours.
+  NSUInteger operations = MIN(MAX(size / 10, 100), 10000);
+  for (NSUInteger i = 0; i < operations; i++) {
+    switch (workload) {
+      case FUIBenchmarkWorkloadInitialLoad:
+        break;
+      case FUIBenchmarkWorkloadAppend:
+        [script.measuredEvents addObject:append()];
+        break;
+      case FUIBenchmarkWorkloadRandomInsertRemove: {
+        if (i % 2 == 0 && keys.count > 0) {
+          NSUInteger index = FUIBenchmarkRandomIndex(&seed, keys.count);
+          NSString *key = keys[index];
+          [script.measuredEvents addObject:event(FIRDataEventTypeChildRemoved, key, index)];
+          [keys removeObjectAtIndex:index];
+        } else {
+          NSUInteger index = FUIBenchmarkRandomIndex(&seed, keys.count + 1);
+          NSString *key = [NSString stringWithFormat:@"key-%010lu", (unsigned long)nextKey++];
+          [script.measuredEvents addObject:event(FIRDataEventTypeChildAdded, key, index)];
+          [keys insertObject:key atIndex:index];
+        }
+        break;
+      }
+      case FUIBenchmarkWorkloadMoveStorm: {
+        NSUInteger from = FUIBenchmarkRandomIndex(&seed, keys.count);
+        NSUInteger to = FUIBenchmarkRandomIndex(&seed, keys.count);
+        NSString *key = keys[from];
+        [keys removeObjectAtIndex:from];
+        [keys insertObject:key atIndex:to];
+        [script.measuredEvents addObject:event(FIRDataEventTypeChildMoved, key, to)];
+        break;
+      }
+      case FUIBenchmarkWorkloadChangeStorm: {
+        NSUInteger index = FUIBenchmarkRandomIndex(&seed, keys.count);
+        [script.measuredEvents addObject:event(FIRDataEventTypeChildChanged, keys[index], index)];
+        break;
+      }
+    }
+  }
+  return script;
+}
+
+@end
@@ -0,0 +1,260 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+// Sends child events like FUITestObservable, and answers the single-value fetches that
+// reload evicted rows from a FUICountingObservable holding the same values.
+@interface FUIPayloadTestObservable : FUITestObservable
+@property (nonatomic, strong) FUICountingObservable *store;
+@end
+
+@implementation FUIPayloadTestObservable
+
+- (id<FUIDataObservable>)child:(NSString *)path {
+  return [self.store child:path];
+}
+
+@end
+
+@interface FUIArrayPayloadBudgetTest : XCTestCase
+@property (nonatomic) FUIPayloadTestObservable *observable;
+@property (nonatomic) FUIArrayTestDelegate *arrayDelegate;
+@property (nonatomic) FUIArray *array;
+@property (nonatomic) NSMutableDictionary<NSString *, NSString *> *values;
+@end
+
+@implementation FUIArrayPayloadBudgetTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUIPayloadTestObservable alloc] initWithDictionary:@{}];
+  self.observable.store = [[FUICountingObservable alloc] initWithDictionary:@{}];
+  self.arrayDelegate = [[FUIArrayTestDelegate alloc] init];
+  self.array = [[FUIArray alloc] initWithQuery:self.observable delegate:self.arrayDelegate];
+  self.values = [NSMutableDictionary dictionary];
+}
+
+- (void)tearDown {
+  [self.array invalidate];
+  [super tearDown];
+}
+
+// Returns a value of about a kilobyte for the given key, and stores it so that the
+// key can be reloaded.
+- (NSString *)valueForKey:(NSString *)key {
+  NSString *value = [key stringByPaddingToLength:1024 withString:@"." startingAtIndex:0];
+  self.values[key] = value;
+  [self.observable.store setValue:value forChildKey:key];
+  return value;
+}
+
+// Adds `count` rows holding about a kilobyte each and ends the batch.
+- (void)populateWithCount:(NSUInteger)count {
+  [self.array observeQuery];
+  [self.observable populateWithCount:count generator:^NSString *(NSUInteger index) {
+    return [self valueForKey:@(index).stringValue];
+  }];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+// Sums the estimated costs of the resident rows from scratch.
+- (NSUInteger)expectedResidentBytes {
+  NSUInteger bytes = 0;
+  for (NSUInteger i = 0; i < self.array.count; i++) {
+    if (![self.array isPayloadResidentAtIndex:i]) { continue; }
+    NSString *key = @(i).stringValue;
+    bytes += self.array.payloadCostEstimator(key, self.values[key]);
+  }
+  return bytes;
+}
+
+// Checks that items and the current version hold only snapshots received from the
+// query, and only those of resident rows.
+- (void)assertPublishedRowsAreResident {
+  NSArray *items = self.array.items;
+  NSArray *published = self.array.currentVersion.items;
+  XCTAssertEqual(items.count, self.array.residentPayloadCount);
+  XCTAssertEqual(published.count, self.array.residentPayloadCount);
+  for (id snapshot in [items arrayByAddingObjectsFromArray:published]) {
+    XCTAssert([snapshot isKindOfClass:[FUIFakeSnapshot class]]);
+    XCTAssertEqualObjects([snapshot value], self.values[[snapshot key]]);
+  }
+}
+
+- (void)testScrollingStaysWithinBudget {
+  NSUInteger budget = 64 * 1024;
+  self.array.payloadBudget = budget;
+  self.array.payloadWindow = 10;
+  self.arrayDelegate.didChangeObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    XCTAssert([object isKindOfClass:[FUIFakeSnapshot class]]);
+  };
+  [self populateWithCount:1000];
+
+  XCTAssertEqual(self.array.count, 1000);
+  XCTAssertLessThan(self.array.residentPayloadCount, 1000);
+  XCTAssertLessThanOrEqual(self.array.residentPayloadBytes, budget);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+  [self assertPublishedRowsAreResident];
+
+  // Scroll down and back up. Evicted rows are reloaded as they're reached.
+  NSMutableArray<NSNumber *> *path = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 1000; i++) { [path addObject:@(i)]; }
+  for (NSUInteger i = 1000; i > 0; i--) { [path addObject:@(i - 1)]; }
+  for (NSNumber *number in path) {
+    NSUInteger index = number.unsignedIntegerValue;
+    XCTAssertEqualObjects([self.array valueAtIndex:index], self.values[@(index).stringValue]);
+    XCTAssert([self.array isPayloadResidentAtIndex:index]);
+    XCTAssertLessThanOrEqual(self.array.residentPayloadBytes, budget);
+  }
+  XCTAssertGreaterThan(self.array.residentPayloadCount, 20);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+  [self assertPublishedRowsAreResident];
+}
+
+- (void)testEvictedPayloadIsReleased {
+  self.array.payloadBudget = 4 * 1024;
+  self.array.payloadWindow = 1;
+  [self.array observeQuery];
+
+  __weak FUIFakeSnapshot *weakSnapshot = nil;
+  @autoreleasepool {
+    [self.observable populateWithCount:10 generator:^NSString *(NSUInteger index) {
+      return [self valueForKey:@(index).stringValue];
+    }];
+    FUIFakeSnapshot *snapshot = [FUIFakeSnapshot snapWithKey:@"10"
+                                                       value:[self valueForKey:@"10"]];
+    weakSnapshot = snapshot;
+    [self.observable sendEvent:FIRDataEventTypeChildAdded
+                    withObject:snapshot
+                   previousKey:@"9"
+                         error:nil];
+    [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+  }
+
+  // The last row is the farthest from the first, so it's evicted first.
+  XCTAssertEqual(self.array.count, 11);
+  XCTAssertFalse([self.array isPayloadResidentAtIndex:10]);
+  XCTAssertNil(weakSnapshot);
+  XCTAssertEqual([self.array indexForKey:@"10"], 10);
+  [self assertPublishedRowsAreResident];
+
+  // Reading the row reloads it and sends the reloaded snapshot as a change.
+  __block id changedObject = nil;
+  __block NSUInteger changedIndex = NSNotFound;
+  self.arrayDelegate.didChangeObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    changedObject = object;
+    changedIndex = index;
+  };
+  XCTAssertEqualObjects([self.array valueAtIndex:10], self.values[@"10"]);
+  XCTAssert([self.array isPayloadResidentAtIndex:10]);
+  XCTAssert([changedObject isKindOfClass:[FUIFakeSnapshot class]]);
+  XCTAssertEqualObjects([changedObject value], self.values[@"10"]);
+  XCTAssertEqual(changedIndex, 10);
+  XCTAssertLessThanOrEqual(self.array.residentPayloadBytes, 4 * 1024);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+  [self assertPublishedRowsAreResident];
+}
+
+- (void)testChangeReplacesEvictedRow {
+  self.array.payloadBudget = 8 * 1024;
+  self.array.payloadWindow = 2;
+  [self populateWithCount:20];
+  XCTAssertFalse([self.array isPayloadResidentAtIndex:19]);
+
+  // The changed row is resident again, and then evicted again at the end of the batch.
+  __block id changedObject = nil;
+  self.arrayDelegate.didChangeObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    changedObject = object;
+  };
+  [self.observable sendEvent:FIRDataEventTypeChildChanged
+                  withObject:[FUIFakeSnapshot snapWithKey:@"19" value:[self valueForKey:@"19"]]
+                 previousKey:@"18"
+                       error:nil];
+  XCTAssert([self.array isPayloadResidentAtIndex:19]);
+  XCTAssert([changedObject isKindOfClass:[FUIFakeSnapshot class]]);
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+  XCTAssertFalse([self.array isPayloadResidentAtIndex:19]);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+  [self assertPublishedRowsAreResident];
+}
+
+- (void)testRemovingEvictedRowsKeepsCounts {
+  self.array.payloadBudget = 8 * 1024;
+  self.array.payloadWindow = 2;
+  [self populateWithCount:20];
+  NSUInteger residentCount = self.array.residentPayloadCount;
+  NSUInteger residentBytes = self.array.residentPayloadBytes;
+  XCTAssertFalse([self.array isPayloadResidentAtIndex:15]);
+
+  [self.observable sendEvent:FIRDataEventTypeChildRemoved
+                  withObject:[FUIFakeSnapshot snapWithKey:@"15" value:self.values[@"15"]]
+                 previousKey:@"14"
+                       error:nil];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  XCTAssertEqual(self.array.count, 19);
+  XCTAssertEqual(self.array.residentPayloadCount, residentCount);
+  XCTAssertEqual(self.array.residentPayloadBytes, residentBytes);
+  XCTAssertEqualObjects([self.array valueAtIndex:15], self.values[@"16"]);
+}
+
+- (void)testZeroBudgetReloadsEvictedRows {
+  self.array.payloadBudget = 8 * 1024;
+  [self populateWithCount:200];
+  XCTAssertLessThan(self.array.residentPayloadCount, 200);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+
+  self.array.payloadBudget = 0;
+  XCTAssertEqual(self.array.residentPayloadCount, 200);
+  XCTAssertEqual(self.array.residentPayloadBytes, 0);
+  XCTAssertEqual(self.array.items.count, 200);
+  XCTAssertEqual(self.array.currentVersion.count, 200);
+}
+
+- (void)testShrinkingBudgetEvictsRightAway {
+  [self populateWithCount:100];
+  XCTAssertEqual(self.array.residentPayloadCount, 100);
+
+  self.array.payloadWindow = 5;
+  self.array.payloadBudget = 16 * 1024;
+  XCTAssertLessThanOrEqual(self.array.residentPayloadBytes, 16 * 1024);
+  XCTAssertEqual(self.array.residentPayloadBytes, [self expectedResidentBytes]);
+  XCTAssert([self.array isPayloadResidentAtIndex:0]);
+  [self assertPublishedRowsAreResident];
+}
+
+- (void)testSortedArrayRejectsBudget {
+  FUISortedArray *sorted =
+      [[FUISortedArray alloc] initWithQuery:self.observable
+                                   delegate:self.arrayDelegate
+                             sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                FIRDataSnapshot *right) {
+    return [left.key compare:right.key];
+  }];
+  XCTAssertThrowsSpecificNamed(sorted.payloadBudget = 1024, NSException,
+                               NSInvalidArgumentException);
+  XCTAssertNoThrow(sorted.payloadBudget = 0);
+}
+
+@end
@@ -23,6 +23,21 @@
 
 #import "FUIDatabaseTestUtils.h"
 
+// Only implements one of FUICollectionDelegate's optional methods.
+@interface FUIArrayAddOnlyTestDelegate : NSObject <FUICollectionDelegate>
+@property (nonatomic, assign) NSInteger addCount;
+@end
+
+@implementation FUIArrayAddOnlyTestDelegate
+- (void)array:(id<FUICollection>)array didAddObject:(id)object atIndex:(NSUInteger)index {
+  self.addCount++;
+}
+@end
+
+@interface FUIArray (Testing)
+- (void)sendDueThrottledChanges;
+@end
+
 @interface FUIArrayTest : XCTestCase
 
 @property (nonatomic, nullable) FUIArrayTestDelegate *arrayDelegate;
@@ -476,6 +491,323 @@
   XCTAssert(ended == 1, @"expected array to end updates exactly once");
 }
 
+#pragma mark - Multiple delegates
+
+- (void)testAdditionalDelegatesReceiveEventsAfterPrimaryDelegate {
+  NSMutableArray<NSString *> *calls = [NSMutableArray array];
+  FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+  self.arrayDelegate.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [calls addObject:@"primary"];
+  };
+  additional.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [calls addObject:@"additional"];
+  };
+  [self.firebaseArray addDelegate:additional];
+
+  [self.observable addObject:@"value" forKey:@"key"];
+
+  NSArray *expected = @[@"primary", @"additional"];
+  XCTAssertEqualObjects(calls, expected,
+                        @"expected every delegate to be called once, primary delegate first");
+}
+
+- (void)testAddingDelegateTwiceDeliversEventsOnce {
+  __block NSInteger adds = 0;
+  FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+  additional.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    adds++;
+  };
+  [self.firebaseArray addDelegate:additional];
+  [self.firebaseArray addDelegate:additional];
+
+  [self.observable addObject:@"value" forKey:@"key"];
+
+  XCTAssertEqual(adds, 1, @"expected duplicate registration to have no effect");
+}
+
+- (void)testRemovedDelegateStopsReceivingEvents {
+  __block NSInteger adds = 0;
+  FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+  additional.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    adds++;
+  };
+  [self.firebaseArray addDelegate:additional];
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.firebaseArray removeDelegate:additional];
+  [self.observable addObject:@"b" forKey:@"1"];
+
+  XCTAssertEqual(adds, 1, @"expected removed delegate to stop receiving events");
+  XCTAssertEqual(self.firebaseArray.delegate, self.arrayDelegate,
+                 @"expected removing an additional delegate to keep the primary delegate");
+}
+
+- (void)testPartialDelegateOnlyReceivesImplementedEvents {
+  FUIArrayAddOnlyTestDelegate *additional = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  [self.firebaseArray addDelegate:additional];
+
+  // Sends begin, add, change, move, remove and end events. Any event sent to
+  // a method the delegate doesn't implement would raise.
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable addObject:@"b" forKey:@"1"];
+  [self.observable changeObject:@"c" forKey:@"0"];
+  [self.observable moveObjectFromIndex:0 toIndex:1];
+  [self.observable removeObjectForKey:@"1"];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  XCTAssertEqual(additional.addCount, 2, @"expected delegate to receive its implemented events");
+}
+
+- (void)testDelegateAddedDuringEventReceivesLaterEvents {
+  __block NSInteger adds = 0;
+  FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+  additional.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    adds++;
+  };
+  FUIArray *firebaseArray = self.firebaseArray;
+  self.arrayDelegate.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [firebaseArray addDelegate:additional];
+  };
+
+  [self.observable addObject:@"a" forKey:@"0"];
+  XCTAssertEqual(adds, 0, @"expected delegate added during an event to miss that event");
+
+  [self.observable addObject:@"b" forKey:@"1"];
+  XCTAssertEqual(adds, 1, @"expected delegate added during an event to receive the next one");
+}
+
+- (void)testAdditionalDelegatesAreHeldWeakly {
+  __weak FUIArrayTestDelegate *weakDelegate;
+  @autoreleasepool {
+    FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+    weakDelegate = additional;
+    [self.firebaseArray addDelegate:additional];
+  }
+
+  XCTAssertNil(weakDelegate, @"expected array to not retain its additional delegates");
+  [self.observable addObject:@"a" forKey:@"0"];
+  XCTAssertEqual(self.firebaseArray.count, 1);
+}
+
+- (void)testClearingPrimaryDelegateKeepsAdditionalDelegates {
+  FUIArrayAddOnlyTestDelegate *primary = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  FUIArrayAddOnlyTestDelegate *additional = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  self.firebaseArray.delegate = primary;
+  [self.firebaseArray addDelegate:additional];
+
+  self.firebaseArray.delegate = nil;
+  [self.observable addObject:@"a" forKey:@"0"];
+
+  XCTAssertNil(self.firebaseArray.delegate);
+  XCTAssertEqual(primary.addCount, 0, @"expected cleared primary delegate to stop receiving events");
+  XCTAssertEqual(additional.addCount, 1, @"expected additional delegate to keep receiving events");
+}
+
+- (void)testSettingFirstPrimaryDelegateKeepsAdditionalDelegates {
+  self.firebaseArray.delegate = nil;
+  FUIArrayAddOnlyTestDelegate *first = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  FUIArrayAddOnlyTestDelegate *second = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  [self.firebaseArray addDelegate:first];
+  [self.firebaseArray addDelegate:second];
+
+  FUIArrayAddOnlyTestDelegate *primary = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  self.firebaseArray.delegate = primary;
+  [self.observable addObject:@"a" forKey:@"0"];
+
+  XCTAssertEqual(primary.addCount, 1);
+  XCTAssertEqual(first.addCount, 1, @"expected first additional delegate to be kept");
+  XCTAssertEqual(second.addCount, 1, @"expected second additional delegate to be kept");
+}
+
+- (void)testReplacingPrimaryDelegateKeepsAdditionalDelegates {
+  NSMutableArray<NSString *> *calls = [NSMutableArray array];
+  FUIArrayTestDelegate *additional = [[FUIArrayTestDelegate alloc] init];
+  additional.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [calls addObject:@"additional"];
+  };
+  self.arrayDelegate.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [calls addObject:@"old"];
+  };
+  [self.firebaseArray addDelegate:additional];
+
+  FUIArrayTestDelegate *replacement = [[FUIArrayTestDelegate alloc] init];
+  replacement.didAddObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [calls addObject:@"new"];
+  };
+  self.firebaseArray.delegate = replacement;
+  [self.observable addObject:@"a" forKey:@"0"];
+
+  NSArray *expected = @[@"new", @"additional"];
+  XCTAssertEqualObjects(calls, expected,
+                        @"expected only the new primary delegate and additional delegates to be called");
+}
+
+- (void)testSortedArraySendsEventsToAdditionalDelegates {
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUISortedArray *array =
+      [[FUISortedArray alloc] initWithQuery:observable
+                                   delegate:self.arrayDelegate
+                             sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                FIRDataSnapshot *right) {
+    return [left.key compare:right.key];
+  }];
+  FUIArrayAddOnlyTestDelegate *additional = [[FUIArrayAddOnlyTestDelegate alloc] init];
+  [array addDelegate:additional];
+  [array observeQuery];
+
+  [observable addObject:@"a" forKey:@"0"];
+  [observable addObject:@"b" forKey:@"1"];
+  [observable addObject:@"c" forKey:@"2"];
+  [observable changeObject:@"changed" forKey:@"1"];
+
+  // The change is sent as a removal followed by an insertion.
+  XCTAssertEqual(additional.addCount, 4, @"expected sorted array to notify additional delegates");
+  [observable removeAllObservers];
+}
+
+#pragma mark - Change throttling
+
+- (void)testThrottledChangesAreCoalesced {
+  __block NSTimeInterval now = 100;
+  self.firebaseArray.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  self.firebaseArray.changeThrottleInterval = 1;
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  __block NSInteger changes = 0;
+  __block id lastChange = nil;
+  self.arrayDelegate.didChangeObject = ^(FUIArray *array, id object, NSUInteger index) {
+    changes++;
+    lastChange = object;
+  };
+  __block NSInteger batches = 0;
+  self.arrayDelegate.didEndUpdates = ^{
+    batches++;
+  };
+
+  [self.observable changeObject:@"b" forKey:@"0"];
+  [self.observable changeObject:@"c" forKey:@"0"];
+  [self.observable changeObject:@"d" forKey:@"0"];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  XCTAssertEqual(changes, 1, @"expected only the first change in the window to be sent");
+  XCTAssertEqualObjects([lastChange value], @"b");
+  XCTAssertEqualObjects([self.firebaseArray snapshotAtIndex:0].value, @"d",
+                        @"expected the array's contents to never be held back");
+
+  now = 100.5;
+  [self.firebaseArray sendDueThrottledChanges];
+  XCTAssertEqual(changes, 1, @"expected held back change to wait for the window to pass");
+
+  now = 101;
+  [self.firebaseArray sendDueThrottledChanges];
+  XCTAssertEqual(changes, 2, @"expected held back changes to be sent as one event");
+  XCTAssertEqualObjects([lastChange value], @"d", @"expected the latest snapshot to be sent");
+  XCTAssertEqual(batches, 2, @"expected the held back change to be sent in its own batch");
+
+  now = 103;
+  [self.observable changeObject:@"e" forKey:@"0"];
+  XCTAssertEqual(changes, 3, @"expected a change after a quiet window to be sent right away");
+}
+
+- (void)testThrottlingIsPerKey {
+  __block NSTimeInterval now = 0;
+  self.firebaseArray.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  self.firebaseArray.changeThrottleInterval = 1;
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable addObject:@"b" forKey:@"1"];
+
+  NSMutableArray<NSNumber *> *changedIndexes = [NSMutableArray array];
+  self.arrayDelegate.didChangeObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [changedIndexes addObject:@(index)];
+  };
+  [self.observable changeObject:@"a1" forKey:@"0"];
+  [self.observable changeObject:@"b1" forKey:@"1"];
+  [self.observable changeObject:@"a2" forKey:@"0"];
+
+  XCTAssertEqualObjects(changedIndexes, (@[@0, @1]),
+                        @"expected each key's first change to be sent immediately");
+}
+
+- (void)testEarlierDeadlineReplacesPendingTimer {
+  __block NSTimeInterval now = 0;
+  self.firebaseArray.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  self.firebaseArray.changeThrottleInterval = 10;
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable addObject:@"b" forKey:@"1"];
+  [self.observable changeObject:@"b1" forKey:@"1"];
+
+  // Key 0's held back change is due at 15, which schedules a timer 10 seconds out.
+  now = 5;
+  [self.observable changeObject:@"a1" forKey:@"0"];
+  [self.observable changeObject:@"a2" forKey:@"0"];
+
+  NSMutableArray<NSNumber *> *changedIndexes = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"trailing change"];
+  self.arrayDelegate.didChangeObject = ^(FUIArray *array, id object, NSUInteger index) {
+    [changedIndexes addObject:@(index)];
+    [expectation fulfill];
+  };
+
+  // Key 1's is due at 10, in 50 milliseconds of the array's clock, and mustn't wait
+  // for key 0's timer.
+  now = 9.95;
+  [self.observable changeObject:@"b2" forKey:@"1"];
+  now = 10;
+
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+  XCTAssertEqualObjects(changedIndexes, @[@1], @"expected only key 1's change to be due");
+}
+
+- (void)testRemovalDropsThrottledChange {
+  __block NSTimeInterval now = 0;
+  self.firebaseArray.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  self.firebaseArray.changeThrottleInterval = 1;
+  [self.observable addObject:@"a" forKey:@"0"];
+
+  __block NSInteger changes = 0;
+  self.arrayDelegate.didChangeObject = ^(FUIArray *array, id object, NSUInteger index) {
+    changes++;
+  };
+  [self.observable changeObject:@"b" forKey:@"0"];
+  [self.observable changeObject:@"c" forKey:@"0"];
+  [self.observable removeObjectForKey:@"0"];
+
+  now = 2;
+  [self.firebaseArray flushThrottledChanges];
+  XCTAssertEqual(changes, 1, @"expected removal to drop the held back change");
+}
+
+- (void)testFlushSendsHeldBackChangesImmediately {
+  __block NSTimeInterval now = 0;
+  self.firebaseArray.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  self.firebaseArray.changeThrottleInterval = 10;
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable addObject:@"b" forKey:@"1"];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  [self.observable changeObject:@"a1" forKey:@"0"];
+  [self.observable changeObject:@"a2" forKey:@"0"];
+  [self.observable moveObjectFromIndex:0 toIndex:1];
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  __block NSUInteger changedIndex = NSNotFound;
+  self.arrayDelegate.didChangeObject = ^(FUIArray *array, id object, NSUInteger index) {
+    changedIndex = index;
+  };
+  [self.firebaseArray flushThrottledChanges];
+  XCTAssertEqual(changedIndex, 1, @"expected flushed change to use the row's current index");
+}
+
 - (void)testRemovesAllElementsWhenInvalidated {
   [self.observable populateWithCount:10];
   [self.firebaseArray invalidate];
@@ -0,0 +1,181 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUICollectionMetricsTestSink : NSObject <FUICollectionMetricsSink>
+@property (nonatomic, readonly) NSMutableArray<FUICollectionBatchMetrics *> *batches;
+@property (nonatomic, weak) id lastCollection;
+@end
+
+@implementation FUICollectionMetricsTestSink
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _batches = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)collection:(id)collection didFinishBatchWithMetrics:(FUICollectionBatchMetrics *)metrics {
+  self.lastCollection = collection;
+  [self.batches addObject:metrics];
+}
+
+@end
+
+@interface FUICollectionMetricsTest : XCTestCase
+@property (nonatomic) FUITestObservable *observable;
+@property (nonatomic) FUIArrayTestDelegate *arrayDelegate;
+@property (nonatomic) FUICollectionMetricsTestSink *sink;
+@end
+
+@implementation FUICollectionMetricsTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUITestObservable alloc] init];
+  self.arrayDelegate = [[FUIArrayTestDelegate alloc] init];
+  self.sink = [[FUICollectionMetricsTestSink alloc] init];
+}
+
+- (void)sendValueEvent {
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+- (void)testArrayReportsEachBatch {
+  FUIArray *array = [[FUIArray alloc] initWithQuery:self.observable delegate:self.arrayDelegate];
+  array.metricsSink = self.sink;
+  [array observeQuery];
+
+  [self.observable addObject:@"a" forKey:@"a"];
+  [self.observable addObject:@"b" forKey:@"b"];
+  [self.observable addObject:@"c" forKey:@"c"];
+  [self.observable changeObject:@"B" forKey:@"b"];
+  [self sendValueEvent];
+
+  [self.observable removeObjectForKey:@"a"];
+  [self sendValueEvent];
+
+  XCTAssertEqual(self.sink.batches.count, 2);
+  XCTAssertEqual(self.sink.lastCollection, array);
+
+  FUICollectionBatchMetrics *first = self.sink.batches[0];
+  XCTAssertEqual(first.eventCount, 4);
+  XCTAssertEqual([first eventCountForType:FIRDataEventTypeChildAdded], 3);
+  XCTAssertEqual([first eventCountForType:FIRDataEventTypeChildChanged], 1);
+  XCTAssertEqual([first eventCountForType:FIRDataEventTypeValue], 0);
+  XCTAssertEqual(first.itemCount, 3);
+  XCTAssertEqual(first.diffDuration, 0);
+  XCTAssertGreaterThan(first.startTime, 0);
+  XCTAssertGreaterThanOrEqual(first.duration, first.storageDuration + first.delegateDuration);
+
+  FUICollectionBatchMetrics *second = self.sink.batches[1];
+  XCTAssertEqual([second eventCountForType:FIRDataEventTypeChildRemoved], 1);
+  XCTAssertEqual(second.itemCount, 2);
+  XCTAssertGreaterThanOrEqual(second.startTime, first.startTime + first.duration);
+}
+
+- (void)testSlowCallbacksAreCountedAsDelegateTime {
+  FUIArray *array = [[FUIArray alloc] initWithQuery:self.observable delegate:self.arrayDelegate];
+  array.metricsSink = self.sink;
+  array.slowCallbackThreshold = 0.004;
+  [array observeQuery];
+
+  self.arrayDelegate.didAddObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    if ([[object key] isEqualToString:@"slow"]) {
+      [NSThread sleepForTimeInterval:0.01];
+    }
+  };
+  [self.observable addObject:@"fast" forKey:@"fast"];
+  [self.observable addObject:@"slow" forKey:@"slow"];
+  [self sendValueEvent];
+
+  FUICollectionBatchMetrics *metrics = self.sink.batches.firstObject;
+  XCTAssertEqual(metrics.slowCallbackCount, 1);
+  XCTAssertGreaterThanOrEqual(metrics.longestCallbackDuration, 0.01);
+  XCTAssertGreaterThanOrEqual(metrics.delegateDuration, 0.01);
+  XCTAssertLessThan(metrics.storageDuration, metrics.delegateDuration,
+                    @"expected time in the delegate not to count as storage time");
+}
+
+- (void)testNothingIsReportedWithoutSink {
+  FUIArray *array = [[FUIArray alloc] initWithQuery:self.observable delegate:self.arrayDelegate];
+  array.metricsSink = self.sink;
+  [array observeQuery];
+  array.metricsSink = nil;
+
+  [self.observable addObject:@"a" forKey:@"a"];
+  [self sendValueEvent];
+
+  XCTAssertNil(array.metricsSink);
+  XCTAssertEqual(self.sink.batches.count, 0);
+}
+
+- (void)testSortedArrayReportsChangesThatReorder {
+  FUISortedArray *array =
+      [[FUISortedArray alloc] initWithQuery:self.observable
+                                   delegate:self.arrayDelegate
+                             sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                FIRDataSnapshot *right) {
+    return [left.value compare:right.value];
+  }];
+  array.metricsSink = self.sink;
+  [array observeQuery];
+
+  [self.observable addObject:@"1" forKey:@"a"];
+  [self.observable addObject:@"2" forKey:@"b"];
+  [self.observable changeObject:@"3" forKey:@"a"];
+  [self sendValueEvent];
+
+  FUICollectionBatchMetrics *metrics = self.sink.batches.firstObject;
+  XCTAssertEqual([metrics eventCountForType:FIRDataEventTypeChildAdded], 2);
+  XCTAssertEqual([metrics eventCountForType:FIRDataEventTypeChildChanged], 1);
+  XCTAssertEqual(metrics.itemCount, 2);
+}
+
+- (void)testIndexArrayReportsIndexBatches {
+  FUITestObservable *index = [[FUITestObservable alloc] initWithDictionary:@{}];
+  FUITestObservable *data = [[FUITestObservable alloc] initWithDictionary:@{
+    @"a": @{@"data": @"a"}, @"b": @{@"data": @"b"},
+  }];
+  FUIIndexArray *array = [[FUIIndexArray alloc] initWithIndex:index data:data];
+  array.metricsSink = self.sink;
+  [array observeQuery];
+
+  [index addObject:@YES forKey:@"a"];
+  [index addObject:@YES forKey:@"b"];
+  [index sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+  [index removeObjectForKey:@"a"];
+  [index sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  XCTAssertEqual(self.sink.batches.count, 2);
+  XCTAssertEqual(self.sink.lastCollection, array);
+  XCTAssertEqual([self.sink.batches[0] eventCountForType:FIRDataEventTypeChildAdded], 2);
+  XCTAssertEqual(self.sink.batches[0].itemCount, 2);
+  XCTAssertEqual([self.sink.batches[1] eventCountForType:FIRDataEventTypeChildRemoved], 1);
+  XCTAssertEqual(self.sink.batches[1].itemCount, 1);
+}
+
+@end
@@ -0,0 +1,214 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import <stdatomic.h>
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUICollectionVersionTest : XCTestCase
+
+@property (nonatomic, nullable) FUITestObservable *observable;
+@property (nonatomic, nullable) FUIArray *firebaseArray;
+
+@end
+
+@implementation FUICollectionVersionTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUITestObservable alloc] init];
+  self.firebaseArray = [[FUIArray alloc] initWithQuery:self.observable];
+  [self.firebaseArray observeQuery];
+}
+
+- (void)tearDown {
+  [super tearDown];
+  [self.observable removeAllObservers];
+  self.firebaseArray = nil;
+}
+
+// Ends the current batch of updates, which is when the array publishes a new version.
+- (void)endUpdates {
+  [self.observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+- (void)testArrayStartsWithEmptyVersion {
+  FUICollectionVersion *version = self.firebaseArray.currentVersion;
+  XCTAssertEqual(version.version, 0, @"expected new array to start at version 0");
+  XCTAssertEqual(version.count, 0, @"expected new array's version to be empty");
+}
+
+- (void)testVersionIsPublishedAtEndOfBatch {
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self.observable addObject:@"b" forKey:@"1"];
+
+  XCTAssertEqual(self.firebaseArray.currentVersion.count, 0,
+                 @"expected version to not change in the middle of a batch");
+
+  [self endUpdates];
+
+  FUICollectionVersion *version = self.firebaseArray.currentVersion;
+  XCTAssertEqual(version.version, 1, @"expected one version to be published per batch");
+  XCTAssertEqual(version.count, 2, @"expected version to contain the batch's insertions");
+  XCTAssertEqualObjects(version.items, self.firebaseArray.items,
+                        @"expected version to match the array's contents");
+}
+
+- (void)testHeldVersionIsUnaffectedByLaterUpdates {
+  [self.observable addObject:@"a" forKey:@"0"];
+  [self endUpdates];
+  FUICollectionVersion *held = self.firebaseArray.currentVersion;
+
+  [self.observable addObject:@"b" forKey:@"1"];
+  [self.observable removeObjectForKey:@"0"];
+  [self endUpdates];
+
+  XCTAssertEqual(held.count, 1, @"expected held version to be immutable");
+  XCTAssertEqualObjects([held snapshotAtIndex:0].key, @"0",
+                        @"expected held version to keep its original contents");
+  XCTAssertEqual(self.firebaseArray.currentVersion.version, held.version + 1,
+                 @"expected a newer version to be published");
+  XCTAssertEqualObjects([self.firebaseArray.currentVersion snapshotAtIndex:0].key, @"1",
+                        @"expected current version to reflect the latest batch");
+}
+
+- (void)testInvalidatePublishesEmptyVersion {
+  [self.observable populateWithCount:10];
+  [self endUpdates];
+  XCTAssertEqual(self.firebaseArray.currentVersion.count, 10);
+
+  [self.firebaseArray invalidate];
+
+  XCTAssertEqual(self.firebaseArray.currentVersion.count, 0,
+                 @"expected invalidated array to publish an empty version");
+}
+
+- (void)testSortedArrayPublishesSortedVersions {
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUISortedArray *array =
+      [[FUISortedArray alloc] initWithQuery:observable
+                                   delegate:nil
+                             sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                FIRDataSnapshot *right) {
+    return [right.key compare:left.key];
+  }];
+  [array observeQuery];
+  [observable populateWithCount:3];
+  [observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  NSArray *keys = [array.currentVersion.items valueForKey:@"key"];
+  NSArray *expected = @[@"2", @"1", @"0"];
+  XCTAssertEqualObjects(keys, expected, @"expected sorted array's version to be sorted");
+  [observable removeAllObservers];
+}
+
+- (void)testIndexArrayPublishesLoadedContents {
+  FUITestObservable *index = [[FUITestObservable alloc] initWithDictionary:@{
+    @"1": @(YES),
+    @"2": @(YES),
+  }];
+  FUITestObservable *data = [[FUITestObservable alloc] initWithDictionary:@{
+    @"1": @{ @"data": @"1" },
+    @"2": @{ @"data": @"2" },
+  }];
+  FUIIndexArray *array = [[FUIIndexArray alloc] initWithIndex:index data:data];
+  [array observeQuery];
+
+  // Loads that finish after the index batch are published asynchronously.
+  XCTestExpectation *expectation = [self expectationWithDescription:@"published"];
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [expectation fulfill];
+  });
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+
+  XCTAssertEqualObjects(array.currentVersion.items, array.items,
+                        @"expected index array's version to match its loaded contents");
+  [array invalidate];
+  XCTAssertEqual(array.currentVersion.count, 0,
+                 @"expected invalidated index array to publish an empty version");
+}
+
+#pragma mark - Concurrency
+
+// Run with the Thread Sanitizer enabled (it is on in the FirebaseDatabaseUI scheme)
+// to catch data races between the main thread writer and the background readers.
+- (void)testConcurrentReadersSeeConsistentVersions {
+  static const NSUInteger kWrites = 2000;
+  static const NSUInteger kReaders = 4;
+
+  __block atomic_bool finished;
+  atomic_init(&finished, false);
+  __block atomic_uint_fast64_t inconsistencies;
+  atomic_init(&inconsistencies, 0);
+
+  dispatch_group_t group = dispatch_group_create();
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  FUIArray *array = self.firebaseArray;
+
+  for (NSUInteger reader = 0; reader < kReaders; reader++) {
+    dispatch_group_async(group, queue, ^{
+      uint64_t lastVersion = 0;
+      while (!atomic_load(&finished)) {
+        FUICollectionVersion *version = array.currentVersion;
+
+        // Versions must never go backwards for a single reader.
+        if (version.version < lastVersion) {
+          atomic_fetch_add(&inconsistencies, 1);
+        }
+        lastVersion = version.version;
+
+        // Every batch below appends exactly one child with an increasing integer key
+        // and every other batch removes the first child, so each version must be a
+        // contiguous run of integer keys.
+        NSArray<FIRDataSnapshot *> *items = version.items;
+        if (items.count == 0) { continue; }
+        NSInteger first = items.firstObject.key.integerValue;
+        NSInteger last = items.lastObject.key.integerValue;
+        if (last - first + 1 != (NSInteger)items.count) {
+          atomic_fetch_add(&inconsistencies, 1);
+        }
+      }
+    });
+  }
+
+  for (NSUInteger i = 0; i < kWrites; i++) {
+    [self.observable addObject:@(i).stringValue forKey:@(i).stringValue];
+    if (i % 2 == 1) {
+      [self.observable removeObjectForKey:@(i / 2).stringValue];
+    }
+    [self endUpdates];
+  }
+
+  atomic_store(&finished, true);
+  long result = dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC));
+
+  XCTAssertEqual(result, 0, @"expected readers to finish");
+  XCTAssertEqual(atomic_load(&inconsistencies), 0,
+                 @"expected every version read from a background thread to be consistent");
+  XCTAssertEqual(array.currentVersion.version, kWrites,
+                 @"expected one version to be published per batch");
+  XCTAssertEqualObjects(array.currentVersion.items, array.items,
+                        @"expected final version to match the array's contents");
+}
+
+@end
@@ -0,0 +1,272 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUIDataTraceTest : XCTestCase
+@property (nonatomic) NSURL *traceURL;
+@end
+
+@implementation FUIDataTraceTest
+
+- (void)setUp {
+  [super setUp];
+  NSString *name = [NSString stringWithFormat:@"%@.fuitrace", NSUUID.UUID.UUIDString];
+  self.traceURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+}
+
+- (void)tearDown {
+  [NSFileManager.defaultManager removeItemAtURL:self.traceURL error:NULL];
+  [super tearDown];
+}
+
+- (FUIDataTraceRecorder *)recorder {
+  NSError *error;
+  FUIDataTraceRecorder *recorder = [[FUIDataTraceRecorder alloc] initWithURL:self.traceURL error:&error];
+  XCTAssertNotNil(recorder, @"expected recorder to be created, got error %@", error);
+  return recorder;
+}
+
+- (FUIDataTraceReplayer *)replayer {
+  NSError *error;
+  FUIDataTraceReplayer *replayer = [[FUIDataTraceReplayer alloc] initWithContentsOfURL:self.traceURL
+                                                                                 error:&error];
+  XCTAssertNotNil(replayer, @"expected trace to load, got error %@", error);
+  return replayer;
+}
+
+- (NSArray *)keysOfSnapshots:(NSArray *)snapshots {
+  return [snapshots valueForKey:@"key"];
+}
+
+- (NSArray *)valuesOfSnapshots:(NSArray *)snapshots {
+  return [snapshots valueForKey:@"value"];
+}
+
+- (void)testReplayingIntoArrayReproducesRecordedContents {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"messages"]];
+  [recorded observeQuery];
+
+  for (NSInteger i = 0; i < 5; i++) {
+    [observable addObject:@{@"text": @(i).stringValue, @"likes": @(i)} forKey:@(i).stringValue];
+  }
+  [observable changeObject:@{@"text": @"edited", @"pinned": @YES} forKey:@"2"];
+  [observable moveObjectFromIndex:4 toIndex:0];
+  [observable removeObjectForKey:@"1"];
+  [observable addObject:@"just a string" forKey:@"5"];
+  [observable addObject:@2.5 forKey:@"6"];
+
+  XCTAssertEqual(recorder.recordedEventCount, 10);
+  NSError *error;
+  XCTAssertTrue([recorder finishRecordingWithError:&error], @"unexpected error %@", error);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  XCTAssertEqual(replayer.eventCount, 10);
+
+  FUIArray *replayed = [[FUIArray alloc] initWithQuery:[replayer observableNamed:@"messages"]];
+  [replayed observeQuery];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedMaximum completion:nil];
+
+  XCTAssertEqualObjects([self keysOfSnapshots:replayed.items], [self keysOfSnapshots:recorded.items]);
+  XCTAssertEqualObjects([self valuesOfSnapshots:replayed.items], [self valuesOfSnapshots:recorded.items]);
+  XCTAssertEqual(replayer.droppedEventCount, 0);
+}
+
+- (void)testDeallocatingRecorderFinishesTrace {
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded;
+  @autoreleasepool {
+    FUIDataTraceRecorder *recorder = [self recorder];
+    recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                        name:@"messages"]];
+    [recorded observeQuery];
+    [observable addObject:@"a" forKey:@"0"];
+    [observable addObject:@"b" forKey:@"1"];
+  }
+
+  // The array still observes the recording observable, which mustn't keep the
+  // trace open. Later events are forwarded without being recorded.
+  [observable addObject:@"c" forKey:@"2"];
+  XCTAssertEqual(recorded.count, 3);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  XCTAssertEqual(replayer.eventCount, 2);
+  [recorded invalidate];
+}
+
+- (void)testReplayedSnapshotsKeepChildOrderAndValueTypes {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"users"]];
+  [recorded observeQuery];
+
+  // Children of a snapshot are in query order, which isn't key order.
+  FUIFakeSnapshot *snap = [FUIFakeSnapshot snapWithKey:@"user"
+                                                 value:@{@"b": @"second", @"a": @[@1, @NO, [NSNull null]]}];
+  snap.childSnapshots = @[
+    [FUIFakeSnapshot snapWithKey:@"b" value:@"second"],
+    [FUIFakeSnapshot snapWithKey:@"a" value:@[@1, @NO, [NSNull null]]],
+  ];
+  [observable sendEvent:FIRDataEventTypeChildAdded withObject:snap previousKey:nil error:nil];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  FUIArray *replayed = [[FUIArray alloc] initWithQuery:[replayer observableNamed:@"users"]];
+  [replayed observeQuery];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedMaximum completion:nil];
+
+  FIRDataSnapshot *user = replayed.items.firstObject;
+  XCTAssertEqualObjects(user.key, @"user");
+  XCTAssertEqualObjects(user.value, snap.value);
+  XCTAssertEqualObjects([self keysOfSnapshots:user.children.allObjects], (@[@"b", @"a"]));
+  XCTAssertEqualObjects([user childSnapshotForPath:@"a/1"].value, @NO);
+  XCTAssertFalse([user childSnapshotForPath:@"c"].exists);
+}
+
+- (void)testReplayingIntoIndexArrayReproducesRecordedContents {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *index = [[FUITestObservable alloc] initWithDictionary:@{
+    @"1": @YES, @"2": @YES, @"3": @YES,
+  }];
+  FUITestObservable *data = [[FUITestObservable alloc] initWithDictionary:@{
+    @"1": @{@"data": @"1"}, @"2": @{@"data": @"2"}, @"3": @{@"data": @"3"},
+  }];
+  FUIIndexArray *recorded = [[FUIIndexArray alloc] initWithIndex:[recorder recordingObservable:index name:@"index"]
+                                                            data:[recorder recordingObservable:data name:@"data"]];
+  [recorded observeQuery];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  FUIIndexArray *replayed = [[FUIIndexArray alloc] initWithIndex:[replayer observableNamed:@"index"]
+                                                            data:[replayer observableNamed:@"data"]];
+  [replayed observeQuery];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedMaximum completion:nil];
+
+  XCTAssertEqual(replayed.items.count, 3);
+  XCTAssertEqualObjects([self keysOfSnapshots:replayed.indexes], [self keysOfSnapshots:recorded.indexes]);
+  XCTAssertEqualObjects([self valuesOfSnapshots:replayed.items], [self valuesOfSnapshots:recorded.items]);
+}
+
+- (void)testCancellationsAreReplayed {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"secret"]];
+  [recorded observeQuery];
+  NSError *denied = [NSError errorWithDomain:@"com.firebase" code:-3 userInfo:nil];
+  [observable sendEvent:FIRDataEventTypeChildAdded withObject:nil previousKey:nil error:denied];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  FUIArrayTestDelegate *delegate = [[FUIArrayTestDelegate alloc] init];
+  __block NSError *replayedError;
+  delegate.queryCancelled = ^(id<FUICollection> array, NSError *error) {
+    replayedError = error;
+  };
+  FUIArray *replayed = [[FUIArray alloc] initWithQuery:[replayer observableNamed:@"secret"]
+                                              delegate:delegate];
+  [replayed observeQuery];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedMaximum completion:nil];
+
+  XCTAssertEqualObjects(replayedError.domain, denied.domain);
+  XCTAssertEqual(replayedError.code, denied.code);
+}
+
+- (void)testOriginalSpeedKeepsRecordedGaps {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"feed"]];
+  [recorded observeQuery];
+  [observable addObject:@"first" forKey:@"a"];
+  [NSThread sleepForTimeInterval:0.2];
+  [observable addObject:@"second" forKey:@"b"];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  XCTAssertGreaterThanOrEqual(replayer.duration, 0.19);
+
+  FUIArray *replayed = [[FUIArray alloc] initWithQuery:[replayer observableNamed:@"feed"]];
+  [replayed observeQuery];
+  XCTestExpectation *finished = [self expectationWithDescription:@"replay finished"];
+  NSDate *start = [NSDate date];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedOriginal completion:^{
+    [finished fulfill];
+  }];
+  // The first event is due right away, the second isn't.
+  XCTAssertEqual(replayed.count, 1);
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+  XCTAssertGreaterThanOrEqual(-start.timeIntervalSinceNow, 0.19);
+  XCTAssertEqual(replayed.count, 2);
+}
+
+- (void)testListenersThatDontMatchTheTraceGetNoEvents {
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"feed"]];
+  [recorded observeQuery];
+  [observable addObject:@"first" forKey:@"a"];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+
+  FUIDataTraceReplayer *replayer = [self replayer];
+  FUIArray *replayed = [[FUIArray alloc] initWithQuery:[replayer observableNamed:@"other"]];
+  [replayed observeQuery];
+  [replayer replayWithSpeed:FUIDataTraceReplaySpeedMaximum completion:nil];
+
+  // FUIArray attaches one listener per event type.
+  XCTAssertEqual(replayer.unmatchedListenerCount, 5);
+  XCTAssertEqual(replayer.droppedEventCount, 1);
+  XCTAssertEqual(replayed.count, 0);
+}
+
+- (void)testCorruptTracesFailToLoad {
+  [[@"not a trace" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:self.traceURL atomically:YES];
+  NSError *error;
+  FUIDataTraceReplayer *replayer = [[FUIDataTraceReplayer alloc] initWithContentsOfURL:self.traceURL
+                                                                                 error:&error];
+  XCTAssertNil(replayer);
+  XCTAssertEqualObjects(error.domain, FUIDataTraceErrorDomain);
+  XCTAssertEqual(error.code, FUIDataTraceErrorCorruptTrace);
+
+  // A trace cut off in the middle of a record.
+  FUIDataTraceRecorder *recorder = [self recorder];
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUIArray *recorded = [[FUIArray alloc] initWithQuery:[recorder recordingObservable:observable
+                                                                                name:@"feed"]];
+  [recorded observeQuery];
+  [observable addObject:@"a value long enough to cut" forKey:@"a"];
+  XCTAssertTrue([recorder finishRecordingWithError:NULL]);
+  NSData *trace = [NSData dataWithContentsOfURL:self.traceURL];
+  [[trace subdataWithRange:NSMakeRange(0, trace.length - 4)] writeToURL:self.traceURL atomically:YES];
+
+  replayer = [[FUIDataTraceReplayer alloc] initWithContentsOfURL:self.traceURL error:&error];
+  XCTAssertNil(replayer);
+  XCTAssertEqual(error.code, FUIDataTraceErrorCorruptTrace);
+}
+
+@end
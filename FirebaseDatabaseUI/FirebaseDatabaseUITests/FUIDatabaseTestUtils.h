@@ -39,6 +39,9 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)snapWithKey:(NSString *)key value:(id)value;
 @property (nonatomic, copy) NSString *key;
 @property (nonatomic, copy) id value;
+// Returned by -children, for snapshots of queries with more than one child.
+@property (nonatomic, copy, nullable) NSArray<FUIFakeSnapshot *> *childSnapshots;
+- (NSEnumerator<FUIFakeSnapshot *> *)children;
 @end
 
 // A dummy observable so we can test this without relying on an internet connection.
@@ -91,6 +94,35 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+// A fake data node that counts the listeners attached to it, so tests can measure how
+// many round-trips to the database a collection makes. Value listeners are called
+// synchronously with the current contents when they're attached. Supports the key
+// range queries used by FUIIndexArray's join planner.
+@interface FUICountingObservable: NSObject <FUIDataObservable>
+
+- (instancetype)initWithDictionary:(NSDictionary<NSString *, id> *)contents;
+
+// The number of listeners attached to this node and to all children and queries
+// created from it.
+@property (nonatomic, readonly) NSUInteger roundTrips;
+
+// The number of those listeners that haven't been removed.
+@property (nonatomic, readonly) NSUInteger activeListeners;
+
+// When YES, listeners on key range queries are cancelled with an error, the way a
+// range read denied by security rules would be.
+@property (nonatomic, assign) BOOL failsRangeQueries;
+
+// Sets the value of a child and sends value events to every listener whose query
+// includes it.
+- (void)setValue:(id)value forChildKey:(NSString *)key;
+
+- (id<FUIDataObservable>)queryOrderedByKey;
+- (id<FUIDataObservable>)queryStartingAtValue:(nullable id)startValue;
+- (id<FUIDataObservable>)queryEndingAtValue:(nullable id)endValue;
+
+@end
+
 @interface FUIArrayTestDelegate : NSObject <FUICollectionDelegate>
 @property (nonatomic, copy) void (^didStartUpdates)(void);
 @property (nonatomic, copy) void (^didEndUpdates)(void);
@@ -48,6 +48,10 @@
   return [snap.key isEqualToString:self.key] && [snap.value isEqual:self.value];
 }
 
+- (NSEnumerator<FUIFakeSnapshot *> *)children {
+  return (self.childSnapshots ?: @[]).objectEnumerator;
+}
+
 - (NSString *)description {
   return [NSString stringWithFormat:@"<FUIFakeSnapshot: %p key = %@, value = %@>", self, self.key, self.value];
 }
@@ -221,6 +225,179 @@
 
 @end
 
+// The data shared by a FUICountingObservable and the children and queries created from it.
+@interface FUICountingStore: NSObject
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, id> *contents;
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber *, FUICountingObservable *> *listeners;
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber *, FUIDataEventHandler *> *handlers;
+@property (nonatomic, assign) NSUInteger roundTrips;
+@property (nonatomic, assign) FIRDatabaseHandle current;
+@property (nonatomic, assign) BOOL failsRangeQueries;
+@end
+
+@implementation FUICountingStore
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _contents = [NSMutableDictionary dictionary];
+    _listeners = [NSMutableDictionary dictionary];
+    _handlers = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+@end
+
+@interface FUICountingObservable ()
+@property (nonatomic, strong) FUICountingStore *store;
+@property (nonatomic, copy, nullable) NSString *childKey;
+@property (nonatomic, assign) BOOL isRange;
+@property (nonatomic, copy, nullable) NSString *startKey;
+@property (nonatomic, copy, nullable) NSString *endKey;
+@end
+
+@implementation FUICountingObservable
+
+- (instancetype)initWithDictionary:(NSDictionary<NSString *, id> *)contents {
+  self = [super init];
+  if (self != nil) {
+    _store = [[FUICountingStore alloc] init];
+    [_store.contents addEntriesFromDictionary:contents];
+  }
+  return self;
+}
+
+- (instancetype)observableWithChildKey:(NSString *)childKey {
+  FUICountingObservable *copy = [[FUICountingObservable alloc] initWithDictionary:@{}];
+  copy.store = self.store;
+  copy.childKey = childKey ?: self.childKey;
+  copy.isRange = self.isRange;
+  copy.startKey = self.startKey;
+  copy.endKey = self.endKey;
+  return copy;
+}
+
+- (NSUInteger)roundTrips {
+  return self.store.roundTrips;
+}
+
+- (NSUInteger)activeListeners {
+  return self.store.listeners.count;
+}
+
+- (BOOL)failsRangeQueries {
+  return self.store.failsRangeQueries;
+}
+
+- (void)setFailsRangeQueries:(BOOL)failsRangeQueries {
+  self.store.failsRangeQueries = failsRangeQueries;
+}
+
+- (id<FUIDataObservable>)child:(NSString *)path {
+  return [self observableWithChildKey:path];
+}
+
+- (id<FUIDataObservable>)queryOrderedByKey {
+  FUICountingObservable *copy = [self observableWithChildKey:nil];
+  copy.isRange = YES;
+  return copy;
+}
+
+- (id<FUIDataObservable>)queryStartingAtValue:(id)startValue {
+  FUICountingObservable *copy = [self observableWithChildKey:nil];
+  copy.startKey = startValue;
+  return copy;
+}
+
+- (id<FUIDataObservable>)queryEndingAtValue:(id)endValue {
+  FUICountingObservable *copy = [self observableWithChildKey:nil];
+  copy.endKey = endValue;
+  return copy;
+}
+
+- (BOOL)includesKey:(NSString *)key {
+  if (self.childKey != nil) { return [self.childKey isEqualToString:key]; }
+  if (self.startKey != nil &&
+      [FUIIndexRangeJoinPlanner compareKey:key toKey:self.startKey] == NSOrderedAscending) {
+    return NO;
+  }
+  if (self.endKey != nil &&
+      [FUIIndexRangeJoinPlanner compareKey:key toKey:self.endKey] == NSOrderedDescending) {
+    return NO;
+  }
+  return YES;
+}
+
+- (FUIFakeSnapshot *)currentSnapshot {
+  if (self.childKey != nil) {
+    id value = self.store.contents[self.childKey] ?: [NSNull null];
+    return [[FUIFakeSnapshot alloc] initWithKey:self.childKey value:value];
+  }
+
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  for (NSString *key in self.store.contents) {
+    if ([self includesKey:key]) { [keys addObject:key]; }
+  }
+  [keys sortUsingComparator:^NSComparisonResult(NSString *left, NSString *right) {
+    return [FUIIndexRangeJoinPlanner compareKey:left toKey:right];
+  }];
+
+  NSMutableArray<FUIFakeSnapshot *> *children = [NSMutableArray arrayWithCapacity:keys.count];
+  NSMutableDictionary<NSString *, id> *value = [NSMutableDictionary dictionary];
+  for (NSString *key in keys) {
+    [children addObject:[[FUIFakeSnapshot alloc] initWithKey:key value:self.store.contents[key]]];
+    value[key] = self.store.contents[key];
+  }
+  FUIFakeSnapshot *snapshot = [[FUIFakeSnapshot alloc] initWithKey:@"data" value:value];
+  snapshot.childSnapshots = children;
+  return snapshot;
+}
+
+- (void)sendCurrentValueToHandler:(FUIDataEventHandler *)handler {
+  if (handler.event != FIRDataEventTypeValue) { return; }
+  if (self.isRange && self.store.failsRangeQueries) {
+    if (handler.cancelled != nil) {
+      handler.cancelled([NSError errorWithDomain:@"FUICountingObservable" code:1 userInfo:nil]);
+    }
+    return;
+  }
+  handler.success((FIRDataSnapshot *)[self currentSnapshot], nil);
+}
+
+- (FIRDatabaseHandle)observeEventType:(FIRDataEventType)eventType
+       andPreviousSiblingKeyWithBlock:(void (^)(FIRDataSnapshot *_Nonnull, NSString *_Nullable))block
+                      withCancelBlock:(void (^)(NSError *_Nonnull))cancelBlock {
+  FUIDataEventHandler *handler = [[FUIDataEventHandler alloc] init];
+  handler.event = eventType;
+  handler.success = block;
+  handler.cancelled = cancelBlock;
+
+  FIRDatabaseHandle handle = self.store.current++;
+  self.store.roundTrips++;
+  self.store.listeners[@(handle)] = self;
+  self.store.handlers[@(handle)] = handler;
+
+  [self sendCurrentValueToHandler:handler];
+  return handle;
+}
+
+- (void)removeObserverWithHandle:(FIRDatabaseHandle)handle {
+  [self.store.listeners removeObjectForKey:@(handle)];
+  [self.store.handlers removeObjectForKey:@(handle)];
+}
+
+- (void)setValue:(id)value forChildKey:(NSString *)key {
+  self.store.contents[key] = value;
+  NSArray<NSNumber *> *handles = [self.store.listeners.allKeys sortedArrayUsingSelector:@selector(compare:)];
+  for (NSNumber *handle in handles) {
+    FUICountingObservable *listener = self.store.listeners[handle];
+    FUIDataEventHandler *handler = self.store.handlers[handle];
+    if (listener == nil || ![listener includesKey:key]) { continue; }
+    [listener sendCurrentValueToHandler:handler];
+  }
+}
+
+@end
+
 @implementation FUIArrayTestDelegate
 
 - (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
@@ -0,0 +1,207 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUIFilteredCollectionTest : XCTestCase
+@property (nonatomic) FUITestObservable *observable;
+@property (nonatomic) FUIArray *array;
+@property (nonatomic) FUIFilteredCollection *filtered;
+@property (nonatomic) FUIArrayTestDelegate *filteredDelegate;
+// The filtered collection's contents as rebuilt from its delegate events.
+@property (nonatomic) NSMutableArray<NSString *> *mirror;
+@end
+
+@implementation FUIFilteredCollectionTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUITestObservable alloc] init];
+  self.array = [[FUIArray alloc] initWithQuery:self.observable];
+  self.filtered = [[FUIFilteredCollection alloc] initWithCollection:self.array
+                                                          predicate:^BOOL(FIRDataSnapshot *snapshot) {
+    return [snapshot.value integerValue] % 2 == 0;
+  }];
+  self.filteredDelegate = [[FUIArrayTestDelegate alloc] init];
+  self.filtered.delegate = self.filteredDelegate;
+
+  self.mirror = [NSMutableArray array];
+  __weak typeof(self) weakSelf = self;
+  self.filteredDelegate.didAddObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    [weakSelf.mirror insertObject:[object key] atIndex:index];
+  };
+  self.filteredDelegate.didRemoveObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    [weakSelf.mirror removeObjectAtIndex:index];
+  };
+  self.filteredDelegate.didMoveObject = ^(id<FUICollection> collection, id object,
+                                          NSUInteger fromIndex, NSUInteger toIndex) {
+    [weakSelf.mirror removeObjectAtIndex:fromIndex];
+    [weakSelf.mirror insertObject:[object key] atIndex:toIndex];
+  };
+  self.filteredDelegate.didChangeObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    XCTAssertEqualObjects(weakSelf.mirror[index], [object key]);
+  };
+
+  [self.filtered observeQuery];
+}
+
+- (void)tearDown {
+  [self.filtered invalidate];
+  [super tearDown];
+}
+
+- (NSArray<NSString *> *)filteredKeys {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  for (FIRDataSnapshot *snapshot in self.filtered.items) {
+    [keys addObject:snapshot.key];
+  }
+  return keys;
+}
+
+- (void)assertMirrorMatches {
+  XCTAssertEqualObjects(self.mirror, [self filteredKeys]);
+  XCTAssertEqual(self.filtered.count, self.mirror.count);
+  for (NSUInteger i = 0; i < self.mirror.count; i++) {
+    XCTAssertEqualObjects([self.filtered snapshotAtIndex:i].key, self.mirror[i]);
+  }
+}
+
+- (void)testFiltersAddedItems {
+  for (NSInteger i = 0; i < 10; i++) {
+    [self.observable addObject:@(i) forKey:[NSString stringWithFormat:@"k%ld", (long)i]];
+  }
+
+  NSArray *expected = @[@"k0", @"k2", @"k4", @"k6", @"k8"];
+  XCTAssertEqualObjects([self filteredKeys], expected);
+  [self assertMirrorMatches];
+  XCTAssertEqual([self.filtered collectionIndexForIndex:2], 4);
+  XCTAssertEqual([self.filtered indexForCollectionIndex:4], 2);
+  XCTAssertEqual([self.filtered indexForCollectionIndex:5], NSNotFound);
+  XCTAssertEqual([self.filtered collectionIndexForIndex:5], NSNotFound);
+}
+
+- (void)testChangesMoveItemsInAndOut {
+  for (NSInteger i = 0; i < 6; i++) {
+    [self.observable addObject:@(i) forKey:[NSString stringWithFormat:@"k%ld", (long)i]];
+  }
+
+  [self.observable changeObject:@3 forKey:@"k2"];
+  [self assertMirrorMatches];
+  NSArray *expected = @[@"k0", @"k4"];
+  XCTAssertEqualObjects(self.mirror, expected);
+
+  [self.observable changeObject:@10 forKey:@"k5"];
+  [self.observable changeObject:@20 forKey:@"k4"];
+  [self assertMirrorMatches];
+  expected = @[@"k0", @"k4", @"k5"];
+  XCTAssertEqualObjects(self.mirror, expected);
+}
+
+- (void)testRemovesAndMoves {
+  for (NSInteger i = 0; i < 8; i++) {
+    [self.observable addObject:@(i) forKey:[NSString stringWithFormat:@"k%ld", (long)i]];
+  }
+
+  [self.observable removeObjectForKey:@"k1"];
+  [self.observable removeObjectForKey:@"k2"];
+  [self assertMirrorMatches];
+
+  [self.observable moveObjectFromIndex:0 toIndex:5];
+  [self assertMirrorMatches];
+  NSArray *expected = @[@"k4", @"k6", @"k0"];
+  XCTAssertEqualObjects(self.mirror, expected);
+}
+
+- (void)testSwappingPredicateSendsOneBatch {
+  for (NSInteger i = 0; i < 20; i++) {
+    [self.observable addObject:@(i) forKey:[NSString stringWithFormat:@"k%02ld", (long)i]];
+  }
+
+  __block NSUInteger batches = 0;
+  __block BOOL inBatch = NO;
+  __block BOOL eventOutsideBatch = NO;
+  self.filteredDelegate.didStartUpdates = ^{
+    batches++;
+    inBatch = YES;
+  };
+  self.filteredDelegate.didEndUpdates = ^{
+    inBatch = NO;
+  };
+  void (^add)(id<FUICollection>, id, NSUInteger) = self.filteredDelegate.didAddObject;
+  self.filteredDelegate.didAddObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    eventOutsideBatch = eventOutsideBatch || !inBatch;
+    add(collection, object, index);
+  };
+
+  self.filtered.predicate = ^BOOL(FIRDataSnapshot *snapshot) {
+    return [snapshot.value integerValue] % 3 == 0;
+  };
+
+  XCTAssertEqual(batches, 1);
+  XCTAssertFalse(eventOutsideBatch);
+  [self assertMirrorMatches];
+  NSArray *expected = @[@"k00", @"k03", @"k06", @"k09", @"k12", @"k15", @"k18"];
+  XCTAssertEqualObjects(self.mirror, expected);
+
+  // A predicate that matches the same items sends nothing.
+  self.filtered.predicate = ^BOOL(FIRDataSnapshot *snapshot) {
+    return [snapshot.value integerValue] % 3 == 0;
+  };
+  XCTAssertEqual(batches, 1);
+}
+
+- (void)testInvalidateRemovesItems {
+  for (NSInteger i = 0; i < 4; i++) {
+    [self.observable addObject:@(i) forKey:[NSString stringWithFormat:@"k%ld", (long)i]];
+  }
+  [self.filtered invalidate];
+  XCTAssertEqual(self.filtered.count, 0);
+  XCTAssertEqual(self.mirror.count, 0);
+
+  // Events after invalidation aren't forwarded.
+  [self.observable addObject:@10 forKey:@"k10"];
+  XCTAssertEqual(self.mirror.count, 0);
+}
+
+- (void)testLargeRandomWorkload {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  srand48(7);
+  for (NSInteger step = 0; step < 2000; step++) {
+    double roll = drand48();
+    if (roll < 0.5 || keys.count == 0) {
+      NSString *key = [NSString stringWithFormat:@"k%ld", (long)step];
+      [keys addObject:key];
+      [self.observable addObject:@(lrand48() % 10) forKey:key];
+    } else if (roll < 0.8) {
+      NSString *key = keys[lrand48() % keys.count];
+      [self.observable changeObject:@(lrand48() % 10) forKey:key];
+    } else {
+      NSUInteger index = lrand48() % keys.count;
+      [self.observable removeObjectForKey:keys[index]];
+      [keys removeObjectAtIndex:index];
+    }
+  }
+  [self assertMirrorMatches];
+}
+
+@end
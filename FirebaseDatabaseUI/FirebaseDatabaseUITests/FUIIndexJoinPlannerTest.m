@@ -0,0 +1,264 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUIIndexJoinPlannerTest : XCTestCase
+
+@property (nonatomic) FUIIndexRangeJoinPlanner *planner;
+@property (nonatomic) FUITestObservable *index;
+@property (nonatomic) FUICountingObservable *data;
+@property (nonatomic) FUIIndexArrayTestDelegate *arrayDelegate;
+
+@end
+
+@implementation FUIIndexJoinPlannerTest
+
+- (void)setUp {
+  [super setUp];
+  self.planner = [[FUIIndexRangeJoinPlanner alloc] init];
+  self.index = [[FUITestObservable alloc] init];
+  self.arrayDelegate = [[FUIIndexArrayTestDelegate alloc] init];
+
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+  for (NSInteger i = 0; i < 20; i++) {
+    data[@(i).stringValue] = @{ @"data": @(i).stringValue };
+  }
+  self.data = [[FUICountingObservable alloc] initWithDictionary:data];
+}
+
+- (void)tearDown {
+  [self.index removeAllObservers];
+  [super tearDown];
+}
+
+- (FUIIndexArray *)observedArrayWithPlanner:(id<FUIIndexJoinPlanner>)planner {
+  FUIIndexArray *array = [[FUIIndexArray alloc] initWithIndex:self.index
+                                                         data:self.data
+                                                     delegate:self.arrayDelegate];
+  array.joinPlanner = planner;
+  [array observeQuery];
+  return array;
+}
+
+// Adds index entries in a single batch, the way an initial load arrives.
+- (void)addIndexKeys:(NSArray<NSString *> *)keys {
+  for (NSString *key in keys) {
+    [self.index addObject:@(YES) forKey:key];
+  }
+  [self.index sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+- (NSArray<NSString *> *)keysFrom:(NSInteger)start to:(NSInteger)end {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  for (NSInteger i = start; i <= end; i++) {
+    [keys addObject:@(i).stringValue];
+  }
+  return keys;
+}
+
+#pragma mark - Planning
+
+- (void)testComparesKeysInDatabaseOrder {
+  NSArray *keys = @[@"b", @"10", @"-1", @"a", @"9", @"010", @"2147483648"];
+  NSArray *sorted = [keys sortedArrayUsingComparator:^NSComparisonResult(NSString *left,
+                                                                         NSString *right) {
+    return [FUIIndexRangeJoinPlanner compareKey:left toKey:right];
+  }];
+  NSArray *expected = @[@"-1", @"9", @"10", @"010", @"2147483648", @"a", @"b"];
+  XCTAssertEqualObjects(sorted, expected,
+                        @"expected 32-bit integer keys first, then other keys as strings");
+}
+
+- (void)testGroupsDenseIntegerKeys {
+  NSArray<FUIIndexJoinRange *> *ranges = [self.planner rangesForKeys:@[@"3", @"1", @"2", @"4", @"5"]];
+  XCTAssertEqual(ranges.count, 1);
+  XCTAssertEqualObjects(ranges.firstObject.startKey, @"1");
+  XCTAssertEqualObjects(ranges.firstObject.endKey, @"5");
+}
+
+- (void)testDoesNotGroupSparseIntegerKeys {
+  NSArray<FUIIndexJoinRange *> *ranges = [self.planner rangesForKeys:@[@"1", @"100", @"200", @"300"]];
+  XCTAssertEqual(ranges.count, 0, @"expected sparse keys to be loaded individually");
+}
+
+- (void)testSplitsRunsAtGaps {
+  NSArray *keys = @[@"1", @"2", @"3", @"4", @"1000", @"1001", @"1002", @"1003", @"5000"];
+  NSArray<FUIIndexJoinRange *> *ranges = [self.planner rangesForKeys:keys];
+  XCTAssertEqual(ranges.count, 2);
+  XCTAssertEqualObjects(ranges[0].keys, (@[@"1", @"2", @"3", @"4"]));
+  XCTAssertEqualObjects(ranges[1].keys, (@[@"1000", @"1001", @"1002", @"1003"]));
+}
+
+- (void)testRespectsRangeSizeLimits {
+  self.planner.maximumRangeSize = 4;
+  NSArray<FUIIndexJoinRange *> *ranges = [self.planner rangesForKeys:[self keysFrom:0 to:9]];
+  XCTAssertEqual(ranges.count, 2, @"expected the 2 leftover keys to be loaded individually");
+  for (FUIIndexJoinRange *range in ranges) {
+    XCTAssertEqual(range.keys.count, 4);
+  }
+
+  self.planner.minimumRangeSize = 20;
+  XCTAssertEqual([self.planner rangesForKeys:[self keysFrom:0 to:9]].count, 0);
+}
+
+- (void)testGroupsStringKeysOptimistically {
+  NSArray *keys = @[@"-KhA", @"-KhB", @"-KhC", @"-KhD"];
+  NSArray<FUIIndexJoinRange *> *ranges = [self.planner rangesForKeys:keys];
+  XCTAssertEqual(ranges.count, 1);
+  XCTAssertTrue([ranges.firstObject containsKey:@"-KhB0"]);
+  XCTAssertFalse([ranges.firstObject containsKey:@"-KhE"]);
+
+  XCTAssertFalse([self.planner shouldKeepRange:ranges.firstObject loadedChildCount:100],
+                 @"expected a range that loaded mostly unindexed children to be split");
+  XCTAssertTrue([self.planner shouldKeepRange:ranges.firstObject loadedChildCount:5]);
+}
+
+#pragma mark - Joining
+
+- (void)testPerKeyListenersWithoutPlanner {
+  FUIIndexArray *array = [self observedArrayWithPlanner:nil];
+  [self addIndexKeys:[self keysFrom:0 to:9]];
+
+  XCTAssertEqual(self.data.roundTrips, 10, @"expected one listener per index key");
+  XCTAssertEqual(array.items.count, 10);
+  [array invalidate];
+}
+
+- (void)testDenseKeysLoadWithOneRangeQuery {
+  __block NSInteger loads = 0;
+  self.arrayDelegate.didLoad = ^(FUIIndexArray *array,
+                                 FIRDatabaseReference *ref,
+                                 FIRDataSnapshot *snap,
+                                 NSUInteger index) {
+    loads++;
+  };
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  [self addIndexKeys:[self keysFrom:0 to:9]];
+
+  XCTAssertEqual(self.data.roundTrips, 1, @"expected a single range query");
+  XCTAssertEqual(loads, 10, @"expected every row to be reported as loaded");
+  XCTAssertEqual(array.items.count, 10);
+  for (NSUInteger i = 0; i < 10; i++) {
+    FIRDataSnapshot *snap = [array objectAtIndex:i];
+    XCTAssertEqualObjects(snap.key, @(i).stringValue, @"expected rows to stay in index order");
+    XCTAssertEqualObjects(snap.value, (@{ @"data": @(i).stringValue }));
+  }
+
+  [array invalidate];
+  XCTAssertEqual(self.data.activeListeners, 0, @"expected invalidate to remove the range query");
+}
+
+- (void)testRangeUpdatesOnlyReportChangedRows {
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  [self addIndexKeys:[self keysFrom:0 to:9]];
+
+  NSMutableArray<NSNumber *> *loadedIndexes = [NSMutableArray array];
+  self.arrayDelegate.didLoad = ^(FUIIndexArray *array,
+                                 FIRDatabaseReference *ref,
+                                 FIRDataSnapshot *snap,
+                                 NSUInteger index) {
+    [loadedIndexes addObject:@(index)];
+  };
+  [self.data setValue:@{ @"data": @"changed" } forChildKey:@"4"];
+
+  XCTAssertEqualObjects(loadedIndexes, @[@4], @"expected only the changed row to be reloaded");
+  XCTAssertEqualObjects([array objectAtIndex:4].value, (@{ @"data": @"changed" }));
+  [array invalidate];
+}
+
+- (void)testKeysAddedInsideLoadedRangeReuseIt {
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  [self addIndexKeys:@[@"0", @"1", @"2", @"4", @"5"]];
+  XCTAssertEqual(self.data.roundTrips, 1);
+
+  [self addIndexKeys:@[@"3"]];
+
+  XCTAssertEqual(self.data.roundTrips, 1, @"expected new key to be loaded by the existing range");
+  XCTAssertEqualObjects([array objectAtIndex:5].value, (@{ @"data": @"3" }));
+  [array invalidate];
+}
+
+- (void)testRemovingAllKeysRemovesRangeQuery {
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  NSArray<NSString *> *keys = [self keysFrom:0 to:4];
+  [self addIndexKeys:keys];
+  XCTAssertEqual(self.data.activeListeners, 1);
+
+  for (NSString *key in keys) {
+    [self.index removeObjectForKey:key];
+  }
+  [self.index sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+
+  XCTAssertEqual(array.count, 0);
+  XCTAssertEqual(self.data.activeListeners, 0, @"expected range query to be removed with its rows");
+  [array invalidate];
+}
+
+- (void)testMissingRowsFallBackToPerKeyListeners {
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  [self addIndexKeys:@[@"0", @"1", @"2", @"3", @"42"]];
+
+  // 0...3 are loaded by a range, then 42 isn't in the data node and gets its own listener.
+  XCTAssertEqual(self.data.roundTrips, 2);
+  XCTAssertEqual(array.items.count, 5);
+  XCTAssertEqualObjects([array objectAtIndex:4].value, [NSNull null],
+                        @"expected missing row to load the same way it would without a planner");
+  [array invalidate];
+}
+
+- (void)testFailedRangeQueryFallsBackToPerKeyListeners {
+  self.data.failsRangeQueries = YES;
+  __block NSInteger failures = 0;
+  self.arrayDelegate.didFail = ^(FUIIndexArray *array,
+                                 FIRDatabaseReference *ref,
+                                 NSUInteger index,
+                                 NSError *error) {
+    failures++;
+  };
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+  [self addIndexKeys:[self keysFrom:0 to:9]];
+
+  XCTAssertEqual(failures, 0, @"expected range query failures to not be reported as row failures");
+  XCTAssertEqual(self.data.roundTrips, 11);
+  XCTAssertEqual(array.items.count, 10);
+  [array invalidate];
+}
+
+- (void)testSparseRangeIsSplitAfterLoading {
+  NSMutableDictionary *data = [NSMutableDictionary dictionary];
+  for (NSInteger i = 0; i < 100; i++) {
+    data[[NSString stringWithFormat:@"k%03ld", (long)i]] = @(i);
+  }
+  self.data = [[FUICountingObservable alloc] initWithDictionary:data];
+  FUIIndexArray *array = [self observedArrayWithPlanner:self.planner];
+
+  [self addIndexKeys:@[@"k000", @"k030", @"k060", @"k099"]];
+
+  XCTAssertEqual(self.data.activeListeners, 4,
+                 @"expected a range that loaded mostly unindexed rows to be split up");
+  XCTAssertEqual(array.items.count, 4);
+  [array invalidate];
+}
+
+@end
@@ -0,0 +1,201 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUIKeyOrderedArrayTest : XCTestCase
+@property (nonatomic) FUIArrayTestDelegate *arrayDelegate;
+@property (nonatomic) FUITestObservable *observable;
+@property (nonatomic) FUIKeyOrderedArray *array;
+@end
+
+@implementation FUIKeyOrderedArrayTest
+
+- (void)setUp {
+  [super setUp];
+  self.arrayDelegate = [[FUIArrayTestDelegate alloc] init];
+  self.observable = [[FUITestObservable alloc] init];
+  self.array = [[FUIKeyOrderedArray alloc] initWithQuery:self.observable
+                                                delegate:self.arrayDelegate];
+  [self.array observeQuery];
+}
+
+- (void)tearDown {
+  [self.array invalidate];
+  [super tearDown];
+}
+
+- (void)addKey:(NSString *)key previousKey:(NSString *)previousKey {
+  [self.observable sendEvent:FIRDataEventTypeChildAdded
+                  withObject:[FUIFakeSnapshot snapWithKey:key value:key]
+                 previousKey:previousKey
+                       error:nil];
+}
+
+- (NSArray<NSString *> *)arrayKeys {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  for (FIRDataSnapshot *snapshot in self.array.items) {
+    [keys addObject:snapshot.key];
+  }
+  return keys;
+}
+
+- (void)testAppendsPushIDs {
+  NSArray<NSString *> *keys = @[
+    @"-KZyXW1bZ6rYbVNHAbbA", @"-KZyXW1bZ6rYbVNHAbbB", @"-KZyXWEpAQsPdeOg1bcK",
+    @"-KZyXZ2kmA3Hz9k4PqN_", @"-KZyXZ2kmA3Hz9k4PqNa",
+  ];
+  NSString *previous = nil;
+  for (NSString *key in keys) {
+    [self addKey:key previousKey:previous];
+    previous = key;
+  }
+
+  XCTAssert(self.array.isKeyOrdered);
+  XCTAssertEqualObjects([self arrayKeys], keys);
+  [keys enumerateObjectsUsingBlock:^(NSString *key, NSUInteger index, BOOL *stop) {
+    XCTAssertEqual([self.array indexForKey:key], index);
+  }];
+  XCTAssertEqual([self.array indexForKey:@"-KZyXW1bZ6rYbVNHAbbC"], NSNotFound);
+}
+
+- (void)testInsertsInKeyOrder {
+  [self addKey:@"b" previousKey:nil];
+  [self addKey:@"d" previousKey:@"b"];
+
+  __block NSUInteger addedIndex = NSNotFound;
+  self.arrayDelegate.didAddObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    addedIndex = index;
+  };
+  [self addKey:@"c" previousKey:@"b"];
+  XCTAssertEqual(addedIndex, 1);
+  [self addKey:@"a" previousKey:nil];
+  XCTAssertEqual(addedIndex, 0);
+
+  XCTAssert(self.array.isKeyOrdered);
+  NSArray *expected = @[@"a", @"b", @"c", @"d"];
+  XCTAssertEqualObjects([self arrayKeys], expected);
+}
+
+- (void)testIntegerKeysSortFirst {
+  [self addKey:@"-5" previousKey:nil];
+  [self addKey:@"2" previousKey:@"-5"];
+  [self addKey:@"10" previousKey:@"2"];
+  [self addKey:@"010" previousKey:@"10"];
+  [self addKey:@"a" previousKey:@"010"];
+  [self addKey:@"3" previousKey:@"2"];
+
+  XCTAssert(self.array.isKeyOrdered);
+  NSArray *expected = @[@"-5", @"2", @"3", @"10", @"010", @"a"];
+  XCTAssertEqualObjects([self arrayKeys], expected);
+  XCTAssertEqual([self.array indexForKey:@"10"], 3);
+}
+
+- (void)testRemovesAndChanges {
+  for (NSUInteger i = 0; i < 100; i++) {
+    [self addKey:[NSString stringWithFormat:@"key%03lu", (unsigned long)i]
+     previousKey:i == 0 ? nil : [NSString stringWithFormat:@"key%03lu", (unsigned long)i - 1]];
+  }
+
+  __block NSUInteger changedIndex = NSNotFound;
+  self.arrayDelegate.didChangeObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    changedIndex = index;
+  };
+  [self.observable sendEvent:FIRDataEventTypeChildChanged
+                  withObject:[FUIFakeSnapshot snapWithKey:@"key050" value:@"changed"]
+                 previousKey:@"key049"
+                       error:nil];
+  XCTAssertEqual(changedIndex, 50);
+
+  for (NSUInteger i = 0; i < 100; i += 2) {
+    NSString *key = [NSString stringWithFormat:@"key%03lu", (unsigned long)i];
+    [self.observable sendEvent:FIRDataEventTypeChildRemoved
+                    withObject:[FUIFakeSnapshot snapWithKey:key value:key]
+                   previousKey:nil
+                         error:nil];
+  }
+
+  XCTAssert(self.array.isKeyOrdered);
+  XCTAssertEqual(self.array.count, 50);
+  XCTAssertEqual([self.array indexForKey:@"key051"], 25);
+  XCTAssertEqual([self.array indexForKey:@"key050"], NSNotFound);
+  XCTAssertEqualObjects([self.array snapshotAtIndex:49].key, @"key099");
+}
+
+- (void)testFallsBackWhenOrderIsViolated {
+  [self addKey:@"a" previousKey:nil];
+  [self addKey:@"c" previousKey:@"a"];
+  // A query ordered by value can put "b" after "c".
+  [self addKey:@"b" previousKey:@"c"];
+
+  XCTAssertFalse(self.array.isKeyOrdered);
+  NSArray *expected = @[@"a", @"c", @"b"];
+  XCTAssertEqualObjects([self arrayKeys], expected);
+  XCTAssertEqual([self.array indexForKey:@"b"], 2);
+
+  [self addKey:@"d" previousKey:nil];
+  expected = @[@"d", @"a", @"c", @"b"];
+  XCTAssertEqualObjects([self arrayKeys], expected);
+
+  [self.array invalidate];
+  XCTAssert(self.array.isKeyOrdered);
+  XCTAssertEqual(self.array.count, 0);
+}
+
+- (void)testInvalidateRemovesEveryKeyLastFirst {
+  NSString *previous = nil;
+  for (NSUInteger i = 0; i < 5000; i++) {
+    NSString *key = [NSString stringWithFormat:@"key%05lu", (unsigned long)i];
+    [self addKey:key previousKey:previous];
+    previous = key;
+  }
+
+  __block NSUInteger expectedIndex = 5000;
+  __block BOOL matches = YES;
+  self.arrayDelegate.didRemoveObject = ^(id<FUICollection> array, id object, NSUInteger index) {
+    expectedIndex--;
+    NSString *expectedKey = [NSString stringWithFormat:@"key%05lu", (unsigned long)expectedIndex];
+    matches = matches && index == expectedIndex && [[object key] isEqualToString:expectedKey] &&
+        array.count == index;
+  };
+  [self.array invalidate];
+
+  XCTAssert(matches, @"expected one removal per key, from the last key to the first");
+  XCTAssertEqual(expectedIndex, 0);
+  XCTAssertEqual(self.array.count, 0);
+}
+
+- (void)testFallsBackOnMove {
+  [self addKey:@"a" previousKey:nil];
+  [self addKey:@"b" previousKey:@"a"];
+  [self.observable sendEvent:FIRDataEventTypeChildMoved
+                  withObject:[FUIFakeSnapshot snapWithKey:@"a" value:@"a"]
+                 previousKey:@"b"
+                       error:nil];
+
+  XCTAssertFalse(self.array.isKeyOrdered);
+  NSArray *expected = @[@"b", @"a"];
+  XCTAssertEqualObjects([self arrayKeys], expected);
+}
+
+@end
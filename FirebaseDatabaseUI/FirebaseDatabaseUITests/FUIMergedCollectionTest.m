@@ -0,0 +1,216 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+@interface FUIMergedCollectionTest : XCTestCase
+@property (nonatomic) FUITestObservable *first;
+@property (nonatomic) FUITestObservable *second;
+@property (nonatomic) FUIMergedCollection *merged;
+@property (nonatomic) FUIArrayTestDelegate *mergedDelegate;
+// The merged collection's keys as rebuilt from its delegate events.
+@property (nonatomic) NSMutableArray<NSString *> *mirror;
+@end
+
+@implementation FUIMergedCollectionTest
+
+- (void)setUp {
+  [super setUp];
+  self.first = [[FUITestObservable alloc] init];
+  self.second = [[FUITestObservable alloc] init];
+  self.mergedDelegate = [[FUIArrayTestDelegate alloc] init];
+  self.merged = [[FUIMergedCollection alloc] initWithQueries:@[self.first, self.second]
+                                                    delegate:self.mergedDelegate
+                                              sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                                 FIRDataSnapshot *right) {
+    return [left.value compare:right.value];
+  }];
+
+  self.mirror = [NSMutableArray array];
+  __weak typeof(self) weakSelf = self;
+  self.mergedDelegate.didAddObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    [weakSelf.mirror insertObject:[object key] atIndex:index];
+  };
+  self.mergedDelegate.didRemoveObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    [weakSelf.mirror removeObjectAtIndex:index];
+  };
+  self.mergedDelegate.didMoveObject = ^(id<FUICollection> collection, id object,
+                                        NSUInteger fromIndex, NSUInteger toIndex) {
+    [weakSelf.mirror removeObjectAtIndex:fromIndex];
+    [weakSelf.mirror insertObject:[object key] atIndex:toIndex];
+  };
+
+  [self.merged observeQuery];
+}
+
+- (void)tearDown {
+  [self.merged invalidate];
+  [super tearDown];
+}
+
+- (NSArray<NSString *> *)mergedKeys {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  for (FIRDataSnapshot *snapshot in self.merged.items) {
+    [keys addObject:snapshot.key];
+  }
+  return keys;
+}
+
+- (void)sendValueEvent:(FUITestObservable *)observable {
+  [observable sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+- (void)testMergesInOrder {
+  [self.first addObject:@1 forKey:@"a1"];
+  [self.first addObject:@5 forKey:@"a5"];
+  [self.second addObject:@3 forKey:@"b3"];
+  [self.second addObject:@0 forKey:@"b0"];
+  [self.second addObject:@7 forKey:@"b7"];
+
+  NSArray *expected = @[@"b0", @"a1", @"b3", @"a5", @"b7"];
+  XCTAssertEqualObjects([self mergedKeys], expected);
+  XCTAssertEqualObjects(self.mirror, expected);
+  XCTAssertEqual([self.merged indexForKey:@"b3" inQuery:self.second], 2);
+  XCTAssertEqual([self.merged indexForKey:@"b3" inQuery:self.first], NSNotFound);
+  XCTAssertEqual([self.merged queryForItemAtIndex:1], self.first);
+}
+
+- (void)testEqualChildrenAreOrderedByQueryThenKey {
+  [self.second addObject:@1 forKey:@"a"];
+  [self.first addObject:@1 forKey:@"z"];
+  [self.first addObject:@1 forKey:@"y"];
+
+  NSArray *expected = @[@"y", @"z", @"a"];
+  XCTAssertEqualObjects([self mergedKeys], expected);
+  XCTAssertEqualObjects(self.mirror, expected);
+}
+
+- (void)testReorderingChangeIsSentAsChangeAndMove {
+  [self.first addObject:@1 forKey:@"a1"];
+  [self.second addObject:@2 forKey:@"b2"];
+  [self.first addObject:@3 forKey:@"a3"];
+
+  __block NSUInteger changedIndex = NSNotFound;
+  self.mergedDelegate.didChangeObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    changedIndex = index;
+  };
+
+  [self.first changeObject:@10 forKey:@"a1"];
+  XCTAssertEqual(changedIndex, 0);
+  NSArray *expected = @[@"b2", @"a3", @"a1"];
+  XCTAssertEqualObjects([self mergedKeys], expected);
+  XCTAssertEqualObjects(self.mirror, expected);
+
+  [self.second changeObject:@4 forKey:@"b2"];
+  XCTAssertEqual(changedIndex, 0);
+  expected = @[@"a3", @"b2", @"a1"];
+  XCTAssertEqualObjects(self.mirror, expected);
+
+  // A change that keeps the order doesn't move.
+  [self.first changeObject:@11 forKey:@"a1"];
+  XCTAssertEqual(changedIndex, 2);
+  XCTAssertEqualObjects(self.mirror, expected);
+}
+
+- (void)testRemovals {
+  [self.first addObject:@1 forKey:@"a1"];
+  [self.second addObject:@2 forKey:@"b2"];
+  [self.first addObject:@3 forKey:@"a3"];
+
+  [self.first removeObjectForKey:@"a1"];
+  NSArray *expected = @[@"b2", @"a3"];
+  XCTAssertEqualObjects([self mergedKeys], expected);
+  XCTAssertEqualObjects(self.mirror, expected);
+}
+
+- (void)testAddingAndRemovingQueries {
+  [self.first addObject:@1 forKey:@"a1"];
+  [self.second addObject:@2 forKey:@"b2"];
+  [self.first addObject:@3 forKey:@"a3"];
+  [self.second addObject:@4 forKey:@"b4"];
+  [self sendValueEvent:self.second];
+
+  __block NSUInteger batches = 0;
+  self.mergedDelegate.didStartUpdates = ^{
+    batches++;
+  };
+  [self.merged removeQuery:self.second];
+  XCTAssertEqual(batches, 1);
+  NSArray *expected = @[@"a1", @"a3"];
+  XCTAssertEqualObjects([self mergedKeys], expected);
+  XCTAssertEqualObjects(self.mirror, expected);
+  XCTAssertEqual(self.merged.queries.count, 1);
+
+  // The removed query's listeners are gone.
+  [self.second addObject:@0 forKey:@"b0"];
+  XCTAssertEqualObjects(self.mirror, expected);
+
+  FUITestObservable *third = [[FUITestObservable alloc] init];
+  [self.merged addQuery:third];
+  [third addObject:@2 forKey:@"c2"];
+  expected = @[@"a1", @"c2", @"a3"];
+  XCTAssertEqualObjects(self.mirror, expected);
+  XCTAssertEqual([self.merged queryForItemAtIndex:1], third);
+}
+
+- (void)testInvalidateRemovesEverything {
+  [self.first addObject:@1 forKey:@"a1"];
+  [self.second addObject:@2 forKey:@"b2"];
+  [self.merged invalidate];
+  XCTAssertEqual(self.merged.count, 0);
+  XCTAssertEqual(self.mirror.count, 0);
+
+  [self.first addObject:@3 forKey:@"a3"];
+  XCTAssertEqual(self.merged.count, 0);
+}
+
+- (void)testRandomWorkloadStaysSorted {
+  NSArray<FUITestObservable *> *queries = @[self.first, self.second];
+  NSMutableArray<NSMutableArray<NSString *> *> *keys = [@[[NSMutableArray array],
+                                                          [NSMutableArray array]] mutableCopy];
+  srand48(11);
+  for (NSInteger step = 0; step < 1500; step++) {
+    NSUInteger q = lrand48() % 2;
+    double roll = drand48();
+    if (roll < 0.5 || keys[q].count == 0) {
+      NSString *key = [NSString stringWithFormat:@"%lu-%ld", (unsigned long)q, (long)step];
+      [keys[q] addObject:key];
+      [queries[q] addObject:@(lrand48() % 100) forKey:key];
+    } else if (roll < 0.8) {
+      [queries[q] changeObject:@(lrand48() % 100) forKey:keys[q][lrand48() % keys[q].count]];
+    } else {
+      NSUInteger index = lrand48() % keys[q].count;
+      [queries[q] removeObjectForKey:keys[q][index]];
+      [keys[q] removeObjectAtIndex:index];
+    }
+  }
+
+  XCTAssertEqualObjects(self.mirror, [self mergedKeys]);
+  XCTAssertEqual(self.merged.count, keys[0].count + keys[1].count);
+  NSArray<FIRDataSnapshot *> *items = self.merged.items;
+  for (NSUInteger i = 1; i < items.count; i++) {
+    XCTAssertNotEqual([items[i - 1].value compare:items[i].value], NSOrderedDescending);
+  }
+}
+
+@end
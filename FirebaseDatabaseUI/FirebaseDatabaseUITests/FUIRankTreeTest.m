@@ -0,0 +1,181 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+
+@interface FUIRankTreeTest : XCTestCase
+@property (nonatomic) FUIRankTree *tree;
+@end
+
+@implementation FUIRankTreeTest
+
+- (void)setUp {
+  [super setUp];
+  self.tree = [[FUIRankTree alloc] init];
+}
+
+- (void)testEmptyTreeRejectsEveryIndex {
+  XCTAssertThrowsSpecificNamed([self.tree removeWeightAtIndex:0], NSException, NSRangeException);
+  XCTAssertThrowsSpecificNamed([self.tree setWeight:1 atIndex:0], NSException, NSRangeException);
+  XCTAssertThrowsSpecificNamed([self.tree weightAtIndex:0], NSException, NSRangeException);
+  XCTAssertThrowsSpecificNamed([self.tree removeWeightAtIndex:NSUIntegerMax], NSException,
+                               NSRangeException);
+
+  // The failed calls mustn't have disturbed the tree.
+  XCTAssertEqual(self.tree.count, 0);
+  XCTAssertEqual(self.tree.totalWeight, 0);
+  [self.tree insertWeight:3 atIndex:0];
+  XCTAssertEqual(self.tree.count, 1);
+  XCTAssertEqual(self.tree.totalWeight, 3);
+  XCTAssertEqual([self.tree indexContainingWeightOffset:2], 0);
+}
+
+- (void)testIndexEqualToCountIsRejected {
+  [self.tree insertWeight:1 atIndex:0];
+  [self.tree insertWeight:0 atIndex:1];
+
+  XCTAssertThrowsSpecificNamed([self.tree removeWeightAtIndex:2], NSException, NSRangeException);
+  XCTAssertThrowsSpecificNamed([self.tree setWeight:1 atIndex:2], NSException, NSRangeException);
+  XCTAssertThrowsSpecificNamed([self.tree insertWeight:1 atIndex:3], NSException, NSRangeException);
+  XCTAssertNoThrow([self.tree insertWeight:1 atIndex:2]);
+
+  [self.tree removeWeightAtIndex:2];
+  [self.tree removeWeightAtIndex:1];
+  [self.tree removeWeightAtIndex:0];
+  XCTAssertEqual(self.tree.count, 0);
+  XCTAssertEqual(self.tree.totalWeight, 0);
+  XCTAssertThrowsSpecificNamed([self.tree removeWeightAtIndex:0], NSException, NSRangeException);
+}
+
+- (void)testPrefixSumsFollowInsertsRemovesAndReweighs {
+  NSMutableArray<NSNumber *> *weights = [NSMutableArray array];
+  srand48(47);
+  for (NSInteger step = 0; step < 2000; step++) {
+    NSUInteger count = weights.count;
+    long choice = lrand48() % 3;
+    if (choice == 0 || count == 0) {
+      NSUInteger index = (NSUInteger)lrand48() % (count + 1);
+      NSUInteger weight = (NSUInteger)lrand48() % 3;
+      [self.tree insertWeight:weight atIndex:index];
+      [weights insertObject:@(weight) atIndex:index];
+    } else if (choice == 1) {
+      NSUInteger index = (NSUInteger)lrand48() % count;
+      [self.tree removeWeightAtIndex:index];
+      [weights removeObjectAtIndex:index];
+    } else {
+      NSUInteger index = (NSUInteger)lrand48() % count;
+      NSUInteger weight = (NSUInteger)lrand48() % 3;
+      [self.tree setWeight:weight atIndex:index];
+      weights[index] = @(weight);
+    }
+  }
+
+  XCTAssertEqual(self.tree.count, weights.count);
+  NSUInteger sum = 0;
+  for (NSUInteger i = 0; i < weights.count; i++) {
+    XCTAssertEqual([self.tree weightBeforeIndex:i], sum);
+    XCTAssertEqual([self.tree weightAtIndex:i], weights[i].unsignedIntegerValue);
+    sum += weights[i].unsignedIntegerValue;
+  }
+  XCTAssertEqual(self.tree.totalWeight, sum);
+  XCTAssertEqual([self.tree indexContainingWeightOffset:sum], NSNotFound);
+}
+
+- (void)testObjectsKeepASortedListSearchable {
+  NSMutableArray<NSNumber *> *numbers = [NSMutableArray array];
+  srand48(49);
+  for (NSInteger step = 0; step < 2000; step++) {
+    if (numbers.count == 0 || lrand48() % 3 != 0) {
+      NSNumber *number = @(lrand48() % 500);
+      NSUInteger index = [self.tree indexOfFirstObjectPassingTest:^BOOL(NSNumber *object) {
+        return [object compare:number] != NSOrderedAscending;
+      }];
+      NSUInteger expected = [numbers indexOfObject:number
+                                     inSortedRange:NSMakeRange(0, numbers.count)
+                                           options:NSBinarySearchingInsertionIndex |
+                                                   NSBinarySearchingFirstEqual
+                                   usingComparator:^NSComparisonResult(id a, id b) {
+                                     return [a compare:b];
+                                   }];
+      XCTAssertEqual(index, expected);
+      [self.tree insertObject:number weight:1 atIndex:index];
+      [numbers insertObject:number atIndex:index];
+    } else {
+      NSUInteger index = (NSUInteger)lrand48() % numbers.count;
+      [self.tree removeWeightAtIndex:index];
+      [numbers removeObjectAtIndex:index];
+    }
+  }
+
+  XCTAssertEqual(self.tree.count, numbers.count);
+  XCTAssertEqual(self.tree.totalWeight, numbers.count);
+  XCTAssertEqualObjects([self.tree allObjects], numbers);
+  for (NSUInteger i = 0; i < numbers.count; i++) {
+    XCTAssertEqualObjects([self.tree objectAtIndex:i], numbers[i]);
+  }
+  XCTAssertEqual([self.tree indexOfFirstObjectPassingTest:^BOOL(id object) { return NO; }],
+                 numbers.count);
+  XCTAssertThrowsSpecificNamed([self.tree objectAtIndex:numbers.count], NSException,
+                               NSRangeException);
+}
+
+- (void)testRemovedObjectsAreReleased {
+  __weak id weakObject = nil;
+  @autoreleasepool {
+    NSObject *object = [[NSObject alloc] init];
+    weakObject = object;
+    [self.tree insertWeight:0 atIndex:0];
+    [self.tree insertObject:object weight:1 atIndex:1];
+    XCTAssertNil([self.tree objectAtIndex:0]);
+    XCTAssertEqual([self.tree objectAtIndex:1], object);
+    XCTAssertEqualObjects([self.tree allObjects], (@[ [NSNull null], object ]));
+    [self.tree removeWeightAtIndex:1];
+  }
+  XCTAssertNil(weakObject);
+}
+
+- (void)testReplacingAllWeightsBuildsAUsableTree {
+  [self.tree insertWeight:5 atIndex:0];
+  [self.tree replaceAllWeightsWithCount:1000 weights:^NSUInteger(NSUInteger index) {
+    return index % 3 == 0 ? 1 : 0;
+  }];
+  XCTAssertEqual(self.tree.count, 1000);
+  XCTAssertEqual(self.tree.totalWeight, 334);
+  for (NSUInteger i = 0; i < 1000; i++) {
+    XCTAssertEqual([self.tree weightBeforeIndex:i], (i + 2) / 3);
+  }
+  XCTAssertEqual([self.tree indexContainingWeightOffset:100], 300);
+
+  // Later edits keep working on the bulk-built tree.
+  [self.tree removeWeightAtIndex:0];
+  [self.tree insertWeight:2 atIndex:500];
+  XCTAssertEqual(self.tree.count, 1000);
+  XCTAssertEqual(self.tree.totalWeight, 335);
+
+  [self.tree replaceAllWeightsWithCount:0 weights:^NSUInteger(NSUInteger index) {
+    return 1;
+  }];
+  XCTAssertEqual(self.tree.count, 0);
+  XCTAssertEqual(self.tree.totalWeight, 0);
+}
+
+@end
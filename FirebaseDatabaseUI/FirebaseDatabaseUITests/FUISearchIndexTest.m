@@ -0,0 +1,248 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+// A fixed list of snapshots, for indexing more items than an FUIArray can be loaded
+// with quickly.
+@interface FUIStaticTestCollection : NSObject <FUICollection>
+- (instancetype)initWithItems:(NSArray<FIRDataSnapshot *> *)items;
+@end
+
+@implementation FUIStaticTestCollection
+
+@synthesize items = _items;
+@synthesize delegate = _delegate;
+
+- (instancetype)initWithItems:(NSArray<FIRDataSnapshot *> *)items {
+  self = [super init];
+  if (self != nil) {
+    _items = [items copy];
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return self.items.count;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index {
+  return self.items[index];
+}
+
+- (void)observeQuery {}
+
+- (void)invalidate {}
+
+@end
+
+@interface FUISearchIndexTest : XCTestCase
+@property (nonatomic) FUITestObservable *observable;
+@property (nonatomic) FUIArray *array;
+@property (nonatomic) FUISearchIndex *index;
+@end
+
+@implementation FUISearchIndexTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUITestObservable alloc] init];
+  self.array = [[FUIArray alloc] initWithQuery:self.observable];
+  self.index = [[FUISearchIndex alloc] initWithCollection:self.array
+                                          textForSnapshot:^NSString *(FIRDataSnapshot *snapshot) {
+    return snapshot.value;
+  }];
+  [self.index observeQuery];
+
+  [self.observable addObject:@"Anna Smith" forKey:@"1"];
+  [self.observable addObject:@"Annabel Jones" forKey:@"2"];
+  [self.observable addObject:@"José Smithers" forKey:@"3"];
+  [self.observable addObject:@"Bob" forKey:@"4"];
+}
+
+- (void)tearDown {
+  [self.index invalidate];
+  [super tearDown];
+}
+
+- (void)testPrefixQueries {
+  NSSet *expected = [NSSet setWithObjects:@"1", @"2", nil];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"ann"], expected);
+
+  expected = [NSSet setWithObject:@"1"];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"ann sm"], expected);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"SMITH anna"], expected);
+
+  expected = [NSSet setWithObjects:@"1", @"3", nil];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"smith"], expected);
+
+  XCTAssertEqual([self.index keysMatchingQuery:@"annx"].count, 0);
+  XCTAssertEqual([self.index keysMatchingQuery:@""].count, 4);
+
+  XCTAssert([self.index itemWithKey:@"2" matchesQuery:@"jon"]);
+  XCTAssertFalse([self.index itemWithKey:@"2" matchesQuery:@"bob"]);
+}
+
+- (void)testIgnoresCaseAndDiacritics {
+  NSSet *expected = [NSSet setWithObject:@"3"];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"jose"], expected);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"JOSÉ"], expected);
+}
+
+- (void)testFollowsChangesAndRemovals {
+  NSUInteger terms = self.index.termCount;
+
+  [self.observable changeObject:@"Robert" forKey:@"4"];
+  XCTAssertEqual([self.index keysMatchingQuery:@"bob"].count, 0);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"rob"], [NSSet setWithObject:@"4"]);
+  XCTAssertEqual(self.index.termCount, terms);
+
+  [self.observable removeObjectForKey:@"2"];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"ann"], [NSSet setWithObject:@"1"]);
+  XCTAssertEqual(self.index.termCount, terms - 2);
+}
+
+- (void)testTermsChangedBetweenQueries {
+  NSUInteger terms = self.index.termCount;
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"bob"], [NSSet setWithObject:@"4"]);
+
+  // Words that come and go between queries mustn't be left behind or lost.
+  [self.observable changeObject:@"Zed" forKey:@"4"];
+  [self.observable changeObject:@"Bob Zed" forKey:@"4"];
+  [self.observable changeObject:@"Bob" forKey:@"4"];
+  [self.observable addObject:@"Aaron" forKey:@"5"];
+  [self.observable removeObjectForKey:@"3"];
+  [self.observable addObject:@"José" forKey:@"3"];
+
+  XCTAssertEqual(self.index.termCount, terms);
+  XCTAssertEqual([self.index keysMatchingQuery:@"zed"].count, 0);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"bob"], [NSSet setWithObject:@"4"]);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"jos"], [NSSet setWithObject:@"3"]);
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"smith"], [NSSet setWithObject:@"1"]);
+  NSSet *expected = [NSSet setWithObjects:@"1", @"2", @"5", nil];
+  XCTAssertEqualObjects([self.index keysMatchingQuery:@"a"], expected);
+}
+
+- (void)testIndexesExistingItems {
+  FUISearchIndex *index =
+      [[FUISearchIndex alloc] initWithCollection:self.array
+                                 textForSnapshot:^NSString *(FIRDataSnapshot *snapshot) {
+    return snapshot.value;
+  }];
+  NSSet *expected = [NSSet setWithObjects:@"1", @"2", nil];
+  XCTAssertEqualObjects([index keysMatchingQuery:@"ann"], expected);
+}
+
+- (void)testLiveResults {
+  FUIFilteredCollection *results = [self.index collectionMatchingQuery:@"smi"];
+  FUIArrayTestDelegate *delegate = [[FUIArrayTestDelegate alloc] init];
+  results.delegate = delegate;
+  [results observeQuery];
+  XCTAssertEqual(results.count, 2);
+  XCTAssertEqualObjects([results snapshotAtIndex:0].key, @"1");
+  XCTAssertEqualObjects([results snapshotAtIndex:1].key, @"3");
+
+  __block NSUInteger addedIndex = NSNotFound;
+  delegate.didAddObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    addedIndex = index;
+  };
+  __block NSUInteger removedIndex = NSNotFound;
+  delegate.didRemoveObject = ^(id<FUICollection> collection, id object, NSUInteger index) {
+    removedIndex = index;
+  };
+
+  [self.observable changeObject:@"Bob Smith" forKey:@"4"];
+  XCTAssertEqual(addedIndex, 2);
+  [self.observable changeObject:@"Anna" forKey:@"1"];
+  XCTAssertEqual(removedIndex, 0);
+  XCTAssertEqual(results.count, 2);
+
+  // Invalidating the results leaves the indexed array alone.
+  [results invalidate];
+  XCTAssertEqual(results.count, 0);
+  XCTAssertEqual(self.array.count, 4);
+}
+
+// Observing live results finds the items already present from the index's postings,
+// without matching each of the 100k items against the query.
+- (void)testLiveResultsPerformance {
+  NSUInteger count = 100000;
+  NSMutableArray<FIRDataSnapshot *> *items = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    NSString *value = [NSString stringWithFormat:@"user%lu team%lu",
+                       (unsigned long)i, (unsigned long)(i % 100)];
+    [items addObject:(FIRDataSnapshot *)[FUIFakeSnapshot snapWithKey:@(i).stringValue value:value]];
+  }
+  FUIStaticTestCollection *collection = [[FUIStaticTestCollection alloc] initWithItems:items];
+  FUISearchIndex *index =
+      [[FUISearchIndex alloc] initWithCollection:collection
+                                 textForSnapshot:^NSString *(FIRDataSnapshot *snapshot) {
+    return snapshot.value;
+  }];
+  XCTAssertEqual(index.termCount, count + 100);
+
+  NSMutableArray<NSString *> *expected = [NSMutableArray array];
+  for (NSUInteger i = 12340; i < 12350; i++) {
+    [expected addObject:@(i).stringValue];
+  }
+  [self measureBlock:^{
+    FUIFilteredCollection *results = [index collectionMatchingQuery:@"user1234 team4"];
+    [results observeQuery];
+    XCTAssertEqualObjects([results.items valueForKey:@"key"], expected);
+    [results invalidate];
+  }];
+}
+
+- (void)testMatchesBruteForce {
+  NSArray<NSString *> *names = @[@"alpha", @"alps", @"beta", @"bet", @"gamma", @"gam", @"delta"];
+  srand48(3);
+  NSMutableDictionary<NSString *, NSString *> *values = [NSMutableDictionary dictionary];
+  for (NSUInteger i = 0; i < 3000; i++) {
+    NSString *key = [NSString stringWithFormat:@"item%lu", (unsigned long)i];
+    NSString *value = [NSString stringWithFormat:@"%@ %@",
+                       names[lrand48() % names.count], names[lrand48() % names.count]];
+    values[key] = value;
+    [self.observable addObject:value forKey:key];
+  }
+
+  for (NSString *query in @[@"al", @"alp", @"be gam", @"delta alpha", @"gamma"]) {
+    NSArray<NSString *> *words = [query componentsSeparatedByString:@" "];
+    NSMutableSet<NSString *> *expected = [NSMutableSet set];
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+      NSArray<NSString *> *valueWords = [value componentsSeparatedByString:@" "];
+      for (NSString *word in words) {
+        BOOL found = NO;
+        for (NSString *valueWord in valueWords) {
+          found = found || [valueWord hasPrefix:word];
+        }
+        if (!found) { return; }
+      }
+      [expected addObject:key];
+    }];
+    NSMutableSet<NSString *> *actual = [[self.index keysMatchingQuery:query] mutableCopy];
+    [actual minusSet:[NSSet setWithObjects:@"1", @"2", @"3", @"4", nil]];
+    XCTAssertEqualObjects(actual, expected, @"%@", query);
+  }
+}
+
+@end
@@ -0,0 +1,386 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+@import XCTest;
+@import FirebaseDatabaseUI;
+
+#import "FUIDatabaseTestUtils.h"
+
+// Follows each child event with a value event, which ends the array's batch of
+// updates the way the database does, unless batches are held open.
+@interface FUIBatchingTestObservable : FUITestObservable
+@property (nonatomic, assign) BOOL holdsBatches;
+- (void)endBatch;
+@end
+
+@implementation FUIBatchingTestObservable
+
+- (void)sendEvent:(FIRDataEventType)event
+       withObject:(FUIFakeSnapshot *)object
+      previousKey:(NSString *)string
+            error:(NSError *)error {
+  [super sendEvent:event withObject:object previousKey:string error:error];
+  if (event != FIRDataEventTypeValue && error == nil && !self.holdsBatches) {
+    [self endBatch];
+  }
+}
+
+- (void)endBatch {
+  [super sendEvent:FIRDataEventTypeValue withObject:nil previousKey:nil error:nil];
+}
+
+@end
+
+@interface FUISectionedCollectionTest : XCTestCase <FUISectionedCollectionDelegate>
+@property (nonatomic) FUIBatchingTestObservable *observable;
+@property (nonatomic) FUIArray *array;
+@property (nonatomic) FUISectionedCollection *sections;
+// The sections' item keys as rebuilt from changesets.
+@property (nonatomic) NSMutableArray<NSMutableArray<NSString *> *> *mirror;
+@property (nonatomic) NSMutableArray<FUISectionChangeset *> *changesets;
+@end
+
+@implementation FUISectionedCollectionTest
+
+- (void)setUp {
+  [super setUp];
+  self.observable = [[FUIBatchingTestObservable alloc] init];
+  self.array = [[FUIArray alloc] initWithQuery:self.observable];
+  self.sections = [[FUISectionedCollection alloc] initWithCollection:self.array
+                                                          sectionKey:^NSString *(FIRDataSnapshot *snapshot) {
+    return snapshot.value;
+  }];
+  self.sections.delegate = self;
+  self.mirror = [NSMutableArray array];
+  self.changesets = [NSMutableArray array];
+  [self.sections observeQuery];
+}
+
+- (void)tearDown {
+  [self.sections invalidate];
+  [super tearDown];
+}
+
+// Applies changesets the way UITableView and UICollectionView batch updates do.
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+          didApplyChangeset:(FUISectionChangeset *)changeset {
+  [self.changesets addObject:changeset];
+  // Reloaded items are given by their index paths before the changeset, and aren't
+  // deleted by it.
+  NSMutableArray<NSString *> *reloadedKeys = [NSMutableArray array];
+  for (NSIndexPath *indexPath in changeset.reloadedItems) {
+    XCTAssertFalse([changeset.deletedSections containsIndex:[indexPath indexAtPosition:0]]);
+    XCTAssertFalse([changeset.deletedItems containsObject:indexPath]);
+    [reloadedKeys addObject:self.mirror[[indexPath indexAtPosition:0]][[indexPath indexAtPosition:1]]];
+  }
+  NSArray *deletedItems = [changeset.deletedItems sortedArrayUsingSelector:@selector(compare:)];
+  for (NSIndexPath *indexPath in deletedItems.reverseObjectEnumerator) {
+    [self.mirror[[indexPath indexAtPosition:0]] removeObjectAtIndex:[indexPath indexAtPosition:1]];
+  }
+  [self.mirror removeObjectsAtIndexes:changeset.deletedSections];
+  NSIndexSet *insertedSections = changeset.insertedSections;
+  for (NSUInteger section = insertedSections.firstIndex;
+       section != NSNotFound;
+       section = [insertedSections indexGreaterThanIndex:section]) {
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    NSUInteger count = [collection numberOfItemsInSection:section];
+    for (NSUInteger item = 0; item < count; item++) {
+      [keys addObject:[collection snapshotAtIndexPath:[self indexPathForSection:section item:item]].key];
+    }
+    [self.mirror insertObject:keys atIndex:section];
+  }
+  NSArray *insertedItems = [changeset.insertedItems sortedArrayUsingSelector:@selector(compare:)];
+  for (NSIndexPath *indexPath in insertedItems) {
+    NSString *key = [collection snapshotAtIndexPath:indexPath].key;
+    [self.mirror[[indexPath indexAtPosition:0]] insertObject:key
+                                                    atIndex:[indexPath indexAtPosition:1]];
+  }
+  for (NSString *key in reloadedKeys) {
+    XCTAssertNotEqual([self.array indexForKey:key], NSNotFound);
+  }
+}
+
+- (NSIndexPath *)indexPathForSection:(NSUInteger)section item:(NSUInteger)item {
+  NSUInteger indexes[] = { section, item };
+  return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+- (void)sendEvent:(FIRDataEventType)event
+              key:(NSString *)key
+            value:(NSString *)value
+      previousKey:(NSString *)previousKey {
+  [self.observable sendEvent:event
+                  withObject:[FUIFakeSnapshot snapWithKey:key value:value]
+                 previousKey:previousKey
+                       error:nil];
+}
+
+// The array's items grouped by hand into runs of equal values.
+- (NSArray<NSArray<NSString *> *> *)expectedSections {
+  NSMutableArray<NSMutableArray<NSString *> *> *sections = [NSMutableArray array];
+  NSString *previousValue = nil;
+  for (FIRDataSnapshot *snapshot in self.array.items) {
+    if (![snapshot.value isEqual:previousValue]) {
+      [sections addObject:[NSMutableArray array]];
+      previousValue = snapshot.value;
+    }
+    [sections.lastObject addObject:snapshot.key];
+  }
+  return sections;
+}
+
+- (void)assertSectionsMatch {
+  NSArray<NSArray<NSString *> *> *expected = [self expectedSections];
+  XCTAssertEqualObjects(self.mirror, expected);
+  XCTAssertEqual(self.sections.numberOfSections, expected.count);
+  NSUInteger collectionIndex = 0;
+  for (NSUInteger section = 0; section < expected.count; section++) {
+    XCTAssertEqual([self.sections numberOfItemsInSection:section], expected[section].count);
+    XCTAssertEqualObjects(self.sections.itemCountsBySection[section], @(expected[section].count));
+    for (NSUInteger item = 0; item < expected[section].count; item++) {
+      NSIndexPath *indexPath = [self indexPathForSection:section item:item];
+      FIRDataSnapshot *snapshot = [self.sections snapshotAtIndexPath:indexPath];
+      XCTAssertEqualObjects(snapshot.key, expected[section][item]);
+      XCTAssertEqualObjects([self.sections keyForSection:section], snapshot.value);
+      XCTAssertEqual([self.sections collectionIndexForIndexPath:indexPath], collectionIndex);
+      XCTAssertEqualObjects([self.sections indexPathForCollectionIndex:collectionIndex], indexPath);
+      collectionIndex++;
+    }
+  }
+  XCTAssertNil([self.sections indexPathForCollectionIndex:collectionIndex]);
+}
+
+- (void)testGroupsAdjacentItemsIntoSections {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"b", @"b", @"b", @"c" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+
+  XCTAssertEqual(self.sections.numberOfSections, 3);
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @2, @3, @1 ]));
+  XCTAssertEqualObjects([self.sections keyForSection:1], @"b");
+  [self assertSectionsMatch];
+}
+
+- (void)testInsertingIntoAnotherSectionSplitsIt {
+  for (NSUInteger i = 0; i < 4; i++) {
+    [self.observable addObject:@"a" forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+  [self.changesets removeAllObjects];
+
+  [self sendEvent:FIRDataEventTypeChildAdded key:@"x" value:@"b" previousKey:@"k1"];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  FUISectionChangeset *changeset = self.changesets.firstObject;
+  XCTAssertEqualObjects(changeset.deletedItems,
+                        (@[ [self indexPathForSection:0 item:2], [self indexPathForSection:0 item:3] ]));
+  XCTAssertEqualObjects(changeset.insertedSections, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 2)]);
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @2, @1, @2 ]));
+  [self assertSectionsMatch];
+}
+
+- (void)testRemovingASectionMergesItsNeighbours {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"b", @"a" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+  [self.changesets removeAllObjects];
+
+  [self.observable removeObjectForKey:@"k2"];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  FUISectionChangeset *changeset = self.changesets.firstObject;
+  XCTAssertEqualObjects(changeset.deletedSections, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 2)]);
+  XCTAssertEqualObjects(changeset.insertedItems, @[ [self indexPathForSection:0 item:2] ]);
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, @[ @3 ]);
+  [self assertSectionsMatch];
+}
+
+- (void)testChangesWithinASectionAreReloads {
+  [self.observable addObject:@"a" forKey:@"k0"];
+  [self.observable addObject:@"a" forKey:@"k1"];
+  [self.changesets removeAllObjects];
+
+  [self sendEvent:FIRDataEventTypeChildChanged key:@"k1" value:@"a" previousKey:@"k0"];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  XCTAssertEqualObjects(self.changesets.firstObject.reloadedItems, @[ [self indexPathForSection:0 item:1] ]);
+  XCTAssertEqual(self.changesets.firstObject.insertedSections.count, 0);
+  [self assertSectionsMatch];
+}
+
+- (void)testChangingTheSectionKeyMovesTheItem {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"a", @"b" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+
+  [self sendEvent:FIRDataEventTypeChildChanged key:@"k1" value:@"c" previousKey:@"k0"];
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @1, @1, @1, @1 ]));
+  [self assertSectionsMatch];
+
+  [self sendEvent:FIRDataEventTypeChildChanged key:@"k1" value:@"a" previousKey:@"k0"];
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @3, @1 ]));
+  [self assertSectionsMatch];
+}
+
+- (void)testMovesBetweenSections {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"b", @"b" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+
+  [self.changesets removeAllObjects];
+
+  [self sendEvent:FIRDataEventTypeChildMoved key:@"k0" value:@"a" previousKey:@"k3"];
+  XCTAssertEqual(self.changesets.count, 1);
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @1, @2, @1 ]));
+  [self assertSectionsMatch];
+}
+
+- (void)testChangingTheSectionKeyIsOneChangeset {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"a", @"b" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+  [self.changesets removeAllObjects];
+
+  // Splits the first section around the item, which leaves the old section with the
+  // items before it and inserts two sections.
+  [self sendEvent:FIRDataEventTypeChildChanged key:@"k1" value:@"c" previousKey:@"k0"];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  FUISectionChangeset *changeset = self.changesets.firstObject;
+  XCTAssertEqualObjects(changeset.deletedItems,
+                        (@[ [self indexPathForSection:0 item:1], [self indexPathForSection:0 item:2] ]));
+  XCTAssertEqualObjects(changeset.insertedSections, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 2)]);
+  XCTAssertEqual(changeset.deletedSections.count, 0);
+  [self assertSectionsMatch];
+}
+
+- (void)testBatchOfEventsIsOneChangeset {
+  NSArray<NSString *> *values = @[ @"a", @"a", @"b", @"c" ];
+  for (NSUInteger i = 0; i < values.count; i++) {
+    [self.observable addObject:values[i] forKey:[NSString stringWithFormat:@"k%lu", (unsigned long)i]];
+  }
+  [self.changesets removeAllObjects];
+
+  self.observable.holdsBatches = YES;
+  [self.observable removeObjectForKey:@"k2"];
+  [self.observable changeObject:@"a" forKey:@"k0"];
+  [self.observable addObject:@"c" forKey:@"k4"];
+  [self sendEvent:FIRDataEventTypeChildAdded key:@"k5" value:@"a" previousKey:@"k0"];
+  XCTAssertEqual(self.changesets.count, 0);
+  [self.observable endBatch];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  FUISectionChangeset *changeset = self.changesets.firstObject;
+  XCTAssertEqualObjects(changeset.deletedSections, [NSIndexSet indexSetWithIndex:1]);
+  XCTAssertEqual(changeset.insertedSections.count, 0);
+  XCTAssertEqualObjects(changeset.insertedItems,
+                        (@[ [self indexPathForSection:0 item:1], [self indexPathForSection:1 item:1] ]));
+  XCTAssertEqualObjects(changeset.reloadedItems, @[ [self indexPathForSection:0 item:0] ]);
+  XCTAssertEqualObjects(self.sections.itemCountsBySection, (@[ @3, @2 ]));
+  [self assertSectionsMatch];
+}
+
+- (void)testExistingItemsAreSentAsOneChangeset {
+  FUISectionedCollection *sections = [[FUISectionedCollection alloc] initWithCollection:self.array
+                                                                             sectionKey:^NSString *(FIRDataSnapshot *snapshot) {
+    return snapshot.value;
+  }];
+  [self.observable addObject:@"a" forKey:@"k0"];
+  [self.observable addObject:@"b" forKey:@"k1"];
+  [self.observable addObject:@"b" forKey:@"k2"];
+  [self.changesets removeAllObjects];
+  [self.mirror removeAllObjects];
+
+  // The array is already observed by self.sections, so only the new collection's
+  // own changeset is sent.
+  sections.delegate = self;
+  [sections observeQuery];
+
+  XCTAssertEqual(self.changesets.count, 1);
+  XCTAssertEqualObjects(self.changesets.firstObject.insertedSections,
+                        [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+  XCTAssertEqualObjects(sections.itemCountsBySection, (@[ @1, @2 ]));
+  XCTAssertEqualObjects(self.mirror, (@[ @[ @"k0" ], @[ @"k1", @"k2" ] ]));
+  sections.delegate = nil;
+}
+
+- (void)testInvalidateEmptiesSections {
+  [self.observable addObject:@"a" forKey:@"k0"];
+  [self.observable addObject:@"b" forKey:@"k1"];
+
+  [self.sections invalidate];
+
+  XCTAssertEqual(self.sections.numberOfSections, 0);
+  XCTAssertEqualObjects(self.mirror, @[]);
+}
+
+- (void)testRandomEventsKeepSectionsConsistent {
+  NSMutableArray<NSString *> *keys = [NSMutableArray array];
+  NSArray<NSString *> *values = @[ @"a", @"b", @"c" ];
+  // A fixed linear congruential sequence, so that failures can be reproduced.
+  uint32_t seed = 7;
+  // Events are sent in batches of one to eight, each combined into one changeset.
+  self.observable.holdsBatches = YES;
+  NSUInteger batchEnd = 0;
+  for (NSUInteger step = 0; step < 500; step++) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t r = (seed >> 8);
+    if (step == batchEnd) {
+      [self.observable endBatch];
+      [self assertSectionsMatch];
+      batchEnd = step + 1 + (r >> 20) % 8;
+    }
+    NSString *value = values[r % values.count];
+    NSUInteger operation = (r >> 4) % 10;
+    if (operation < 5 || keys.count == 0) {
+      NSUInteger index = (r >> 8) % (keys.count + 1);
+      NSString *key = [NSString stringWithFormat:@"k%lu", (unsigned long)step];
+      [self sendEvent:FIRDataEventTypeChildAdded key:key value:value
+          previousKey:index > 0 ? keys[index - 1] : nil];
+      [keys insertObject:key atIndex:index];
+    } else if (operation < 7) {
+      NSUInteger index = (r >> 8) % keys.count;
+      [self sendEvent:FIRDataEventTypeChildRemoved key:keys[index] value:value
+          previousKey:index > 0 ? keys[index - 1] : nil];
+      [keys removeObjectAtIndex:index];
+    } else if (operation < 8) {
+      NSUInteger index = (r >> 8) % keys.count;
+      [self sendEvent:FIRDataEventTypeChildChanged key:keys[index] value:value
+          previousKey:index > 0 ? keys[index - 1] : nil];
+    } else {
+      NSUInteger from = (r >> 8) % keys.count;
+      NSString *key = keys[from];
+      [keys removeObjectAtIndex:from];
+      NSUInteger to = (r >> 16) % (keys.count + 1);
+      [keys insertObject:key atIndex:to];
+      [self sendEvent:FIRDataEventTypeChildMoved key:key
+                value:[self.array snapshotAtIndex:[self.array indexForKey:key]].value
+          previousKey:to > 0 ? keys[to - 1] : nil];
+    }
+  }
+  [self.observable endBatch];
+  [self assertSectionsMatch];
+}
+
+@end
@@ -167,6 +167,50 @@
   XCTAssert(expectedParametersWereCorrect, @"unexpected parameter in delegate callback");
 }
 
+- (void)testThrottlingNeverHoldsBackReordering {
+  __block NSTimeInterval now = 0;
+  FUITestObservable *observable = [[FUITestObservable alloc] init];
+  FUISortedArray *array =
+      [[FUISortedArray alloc] initWithQuery:observable
+                                   delegate:self.arrayDelegate
+                             sortDescriptor:^NSComparisonResult(FIRDataSnapshot *left,
+                                                                FIRDataSnapshot *right) {
+    return [left.value compare:right.value];
+  }];
+  array.throttleClock = ^NSTimeInterval {
+    return now;
+  };
+  array.changeThrottleInterval = 1;
+  [array observeQuery];
+  [observable addObject:@"b" forKey:@"0"];
+  [observable addObject:@"d" forKey:@"1"];
+
+  __block NSInteger changes = 0;
+  __block NSInteger moves = 0;
+  self.arrayDelegate.didChangeObject = ^(FUISortedArray *array, id object, NSUInteger index) {
+    changes++;
+  };
+  self.arrayDelegate.didAddObject = ^(FUISortedArray *array, id object, NSUInteger index) {
+    moves++;
+  };
+
+  // Changes that keep the sort order are throttled.
+  [observable changeObject:@"c" forKey:@"0"];
+  [observable changeObject:@"c1" forKey:@"0"];
+  XCTAssertEqual(changes, 1);
+  XCTAssertEqual(moves, 0);
+
+  // A change that reorders the array is applied and sent right away.
+  [observable changeObject:@"e" forKey:@"0"];
+  XCTAssertEqual(moves, 1, @"expected reordering change to be sent immediately");
+  XCTAssertEqualObjects([array snapshotAtIndex:1].key, @"0");
+
+  now = 2;
+  [array flushThrottledChanges];
+  XCTAssertEqual(changes, 1, @"expected reordering to replace the held back change");
+  [observable removeAllObservers];
+}
+
 - (void)testItSortsItselfWhenChangingObjects {
   [self.observable removeAllObservers];
   self.array = [[FUISortedArray alloc] initWithQuery:self.observable
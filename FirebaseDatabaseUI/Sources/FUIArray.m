@@ -18,7 +18,100 @@
 
 // clang-format on
 
-#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIArray.h"
+#import "FirebaseDatabaseUI/Sources/FUIArray_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionMetrics_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+#import "FirebaseDatabaseUI/Sources/FUIVersionPublisher.h"
+
+/**
+ * Takes the place of a row's snapshot once payloadBudget evicts it. It keeps the row's
+ * key and ref, but no value, until the array reloads the row. snapshotAtIndex: returns
+ * it while the reload is in flight, but it's never included in items or published
+ * versions, and the only delegate events it's sent in are removals by invalidate.
+ */
+@interface FUIEvictedSnapshot : NSObject
+
+- (instancetype)initWithKey:(NSString *)key ref:(nullable FIRDatabaseReference *)ref;
+
+@property (nonatomic, readonly, copy) NSString *key;
+@property (nonatomic, readonly, nullable) FIRDatabaseReference *ref;
+
+@end
+
+@implementation FUIEvictedSnapshot
+
+- (instancetype)initWithKey:(NSString *)key ref:(FIRDatabaseReference *)ref {
+  self = [super init];
+  if (self != nil) {
+    _key = [key copy];
+    _ref = ref;
+  }
+  return self;
+}
+
+- (id)value {
+  return nil;
+}
+
+- (id)priority {
+  return nil;
+}
+
+- (id)valueInExportFormat {
+  return nil;
+}
+
+- (BOOL)exists {
+  return NO;
+}
+
+- (NSUInteger)childrenCount {
+  return 0;
+}
+
+- (BOOL)hasChildren {
+  return NO;
+}
+
+- (BOOL)hasChild:(NSString *)childPathString {
+  return NO;
+}
+
+- (NSEnumerator *)children {
+  return @[].objectEnumerator;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, key: %@>", NSStringFromClass([self class]), self, self.key];
+}
+
+@end
+
+// A rough estimate of the memory held by a snapshot's value.
+static NSUInteger FUIEstimatedValueCost(id value) {
+  if ([value isKindOfClass:[NSString class]]) {
+    return 16 + [(NSString *)value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+  }
+  if ([value isKindOfClass:[NSNumber class]]) {
+    return 16;
+  }
+  if ([value isKindOfClass:[NSDictionary class]]) {
+    __block NSUInteger cost = 32;
+    [(NSDictionary *)value enumerateKeysAndObjectsUsingBlock:^(id key, id child, BOOL *stop) {
+      cost += FUIEstimatedValueCost(key) + FUIEstimatedValueCost(child);
+    }];
+    return cost;
+  }
+  if ([value isKindOfClass:[NSArray class]]) {
+    NSUInteger cost = 32;
+    for (id child in (NSArray *)value) {
+      cost += FUIEstimatedValueCost(child);
+    }
+    return cost;
+  }
+  return 0;
+}
 
 @interface FUIArray ()
 
@@ -46,10 +139,76 @@
  */
 @property (nonatomic, assign) BOOL isSendingUpdates;
 
+/**
+ * Publishes immutable copies of the array's contents at the end of each batch
+ * of updates, so they can be read from other threads.
+ */
+@property (strong, nonatomic, readonly) FUIVersionPublisher *versionPublisher;
+
+/**
+ * The primary delegate and any additional delegates. Every delegate event is
+ * sent through this list.
+ */
+@property (strong, nonatomic) FUICollectionDelegateList *delegates;
+
+/**
+ * The time each key's most recent change event was sent. Only used when
+ * changeThrottleInterval is greater than zero.
+ */
+@property (strong, nonatomic) NSMutableDictionary<NSString *, NSNumber *> *lastChangeTimes;
+
+/**
+ * Keys with a change event being held back, in the order they first changed.
+ */
+@property (strong, nonatomic) NSMutableOrderedSet<NSString *> *throttledKeys;
+
+/**
+ * The throttleClock time the pending timer to send held back change events is set
+ * for, or DBL_MAX if none is pending.
+ */
+@property (nonatomic, assign) NSTimeInterval throttledChangesDeadline;
+
+/**
+ * Incremented each time a timer is scheduled, so that timers replaced by one with
+ * an earlier deadline do nothing when they fire.
+ */
+@property (nonatomic, assign) NSUInteger throttleTimerGeneration;
+
+/**
+ * The estimated cost of each row's snapshot, in the same order as snapshots, with 0
+ * for evicted rows. Its total weight is the resident size, and the farthest resident
+ * rows at either end are found by weight offset. Nil while payloadBudget is zero.
+ */
+@property (strong, nonatomic, nullable) FUIRankTree *payloadCosts;
+
+/**
+ * The number of rows holding an FUIEvictedSnapshot.
+ */
+@property (nonatomic, assign) NSUInteger evictedPayloadCount;
+
+/**
+ * Removes the listener of each payload being reloaded, by key.
+ */
+@property (strong, nonatomic) NSMutableDictionary<NSString *, dispatch_block_t> *payloadReloads;
+
+/**
+ * The index most recently accessed while payloadBudget is nonzero, around which
+ * payloads are kept.
+ */
+@property (nonatomic, assign) NSUInteger lastAccessedIndex;
+
+/**
+ * Measures batches for the metrics sink. Nil while there's no sink, which makes
+ * every measurement a message to nil.
+ */
+@property (strong, nonatomic, nullable) FUICollectionMetricsRecorder *metricsRecorder;
+
 @end
 
 @implementation FUIArray
 
+@synthesize payloadCostEstimator = _payloadCostEstimator;
+
 #pragma mark - Initializer methods
 
 - (instancetype)initWithQuery:(FIRDatabaseQuery *)query delegate:(id<FUICollectionDelegate>)delegate {
@@ -60,7 +219,15 @@
     self.keys = [NSMutableArray array];
     self.query = query;
     self.handles = [NSMutableSet setWithCapacity:4];
+    self.delegates = [[FUICollectionDelegateList alloc] init];
     self.delegate = delegate;
+    self.lastChangeTimes = [NSMutableDictionary dictionary];
+    self.throttledKeys = [NSMutableOrderedSet orderedSet];
+    _throttledChangesDeadline = DBL_MAX;
+    _slowCallbackThreshold = FUICollectionDefaultSlowCallbackThreshold;
+    _payloadWindow = 20;
+    self.payloadReloads = [NSMutableDictionary dictionary];
+    _versionPublisher = [[FUIVersionPublisher alloc] init];
   }
   return self;
 }
@@ -86,8 +253,11 @@
   FIRDatabaseHandle handle;
   handle = [self.query observeEventType:FIRDataEventTypeChildAdded
       andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+        FUICollectionMetricsMark mark = [metrics mark];
         [self didUpdate];
         [self insertSnapshot:snapshot withPreviousChildKey:previousChildKey];
+        [metrics endWork:mark eventType:FIRDataEventTypeChildAdded];
       }
       withCancelBlock:^(NSError *error) {
         [self raiseError:error];
@@ -96,8 +266,11 @@
 
   handle = [self.query observeEventType:FIRDataEventTypeChildChanged
       andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+        FUICollectionMetricsMark mark = [metrics mark];
         [self didUpdate];
         [self changeSnapshot:snapshot withPreviousChildKey:previousChildKey];
+        [metrics endWork:mark eventType:FIRDataEventTypeChildChanged];
       }
       withCancelBlock:^(NSError *error) {
         [self raiseError:error];
@@ -106,8 +279,11 @@
 
   handle = [self.query observeEventType:FIRDataEventTypeChildRemoved
       andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousSiblingKey) {
+        FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+        FUICollectionMetricsMark mark = [metrics mark];
         [self didUpdate];
         [self removeSnapshot:snapshot withPreviousChildKey:previousSiblingKey];
+        [metrics endWork:mark eventType:FIRDataEventTypeChildRemoved];
       }
       withCancelBlock:^(NSError *error) {
         [self raiseError:error];
@@ -116,8 +292,11 @@
 
   handle = [self.query observeEventType:FIRDataEventTypeChildMoved
       andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+        FUICollectionMetricsMark mark = [metrics mark];
         [self didUpdate];
         [self moveSnapshot:snapshot withPreviousChildKey:previousChildKey];
+        [metrics endWork:mark eventType:FIRDataEventTypeChildMoved];
       }
       withCancelBlock:^(NSError *error) {
         [self raiseError:error];
@@ -140,24 +319,26 @@
     return;
   }
   self.isSendingUpdates = YES;
-  if ([self.delegate respondsToSelector:@selector(arrayDidBeginUpdates:)]) {
-    [self.delegate arrayDidBeginUpdates:self];
-  }
+  [self.metricsRecorder beginBatch];
+  [self.delegates arrayDidBeginUpdates:self];
 }
 
 // Must be called from a value event listener.
 - (void)didFinishUpdates {
   if (!self.isSendingUpdates) { /* This is probably an error */ return; }
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
+  [self sendDueThrottledChanges];
   self.isSendingUpdates = NO;
-  if ([self.delegate respondsToSelector:@selector(arrayDidEndUpdates:)]) {
-    [self.delegate arrayDidEndUpdates:self];
-  }
+  [self enforcePayloadBudget];
+  [self.versionPublisher publishItems:self.items];
+  [self.delegates arrayDidEndUpdates:self];
+  [metrics endWork:mark];
+  [metrics finishBatchWithItemCount:self.snapshots.count];
 }
 
 - (void)raiseError:(NSError *)error {
-  if ([self.delegate respondsToSelector:@selector(array:queryCancelledWithError:)]) {
-    [self.delegate array:self queryCancelledWithError:error];
-  }
+  [self.delegates array:self queryCancelledWithError:error];
 }
 
 - (void)invalidate {
@@ -166,18 +347,20 @@
   }
 
   [self.handles removeAllObjects];
+  [self cancelPayloadReloads];
+  [self.throttledKeys removeAllObjects];
+  [self.lastChangeTimes removeAllObjects];
+  [self cancelThrottleTimer];
 
-  // Remove all values on invalidation.
+  // Remove all values on invalidation, last first so that no removal shifts the
+  // keys after it.
   [self didUpdate];
-  for (NSInteger i = 0; i < self.snapshots.count; /* no i++ since we modify the array instead */ ) {
-    FIRDataSnapshot *current = self.snapshots[i];
+  for (NSUInteger i = self.snapshots.count; i > 0; i--) {
+    FIRDataSnapshot *current = self.snapshots[i - 1];
 
-    [self.snapshots removeObjectAtIndex:i];
+    [self removeSnapshotAtIndex:i - 1];
 
-    [self.keys removeObjectAtIndex:i];
-    if ([self.delegate respondsToSelector:@selector(array:didRemoveObject:atIndex:)]) {
-      [self.delegate array:self didRemoveObject:current atIndex:i];
-    }
+    [self.delegates array:self didRemoveObject:current atIndex:i - 1];
   }
   [self didFinishUpdates];
 }
@@ -205,12 +388,9 @@
     index = previousChildIndex + 1;
   }
 
-  [self.snapshots insertObject:snap atIndex:index];
-  [self.keys insertObject:snap.key atIndex:index];
+  [self insertSnapshot:snap atIndex:index];
 
-  if ([self.delegate respondsToSelector:@selector(array:didAddObject:atIndex:)]) {
-    [self.delegate array:self didAddObject:snap atIndex:index];
-  }
+  [self.delegates array:self didAddObject:snap atIndex:index];
 }
 
 - (void)removeSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -225,12 +405,10 @@
     @throw exception;
   }
 
-  [self.snapshots removeObjectAtIndex:index];
-  [self.keys removeObjectAtIndex:index];
+  [self removeSnapshotAtIndex:index];
+  [self cancelThrottledChangeForKey:snap.key];
 
-  if ([self.delegate respondsToSelector:@selector(array:didRemoveObject:atIndex:)]) {
-    [self.delegate array:self didRemoveObject:snap atIndex:index];
-  }
+  [self.delegates array:self didRemoveObject:snap atIndex:index];
 }
 
 - (void)changeSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -245,12 +423,9 @@
     @throw exception;
   }
 
-  [self.snapshots replaceObjectAtIndex:index withObject:snap];
-  [self.keys replaceObjectAtIndex:index withObject:snap.key];
+  [self replaceSnapshotAtIndex:index withSnapshot:snap];
 
-  if ([self.delegate respondsToSelector:@selector(array:didChangeObject:atIndex:)]) {
-    [self.delegate array:self didChangeObject:snap atIndex:index];
-  }
+  [self didChangeSnapshot:snap atIndex:index];
 }
 
 - (void)moveSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -265,8 +440,7 @@
     @throw exception;
   }
 
-  [self.snapshots removeObjectAtIndex:fromIndex];
-  [self.keys removeObjectAtIndex:fromIndex];
+  [self removeSnapshotAtIndex:fromIndex];
 
   NSUInteger toIndex = 0;
   if (previous != nil) {
@@ -275,41 +449,440 @@
       toIndex = prevIndex + 1;
     }
   }
-  [self.snapshots insertObject:snap atIndex:toIndex];
-  [self.keys insertObject:snap.key atIndex:toIndex];
+  [self insertSnapshot:snap atIndex:toIndex];
+
+  [self.delegates array:self didMoveObject:snap fromIndex:fromIndex toIndex:toIndex];
+}
+
+#pragma mark - Change throttling
+
+- (void)didChangeSnapshot:(FIRDataSnapshot *)snap atIndex:(NSUInteger)index {
+  if (self.changeThrottleInterval <= 0) {
+    [self.delegates array:self didChangeObject:snap atIndex:index];
+    return;
+  }
 
-  if ([self.delegate respondsToSelector:@selector(array:didMoveObject:fromIndex:toIndex:)]) {
-    [self.delegate array:self didMoveObject:snap fromIndex:fromIndex toIndex:toIndex];
+  NSString *key = snap.key;
+  NSTimeInterval now = self.throttleClock();
+  NSNumber *lastChange = self.lastChangeTimes[key];
+  if (lastChange == nil || now - lastChange.doubleValue >= self.changeThrottleInterval) {
+    // Leading edge: the first change in a window is sent right away.
+    [self.throttledKeys removeObject:key];
+    self.lastChangeTimes[key] = @(now);
+    [self.delegates array:self didChangeObject:snap atIndex:index];
+    return;
   }
+
+  // The snapshot is already stored, so the trailing event will carry the latest contents.
+  [self.throttledKeys addObject:key];
+  [self scheduleThrottledChangesAt:lastChange.doubleValue + self.changeThrottleInterval];
 }
 
+- (void)cancelThrottledChangeForKey:(NSString *)key {
+  [self.throttledKeys removeObject:key];
+  [self.lastChangeTimes removeObjectForKey:key];
+}
+
+// Deadlines are throttleClock times. A pending timer is kept if it fires no later
+// than the new deadline, and replaced otherwise, so a key never waits for another
+// key's later deadline.
+- (void)scheduleThrottledChangesAt:(NSTimeInterval)deadline {
+  if (self.throttledChangesDeadline <= deadline) { return; }
+  self.throttledChangesDeadline = deadline;
+  NSUInteger generation = ++self.throttleTimerGeneration;
+  NSTimeInterval delay = deadline - self.throttleClock();
+  __weak typeof(self) wSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(delay, 0) * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+    __strong typeof(wSelf) sSelf = wSelf;
+    if (sSelf == nil || sSelf.throttleTimerGeneration != generation) { return; }
+    sSelf.throttledChangesDeadline = DBL_MAX;
+    [sSelf sendDueThrottledChanges];
+  });
+}
+
+- (void)cancelThrottleTimer {
+  self.throttleTimerGeneration++;
+  self.throttledChangesDeadline = DBL_MAX;
+}
+
+- (void)sendDueThrottledChanges {
+  if (self.throttledKeys.count == 0) { return; }
+
+  NSTimeInterval now = self.throttleClock();
+  NSTimeInterval nextDue = DBL_MAX;
+  NSMutableArray<NSString *> *dueKeys = [NSMutableArray arrayWithCapacity:self.throttledKeys.count];
+  for (NSString *key in self.throttledKeys) {
+    NSTimeInterval due = self.lastChangeTimes[key].doubleValue + self.changeThrottleInterval;
+    if (due <= now) {
+      [dueKeys addObject:key];
+    } else {
+      nextDue = MIN(nextDue, due);
+    }
+  }
+
+  [self sendThrottledChangesForKeys:dueKeys time:now];
+  if (self.throttledKeys.count > 0 && nextDue != DBL_MAX) {
+    [self scheduleThrottledChangesAt:nextDue];
+  }
+}
+
+- (void)flushThrottledChanges {
+  // -array returns a live view of the set, which is mutated while sending.
+  NSArray<NSString *> *keys = [self.throttledKeys.array copy];
+  [self sendThrottledChangesForKeys:keys time:self.throttleClock()];
+}
+
+- (void)sendThrottledChangesForKeys:(NSArray<NSString *> *)keys time:(NSTimeInterval)now {
+  if (keys.count == 0) { return; }
+  [self.throttledKeys removeObjectsInArray:keys];
+
+  // Changes sent outside of a batch of Firebase events get a batch of their own.
+  BOOL startsBatch = !self.isSendingUpdates;
+  if (startsBatch) {
+    [self didUpdate];
+  }
+  for (NSString *key in keys) {
+    NSUInteger index = [self indexForKey:key];
+    if (index == NSNotFound) { continue; }
+    self.lastChangeTimes[key] = @(now);
+    [self.delegates array:self didChangeObject:self.snapshots[index] atIndex:index];
+  }
+  if (startsBatch) {
+    [self didFinishUpdates];
+  }
+}
+
+#pragma mark - Payload budget
+
+- (void)setPayloadBudget:(NSUInteger)payloadBudget {
+  _payloadBudget = payloadBudget;
+  if (payloadBudget == 0) {
+    self.payloadCosts = nil;
+    [self reloadEvictedPayloads];
+    return;
+  }
+  if (self.payloadCosts == nil) {
+    [self estimatePayloadCosts];
+  }
+  [self enforcePayloadBudgetOutsideBatch];
+}
+
+- (NSUInteger (^)(NSString *, id))payloadCostEstimator {
+  if (_payloadCostEstimator == nil) {
+    _payloadCostEstimator = ^NSUInteger(NSString *key, id value) {
+      return 48 + FUIEstimatedValueCost(key) + FUIEstimatedValueCost(value);
+    };
+  }
+  return _payloadCostEstimator;
+}
+
+- (void)setPayloadCostEstimator:(NSUInteger (^)(NSString *, id))payloadCostEstimator {
+  _payloadCostEstimator = [payloadCostEstimator copy];
+  // Held snapshots were measured by the old estimator.
+  if (self.payloadCosts != nil) {
+    [self estimatePayloadCosts];
+    [self enforcePayloadBudgetOutsideBatch];
+  }
+}
+
+- (NSUInteger)payloadCostOfSnapshot:(FIRDataSnapshot *)snapshot {
+  if ([snapshot isKindOfClass:[FUIEvictedSnapshot class]]) { return 0; }
+  return self.payloadCostEstimator(snapshot.key, snapshot.value);
+}
+
+// Estimates every row's cost from scratch, in O(n) time.
+- (void)estimatePayloadCosts {
+  if (self.payloadCosts == nil) {
+    self.payloadCosts = [[FUIRankTree alloc] init];
+  }
+  NSArray<FIRDataSnapshot *> *snapshots = self.snapshots;
+  [self.payloadCosts replaceAllWeightsWithCount:snapshots.count
+                                        weights:^NSUInteger(NSUInteger index) {
+    return [self payloadCostOfSnapshot:snapshots[index]];
+  }];
+}
+
+- (NSUInteger)residentPayloadBytes {
+  return self.payloadCosts.totalWeight;
+}
+
+- (NSUInteger)residentPayloadCount {
+  return self.snapshots.count - self.evictedPayloadCount;
+}
+
+- (BOOL)isPayloadResidentAtIndex:(NSUInteger)index {
+  return ![self.snapshots[index] isKindOfClass:[FUIEvictedSnapshot class]];
+}
+
+// Evicts the payloads farthest from the most recently accessed row until the budget
+// holds, never evicting rows within the payload window or rows with a change being
+// held back. Each eviction takes O(log n) time. Returns YES if any row was evicted.
+- (BOOL)enforcePayloadBudget {
+  FUIRankTree *costs = self.payloadCosts;
+  NSUInteger budget = self.payloadBudget;
+  if (budget == 0 || costs.totalWeight <= budget) { return NO; }
+
+  NSUInteger count = self.snapshots.count;
+  NSUInteger anchor = MIN(self.lastAccessedIndex, count - 1);
+  NSUInteger window = self.payloadWindow;
+  NSUInteger protectedStart = anchor > window ? anchor - window : 0;
+  NSUInteger protectedEnd = count - 1 - anchor > window ? anchor + window : count - 1;
+
+  // The cost of the rows passed over at either end. Evicted rows weigh nothing, so the
+  // farthest resident rows not yet passed over hold the first and last weight offsets
+  // between these.
+  NSUInteger skippedLow = 0;
+  NSUInteger skippedHigh = 0;
+  BOOL evicted = NO;
+  while (costs.totalWeight > budget && skippedLow + skippedHigh < costs.totalWeight) {
+    NSUInteger low = [costs indexContainingWeightOffset:skippedLow];
+    NSUInteger high = [costs indexContainingWeightOffset:costs.totalWeight - skippedHigh - 1];
+    BOOL canEvictLow = low < protectedStart;
+    BOOL canEvictHigh = high > protectedEnd;
+    if (!canEvictLow && !canEvictHigh) { break; }
+    BOOL fromLow = canEvictLow && (!canEvictHigh || protectedStart - low >= high - protectedEnd);
+    NSUInteger index = fromLow ? low : high;
+
+    if ([self.throttledKeys containsObject:self.keys[index]]) {
+      // Its held back change must be sent with its snapshot.
+      if (fromLow) {
+        skippedLow += [costs weightAtIndex:index];
+      } else {
+        skippedHigh += [costs weightAtIndex:index];
+      }
+      continue;
+    }
+    [self evictPayloadAtIndex:index];
+    evicted = YES;
+  }
+  return evicted;
+}
+
+// Evicts right away rather than at the end of the next batch, and publishes the rows
+// that are left so that the current version lets go of the evicted snapshots too.
+- (void)enforcePayloadBudgetOutsideBatch {
+  if (self.isSendingUpdates) { return; }
+  if ([self enforcePayloadBudget]) {
+    [self.versionPublisher publishItems:self.items];
+  }
+}
+
+- (void)evictPayloadAtIndex:(NSUInteger)index {
+  NSString *key = self.keys[index];
+  FIRDatabaseReference *ref = nil;
+  if ([self.query isKindOfClass:[FIRDatabaseQuery class]]) {
+    ref = [((FIRDatabaseQuery *)self.query).ref child:key];
+  }
+  FUIEvictedSnapshot *evicted = [[FUIEvictedSnapshot alloc] initWithKey:key ref:ref];
+  [self.snapshots replaceObjectAtIndex:index withObject:(FIRDataSnapshot *)evicted];
+  [self.payloadCosts setWeight:0 atIndex:index];
+  self.evictedPayloadCount++;
+}
+
+- (id<FUIDataObservable>)observableForKey:(NSString *)key {
+  // Queries that aren't references can't make children, but their references can.
+  if (![self.query respondsToSelector:@selector(child:)] &&
+      [self.query isKindOfClass:[FIRDatabaseQuery class]]) {
+    return (id<FUIDataObservable>)[((FIRDatabaseQuery *)self.query).ref child:key];
+  }
+  return [self.query child:key];
+}
+
+// Fetches an evicted row's snapshot with a single-value listener on its location,
+// which the database answers from its local cache when it can.
+- (void)reloadPayloadForKey:(NSString *)key {
+  if (self.payloadReloads[key] != nil) { return; }
+  id<FUIDataObservable> location = [self observableForKey:key];
+  if (location == nil) { return; }
+
+  // The listener may be called before observeEventType: returns, in which case it's
+  // removed once the handle is known.
+  __block BOOL finished = NO;
+  __block BOOL observing = NO;
+  __block FIRDatabaseHandle handle = 0;
+  __weak typeof(self) wSelf = self;
+  self.payloadReloads[key] = ^{
+    finished = YES;
+    if (observing) {
+      [location removeObserverWithHandle:handle];
+    }
+  };
+  handle = [location observeEventType:FIRDataEventTypeValue
+       andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousKey) {
+    if (finished) { return; }
+    [wSelf finishPayloadReloadForKey:key];
+    [wSelf didReloadPayload:snapshot forKey:key];
+  } withCancelBlock:^(NSError *error) {
+    if (finished) { return; }
+    [wSelf finishPayloadReloadForKey:key];
+  }];
+  observing = YES;
+  if (finished) {
+    [location removeObserverWithHandle:handle];
+  }
+}
+
+- (void)finishPayloadReloadForKey:(NSString *)key {
+  dispatch_block_t finish = self.payloadReloads[key];
+  if (finish == nil) { return; }
+  [self.payloadReloads removeObjectForKey:key];
+  finish();
+}
+
+- (void)cancelPayloadReloads {
+  for (NSString *key in self.payloadReloads.allKeys) {
+    [self finishPayloadReloadForKey:key];
+  }
+}
+
+- (void)reloadEvictedPayloads {
+  if (self.evictedPayloadCount == 0) { return; }
+  NSArray<NSString *> *keys = [self.keys copy];
+  for (NSUInteger i = 0; i < keys.count; i++) {
+    if (![self isPayloadResidentAtIndex:i]) {
+      [self reloadPayloadForKey:keys[i]];
+    }
+  }
+}
+
+- (void)didReloadPayload:(FIRDataSnapshot *)snapshot forKey:(NSString *)key {
+  NSUInteger index = [self indexForKey:key];
+  // The row may have been removed, or updated by the query, while reloading.
+  if (index == NSNotFound || [self isPayloadResidentAtIndex:index]) { return; }
+
+  BOOL startsBatch = !self.isSendingUpdates;
+  if (startsBatch) {
+    [self didUpdate];
+  }
+  [self replaceSnapshotAtIndex:index withSnapshot:snapshot];
+  [self.delegates array:self didChangeObject:snapshot atIndex:index];
+  if (startsBatch) {
+    [self didFinishUpdates];
+  }
+}
+
+#pragma mark - Storage
+
+// Every change to snapshots goes through these, to keep the payload costs in step.
+
 - (void)removeSnapshotAtIndex:(NSUInteger)index {
+  if (![self isPayloadResidentAtIndex:index]) {
+    self.evictedPayloadCount--;
+    [self finishPayloadReloadForKey:self.keys[index]];
+  }
   [self.snapshots removeObjectAtIndex:index];
   [self.keys removeObjectAtIndex:index];
+  [self.payloadCosts removeWeightAtIndex:index];
 }
 
 - (void)insertSnapshot:(FIRDataSnapshot *)snap atIndex:(NSUInteger)index {
   [self.snapshots insertObject:snap atIndex:index];
   [self.keys insertObject:snap.key atIndex:index];
+  if (self.payloadCosts != nil) {
+    [self.payloadCosts insertWeight:[self payloadCostOfSnapshot:snap] atIndex:index];
+  }
+}
+
+- (void)replaceSnapshotAtIndex:(NSUInteger)index withSnapshot:(FIRDataSnapshot *)snap {
+  if (![self isPayloadResidentAtIndex:index]) {
+    self.evictedPayloadCount--;
+  }
+  [self.snapshots replaceObjectAtIndex:index withObject:snap];
+  [self.keys replaceObjectAtIndex:index withObject:snap.key];
+  if (self.payloadCosts != nil) {
+    [self.payloadCosts setWeight:[self payloadCostOfSnapshot:snap] atIndex:index];
+  }
 }
 
 - (void)addSnapshot:(FIRDataSnapshot *)snap {
-  [self.snapshots addObject:snap];
-  [self.keys addObject:snap.key];
+  [self insertSnapshot:snap atIndex:self.snapshots.count];
 }
 
 #pragma mark - Public API methods
 
+- (id<FUICollectionDelegate>)delegate {
+  return self.delegates.primaryDelegate;
+}
+
+- (void)setDelegate:(id<FUICollectionDelegate>)delegate {
+  self.delegates.primaryDelegate = delegate;
+}
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates addDelegate:delegate];
+}
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates removeDelegate:delegate];
+}
+
+- (id<FUICollectionMetricsSink>)metricsSink {
+  return self.metricsRecorder.sink;
+}
+
+- (void)setMetricsSink:(id<FUICollectionMetricsSink>)metricsSink {
+  if (metricsSink == self.metricsRecorder.sink) { return; }
+  FUICollectionMetricsRecorder *recorder = nil;
+  if (metricsSink != nil) {
+    recorder = [[FUICollectionMetricsRecorder alloc] initWithCollection:self sink:metricsSink];
+    recorder.slowCallbackThreshold = self.slowCallbackThreshold;
+  }
+  self.metricsRecorder = recorder;
+  self.delegates.metricsRecorder = recorder;
+}
+
+- (void)setSlowCallbackThreshold:(NSTimeInterval)slowCallbackThreshold {
+  _slowCallbackThreshold = slowCallbackThreshold;
+  self.metricsRecorder.slowCallbackThreshold = slowCallbackThreshold;
+}
+
+- (NSTimeInterval (^)(void))throttleClock {
+  if (_throttleClock == nil) {
+    _throttleClock = ^NSTimeInterval {
+      return [NSProcessInfo processInfo].systemUptime;
+    };
+  }
+  return _throttleClock;
+}
+
 - (NSArray *)items {
-  return [self.snapshots copy];
+  if (self.evictedPayloadCount == 0) {
+    return [self.snapshots copy];
+  }
+  NSMutableArray<FIRDataSnapshot *> *items =
+      [NSMutableArray arrayWithCapacity:self.snapshots.count - self.evictedPayloadCount];
+  for (FIRDataSnapshot *snapshot in self.snapshots) {
+    if (![snapshot isKindOfClass:[FUIEvictedSnapshot class]]) {
+      [items addObject:snapshot];
+    }
+  }
+  return [items copy];
 }
 
 - (NSUInteger)count {
   return [self.snapshots count];
 }
 
+- (FUICollectionVersion *)currentVersion {
+  return [self.versionPublisher currentVersion];
+}
+
 - (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index {
-  return (FIRDataSnapshot *)[self.snapshots objectAtIndex:index];
+  FIRDataSnapshot *snapshot = [self.snapshots objectAtIndex:index];
+  if (self.payloadBudget > 0) {
+    self.lastAccessedIndex = index;
+  }
+  if ([snapshot isKindOfClass:[FUIEvictedSnapshot class]]) {
+    [self reloadPayloadForKey:snapshot.key];
+    // The reload may have finished already.
+    snapshot = [self.snapshots objectAtIndex:index];
+  }
+  return snapshot;
+}
+
+- (id)valueAtIndex:(NSUInteger)index {
+  return [self snapshotAtIndex:index].value;
 }
 
 - (FIRDatabaseReference *)refForIndex:(NSUInteger)index {
@@ -0,0 +1,62 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIArray.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FUIArray methods used by its subclasses.
+ */
+@interface FUIArray ()
+
+/**
+ * Sends @c array:didChangeObject:atIndex: for a snapshot that was changed in place,
+ * or holds the event back if the snapshot's key changed less than
+ * @c changeThrottleInterval seconds ago.
+ */
+- (void)didChangeSnapshot:(FIRDataSnapshot *)snap atIndex:(NSUInteger)index;
+
+/**
+ * Drops any change event being held back for the given key. Must be called when
+ * a snapshot is removed, or when a change is sent some other way.
+ */
+- (void)cancelThrottledChangeForKey:(NSString *)key;
+
+/**
+ * Sends the held back change events whose throttle window has passed.
+ */
+- (void)sendDueThrottledChanges;
+
+/**
+ * Inserts a snapshot and its key. Subclasses that change the array's storage must do
+ * so through this method, @c removeSnapshotAtIndex: and
+ * @c replaceSnapshotAtIndex:withSnapshot:, which keep the costs tracked under
+ * @c payloadBudget in step.
+ */
+- (void)insertSnapshot:(FIRDataSnapshot *)snap atIndex:(NSUInteger)index;
+
+- (void)removeSnapshotAtIndex:(NSUInteger)index;
+
+- (void)replaceSnapshotAtIndex:(NSUInteger)index withSnapshot:(FIRDataSnapshot *)snap;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,84 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUICollection.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionMetrics_Private.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The optional FUICollectionDelegate methods a delegate implements. Computed once
+ * when the delegate is registered so events don't need to call -respondsToSelector:.
+ */
+typedef NS_OPTIONS(NSUInteger, FUICollectionDelegateCapabilities) {
+  FUICollectionDelegateCapabilityBeginUpdates = 1 << 0,
+  FUICollectionDelegateCapabilityEndUpdates   = 1 << 1,
+  FUICollectionDelegateCapabilityAdd          = 1 << 2,
+  FUICollectionDelegateCapabilityChange       = 1 << 3,
+  FUICollectionDelegateCapabilityRemove       = 1 << 4,
+  FUICollectionDelegateCapabilityMove         = 1 << 5,
+  FUICollectionDelegateCapabilityCancel       = 1 << 6,
+};
+
+/**
+ * Returns the capabilities of the given delegate.
+ */
+FUICollectionDelegateCapabilities
+FUICollectionDelegateCapabilitiesForDelegate(id<FUICollectionDelegate> _Nullable delegate);
+
+/**
+ * An internal helper that holds a collection's delegates weakly and fans events
+ * out to them. The list conforms to FUICollectionDelegate itself; each delegate
+ * method forwards the event to every registered delegate that implements it,
+ * starting with the primary delegate.
+ *
+ * Registering and unregistering delegates may happen during event delivery. Those
+ * changes take effect starting with the next event.
+ */
+@interface FUICollectionDelegateList : NSObject <FUICollectionDelegate>
+
+/**
+ * The delegate assigned through a collection's @c delegate property.
+ */
+@property (nonatomic, weak, nullable) id<FUICollectionDelegate> primaryDelegate;
+
+/**
+ * The primary delegate followed by all additional delegates that are still alive.
+ */
+@property (nonatomic, readonly) NSArray<id<FUICollectionDelegate>> *allDelegates;
+
+/**
+ * Times every delegate callback when set. Nil unless the collection has a metrics sink.
+ */
+@property (nonatomic, strong, nullable) FUICollectionMetricsRecorder *metricsRecorder;
+
+/**
+ * Adds an additional delegate. Adding a delegate that is already registered has no effect.
+ */
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+/**
+ * Removes a delegate previously added with @c addDelegate:.
+ */
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,255 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+
+FUICollectionDelegateCapabilities
+FUICollectionDelegateCapabilitiesForDelegate(id<FUICollectionDelegate> delegate) {
+  if (delegate == nil) { return 0; }
+  FUICollectionDelegateCapabilities capabilities = 0;
+  if ([delegate respondsToSelector:@selector(arrayDidBeginUpdates:)]) {
+    capabilities |= FUICollectionDelegateCapabilityBeginUpdates;
+  }
+  if ([delegate respondsToSelector:@selector(arrayDidEndUpdates:)]) {
+    capabilities |= FUICollectionDelegateCapabilityEndUpdates;
+  }
+  if ([delegate respondsToSelector:@selector(array:didAddObject:atIndex:)]) {
+    capabilities |= FUICollectionDelegateCapabilityAdd;
+  }
+  if ([delegate respondsToSelector:@selector(array:didChangeObject:atIndex:)]) {
+    capabilities |= FUICollectionDelegateCapabilityChange;
+  }
+  if ([delegate respondsToSelector:@selector(array:didRemoveObject:atIndex:)]) {
+    capabilities |= FUICollectionDelegateCapabilityRemove;
+  }
+  if ([delegate respondsToSelector:@selector(array:didMoveObject:fromIndex:toIndex:)]) {
+    capabilities |= FUICollectionDelegateCapabilityMove;
+  }
+  if ([delegate respondsToSelector:@selector(array:queryCancelledWithError:)]) {
+    capabilities |= FUICollectionDelegateCapabilityCancel;
+  }
+  return capabilities;
+}
+
+@interface FUICollectionDelegateEntry : NSObject
+
+@property (nonatomic, weak, readonly) id<FUICollectionDelegate> delegate;
+
+@property (nonatomic, assign, readonly) FUICollectionDelegateCapabilities capabilities;
+
+- (instancetype)initWithDelegate:(id<FUICollectionDelegate>)delegate;
+
+@end
+
+@implementation FUICollectionDelegateEntry
+
+- (instancetype)initWithDelegate:(id<FUICollectionDelegate>)delegate {
+  self = [super init];
+  if (self != nil) {
+    _delegate = delegate;
+    _capabilities = FUICollectionDelegateCapabilitiesForDelegate(delegate);
+  }
+  return self;
+}
+
+@end
+
+@implementation FUICollectionDelegateList {
+  // The primary delegate's entry, if any. Also the first element of _entries.
+  FUICollectionDelegateEntry *_primaryEntry;
+
+  // Never mutated; replaced whenever a delegate is added or removed so that
+  // event delivery can iterate over it while delegates change.
+  NSArray<FUICollectionDelegateEntry *> *_entries;
+
+  // The union of all entries' capabilities, so events nobody listens to
+  // return without walking the list.
+  FUICollectionDelegateCapabilities _capabilities;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _entries = @[];
+  }
+  return self;
+}
+
+#pragma mark - Registration
+
+- (id<FUICollectionDelegate>)primaryDelegate {
+  return _primaryEntry.delegate;
+}
+
+- (void)setPrimaryDelegate:(id<FUICollectionDelegate>)primaryDelegate {
+  NSMutableArray<FUICollectionDelegateEntry *> *entries =
+      [NSMutableArray arrayWithCapacity:_entries.count + 1];
+  FUICollectionDelegateEntry *oldPrimaryEntry = _primaryEntry;
+  _primaryEntry = primaryDelegate != nil
+      ? [[FUICollectionDelegateEntry alloc] initWithDelegate:primaryDelegate]
+      : nil;
+  if (_primaryEntry != nil) {
+    [entries addObject:_primaryEntry];
+  }
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    id<FUICollectionDelegate> delegate = entry.delegate;
+    // Drop the old primary delegate and entries for deallocated delegates, and
+    // don't notify the new primary delegate twice if it was also added as an
+    // additional delegate.
+    if (entry == oldPrimaryEntry || delegate == nil || delegate == primaryDelegate) { continue; }
+    [entries addObject:entry];
+  }
+  [self setEntries:entries];
+}
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate {
+  NSParameterAssert(delegate != nil);
+  NSMutableArray<FUICollectionDelegateEntry *> *entries =
+      [NSMutableArray arrayWithCapacity:_entries.count + 1];
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    id<FUICollectionDelegate> existing = entry.delegate;
+    if (existing == delegate) { return; }
+    if (existing == nil && entry != _primaryEntry) { continue; }
+    [entries addObject:entry];
+  }
+  [entries addObject:[[FUICollectionDelegateEntry alloc] initWithDelegate:delegate]];
+  [self setEntries:entries];
+}
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate {
+  NSParameterAssert(delegate != nil);
+  NSMutableArray<FUICollectionDelegateEntry *> *entries =
+      [NSMutableArray arrayWithCapacity:_entries.count];
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if (entry == _primaryEntry) {
+      [entries addObject:entry];
+      continue;
+    }
+    id<FUICollectionDelegate> existing = entry.delegate;
+    if (existing == nil || existing == delegate) { continue; }
+    [entries addObject:entry];
+  }
+  [self setEntries:entries];
+}
+
+- (NSArray<id<FUICollectionDelegate>> *)allDelegates {
+  NSMutableArray<id<FUICollectionDelegate>> *delegates =
+      [NSMutableArray arrayWithCapacity:_entries.count];
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    id<FUICollectionDelegate> delegate = entry.delegate;
+    if (delegate != nil) {
+      [delegates addObject:delegate];
+    }
+  }
+  return [delegates copy];
+}
+
+- (void)setEntries:(NSArray<FUICollectionDelegateEntry *> *)entries {
+  FUICollectionDelegateCapabilities capabilities = 0;
+  for (FUICollectionDelegateEntry *entry in entries) {
+    capabilities |= entry.capabilities;
+  }
+  _entries = [entries copy];
+  _capabilities = capabilities;
+}
+
+#pragma mark - FUICollectionDelegate
+
+- (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
+  if ((_capabilities & FUICollectionDelegateCapabilityBeginUpdates) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityBeginUpdates) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate arrayDidBeginUpdates:collection];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)arrayDidEndUpdates:(id<FUICollection>)collection {
+  if ((_capabilities & FUICollectionDelegateCapabilityEndUpdates) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityEndUpdates) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate arrayDidEndUpdates:collection];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didAddObject:(id)object atIndex:(NSUInteger)index {
+  if ((_capabilities & FUICollectionDelegateCapabilityAdd) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityAdd) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate array:array didAddObject:object atIndex:index];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didChangeObject:(id)object atIndex:(NSUInteger)index {
+  if ((_capabilities & FUICollectionDelegateCapabilityChange) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityChange) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate array:array didChangeObject:object atIndex:index];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didRemoveObject:(id)object atIndex:(NSUInteger)index {
+  if ((_capabilities & FUICollectionDelegateCapabilityRemove) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityRemove) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate array:array didRemoveObject:object atIndex:index];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)array:(id<FUICollection>)array
+didMoveObject:(id)object
+    fromIndex:(NSUInteger)fromIndex
+      toIndex:(NSUInteger)toIndex {
+  if ((_capabilities & FUICollectionDelegateCapabilityMove) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityMove) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate array:array didMoveObject:object fromIndex:fromIndex toIndex:toIndex];
+    [metrics endCallback:mark];
+  }
+}
+
+- (void)array:(id<FUICollection>)array queryCancelledWithError:(NSError *)error {
+  if ((_capabilities & FUICollectionDelegateCapabilityCancel) == 0) { return; }
+  FUICollectionMetricsRecorder *metrics = _metricsRecorder;
+  for (FUICollectionDelegateEntry *entry in _entries) {
+    if ((entry.capabilities & FUICollectionDelegateCapabilityCancel) == 0) { continue; }
+    FUICollectionMetricsMark mark = [metrics mark];
+    [entry.delegate array:array queryCancelledWithError:error];
+    [metrics endCallback:mark];
+  }
+}
+
+@end
@@ -0,0 +1,181 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUICollectionMetrics_Private.h"
+
+#include <time.h>
+
+const NSTimeInterval FUICollectionDefaultSlowCallbackThreshold = 1.0 / 60.0;
+
+// Child added, removed, changed and moved. Value events aren't counted.
+enum { FUICollectionMetricsEventTypeCount = FIRDataEventTypeValue };
+
+static inline uint64_t FUICollectionMetricsNow(void) {
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static inline NSTimeInterval FUICollectionMetricsSeconds(uint64_t nanoseconds) {
+  return (NSTimeInterval)nanoseconds / NSEC_PER_SEC;
+}
+
+// Filled in directly by the recorder.
+@interface FUICollectionBatchMetrics () {
+ @package
+  NSTimeInterval _startTime;
+  NSTimeInterval _duration;
+  NSUInteger _eventCounts[FUICollectionMetricsEventTypeCount];
+  NSTimeInterval _storageDuration;
+  NSTimeInterval _delegateDuration;
+  NSTimeInterval _diffDuration;
+  NSUInteger _itemCount;
+  NSUInteger _slowCallbackCount;
+  NSTimeInterval _longestCallbackDuration;
+}
+
+- (instancetype)initPrivate;
+
+@end
+
+@implementation FUICollectionBatchMetrics
+
+- (instancetype)initPrivate {
+  return [super init];
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Metrics are created by collections."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (NSUInteger)eventCount {
+  NSUInteger count = 0;
+  for (NSUInteger i = 0; i < FUICollectionMetricsEventTypeCount; i++) {
+    count += _eventCounts[i];
+  }
+  return count;
+}
+
+- (NSUInteger)eventCountForType:(FIRDataEventType)eventType {
+  if ((NSUInteger)eventType >= FUICollectionMetricsEventTypeCount) { return 0; }
+  return _eventCounts[eventType];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, events: %lu, items: %lu, storage: %.3fms, "
+                                    @"delegates: %.3fms, slow callbacks: %lu>",
+      NSStringFromClass([self class]), self, (unsigned long)self.eventCount,
+      (unsigned long)_itemCount, _storageDuration * 1000, _delegateDuration * 1000,
+      (unsigned long)_slowCallbackCount];
+}
+
+@end
+
+@implementation FUICollectionMetricsRecorder {
+  __weak id _collection;
+
+  // The metrics of the batch in progress, or nil between batches.
+  FUICollectionBatchMetrics *_batch;
+  uint64_t _batchStart;
+  uint64_t _batchCallbackStart;
+  uint64_t _storageTime;
+
+  // The total time spent in callbacks, which only ever grows, so marks can tell
+  // how much of the work since them was spent in callbacks.
+  uint64_t _callbackTime;
+}
+
+- (instancetype)initWithCollection:(id)collection sink:(id<FUICollectionMetricsSink>)sink {
+  self = [super init];
+  if (self != nil) {
+    _collection = collection;
+    _sink = sink;
+    _slowCallbackThreshold = FUICollectionDefaultSlowCallbackThreshold;
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (void)beginBatch {
+  if (_batch != nil) { return; }
+  _batch = [[FUICollectionBatchMetrics alloc] initPrivate];
+  _batchStart = FUICollectionMetricsNow();
+  _batchCallbackStart = _callbackTime;
+  _storageTime = 0;
+}
+
+- (FUICollectionMetricsMark)mark {
+  return (FUICollectionMetricsMark){ .time = FUICollectionMetricsNow(), .callbackTime = _callbackTime };
+}
+
+- (void)endWork:(FUICollectionMetricsMark)mark {
+  uint64_t elapsed = FUICollectionMetricsNow() - mark.time;
+  uint64_t inCallbacks = _callbackTime - mark.callbackTime;
+  _storageTime += elapsed > inCallbacks ? elapsed - inCallbacks : 0;
+}
+
+- (void)endWork:(FUICollectionMetricsMark)mark eventType:(FIRDataEventType)eventType {
+  [self endWork:mark];
+  if (_batch != nil && (NSUInteger)eventType < FUICollectionMetricsEventTypeCount) {
+    _batch->_eventCounts[eventType]++;
+  }
+}
+
+- (void)endCallback:(FUICollectionMetricsMark)mark {
+  uint64_t elapsed = FUICollectionMetricsNow() - mark.time;
+  // Callbacks can cause other callbacks, which have already been counted.
+  uint64_t nested = _callbackTime - mark.callbackTime;
+  _callbackTime += elapsed > nested ? elapsed - nested : 0;
+  if (_batch == nil) { return; }
+
+  NSTimeInterval duration = FUICollectionMetricsSeconds(elapsed);
+  _batch->_longestCallbackDuration = MAX(_batch->_longestCallbackDuration, duration);
+  if (duration > _slowCallbackThreshold) {
+    _batch->_slowCallbackCount++;
+  }
+}
+
+- (void)finishBatchWithItemCount:(NSUInteger)itemCount {
+  FUICollectionBatchMetrics *batch = _batch;
+  if (batch == nil) { return; }
+  _batch = nil;
+
+  batch->_startTime = FUICollectionMetricsSeconds(_batchStart);
+  batch->_duration = FUICollectionMetricsSeconds(FUICollectionMetricsNow() - _batchStart);
+  batch->_storageDuration = FUICollectionMetricsSeconds(_storageTime);
+  batch->_delegateDuration = FUICollectionMetricsSeconds(_callbackTime - _batchCallbackStart);
+  batch->_itemCount = itemCount;
+
+  id collection = _collection;
+  if (collection != nil) {
+    [self.sink collection:collection didFinishBatchWithMetrics:batch];
+  }
+}
+
+@end
@@ -0,0 +1,77 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUICollectionMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The default @c slowCallbackThreshold of collections: one frame at 60Hz.
+ */
+FOUNDATION_EXTERN const NSTimeInterval FUICollectionDefaultSlowCallbackThreshold;
+
+/**
+ * A point in time taken by FUICollectionMetricsRecorder, along with how much time
+ * had been spent in callbacks by then.
+ */
+typedef struct {
+  uint64_t time;
+  uint64_t callbackTime;
+} FUICollectionMetricsMark;
+
+/**
+ * Accumulates the metrics of a collection's batches and sends them to its sink.
+ * Collections only create a recorder while they have a sink, and message it
+ * through a possibly nil reference, so that every measurement is a no-op otherwise.
+ *
+ * Work is timed between @c mark and one of the @c endWork: methods, and counts as
+ * storage time except for the callbacks timed inside it, which count as delegate
+ * time. Work mustn't be nested.
+ */
+@interface FUICollectionMetricsRecorder : NSObject
+
+- (instancetype)initWithCollection:(id)collection
+                              sink:(id<FUICollectionMetricsSink>)sink NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, weak, readonly, nullable) id<FUICollectionMetricsSink> sink;
+
+@property (nonatomic, assign) NSTimeInterval slowCallbackThreshold;
+
+/// Starts a batch, unless one is already in progress.
+- (void)beginBatch;
+
+- (FUICollectionMetricsMark)mark;
+
+- (void)endWork:(FUICollectionMetricsMark)mark;
+
+/// Ends work that applied one event.
+- (void)endWork:(FUICollectionMetricsMark)mark eventType:(FIRDataEventType)eventType;
+
+- (void)endCallback:(FUICollectionMetricsMark)mark;
+
+/// Sends the current batch's metrics to the sink and ends the batch. Does nothing
+/// if no batch is in progress.
+- (void)finishBatchWithItemCount:(NSUInteger)itemCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,55 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUICollectionVersion.h"
+
+@implementation FUICollectionVersion
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (instancetype)initWithVersion:(uint64_t)version items:(NSArray<FIRDataSnapshot *> *)items {
+  self = [super init];
+  if (self != nil) {
+    _version = version;
+    _items = [items copy];
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _items.count;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndex:(NSUInteger)index {
+  return _items[index];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, version: %llu, count: %lu>",
+      NSStringFromClass([self class]), self, _version, (unsigned long)_items.count];
+}
+
+@end
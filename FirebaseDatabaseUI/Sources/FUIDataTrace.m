@@ -0,0 +1,635 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUIDataTrace_Private.h"
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIDataTraceReplayer.h"
+
+NSErrorDomain const FUIDataTraceErrorDomain = @"FUIDataTraceErrorDomain";
+
+static const char FUIDataTraceMagic[8] = {'F', 'U', 'I', 'T', 'R', 'A', 'C', 'E'};
+static const uint64_t FUIDataTraceVersion = 1;
+
+// Buffered records are written to the file once they reach this size.
+static const NSUInteger FUIDataTraceFlushThreshold = 64 * 1024;
+
+// Snapshots nest no deeper than the database does.
+static const NSUInteger FUIDataTraceMaxDepth = 32;
+
+typedef NS_ENUM(uint8_t, FUIDataTraceValueKind) {
+  FUIDataTraceValueKindNull = 0,
+  FUIDataTraceValueKindString = 1,
+  FUIDataTraceValueKindInteger = 2,
+  FUIDataTraceValueKindDouble = 3,
+  FUIDataTraceValueKindTrue = 4,
+  FUIDataTraceValueKindFalse = 5,
+  FUIDataTraceValueKindObject = 6,
+  FUIDataTraceValueKindArray = 7,
+};
+
+NSString *FUIDataTraceQueryValueDescription(id value) {
+  return value == nil ? @"null" : [value description];
+}
+
+#pragma mark - Encoding
+
+static void FUIDataTraceAppendByte(NSMutableData *data, uint8_t byte) {
+  [data appendBytes:&byte length:1];
+}
+
+static void FUIDataTraceAppendVarint(NSMutableData *data, uint64_t value) {
+  uint8_t bytes[10];
+  NSUInteger length = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    bytes[length++] = value != 0 ? (byte | 0x80) : byte;
+  } while (value != 0);
+  [data appendBytes:bytes length:length];
+}
+
+static void FUIDataTraceAppendSignedVarint(NSMutableData *data, int64_t value) {
+  FUIDataTraceAppendVarint(data, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void FUIDataTraceAppendString(NSMutableData *data, NSString *string) {
+  const char *utf8 = string.UTF8String ?: "";
+  size_t length = strlen(utf8);
+  FUIDataTraceAppendVarint(data, length);
+  [data appendBytes:utf8 length:length];
+}
+
+static void FUIDataTraceAppendOptionalString(NSMutableData *data, NSString *string) {
+  if (string == nil) {
+    FUIDataTraceAppendVarint(data, 0);
+    return;
+  }
+  const char *utf8 = string.UTF8String ?: "";
+  size_t length = strlen(utf8);
+  FUIDataTraceAppendVarint(data, length + 1);
+  [data appendBytes:utf8 length:length];
+}
+
+static void FUIDataTraceAppendValue(NSMutableData *data, id value);
+
+static void FUIDataTraceAppendNumber(NSMutableData *data, NSNumber *number) {
+  if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+    FUIDataTraceAppendByte(data, number.boolValue ? FUIDataTraceValueKindTrue
+                                                  : FUIDataTraceValueKindFalse);
+    return;
+  }
+  const char *type = number.objCType;
+  if (strcmp(type, @encode(double)) == 0 || strcmp(type, @encode(float)) == 0) {
+    FUIDataTraceAppendByte(data, FUIDataTraceValueKindDouble);
+    uint64_t bits;
+    double value = number.doubleValue;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = CFSwapInt64HostToLittle(bits);
+    [data appendBytes:&bits length:sizeof(bits)];
+    return;
+  }
+  FUIDataTraceAppendByte(data, FUIDataTraceValueKindInteger);
+  FUIDataTraceAppendSignedVarint(data, number.longLongValue);
+}
+
+// Database objects are ordered by key unless a snapshot says otherwise.
+static void FUIDataTraceAppendDictionary(NSMutableData *data, NSDictionary *dictionary) {
+  FUIDataTraceAppendByte(data, FUIDataTraceValueKindObject);
+  FUIDataTraceAppendVarint(data, dictionary.count);
+  NSArray *keys = [dictionary.allKeys sortedArrayUsingSelector:@selector(compare:)];
+  for (NSString *key in keys) {
+    FUIDataTraceAppendString(data, key.description);
+    FUIDataTraceAppendValue(data, dictionary[key]);
+  }
+}
+
+static void FUIDataTraceAppendValue(NSMutableData *data, id value) {
+  if ([value isKindOfClass:[NSString class]]) {
+    FUIDataTraceAppendByte(data, FUIDataTraceValueKindString);
+    FUIDataTraceAppendString(data, value);
+  } else if ([value isKindOfClass:[NSNumber class]]) {
+    FUIDataTraceAppendNumber(data, value);
+  } else if ([value isKindOfClass:[NSDictionary class]]) {
+    FUIDataTraceAppendDictionary(data, value);
+  } else if ([value isKindOfClass:[NSArray class]]) {
+    FUIDataTraceAppendByte(data, FUIDataTraceValueKindArray);
+    FUIDataTraceAppendVarint(data, [value count]);
+    for (id element in value) {
+      FUIDataTraceAppendValue(data, element);
+    }
+  } else {
+    FUIDataTraceAppendByte(data, FUIDataTraceValueKindNull);
+  }
+}
+
+// Objects are written in the order of the snapshot's children, which follows the
+// query's ordering, so that replayed snapshots enumerate children the same way.
+static void FUIDataTraceAppendSnapshotValue(NSMutableData *data, FIRDataSnapshot *snapshot) {
+  id value = snapshot.value;
+  if (![value isKindOfClass:[NSDictionary class]] || ![snapshot respondsToSelector:@selector(children)]) {
+    FUIDataTraceAppendValue(data, value);
+    return;
+  }
+  NSArray<FIRDataSnapshot *> *children = snapshot.children.allObjects;
+  if (children.count != [value count]) {
+    FUIDataTraceAppendValue(data, value);
+    return;
+  }
+  FUIDataTraceAppendByte(data, FUIDataTraceValueKindObject);
+  FUIDataTraceAppendVarint(data, children.count);
+  for (FIRDataSnapshot *child in children) {
+    FUIDataTraceAppendString(data, child.key);
+    FUIDataTraceAppendSnapshotValue(data, child);
+  }
+}
+
+#pragma mark - Decoding
+
+typedef struct {
+  const uint8_t *bytes;
+  NSUInteger length;
+  NSUInteger offset;
+  BOOL failed;
+} FUIDataTraceCursor;
+
+static uint8_t FUIDataTraceReadByte(FUIDataTraceCursor *cursor) {
+  if (cursor->failed || cursor->offset >= cursor->length) {
+    cursor->failed = YES;
+    return 0;
+  }
+  return cursor->bytes[cursor->offset++];
+}
+
+static uint64_t FUIDataTraceReadVarint(FUIDataTraceCursor *cursor) {
+  uint64_t value = 0;
+  for (NSUInteger shift = 0; shift < 64; shift += 7) {
+    uint8_t byte = FUIDataTraceReadByte(cursor);
+    if (cursor->failed) { return 0; }
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) { return value; }
+  }
+  cursor->failed = YES;
+  return 0;
+}
+
+static int64_t FUIDataTraceReadSignedVarint(FUIDataTraceCursor *cursor) {
+  uint64_t value = FUIDataTraceReadVarint(cursor);
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static NSString *FUIDataTraceReadStringOfLength(FUIDataTraceCursor *cursor, uint64_t length) {
+  if (cursor->failed || length > cursor->length - cursor->offset) {
+    cursor->failed = YES;
+    return nil;
+  }
+  NSString *string = [[NSString alloc] initWithBytes:cursor->bytes + cursor->offset
+                                              length:(NSUInteger)length
+                                            encoding:NSUTF8StringEncoding];
+  cursor->offset += (NSUInteger)length;
+  if (string == nil) {
+    cursor->failed = YES;
+  }
+  return string;
+}
+
+static NSString *FUIDataTraceReadString(FUIDataTraceCursor *cursor) {
+  return FUIDataTraceReadStringOfLength(cursor, FUIDataTraceReadVarint(cursor));
+}
+
+static NSString *FUIDataTraceReadOptionalString(FUIDataTraceCursor *cursor) {
+  uint64_t length = FUIDataTraceReadVarint(cursor);
+  if (length == 0) { return nil; }
+  return FUIDataTraceReadStringOfLength(cursor, length - 1);
+}
+
+static FUIDataTraceSnapshot *FUIDataTraceReadSnapshot(FUIDataTraceCursor *cursor,
+                                                      NSString *key,
+                                                      NSUInteger depth) {
+  if (depth > FUIDataTraceMaxDepth) {
+    cursor->failed = YES;
+    return nil;
+  }
+  NSArray<FUIDataTraceSnapshot *> *noChildren = @[];
+  uint8_t kind = FUIDataTraceReadByte(cursor);
+  switch (kind) {
+    case FUIDataTraceValueKindNull:
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key value:[NSNull null] children:noChildren];
+    case FUIDataTraceValueKindString: {
+      NSString *string = FUIDataTraceReadString(cursor);
+      if (string == nil) { return nil; }
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key value:string children:noChildren];
+    }
+    case FUIDataTraceValueKindInteger:
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key
+                                                 value:@(FUIDataTraceReadSignedVarint(cursor))
+                                              children:noChildren];
+    case FUIDataTraceValueKindDouble: {
+      if (cursor->failed || cursor->length - cursor->offset < sizeof(uint64_t)) {
+        cursor->failed = YES;
+        return nil;
+      }
+      uint64_t bits;
+      memcpy(&bits, cursor->bytes + cursor->offset, sizeof(bits));
+      cursor->offset += sizeof(bits);
+      bits = CFSwapInt64LittleToHost(bits);
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key value:@(value) children:noChildren];
+    }
+    case FUIDataTraceValueKindTrue:
+    case FUIDataTraceValueKindFalse:
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key
+                                                 value:@(kind == FUIDataTraceValueKindTrue)
+                                              children:noChildren];
+    case FUIDataTraceValueKindObject:
+    case FUIDataTraceValueKindArray: {
+      uint64_t count = FUIDataTraceReadVarint(cursor);
+      // Every child takes at least a byte, which bounds allocations on corrupt input.
+      if (cursor->failed || count > cursor->length - cursor->offset) {
+        cursor->failed = YES;
+        return nil;
+      }
+      BOOL isArray = kind == FUIDataTraceValueKindArray;
+      NSMutableArray<FUIDataTraceSnapshot *> *children = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+      NSMutableDictionary *dictionary = isArray ? nil : [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+      NSMutableArray *array = isArray ? [NSMutableArray arrayWithCapacity:(NSUInteger)count] : nil;
+      for (uint64_t i = 0; i < count; i++) {
+        NSString *childKey = isArray ? @(i).stringValue : FUIDataTraceReadString(cursor);
+        if (childKey == nil) { return nil; }
+        FUIDataTraceSnapshot *child = FUIDataTraceReadSnapshot(cursor, childKey, depth + 1);
+        if (child == nil) { return nil; }
+        [children addObject:child];
+        if (isArray) {
+          [array addObject:child.value];
+        } else {
+          dictionary[childKey] = child.value;
+        }
+      }
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key
+                                                 value:isArray ? [array copy] : [dictionary copy]
+                                              children:children];
+    }
+    default:
+      cursor->failed = YES;
+      return nil;
+  }
+}
+
+static NSError *FUIDataTraceError(FUIDataTraceErrorCode code, NSString *description) {
+  return [NSError errorWithDomain:FUIDataTraceErrorDomain
+                             code:code
+                         userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+NSArray<FUIDataTraceRecord *> *FUIDataTraceReadRecords(NSURL *url, NSError **error) {
+  NSData *data = [NSData dataWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:error];
+  if (data == nil) { return nil; }
+
+  FUIDataTraceCursor cursor = { data.bytes, data.length, 0, NO };
+  if (data.length < sizeof(FUIDataTraceMagic) ||
+      memcmp(data.bytes, FUIDataTraceMagic, sizeof(FUIDataTraceMagic)) != 0) {
+    if (error != NULL) {
+      *error = FUIDataTraceError(FUIDataTraceErrorCorruptTrace, @"The file is not a data trace");
+    }
+    return nil;
+  }
+  cursor.offset = sizeof(FUIDataTraceMagic);
+  uint64_t version = FUIDataTraceReadVarint(&cursor);
+  if (!cursor.failed && version > FUIDataTraceVersion) {
+    if (error != NULL) {
+      NSString *description =
+          [NSString stringWithFormat:@"Data trace version %llu is not supported", version];
+      *error = FUIDataTraceError(FUIDataTraceErrorUnsupportedVersion, description);
+    }
+    return nil;
+  }
+
+  NSMutableArray<FUIDataTraceRecord *> *records = [NSMutableArray array];
+  uint64_t timestamp = 0;
+  while (!cursor.failed && cursor.offset < cursor.length) {
+    @autoreleasepool {
+      FUIDataTraceRecord *record = [[FUIDataTraceRecord alloc] init];
+      record.type = FUIDataTraceReadByte(&cursor);
+      switch (record.type) {
+        case FUIDataTraceRecordTypeRoot:
+          record.path = FUIDataTraceReadString(&cursor);
+          record.supportsKeyRangeQueries = (FUIDataTraceReadByte(&cursor) & 1) != 0;
+          break;
+        case FUIDataTraceRecordTypeListener:
+          record.listenerID = (NSUInteger)FUIDataTraceReadVarint(&cursor);
+          record.path = FUIDataTraceReadString(&cursor);
+          record.eventType = FUIDataTraceReadByte(&cursor);
+          break;
+        case FUIDataTraceRecordTypeEvent:
+          record.listenerID = (NSUInteger)FUIDataTraceReadVarint(&cursor);
+          timestamp += FUIDataTraceReadVarint(&cursor);
+          record.timestamp = timestamp;
+          record.previousKey = FUIDataTraceReadOptionalString(&cursor);
+          record.snapshot = (FIRDataSnapshot *)FUIDataTraceReadSnapshot(&cursor,
+                                                                        FUIDataTraceReadOptionalString(&cursor),
+                                                                        0);
+          break;
+        case FUIDataTraceRecordTypeCancel: {
+          record.listenerID = (NSUInteger)FUIDataTraceReadVarint(&cursor);
+          timestamp += FUIDataTraceReadVarint(&cursor);
+          record.timestamp = timestamp;
+          NSString *domain = FUIDataTraceReadString(&cursor);
+          NSInteger code = (NSInteger)FUIDataTraceReadSignedVarint(&cursor);
+          if (domain != nil) {
+            record.error = [NSError errorWithDomain:domain code:code userInfo:nil];
+          }
+          break;
+        }
+        default:
+          cursor.failed = YES;
+          break;
+      }
+      if (!cursor.failed) {
+        [records addObject:record];
+      }
+    }
+  }
+
+  if (cursor.failed) {
+    if (error != NULL) {
+      *error = FUIDataTraceError(FUIDataTraceErrorCorruptTrace, @"The data trace is truncated or corrupt");
+    }
+    return nil;
+  }
+  return records;
+}
+
+#pragma mark - FUIDataTraceRecord
+
+@implementation FUIDataTraceRecord
+@end
+
+#pragma mark - FUIDataTraceWriter
+
+@implementation FUIDataTraceWriter {
+  // All guarded by @synchronized (self).
+  NSOutputStream *_stream;
+  NSMutableData *_buffer;
+  NSUInteger _nextListenerID;
+  uint64_t _lastTimestamp;
+  BOOL _hasTimestamp;
+  NSError *_streamError;
+  NSUInteger _eventCount;
+}
+
+- (instancetype)initWithURL:(NSURL *)url error:(NSError **)error {
+  self = [super init];
+  if (self) {
+    _stream = [NSOutputStream outputStreamWithURL:url append:NO];
+    [_stream open];
+    if (_stream.streamStatus != NSStreamStatusOpen) {
+      if (error != NULL) {
+        *error = _stream.streamError ?:
+            [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+      }
+      return nil;
+    }
+    _buffer = [NSMutableData dataWithCapacity:FUIDataTraceFlushThreshold];
+    [_buffer appendBytes:FUIDataTraceMagic length:sizeof(FUIDataTraceMagic)];
+    FUIDataTraceAppendVarint(_buffer, FUIDataTraceVersion);
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (void)dealloc {
+  [self closeWithError:NULL];
+}
+
+- (void)writeRootWithName:(NSString *)name supportsKeyRangeQueries:(BOOL)supportsKeyRangeQueries {
+  @synchronized (self) {
+    if (_stream == nil) { return; }
+    FUIDataTraceAppendByte(_buffer, FUIDataTraceRecordTypeRoot);
+    FUIDataTraceAppendString(_buffer, name);
+    FUIDataTraceAppendByte(_buffer, supportsKeyRangeQueries ? 1 : 0);
+    [self flushIfNeeded];
+  }
+}
+
+- (NSUInteger)writeListenerWithPath:(NSString *)path eventType:(FIRDataEventType)eventType {
+  @synchronized (self) {
+    NSUInteger listenerID = _nextListenerID++;
+    if (_stream == nil) { return listenerID; }
+    FUIDataTraceAppendByte(_buffer, FUIDataTraceRecordTypeListener);
+    FUIDataTraceAppendVarint(_buffer, listenerID);
+    FUIDataTraceAppendString(_buffer, path);
+    FUIDataTraceAppendByte(_buffer, (uint8_t)eventType);
+    [self flushIfNeeded];
+    return listenerID;
+  }
+}
+
+- (void)writeEventForListener:(NSUInteger)listenerID
+                     snapshot:(FIRDataSnapshot *)snapshot
+                  previousKey:(NSString *)previousKey {
+  @synchronized (self) {
+    if (_stream == nil) { return; }
+    FUIDataTraceAppendByte(_buffer, FUIDataTraceRecordTypeEvent);
+    FUIDataTraceAppendVarint(_buffer, listenerID);
+    FUIDataTraceAppendVarint(_buffer, [self elapsedMicroseconds]);
+    FUIDataTraceAppendOptionalString(_buffer, previousKey);
+    FUIDataTraceAppendOptionalString(_buffer, snapshot.key);
+    FUIDataTraceAppendSnapshotValue(_buffer, snapshot);
+    _eventCount++;
+    [self flushIfNeeded];
+  }
+}
+
+- (void)writeCancelForListener:(NSUInteger)listenerID error:(NSError *)error {
+  @synchronized (self) {
+    if (_stream == nil) { return; }
+    FUIDataTraceAppendByte(_buffer, FUIDataTraceRecordTypeCancel);
+    FUIDataTraceAppendVarint(_buffer, listenerID);
+    FUIDataTraceAppendVarint(_buffer, [self elapsedMicroseconds]);
+    FUIDataTraceAppendString(_buffer, error.domain ?: @"");
+    FUIDataTraceAppendSignedVarint(_buffer, error.code);
+    _eventCount++;
+    [self flushIfNeeded];
+  }
+}
+
+- (NSUInteger)eventCount {
+  @synchronized (self) {
+    return _eventCount;
+  }
+}
+
+- (BOOL)closeWithError:(NSError **)error {
+  @synchronized (self) {
+    if (_stream != nil) {
+      [self flush];
+      [_stream close];
+      _stream = nil;
+      _buffer = nil;
+    }
+    if (_streamError != nil && error != NULL) {
+      *error = _streamError;
+    }
+    return _streamError == nil;
+  }
+}
+
+// Must be called while synchronized.
+- (uint64_t)elapsedMicroseconds {
+  uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / NSEC_PER_USEC;
+  uint64_t elapsed = _hasTimestamp ? now - _lastTimestamp : 0;
+  _lastTimestamp = now;
+  _hasTimestamp = YES;
+  return elapsed;
+}
+
+// Must be called while synchronized.
+- (void)flushIfNeeded {
+  if (_buffer.length >= FUIDataTraceFlushThreshold) {
+    [self flush];
+  }
+}
+
+// Must be called while synchronized. A failed write stops recording, since the
+// rest of the trace couldn't be decoded anyway.
+- (void)flush {
+  const uint8_t *bytes = _buffer.bytes;
+  NSUInteger remaining = _buffer.length;
+  while (remaining > 0 && _streamError == nil) {
+    NSInteger written = [_stream write:bytes maxLength:remaining];
+    if (written <= 0) {
+      _streamError = _stream.streamError ?:
+          [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+      break;
+    }
+    bytes += written;
+    remaining -= (NSUInteger)written;
+  }
+  _buffer.length = 0;
+  if (_streamError != nil) {
+    [_stream close];
+    _stream = nil;
+  }
+}
+
+@end
+
+#pragma mark - FUIDataTraceSnapshot
+
+@implementation FUIDataTraceSnapshot {
+  NSArray<FUIDataTraceSnapshot *> *_children;
+}
+
+- (instancetype)initWithKey:(NSString *)key
+                      value:(id)value
+                   children:(NSArray<FUIDataTraceSnapshot *> *)children {
+  self = [super init];
+  if (self) {
+    _key = [key copy];
+    _value = value ?: [NSNull null];
+    _children = [children copy];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (NSUInteger)childrenCount {
+  return _children.count;
+}
+
+- (FIRDatabaseReference *)ref {
+  return nil;
+}
+
+- (id)priority {
+  return nil;
+}
+
+- (NSEnumerator<FUIDataTraceSnapshot *> *)children {
+  return _children.objectEnumerator;
+}
+
+- (BOOL)exists {
+  return ![self.value isEqual:[NSNull null]];
+}
+
+- (BOOL)hasChildren {
+  return _children.count > 0;
+}
+
+- (BOOL)hasChild:(NSString *)childPathString {
+  return [self childSnapshotForPath:childPathString].exists;
+}
+
+- (FUIDataTraceSnapshot *)childSnapshotForPath:(NSString *)childPathString {
+  FUIDataTraceSnapshot *snapshot = self;
+  NSString *key = self.key;
+  for (NSString *component in [childPathString componentsSeparatedByString:@"/"]) {
+    if (component.length == 0) { continue; }
+    key = component;
+    FUIDataTraceSnapshot *child = nil;
+    for (FUIDataTraceSnapshot *candidate in snapshot->_children) {
+      if ([candidate.key isEqualToString:component]) {
+        child = candidate;
+        break;
+      }
+    }
+    if (child == nil) {
+      return [[FUIDataTraceSnapshot alloc] initWithKey:key value:nil children:@[]];
+    }
+    snapshot = child;
+  }
+  return snapshot;
+}
+
+- (id)valueInExportFormat {
+  return self.value;
+}
+
+- (BOOL)isEqual:(id)object {
+  if (![object isKindOfClass:[FUIDataTraceSnapshot class]]) { return NO; }
+  FUIDataTraceSnapshot *snapshot = object;
+  return (self.key == snapshot.key || [self.key isEqualToString:snapshot.key]) &&
+      [self.value isEqual:snapshot.value];
+}
+
+- (NSUInteger)hash {
+  return self.key.hash ^ [self.value hash];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p> { key = %@, value = %@ }",
+          NSStringFromClass(self.class), (void *)self, self.key, self.value];
+}
+
+@end
@@ -0,0 +1,168 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIDataTraceRecorder.h"
+#import "FirebaseDatabaseUI/Sources/FUIDataTrace_Private.h"
+
+static BOOL FUIDataTraceSupportsKeyRangeQueries(id<FUIDataObservable> observable) {
+  return [observable respondsToSelector:@selector(queryOrderedByKey)] &&
+      [observable respondsToSelector:@selector(queryStartingAtValue:)] &&
+      [observable respondsToSelector:@selector(queryEndingAtValue:)];
+}
+
+/// Forwards to an observable, recording what's delivered to its listeners. The writer
+/// is held weakly, so that collections observing the recording observables don't
+/// keep the trace open once the recorder is gone.
+@interface FUIDataTraceRecordingObservable : NSObject <FUIDataObservable>
+
+- (instancetype)initWithObservable:(id<FUIDataObservable>)observable
+                              path:(NSString *)path
+                            writer:(FUIDataTraceWriter *)writer;
+
+@property (nonatomic, readonly) id<FUIDataObservable> observable;
+@property (nonatomic, readonly, copy) NSString *path;
+@property (nonatomic, readonly, weak) FUIDataTraceWriter *writer;
+
+@end
+
+@implementation FUIDataTraceRecordingObservable
+
+- (instancetype)initWithObservable:(id<FUIDataObservable>)observable
+                              path:(NSString *)path
+                            writer:(FUIDataTraceWriter *)writer {
+  self = [super init];
+  if (self) {
+    _observable = observable;
+    _path = [path copy];
+    _writer = writer;
+  }
+  return self;
+}
+
+- (FIRDatabaseHandle)observeEventType:(FIRDataEventType)eventType
+       andPreviousSiblingKeyWithBlock:(void (^)(FIRDataSnapshot *snapshot, NSString *prevKey))block
+                      withCancelBlock:(void (^)(NSError *error))cancelBlock {
+  // Written first, since some observables deliver events before returning.
+  FUIDataTraceWriter *writer = self.writer;
+  NSUInteger listenerID = [writer writeListenerWithPath:self.path eventType:eventType];
+  __weak FUIDataTraceWriter *weakWriter = writer;
+  return [self.observable observeEventType:eventType
+            andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *prevKey) {
+    [weakWriter writeEventForListener:listenerID snapshot:snapshot previousKey:prevKey];
+    block(snapshot, prevKey);
+  } withCancelBlock:^(NSError *error) {
+    [weakWriter writeCancelForListener:listenerID error:error];
+    if (cancelBlock != nil) {
+      cancelBlock(error);
+    }
+  }];
+}
+
+- (void)removeObserverWithHandle:(FIRDatabaseHandle)handle {
+  [self.observable removeObserverWithHandle:handle];
+}
+
+- (id<FUIDataObservable>)child:(NSString *)path {
+  id<FUIDataObservable> child = [self.observable child:path];
+  if (child == nil) { return nil; }
+  NSString *childPath = [NSString stringWithFormat:@"%@/%@", self.path, path];
+  return [[FUIDataTraceRecordingObservable alloc] initWithObservable:child
+                                                                path:childPath
+                                                              writer:self.writer];
+}
+
+// The key range queries are only offered if the recorded observable offers them, so
+// that collections behave the same with and without recording.
+- (BOOL)respondsToSelector:(SEL)selector {
+  if (selector == @selector(queryOrderedByKey) ||
+      selector == @selector(queryStartingAtValue:) ||
+      selector == @selector(queryEndingAtValue:)) {
+    return [self.observable respondsToSelector:selector];
+  }
+  return [super respondsToSelector:selector];
+}
+
+- (id<FUIDataObservable>)queryOrderedByKey {
+  return [self recordingQuery:[self.observable queryOrderedByKey] suffix:@"?orderByKey"];
+}
+
+- (id<FUIDataObservable>)queryStartingAtValue:(id)startValue {
+  NSString *suffix =
+      [NSString stringWithFormat:@"?startAt=%@", FUIDataTraceQueryValueDescription(startValue)];
+  return [self recordingQuery:[self.observable queryStartingAtValue:startValue] suffix:suffix];
+}
+
+- (id<FUIDataObservable>)queryEndingAtValue:(id)endValue {
+  NSString *suffix =
+      [NSString stringWithFormat:@"?endAt=%@", FUIDataTraceQueryValueDescription(endValue)];
+  return [self recordingQuery:[self.observable queryEndingAtValue:endValue] suffix:suffix];
+}
+
+- (id<FUIDataObservable>)recordingQuery:(id<FUIDataObservable>)query suffix:(NSString *)suffix {
+  return [[FUIDataTraceRecordingObservable alloc] initWithObservable:query
+                                                                path:[self.path stringByAppendingString:suffix]
+                                                              writer:self.writer];
+}
+
+@end
+
+@implementation FUIDataTraceRecorder {
+  FUIDataTraceWriter *_writer;
+}
+
+- (instancetype)initWithURL:(NSURL *)url error:(NSError **)error {
+  self = [super init];
+  if (self) {
+    _writer = [[FUIDataTraceWriter alloc] initWithURL:url error:error];
+    if (_writer == nil) {
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (id<FUIDataObservable>)recordingObservable:(id<FUIDataObservable>)observable
+                                        name:(NSString *)name {
+  NSParameterAssert(observable != nil);
+  NSParameterAssert(name != nil);
+  [_writer writeRootWithName:name
+     supportsKeyRangeQueries:FUIDataTraceSupportsKeyRangeQueries(observable)];
+  return [[FUIDataTraceRecordingObservable alloc] initWithObservable:observable
+                                                                path:name
+                                                              writer:_writer];
+}
+
+- (NSUInteger)recordedEventCount {
+  return _writer.eventCount;
+}
+
+- (BOOL)finishRecordingWithError:(NSError **)error {
+  return [_writer closeWithError:error];
+}
+
+@end
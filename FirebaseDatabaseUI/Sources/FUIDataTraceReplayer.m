@@ -0,0 +1,324 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIDataTraceReplayer.h"
+#import "FirebaseDatabaseUI/Sources/FUIDataTrace_Private.h"
+
+static NSString *FUIDataTraceListenerKey(FIRDataEventType eventType, NSString *path) {
+  return [NSString stringWithFormat:@"%ld %@", (long)eventType, path];
+}
+
+@interface FUIDataTraceReplayer ()
+
+- (FIRDatabaseHandle)observeEventType:(FIRDataEventType)eventType
+                                 path:(NSString *)path
+                                block:(void (^)(FIRDataSnapshot *snapshot, NSString *prevKey))block
+                          cancelBlock:(void (^)(NSError *error))cancelBlock;
+
+- (void)removeObserverWithHandle:(FIRDatabaseHandle)handle;
+
+@end
+
+/// A listener attached to one of the replayer's observables.
+@interface FUIDataTraceReplayListener : NSObject
+@property (nonatomic, copy) void (^block)(FIRDataSnapshot *snapshot, NSString *prevKey);
+@property (nonatomic, copy) void (^cancelBlock)(NSError *error);
+@end
+
+@implementation FUIDataTraceReplayListener
+@end
+
+/// Stands in for a recorded query, attaching its listeners to the replayer.
+@interface FUIDataTraceReplayObservable : NSObject <FUIDataObservable>
+
+- (instancetype)initWithReplayer:(FUIDataTraceReplayer *)replayer
+                            path:(NSString *)path
+         supportsKeyRangeQueries:(BOOL)supportsKeyRangeQueries;
+
+@property (nonatomic, readonly) FUIDataTraceReplayer *replayer;
+@property (nonatomic, readonly, copy) NSString *path;
+@property (nonatomic, readonly) BOOL supportsKeyRangeQueries;
+
+@end
+
+@implementation FUIDataTraceReplayObservable
+
+- (instancetype)initWithReplayer:(FUIDataTraceReplayer *)replayer
+                            path:(NSString *)path
+         supportsKeyRangeQueries:(BOOL)supportsKeyRangeQueries {
+  self = [super init];
+  if (self) {
+    _replayer = replayer;
+    _path = [path copy];
+    _supportsKeyRangeQueries = supportsKeyRangeQueries;
+  }
+  return self;
+}
+
+- (FIRDatabaseHandle)observeEventType:(FIRDataEventType)eventType
+       andPreviousSiblingKeyWithBlock:(void (^)(FIRDataSnapshot *snapshot, NSString *prevKey))block
+                      withCancelBlock:(void (^)(NSError *error))cancelBlock {
+  return [self.replayer observeEventType:eventType path:self.path block:block cancelBlock:cancelBlock];
+}
+
+- (void)removeObserverWithHandle:(FIRDatabaseHandle)handle {
+  [self.replayer removeObserverWithHandle:handle];
+}
+
+- (id<FUIDataObservable>)child:(NSString *)path {
+  return [self observableWithPath:[NSString stringWithFormat:@"%@/%@", self.path, path]];
+}
+
+// Mirrors whether the recorded query offered key range queries.
+- (BOOL)respondsToSelector:(SEL)selector {
+  if (selector == @selector(queryOrderedByKey) ||
+      selector == @selector(queryStartingAtValue:) ||
+      selector == @selector(queryEndingAtValue:)) {
+    return self.supportsKeyRangeQueries;
+  }
+  return [super respondsToSelector:selector];
+}
+
+- (id<FUIDataObservable>)queryOrderedByKey {
+  return [self observableWithPath:[self.path stringByAppendingString:@"?orderByKey"]];
+}
+
+- (id<FUIDataObservable>)queryStartingAtValue:(id)startValue {
+  return [self observableWithPath:[self.path stringByAppendingFormat:@"?startAt=%@",
+                                   FUIDataTraceQueryValueDescription(startValue)]];
+}
+
+- (id<FUIDataObservable>)queryEndingAtValue:(id)endValue {
+  return [self observableWithPath:[self.path stringByAppendingFormat:@"?endAt=%@",
+                                   FUIDataTraceQueryValueDescription(endValue)]];
+}
+
+- (FUIDataTraceReplayObservable *)observableWithPath:(NSString *)path {
+  return [[FUIDataTraceReplayObservable alloc] initWithReplayer:self.replayer
+                                                           path:path
+                                        supportsKeyRangeQueries:self.supportsKeyRangeQueries];
+}
+
+@end
+
+@implementation FUIDataTraceReplayer {
+  /// Whether each recorded root offered key range queries, by name.
+  NSDictionary<NSString *, NSNumber *> *_roots;
+
+  /// The ids of the recorded listeners, in the order they were attached, by the
+  /// event type and path they listened to.
+  NSDictionary<NSString *, NSArray<NSNumber *> *> *_recordedListeners;
+
+  /// How many listeners have been attached, by event type and path.
+  NSMutableDictionary<NSString *, NSNumber *> *_attachedListenerCounts;
+
+  /// The events and cancellations to deliver, in order.
+  NSArray<FUIDataTraceRecord *> *_events;
+  NSUInteger _nextEventIndex;
+
+  /// Attached listeners, by the id of the recorded listener they stand in for.
+  NSMutableDictionary<NSNumber *, FUIDataTraceReplayListener *> *_listeners;
+
+  /// The recorded listener id of each attached listener, by handle.
+  NSMutableDictionary<NSNumber *, NSNumber *> *_listenerIDsByHandle;
+  FIRDatabaseHandle _nextHandle;
+
+  /// Incremented to invalidate scheduled deliveries.
+  NSUInteger _replayGeneration;
+}
+
+- (instancetype)initWithContentsOfURL:(NSURL *)url error:(NSError **)error {
+  self = [super init];
+  if (self) {
+    NSArray<FUIDataTraceRecord *> *records = FUIDataTraceReadRecords(url, error);
+    if (records == nil) {
+      return nil;
+    }
+
+    NSMutableDictionary<NSString *, NSNumber *> *roots = [NSMutableDictionary dictionary];
+    NSMutableDictionary<NSString *, NSMutableArray<NSNumber *> *> *recordedListeners =
+        [NSMutableDictionary dictionary];
+    NSMutableArray<FUIDataTraceRecord *> *events = [NSMutableArray arrayWithCapacity:records.count];
+    for (FUIDataTraceRecord *record in records) {
+      switch (record.type) {
+        case FUIDataTraceRecordTypeRoot:
+          roots[record.path] = @(record.supportsKeyRangeQueries);
+          break;
+        case FUIDataTraceRecordTypeListener: {
+          NSString *key = FUIDataTraceListenerKey(record.eventType, record.path);
+          if (recordedListeners[key] == nil) {
+            recordedListeners[key] = [NSMutableArray array];
+          }
+          [recordedListeners[key] addObject:@(record.listenerID)];
+          break;
+        }
+        case FUIDataTraceRecordTypeEvent:
+        case FUIDataTraceRecordTypeCancel:
+          [events addObject:record];
+          break;
+      }
+    }
+    _roots = [roots copy];
+    _recordedListeners = [recordedListeners copy];
+    _events = [events copy];
+    _attachedListenerCounts = [NSMutableDictionary dictionary];
+    _listeners = [NSMutableDictionary dictionary];
+    _listenerIDsByHandle = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (NSUInteger)eventCount {
+  return _events.count;
+}
+
+- (NSTimeInterval)duration {
+  if (_events.count == 0) { return 0; }
+  return (NSTimeInterval)(_events.lastObject.timestamp - _events.firstObject.timestamp) / USEC_PER_SEC;
+}
+
+- (id<FUIDataObservable>)observableNamed:(NSString *)name {
+  NSParameterAssert(name != nil);
+  return [[FUIDataTraceReplayObservable alloc] initWithReplayer:self
+                                                           path:name
+                                        supportsKeyRangeQueries:_roots[name].boolValue];
+}
+
+#pragma mark - Listeners
+
+- (FIRDatabaseHandle)observeEventType:(FIRDataEventType)eventType
+                                 path:(NSString *)path
+                                block:(void (^)(FIRDataSnapshot *snapshot, NSString *prevKey))block
+                          cancelBlock:(void (^)(NSError *error))cancelBlock {
+  FIRDatabaseHandle handle = _nextHandle++;
+
+  // Listeners are matched to the trace by the order they were attached in for each
+  // query and event type, which doesn't depend on when events arrive.
+  NSString *key = FUIDataTraceListenerKey(eventType, path);
+  NSUInteger occurrence = _attachedListenerCounts[key].unsignedIntegerValue;
+  _attachedListenerCounts[key] = @(occurrence + 1);
+  NSArray<NSNumber *> *recordedIDs = _recordedListeners[key];
+  if (occurrence >= recordedIDs.count) {
+    _unmatchedListenerCount++;
+    return handle;
+  }
+
+  FUIDataTraceReplayListener *listener = [[FUIDataTraceReplayListener alloc] init];
+  listener.block = block;
+  listener.cancelBlock = cancelBlock;
+  _listeners[recordedIDs[occurrence]] = listener;
+  _listenerIDsByHandle[@(handle)] = recordedIDs[occurrence];
+  return handle;
+}
+
+- (void)removeObserverWithHandle:(FIRDatabaseHandle)handle {
+  NSNumber *listenerID = _listenerIDsByHandle[@(handle)];
+  if (listenerID == nil) { return; }
+  [_listenerIDsByHandle removeObjectForKey:@(handle)];
+  [_listeners removeObjectForKey:listenerID];
+}
+
+#pragma mark - Replaying
+
+- (void)replayWithSpeed:(FUIDataTraceReplaySpeed)speed completion:(void (^)(void))completion {
+  _replayGeneration++;
+  if (speed == FUIDataTraceReplaySpeedMaximum) {
+    while (_nextEventIndex < _events.count) {
+      @autoreleasepool {
+        [self deliverEvent:_events[_nextEventIndex++]];
+      }
+    }
+    if (completion != nil) {
+      completion();
+    }
+    return;
+  }
+
+  uint64_t firstTimestamp = _nextEventIndex < _events.count ? _events[_nextEventIndex].timestamp : 0;
+  [self deliverEventsFromTimestamp:firstTimestamp
+                         startTime:dispatch_time(DISPATCH_TIME_NOW, 0)
+                        generation:_replayGeneration
+                        completion:completion];
+}
+
+- (void)cancelReplay {
+  _replayGeneration++;
+}
+
+// Delivers every event that's due and schedules the next one.
+- (void)deliverEventsFromTimestamp:(uint64_t)firstTimestamp
+                         startTime:(dispatch_time_t)startTime
+                        generation:(NSUInteger)generation
+                        completion:(void (^)(void))completion {
+  if (generation != _replayGeneration) { return; }
+
+  uint64_t now = dispatch_time(DISPATCH_TIME_NOW, 0);
+  while (_nextEventIndex < _events.count) {
+    FUIDataTraceRecord *event = _events[_nextEventIndex];
+    dispatch_time_t due = dispatch_time(startTime, (int64_t)((event.timestamp - firstTimestamp) * NSEC_PER_USEC));
+    if (due > now) {
+      __weak FUIDataTraceReplayer *weakSelf = self;
+      dispatch_after(due, dispatch_get_main_queue(), ^{
+        [weakSelf deliverEventsFromTimestamp:firstTimestamp
+                                   startTime:startTime
+                                  generation:generation
+                                  completion:completion];
+      });
+      return;
+    }
+    _nextEventIndex++;
+    @autoreleasepool {
+      [self deliverEvent:event];
+    }
+    // A listener may have cancelled the replay.
+    if (generation != _replayGeneration) { return; }
+  }
+  if (completion != nil) {
+    completion();
+  }
+}
+
+- (void)deliverEvent:(FUIDataTraceRecord *)event {
+  NSNumber *listenerID = @(event.listenerID);
+  FUIDataTraceReplayListener *listener = _listeners[listenerID];
+  if (listener == nil) {
+    _droppedEventCount++;
+    return;
+  }
+  if (event.type == FUIDataTraceRecordTypeCancel) {
+    // Like the database, cancelled listeners are removed.
+    [_listeners removeObjectForKey:listenerID];
+    if (listener.cancelBlock != nil) {
+      listener.cancelBlock(event.error);
+    }
+    return;
+  }
+  listener.block(event.snapshot, event.previousKey);
+}
+
+@end
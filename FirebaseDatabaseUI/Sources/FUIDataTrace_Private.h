@@ -0,0 +1,143 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <FirebaseDatabase/FirebaseDatabase.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ * Trace files start with the 8 byte magic "FUITRACE" and a varint format version,
+ * followed by records. Each record starts with its type byte. Integers are unsigned
+ * LEB128 varints, signed integers are zigzag encoded first, and strings are a varint
+ * byte length followed by UTF-8. Optional strings store their length plus one, with
+ * zero meaning nil.
+ *
+ *   Root      name, flags (bit 0: supports key range queries)
+ *   Listener  listener id, path, event type
+ *   Event     listener id, microseconds since the previous event or cancel,
+ *             optional previous child key, snapshot
+ *   Cancel    listener id, microseconds since the previous event or cancel,
+ *             error domain, error code
+ *
+ * A snapshot is an optional key followed by a value. A value is a kind byte and,
+ * depending on the kind, a string, a zigzag integer, a little endian double, an
+ * object (child count, then each child's key and value in the snapshot's order) or an
+ * array (element count, then each element's value).
+ */
+
+typedef NS_ENUM(uint8_t, FUIDataTraceRecordType) {
+  FUIDataTraceRecordTypeRoot = 1,
+  FUIDataTraceRecordTypeListener = 2,
+  FUIDataTraceRecordTypeEvent = 3,
+  FUIDataTraceRecordTypeCancel = 4,
+};
+
+/// A decoded trace record. Which properties are set depends on the record's type.
+@interface FUIDataTraceRecord : NSObject
+
+@property (nonatomic, assign) FUIDataTraceRecordType type;
+
+/// The root's name, or the path of a listener's query.
+@property (nonatomic, copy, nullable) NSString *path;
+
+/// Set on root records.
+@property (nonatomic, assign) BOOL supportsKeyRangeQueries;
+
+/// Set on listener, event and cancel records.
+@property (nonatomic, assign) NSUInteger listenerID;
+
+/// Set on listener records.
+@property (nonatomic, assign) FIRDataEventType eventType;
+
+/// Microseconds since the first event or cancel of the trace. Set on event and
+/// cancel records.
+@property (nonatomic, assign) uint64_t timestamp;
+
+/// Set on event records.
+@property (nonatomic, strong, nullable) FIRDataSnapshot *snapshot;
+@property (nonatomic, copy, nullable) NSString *previousKey;
+
+/// Set on cancel records.
+@property (nonatomic, strong, nullable) NSError *error;
+
+@end
+
+/// Writes trace records to a file, buffering them in memory. Thread-safe.
+@interface FUIDataTraceWriter : NSObject
+
+- (nullable instancetype)initWithURL:(NSURL *)url error:(NSError **)error NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// The number of event and cancel records written.
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+- (void)writeRootWithName:(NSString *)name supportsKeyRangeQueries:(BOOL)supportsKeyRangeQueries;
+
+/// Writes a listener record and returns the listener's id.
+- (NSUInteger)writeListenerWithPath:(NSString *)path eventType:(FIRDataEventType)eventType;
+
+- (void)writeEventForListener:(NSUInteger)listenerID
+                     snapshot:(FIRDataSnapshot *)snapshot
+                  previousKey:(nullable NSString *)previousKey;
+
+- (void)writeCancelForListener:(NSUInteger)listenerID error:(NSError *)error;
+
+/// Writes any buffered records and closes the file. Later writes are ignored.
+- (BOOL)closeWithError:(NSError **)error;
+
+@end
+
+/// Describes a key range query's start or end value in a listener's path.
+FOUNDATION_EXTERN NSString *FUIDataTraceQueryValueDescription(id _Nullable value);
+
+/// Decodes every record of a trace file.
+FOUNDATION_EXTERN NSArray<FUIDataTraceRecord *> *_Nullable
+    FUIDataTraceReadRecords(NSURL *url, NSError **error);
+
+/**
+ * A snapshot decoded from a trace. It isn't a FIRDataSnapshot, which can't be
+ * created outside of the Firebase SDK, but implements the parts of its interface
+ * that describe data, and is handed to listeners in its place. Its @c ref is always nil.
+ */
+@interface FUIDataTraceSnapshot : NSObject
+
+- (instancetype)initWithKey:(nullable NSString *)key
+                      value:(nullable id)value
+                   children:(NSArray<FUIDataTraceSnapshot *> *)children NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly, copy, nullable) NSString *key;
+@property (nonatomic, readonly, strong, nullable) id value;
+@property (nonatomic, readonly) NSUInteger childrenCount;
+@property (nonatomic, readonly, nullable) FIRDatabaseReference *ref;
+@property (nonatomic, readonly, nullable) id priority;
+
+- (NSEnumerator<FUIDataTraceSnapshot *> *)children;
+- (BOOL)exists;
+- (BOOL)hasChildren;
+- (BOOL)hasChild:(NSString *)childPathString;
+- (FUIDataTraceSnapshot *)childSnapshotForPath:(NSString *)childPathString;
+- (nullable id)valueInExportFormat;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,316 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUIFilteredCollection_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+
+@interface FUIFilteredCollection () <FUICollectionDelegate>
+
+/**
+ * A weight of 1 for each of the wrapped collection's items that matches the
+ * predicate and 0 for the others, so the filtered index of an item is the total
+ * weight before it.
+ */
+@property (strong, nonatomic) FUIRankTree *visibility;
+
+/**
+ * The primary delegate and any additional delegates.
+ */
+@property (strong, nonatomic) FUICollectionDelegateList *delegates;
+
+@property (nonatomic, assign) BOOL isObserving;
+
+/**
+ * YES between the wrapped collection's arrayDidBeginUpdates: and arrayDidEndUpdates:.
+ */
+@property (nonatomic, assign) BOOL isSendingUpdates;
+
+@end
+
+@implementation FUIFilteredCollection
+
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                         predicate:(BOOL (^)(FIRDataSnapshot *))predicate {
+  NSParameterAssert(collection != nil);
+  NSParameterAssert(predicate != nil);
+  self = [super init];
+  if (self != nil) {
+    _collection = collection;
+    _predicate = [predicate copy];
+    _visibility = [[FUIRankTree alloc] init];
+    _delegates = [[FUICollectionDelegateList alloc] init];
+    _observesCollection = YES;
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+#pragma mark - FUICollection
+
+- (NSArray<FIRDataSnapshot *> *)items {
+  NSArray<FIRDataSnapshot *> *items = self.collection.items;
+  NSMutableArray<FIRDataSnapshot *> *filtered = [NSMutableArray arrayWithCapacity:self.count];
+  NSUInteger count = MIN(items.count, self.visibility.count);
+  for (NSUInteger i = 0; i < count; i++) {
+    if ([self.visibility weightAtIndex:i] > 0) {
+      [filtered addObject:items[i]];
+    }
+  }
+  return [filtered copy];
+}
+
+- (NSUInteger)count {
+  return self.visibility.totalWeight;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index {
+  NSUInteger collectionIndex = [self collectionIndexForIndex:index];
+  if (collectionIndex == NSNotFound) {
+    [NSException raise:NSRangeException
+                format:@"Index %ld beyond bounds of filtered collection with %lu items",
+                       (long)index, (unsigned long)self.count];
+  }
+  return [self.collection snapshotAtIndex:collectionIndex];
+}
+
+- (void)observeQuery {
+  if (self.isObserving) { return; }
+  self.isObserving = YES;
+
+  if ([self.collection respondsToSelector:@selector(addDelegate:)]) {
+    [self.collection addDelegate:self];
+  } else {
+    self.collection.delegate = self;
+  }
+
+  // The wrapped collection may already contain items, which are matched without
+  // sending events, the same way an FUIArray starts out with its query's contents.
+  NSArray<FIRDataSnapshot *> *items = self.collection.items;
+  NSSet<NSString *> *matchingKeys = self.matchingKeysBlock != nil ? self.matchingKeysBlock() : nil;
+  [self.visibility replaceAllWeightsWithCount:items.count weights:^NSUInteger(NSUInteger index) {
+    if (matchingKeys != nil) {
+      return [matchingKeys containsObject:items[index].key] ? 1 : 0;
+    }
+    return self.predicate(items[index]) ? 1 : 0;
+  }];
+
+  if (self.observesCollection) {
+    [self.collection observeQuery];
+  }
+}
+
+- (void)invalidate {
+  if (!self.isObserving) { return; }
+  if (self.observesCollection) {
+    // The wrapped collection sends removals for its items, which are forwarded.
+    [self.collection invalidate];
+  } else {
+    [self removeAllItems];
+  }
+
+  if ([self.collection respondsToSelector:@selector(removeDelegate:)]) {
+    [self.collection removeDelegate:self];
+  } else if (self.collection.delegate == self) {
+    self.collection.delegate = nil;
+  }
+  [self.visibility removeAllWeights];
+  self.isSendingUpdates = NO;
+  self.isObserving = NO;
+}
+
+- (id<FUICollectionDelegate>)delegate {
+  return self.delegates.primaryDelegate;
+}
+
+- (void)setDelegate:(id<FUICollectionDelegate>)delegate {
+  self.delegates.primaryDelegate = delegate;
+}
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates addDelegate:delegate];
+}
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates removeDelegate:delegate];
+}
+
+// Sends a removal for every item, from the last to the first, in one batch.
+- (void)removeAllItems {
+  NSUInteger count = self.count;
+  if (count == 0) { return; }
+  NSArray<FIRDataSnapshot *> *items = self.items;
+  BOOL startsBatch = !self.isSendingUpdates;
+  if (startsBatch) {
+    [self.delegates arrayDidBeginUpdates:self];
+  }
+  for (NSUInteger i = count; i > 0; i--) {
+    [self.visibility setWeight:0 atIndex:[self collectionIndexForIndex:i - 1]];
+    [self.delegates array:self didRemoveObject:items[i - 1] atIndex:i - 1];
+  }
+  if (startsBatch) {
+    [self.delegates arrayDidEndUpdates:self];
+  }
+}
+
+#pragma mark - Index mapping
+
+- (NSUInteger)collectionIndexForIndex:(NSUInteger)index {
+  return [self.visibility indexContainingWeightOffset:index];
+}
+
+- (NSUInteger)indexForCollectionIndex:(NSUInteger)collectionIndex {
+  if (collectionIndex >= self.visibility.count ||
+      [self.visibility weightAtIndex:collectionIndex] == 0) {
+    return NSNotFound;
+  }
+  return [self.visibility weightBeforeIndex:collectionIndex];
+}
+
+#pragma mark - Predicate
+
+- (void)setPredicate:(BOOL (^)(FIRDataSnapshot *))predicate {
+  NSParameterAssert(predicate != nil);
+  _predicate = [predicate copy];
+  if (!self.isObserving) { return; }
+
+  NSArray<FIRDataSnapshot *> *items = self.collection.items;
+  NSUInteger count = items.count;
+  NSAssert(count == self.visibility.count, @"Filtered collection is out of sync with %@",
+           self.collection);
+
+  NSMutableData *matches = [NSMutableData dataWithLength:count * sizeof(BOOL)];
+  NSMutableData *matched = [NSMutableData dataWithLength:count * sizeof(BOOL)];
+  BOOL *newMatches = matches.mutableBytes;
+  BOOL *oldMatches = matched.mutableBytes;
+  BOOL changed = NO;
+  for (NSUInteger i = 0; i < count; i++) {
+    newMatches[i] = self.predicate(items[i]);
+    oldMatches[i] = [self.visibility weightAtIndex:i] > 0;
+    changed = changed || newMatches[i] != oldMatches[i];
+  }
+  if (!changed) { return; }
+
+  BOOL startsBatch = !self.isSendingUpdates;
+  if (startsBatch) {
+    [self.delegates arrayDidBeginUpdates:self];
+  }
+
+  // Removals are sent from the end so that each index is valid both before the batch
+  // and at the time it's sent, and insertions from the start for the same reason.
+  NSUInteger oldIndex = self.visibility.totalWeight;
+  for (NSUInteger i = count; i > 0; i--) {
+    if (!oldMatches[i - 1]) { continue; }
+    oldIndex--;
+    if (!newMatches[i - 1]) {
+      [self.visibility setWeight:0 atIndex:i - 1];
+      [self.delegates array:self didRemoveObject:items[i - 1] atIndex:oldIndex];
+    }
+  }
+  NSUInteger newIndex = 0;
+  for (NSUInteger i = 0; i < count; i++) {
+    if (!newMatches[i]) { continue; }
+    if (!oldMatches[i]) {
+      [self.visibility setWeight:1 atIndex:i];
+      [self.delegates array:self didAddObject:items[i] atIndex:newIndex];
+    }
+    newIndex++;
+  }
+
+  if (startsBatch) {
+    [self.delegates arrayDidEndUpdates:self];
+  }
+}
+
+#pragma mark - FUICollectionDelegate
+
+- (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
+  self.isSendingUpdates = YES;
+  [self.delegates arrayDidBeginUpdates:self];
+}
+
+- (void)arrayDidEndUpdates:(id<FUICollection>)collection {
+  self.isSendingUpdates = NO;
+  [self.delegates arrayDidEndUpdates:self];
+}
+
+- (void)array:(id<FUICollection>)array didAddObject:(id)object atIndex:(NSUInteger)index {
+  BOOL matches = self.predicate(object);
+  [self.visibility insertWeight:matches ? 1 : 0 atIndex:index];
+  if (matches) {
+    [self.delegates array:self
+             didAddObject:object
+                  atIndex:[self.visibility weightBeforeIndex:index]];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didChangeObject:(id)object atIndex:(NSUInteger)index {
+  BOOL matched = [self.visibility weightAtIndex:index] > 0;
+  BOOL matches = self.predicate(object);
+  NSUInteger filteredIndex = [self.visibility weightBeforeIndex:index];
+
+  if (matched && matches) {
+    [self.delegates array:self didChangeObject:object atIndex:filteredIndex];
+  } else if (matched) {
+    [self.visibility setWeight:0 atIndex:index];
+    [self.delegates array:self didRemoveObject:object atIndex:filteredIndex];
+  } else if (matches) {
+    [self.visibility setWeight:1 atIndex:index];
+    [self.delegates array:self didAddObject:object atIndex:filteredIndex];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didRemoveObject:(id)object atIndex:(NSUInteger)index {
+  BOOL matched = [self.visibility weightAtIndex:index] > 0;
+  NSUInteger filteredIndex = [self.visibility weightBeforeIndex:index];
+  [self.visibility removeWeightAtIndex:index];
+  if (matched) {
+    [self.delegates array:self didRemoveObject:object atIndex:filteredIndex];
+  }
+}
+
+- (void)array:(id<FUICollection>)array
+    didMoveObject:(id)object
+        fromIndex:(NSUInteger)fromIndex
+          toIndex:(NSUInteger)toIndex {
+  NSUInteger weight = [self.visibility weightAtIndex:fromIndex];
+  NSUInteger filteredFromIndex = [self.visibility weightBeforeIndex:fromIndex];
+  [self.visibility removeWeightAtIndex:fromIndex];
+  [self.visibility insertWeight:weight atIndex:toIndex];
+  if (weight > 0) {
+    [self.delegates array:self
+            didMoveObject:object
+                fromIndex:filteredFromIndex
+                  toIndex:[self.visibility weightBeforeIndex:toIndex]];
+  }
+}
+
+- (void)array:(id<FUICollection>)array queryCancelledWithError:(NSError *)error {
+  [self.delegates array:self queryCancelledWithError:error];
+}
+
+@end
@@ -0,0 +1,37 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIFilteredCollection.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FUIFilteredCollection ()
+
+/**
+ * Returns the keys of the wrapped collection's items that match the predicate. If
+ * set, @c observeQuery uses it to find the items already in the wrapped collection,
+ * instead of evaluating the predicate on each of them. Used by FUISearchIndex, which
+ * can answer from its postings without reading any snapshot.
+ */
+@property (nonatomic, copy, nullable) NSSet<NSString *> *(^matchingKeysBlock)(void);
+
+@end
+
+NS_ASSUME_NONNULL_END
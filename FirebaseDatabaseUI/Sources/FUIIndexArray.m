@@ -19,7 +19,42 @@
 // clang-format on
 
 #import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIIndexArray.h"
-#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIQueryObserver.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionMetrics_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUIQueryObserver_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUIVersionPublisher.h"
+
+/**
+ * A single key range query over the data node that loads the rows for several
+ * index keys at once.
+ */
+@interface FUIIndexRangeObserver : NSObject
+
+@property (nonatomic, readonly) FUIIndexJoinRange *range;
+@property (nonatomic, readonly) FUIQueryObserver *observer;
+
+/// The keys of the rows currently loaded by this range query.
+@property (nonatomic, readonly) NSMutableSet<NSString *> *keys;
+
+/// The children from the most recent value event, or nil until the first one arrives.
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, FIRDataSnapshot *> *children;
+
+- (instancetype)initWithRange:(FUIIndexJoinRange *)range query:(id<FUIDataObservable>)query;
+
+@end
+
+@implementation FUIIndexRangeObserver
+
+- (instancetype)initWithRange:(FUIIndexJoinRange *)range query:(id<FUIDataObservable>)query {
+  self = [super init];
+  if (self != nil) {
+    _range = range;
+    _observer = [[FUIQueryObserver alloc] initWithQuery:query];
+    _keys = [NSMutableSet setWithCapacity:range.keys.count];
+  }
+  return self;
+}
+
+@end
 
 @interface FUIIndexArray () <FUICollectionDelegate>
 
@@ -30,6 +65,29 @@
 
 @property (nonatomic, readonly) NSMutableArray<FUIQueryObserver *> *observers;
 
+@property (nonatomic, readonly) FUIVersionPublisher *versionPublisher;
+
+/// Set when loaded contents change outside of an index update batch, so that
+/// several loads finishing in the same run loop pass only publish one version.
+@property (nonatomic, assign) BOOL needsPublish;
+
+/// YES if rows are loaded through the join planner. Decided when observing starts.
+@property (nonatomic, assign) BOOL usesJoinPlanner;
+
+/// The observer for each row, by index key. Only used with a join planner.
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, FUIQueryObserver *> *rowsByKey;
+
+/// Keys of rows added during the current index batch, which are handed to the
+/// join planner when the batch ends.
+@property (nonatomic, readonly) NSMutableSet<NSString *> *pendingKeys;
+
+/// The active range queries, and the range query loading each row by index key.
+@property (nonatomic, readonly) NSMutableArray<FUIIndexRangeObserver *> *rangeObservers;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, FUIIndexRangeObserver *> *rangesByKey;
+
+/// Measures index batches for the metrics sink. Nil while there's no sink.
+@property (nonatomic, strong, nullable) FUICollectionMetricsRecorder *metricsRecorder;
+
 @end
 
 /**
@@ -59,6 +117,12 @@
     _data = data;
     _observers = [NSMutableArray array];
     _delegate = delegate;
+    _versionPublisher = [[FUIVersionPublisher alloc] init];
+    _rowsByKey = [NSMutableDictionary dictionary];
+    _pendingKeys = [NSMutableSet set];
+    _rangeObservers = [NSMutableArray array];
+    _rangesByKey = [NSMutableDictionary dictionary];
+    _slowCallbackThreshold = FUICollectionDefaultSlowCallbackThreshold;
   }
   return self;
 }
@@ -69,6 +133,10 @@
 }
 
 - (void)observeQueries {
+  self.usesJoinPlanner = self.joinPlanner != nil &&
+      [self.data respondsToSelector:@selector(queryOrderedByKey)] &&
+      [self.data respondsToSelector:@selector(queryStartingAtValue:)] &&
+      [self.data respondsToSelector:@selector(queryEndingAtValue:)];
   _indexArray = [[FUIArray alloc] initWithQuery:self.index delegate:self];
   [_indexArray observeQuery];
 }
@@ -92,6 +160,46 @@
   return self.observers.count;
 }
 
+- (id<FUICollectionMetricsSink>)metricsSink {
+  return self.metricsRecorder.sink;
+}
+
+- (void)setMetricsSink:(id<FUICollectionMetricsSink>)metricsSink {
+  if (metricsSink == self.metricsRecorder.sink) { return; }
+  FUICollectionMetricsRecorder *recorder = nil;
+  if (metricsSink != nil) {
+    recorder = [[FUICollectionMetricsRecorder alloc] initWithCollection:self sink:metricsSink];
+    recorder.slowCallbackThreshold = self.slowCallbackThreshold;
+  }
+  self.metricsRecorder = recorder;
+}
+
+- (void)setSlowCallbackThreshold:(NSTimeInterval)slowCallbackThreshold {
+  _slowCallbackThreshold = slowCallbackThreshold;
+  self.metricsRecorder.slowCallbackThreshold = slowCallbackThreshold;
+}
+
+- (FUICollectionVersion *)currentVersion {
+  return [self.versionPublisher currentVersion];
+}
+
+- (void)publishVersion {
+  self.needsPublish = NO;
+  [self.versionPublisher publishItems:self.items];
+}
+
+- (void)schedulePublish {
+  if (self.needsPublish) { return; }
+  self.needsPublish = YES;
+  __weak typeof(self) wSelf = self;
+  dispatch_async(dispatch_get_main_queue(), ^{
+    __strong typeof(wSelf) sSelf = wSelf;
+    if (sSelf.needsPublish) {
+      [sSelf publishVersion];
+    }
+  });
+}
+
 - (void)observeQuery {
   [self observeQueries];
 }
@@ -103,6 +211,14 @@
     [observer removeAllObservers];
   }
   _observers = nil;
+  for (FUIIndexRangeObserver *rangeObserver in self.rangeObservers) {
+    [rangeObserver.observer removeAllObservers];
+  }
+  [self.rangeObservers removeAllObjects];
+  [self.rangesByKey removeAllObjects];
+  [self.rowsByKey removeAllObjects];
+  [self.pendingKeys removeAllObjects];
+  [self publishVersion];
 }
 
 - (FIRDataSnapshot *)objectAtIndex:(NSUInteger)index {
@@ -113,6 +229,184 @@
   [self invalidate];
 }
 
+#pragma mark - Loading rows
+
+// Returns the observer for a new row. Without a join planner the row starts loading
+// right away; otherwise it waits for the planner at the end of the index batch.
+- (FUIQueryObserver *)rowObserverForKey:(NSString *)key {
+  id<FUIDataObservable> query = [self.data child:key];
+  if (!self.usesJoinPlanner) {
+    __weak typeof(self) wSelf = self;
+    return [FUIQueryObserver observerForQuery:query
+                                   completion:^(FUIQueryObserver *observer,
+                                                FIRDataSnapshot *snap,
+                                                NSError *error) {
+      [wSelf observer:observer didFinishLoadWithSnap:snap error:error];
+    }];
+  }
+
+  FUIQueryObserver *obs = [[FUIQueryObserver alloc] initWithQuery:query];
+  self.rowsByKey[key] = obs;
+  [self.pendingKeys addObject:key];
+  return obs;
+}
+
+- (void)forgetRowWithKey:(NSString *)key {
+  [self detachKeyFromRange:key];
+  [self.pendingKeys removeObject:key];
+  [self.rowsByKey removeObjectForKey:key];
+}
+
+- (void)observeRowWithKey:(NSString *)key {
+  __weak typeof(self) wSelf = self;
+  [self.rowsByKey[key] observeValueWithCompletion:^(FUIQueryObserver *observer,
+                                                    FIRDataSnapshot *snap,
+                                                    NSError *error) {
+    [wSelf observer:observer didFinishLoadWithSnap:snap error:error];
+  }];
+}
+
+- (void)planPendingRows {
+  if (self.pendingKeys.count == 0) { return; }
+
+  // Keys that fall inside a range that's already being observed are loaded by it.
+  NSMutableArray<NSString *> *unplanned = [NSMutableArray arrayWithCapacity:self.pendingKeys.count];
+  NSMutableArray<NSString *> *attached = [NSMutableArray array];
+  for (NSString *key in self.pendingKeys) {
+    FUIIndexRangeObserver *existing = nil;
+    for (FUIIndexRangeObserver *rangeObserver in self.rangeObservers) {
+      if ([rangeObserver.range containsKey:key]) {
+        existing = rangeObserver;
+        break;
+      }
+    }
+    if (existing != nil) {
+      [existing.keys addObject:key];
+      self.rangesByKey[key] = existing;
+      [attached addObject:key];
+    } else {
+      [unplanned addObject:key];
+    }
+  }
+  [self.pendingKeys removeAllObjects];
+
+  NSMutableSet<NSString *> *remaining = [NSMutableSet setWithArray:unplanned];
+  NSMutableArray<FUIIndexRangeObserver *> *started = [NSMutableArray array];
+  for (FUIIndexJoinRange *range in [self.joinPlanner rangesForKeys:unplanned]) {
+    id<FUIDataObservable> query = [[[self.data queryOrderedByKey]
+        queryStartingAtValue:range.startKey] queryEndingAtValue:range.endKey];
+    FUIIndexRangeObserver *rangeObserver = [[FUIIndexRangeObserver alloc] initWithRange:range
+                                                                                  query:query];
+    for (NSString *key in range.keys) {
+      if (![remaining containsObject:key]) { continue; }
+      [remaining removeObject:key];
+      [rangeObserver.keys addObject:key];
+      self.rangesByKey[key] = rangeObserver;
+    }
+    if (rangeObserver.keys.count > 0) {
+      [self.rangeObservers addObject:rangeObserver];
+      [started addObject:rangeObserver];
+    }
+  }
+
+  // Listeners may call back synchronously, so only start them once all rows
+  // have been assigned.
+  for (NSString *key in remaining) {
+    [self observeRowWithKey:key];
+  }
+  for (NSString *key in attached) {
+    FUIIndexRangeObserver *rangeObserver = self.rangesByKey[key];
+    if (rangeObserver.children != nil) {
+      [self applyChildren:rangeObserver.children toKey:key];
+    }
+  }
+  __weak typeof(self) wSelf = self;
+  for (FUIIndexRangeObserver *rangeObserver in started) {
+    __weak FUIIndexRangeObserver *wRangeObserver = rangeObserver;
+    [rangeObserver.observer observeValueWithCompletion:^(FUIQueryObserver *observer,
+                                                         FIRDataSnapshot *snap,
+                                                         NSError *error) {
+      [wSelf rangeObserver:wRangeObserver didFinishLoadWithSnap:snap error:error];
+    }];
+  }
+}
+
+- (void)rangeObserver:(FUIIndexRangeObserver *)rangeObserver
+didFinishLoadWithSnap:(FIRDataSnapshot *)snap
+                error:(NSError *)error {
+  if (rangeObserver == nil || ![self.rangeObservers containsObject:rangeObserver]) { return; }
+
+  // Security rules may allow reading each child but not a range of the data node,
+  // so fall back to loading the rows individually.
+  if (error != nil) {
+    [self splitRange:rangeObserver];
+    return;
+  }
+
+  BOOL isFirstLoad = rangeObserver.children == nil;
+  NSMutableDictionary<NSString *, FIRDataSnapshot *> *children =
+      [NSMutableDictionary dictionaryWithCapacity:rangeObserver.keys.count];
+  for (FIRDataSnapshot *child in snap.children) {
+    children[child.key] = child;
+  }
+  rangeObserver.children = children;
+
+  for (NSString *key in [rangeObserver.keys allObjects]) {
+    [self applyChildren:children toKey:key];
+  }
+
+  if (isFirstLoad && [self.rangeObservers containsObject:rangeObserver] &&
+      [self.joinPlanner respondsToSelector:@selector(shouldKeepRange:loadedChildCount:)] &&
+      ![self.joinPlanner shouldKeepRange:rangeObserver.range loadedChildCount:children.count]) {
+    [self splitRange:rangeObserver];
+  }
+}
+
+// Fills in a row from a range query's results. Rows missing from the results are
+// handed to a listener of their own, which reports the missing data the same way
+// it would without a join planner.
+- (void)applyChildren:(NSDictionary<NSString *, FIRDataSnapshot *> *)children
+                toKey:(NSString *)key {
+  FIRDataSnapshot *snap = children[key];
+  if (snap == nil) {
+    [self detachKeyFromRange:key];
+    [self observeRowWithKey:key];
+    return;
+  }
+
+  FUIQueryObserver *obs = self.rowsByKey[key];
+  id oldValue = obs.contents.value;
+  if (obs.contents != nil && (oldValue == snap.value || [oldValue isEqual:snap.value])) {
+    return;
+  }
+  obs.contents = snap;
+
+  NSUInteger index = [self.observers indexOfObjectIdenticalTo:obs];
+  if (index == NSNotFound) { return; }
+  [self schedulePublish];
+  if ([self.delegate respondsToSelector:@selector(array:reference:didLoadObject:atIndex:)]) {
+    [self.delegate array:self reference:obs.query didLoadObject:snap atIndex:index];
+  }
+}
+
+- (void)detachKeyFromRange:(NSString *)key {
+  FUIIndexRangeObserver *rangeObserver = self.rangesByKey[key];
+  if (rangeObserver == nil) { return; }
+  [self.rangesByKey removeObjectForKey:key];
+  [rangeObserver.keys removeObject:key];
+  if (rangeObserver.keys.count == 0) {
+    [rangeObserver.observer removeAllObservers];
+    [self.rangeObservers removeObject:rangeObserver];
+  }
+}
+
+- (void)splitRange:(FUIIndexRangeObserver *)rangeObserver {
+  for (NSString *key in [rangeObserver.keys allObjects]) {
+    [self detachKeyFromRange:key];
+    [self observeRowWithKey:key];
+  }
+}
+
 #pragma mark - FirebaseArrayDelegate
 
 - (void)observer:(FUIQueryObserver *)obs
@@ -128,28 +422,40 @@ didFinishLoadWithSnap:(FIRDataSnapshot *)snap
     return;
   }
 
+  [self schedulePublish];
   if ([self.delegate respondsToSelector:@selector(array:reference:didLoadObject:atIndex:)]) {
     [self.delegate array:self reference:obs.query didLoadObject:snap atIndex:index];
   }
 }
 
+- (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
+  [self.metricsRecorder beginBatch];
+}
+
+- (void)arrayDidEndUpdates:(id<FUICollection>)collection {
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
+  [self planPendingRows];
+  [self publishVersion];
+  [metrics endWork:mark];
+  [metrics finishBatchWithItemCount:self.count];
+}
+
 - (void)array:(FUIArray *)array
  didAddObject:(FIRDataSnapshot *)object
       atIndex:(NSUInteger)index {
   NSParameterAssert([object.key isKindOfClass:[NSString class]]);
-  id<FUIDataObservable> query = [self.data child:object.key];
-  __weak typeof(self) wSelf = self;
-  FUIQueryObserver *obs = [FUIQueryObserver observerForQuery:query
-                                                            completion:^(FUIQueryObserver *observer,
-                                                                         FIRDataSnapshot *snap,
-                                                                         NSError *error) {
-    [wSelf observer:observer didFinishLoadWithSnap:snap error:error];
-  }];
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
+  FUIQueryObserver *obs = [self rowObserverForKey:object.key];
   [self.observers insertObject:obs atIndex:index];
 
   if ([self.delegate respondsToSelector:@selector(array:didAddReference:atIndex:)]) {
-    [self.delegate array:self didAddReference:query atIndex:index];
+    FUICollectionMetricsMark callback = [metrics mark];
+    [self.delegate array:self didAddReference:obs.query atIndex:index];
+    [metrics endCallback:callback];
   }
+  [metrics endWork:mark eventType:FIRDataEventTypeChildAdded];
 }
 
 - (void)array:(FUIArray *)array
@@ -157,52 +463,63 @@ didMoveObject:(FIRDataSnapshot *)object
     fromIndex:(NSUInteger)fromIndex
       toIndex:(NSUInteger)toIndex {
   NSParameterAssert([object.key isKindOfClass:[NSString class]]);
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
   FUIQueryObserver *obs = self.observers[fromIndex];
 
   [self.observers removeObjectAtIndex:fromIndex];
   [self.observers insertObject:obs atIndex:toIndex];
 
   if ([self.delegate respondsToSelector:@selector(array:didMoveReference:fromIndex:toIndex:)]) {
+    FUICollectionMetricsMark callback = [metrics mark];
     [self.delegate array:self didMoveReference:obs.query fromIndex:fromIndex toIndex:toIndex];
+    [metrics endCallback:callback];
   }
+  [metrics endWork:mark eventType:FIRDataEventTypeChildMoved];
 }
 
 - (void)array:(FUIArray *)array
 didChangeObject:(FIRDataSnapshot *)object
       atIndex:(NSUInteger)index {
   NSParameterAssert([object.key isKindOfClass:[NSString class]]);
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
 
   // Cancel any active loads on the old observer
   [self.observers[index] removeAllObservers];
+  [self forgetRowWithKey:object.key];
 
   // Add new observer
-  __weak typeof(self) wSelf = self;
-  id<FUIDataObservable> query = [self.data child:object.key];
-  FUIQueryObserver *obs = [FUIQueryObserver observerForQuery:query
-                                                            completion:^(FUIQueryObserver *observer,
-                                                                         FIRDataSnapshot *snap,
-                                                                         NSError *error) {
-    [wSelf observer:observer didFinishLoadWithSnap:snap error:error];
-  }];
+  FUIQueryObserver *obs = [self rowObserverForKey:object.key];
   [self.observers replaceObjectAtIndex:index withObject:obs];
 
   if ([self.delegate respondsToSelector:@selector(array:didChangeReference:atIndex:)]) {
-    [self.delegate array:self didChangeReference:query atIndex:index];
+    FUICollectionMetricsMark callback = [metrics mark];
+    [self.delegate array:self didChangeReference:obs.query atIndex:index];
+    [metrics endCallback:callback];
   }
+  [metrics endWork:mark eventType:FIRDataEventTypeChildChanged];
 }
 
 - (void)array:(FUIArray *)array
 didRemoveObject:(FIRDataSnapshot *)object
       atIndex:(NSUInteger)index {
+  FUICollectionMetricsRecorder *metrics = self.metricsRecorder;
+  FUICollectionMetricsMark mark = [metrics mark];
+
   // Cancel loads on old observer
   [self.observers[index] removeAllObservers];
+  [self forgetRowWithKey:object.key];
 
   [self.observers removeObjectAtIndex:index];
 
   id<FUIDataObservable> query = [self.data child:object.key];
   if ([self.delegate respondsToSelector:@selector(array:didRemoveReference:atIndex:)]) {
+    FUICollectionMetricsMark callback = [metrics mark];
     [self.delegate array:self didRemoveReference:query atIndex:index];
+    [metrics endCallback:callback];
   }
+  [metrics endWork:mark eventType:FIRDataEventTypeChildRemoved];
 }
 
 - (void)array:(FUIArray *)array queryCancelledWithError:(NSError *)error {
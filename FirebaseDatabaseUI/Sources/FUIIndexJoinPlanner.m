@@ -0,0 +1,163 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIIndexJoinPlanner.h"
+
+// Returns YES and sets value if the key is one Firebase Database treats as an
+// integer: an optional minus sign followed by digits without leading zeros, within
+// the range of a 32-bit signed integer.
+static BOOL FUIKeyIntegerValue(NSString *key, int64_t *value) {
+  NSUInteger length = key.length;
+  if (length == 0 || length > 11) { return NO; }
+
+  NSUInteger i = 0;
+  BOOL negative = [key characterAtIndex:0] == '-';
+  if (negative) {
+    i = 1;
+    if (length == 1) { return NO; }
+  }
+
+  unichar first = [key characterAtIndex:i];
+  if (first == '0' && (length - i > 1 || negative)) { return NO; }
+
+  int64_t result = 0;
+  for (; i < length; i++) {
+    unichar c = [key characterAtIndex:i];
+    if (c < '0' || c > '9') { return NO; }
+    result = result * 10 + (c - '0');
+  }
+  if (negative) { result = -result; }
+  if (result < INT32_MIN || result > INT32_MAX) { return NO; }
+
+  *value = result;
+  return YES;
+}
+
+@implementation FUIIndexJoinRange
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (instancetype)initWithKeys:(NSArray<NSString *> *)keys {
+  NSParameterAssert(keys.count > 0);
+  self = [super init];
+  if (self != nil) {
+    _keys = [keys copy];
+    _startKey = [keys.firstObject copy];
+    _endKey = [keys.lastObject copy];
+  }
+  return self;
+}
+
+- (BOOL)containsKey:(NSString *)key {
+  return [FUIIndexRangeJoinPlanner compareKey:key toKey:self.startKey] != NSOrderedAscending &&
+      [FUIIndexRangeJoinPlanner compareKey:key toKey:self.endKey] != NSOrderedDescending;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, %@...%@, keys: %lu>",
+      NSStringFromClass([self class]), self, self.startKey, self.endKey,
+          (unsigned long)self.keys.count];
+}
+
+@end
+
+@implementation FUIIndexRangeJoinPlanner
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _minimumRangeSize = 4;
+    _maximumRangeSize = 50;
+    _minimumDensity = 0.5;
+  }
+  return self;
+}
+
++ (NSComparisonResult)compareKey:(NSString *)key toKey:(NSString *)otherKey {
+  int64_t left, right;
+  BOOL leftIsInteger = FUIKeyIntegerValue(key, &left);
+  BOOL rightIsInteger = FUIKeyIntegerValue(otherKey, &right);
+
+  if (leftIsInteger && rightIsInteger) {
+    if (left == right) { return NSOrderedSame; }
+    return left < right ? NSOrderedAscending : NSOrderedDescending;
+  }
+  if (leftIsInteger) { return NSOrderedAscending; }
+  if (rightIsInteger) { return NSOrderedDescending; }
+  return [key compare:otherKey options:NSLiteralSearch];
+}
+
+- (NSArray<FUIIndexJoinRange *> *)rangesForKeys:(NSArray<NSString *> *)keys {
+  NSUInteger minimumSize = MAX(self.minimumRangeSize, 2);
+  if (keys.count < minimumSize) { return @[]; }
+
+  NSArray<NSString *> *sorted = [keys sortedArrayUsingComparator:^NSComparisonResult(NSString *left,
+                                                                                      NSString *right) {
+    return [FUIIndexRangeJoinPlanner compareKey:left toKey:right];
+  }];
+
+  NSMutableArray<FUIIndexJoinRange *> *ranges = [NSMutableArray array];
+  NSMutableArray<NSString *> *run = [NSMutableArray array];
+  int64_t runStart = 0;
+  BOOL runIsInteger = NO;
+
+  for (NSString *key in sorted) {
+    int64_t value = 0;
+    BOOL isInteger = FUIKeyIntegerValue(key, &value);
+
+    BOOL extendsRun = run.count > 0 && isInteger == runIsInteger;
+    if (extendsRun && self.maximumRangeSize > 0 && run.count >= self.maximumRangeSize) {
+      extendsRun = NO;
+    }
+    if (extendsRun && isInteger) {
+      // The range query would load every child between the first key and this one.
+      double span = (double)(value - runStart + 1);
+      extendsRun = (run.count + 1) / span >= self.minimumDensity;
+    }
+
+    if (!extendsRun) {
+      if (run.count >= minimumSize) {
+        [ranges addObject:[[FUIIndexJoinRange alloc] initWithKeys:run]];
+      }
+      [run removeAllObjects];
+      runStart = value;
+      runIsInteger = isInteger;
+    }
+    [run addObject:key];
+  }
+
+  if (run.count >= minimumSize) {
+    [ranges addObject:[[FUIIndexJoinRange alloc] initWithKeys:run]];
+  }
+  return [ranges copy];
+}
+
+- (BOOL)shouldKeepRange:(FUIIndexJoinRange *)range loadedChildCount:(NSUInteger)childCount {
+  if (childCount == 0) { return YES; }
+  return (double)range.keys.count / childCount >= self.minimumDensity;
+}
+
+@end
@@ -0,0 +1,62 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An internal mutable array of keys that stores them as UTF-8 in one contiguous
+ * buffer, rather than as separate string objects. Keys are turned back into strings
+ * only when read through the NSArray interface.
+ *
+ * The buffer can also binary search its keys in the order Firebase Database sorts
+ * keys by: integer keys first, numerically, then every other key by its bytes.
+ * These lookups assume the keys are in that order.
+ */
+@interface FUIKeyBuffer : NSMutableArray<NSString *>
+
+/**
+ * The number of bytes used to store keys, including the bytes of removed keys
+ * that haven't been compacted away yet.
+ */
+@property (nonatomic, readonly) NSUInteger byteCount;
+
+/**
+ * Returns the index at which the given key would be inserted to keep the keys
+ * sorted, which is the index of the key if it's present. Keys greater than the
+ * last key are found without searching.
+ */
+- (NSUInteger)insertionIndexForSortedKey:(NSString *)key;
+
+/**
+ * Returns the index of the given key, or NSNotFound, by binary search.
+ */
+- (NSUInteger)indexOfSortedKey:(NSString *)key;
+
+/**
+ * Returns YES if the key at the given index is equal to the given key, without
+ * creating a string.
+ */
+- (BOOL)keyAtIndex:(NSUInteger)index isEqualToKey:(NSString *)key;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,292 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUIKeyBuffer.h"
+
+typedef struct {
+  uint32_t offset;
+  uint32_t length;
+} FUIKeySlot;
+
+// A key's bytes, with its integer value parsed once for comparisons.
+typedef struct {
+  const char *bytes;
+  NSUInteger length;
+  BOOL isInteger;
+  int64_t integerValue;
+} FUIKeyBytes;
+
+// Returns YES and sets value if the key is one Firebase Database treats as an
+// integer: an optional minus sign followed by digits without leading zeros, within
+// the range of a 32-bit signed integer. See FUIIndexRangeJoinPlanner.
+static BOOL FUIKeyBytesIntegerValue(const char *bytes, NSUInteger length, int64_t *value) {
+  if (length == 0 || length > 11) { return NO; }
+
+  NSUInteger i = 0;
+  BOOL negative = bytes[0] == '-';
+  if (negative) {
+    i = 1;
+    if (length == 1) { return NO; }
+  }
+
+  if (bytes[i] == '0' && (length - i > 1 || negative)) { return NO; }
+
+  int64_t result = 0;
+  for (; i < length; i++) {
+    char c = bytes[i];
+    if (c < '0' || c > '9') { return NO; }
+    result = result * 10 + (c - '0');
+  }
+  if (negative) { result = -result; }
+  if (result < INT32_MIN || result > INT32_MAX) { return NO; }
+
+  *value = result;
+  return YES;
+}
+
+static FUIKeyBytes FUIKeyBytesMake(const char *bytes, NSUInteger length) {
+  FUIKeyBytes key = { bytes, length, NO, 0 };
+  key.isInteger = FUIKeyBytesIntegerValue(bytes, length, &key.integerValue);
+  return key;
+}
+
+// Orders UTF-8 bytes by code point, which matches comparing strings with
+// NSLiteralSearch except between characters outside the Basic Multilingual Plane and
+// those above U+E000. Callers that care, like FUIKeyOrderedArray, check the order
+// they're given instead of relying on it.
+static NSComparisonResult FUIKeyBytesCompare(FUIKeyBytes left, FUIKeyBytes right) {
+  if (left.isInteger && right.isInteger) {
+    if (left.integerValue == right.integerValue) { return NSOrderedSame; }
+    return left.integerValue < right.integerValue ? NSOrderedAscending : NSOrderedDescending;
+  }
+  if (left.isInteger) { return NSOrderedAscending; }
+  if (right.isInteger) { return NSOrderedDescending; }
+
+  int result = memcmp(left.bytes, right.bytes, MIN(left.length, right.length));
+  if (result == 0) {
+    if (left.length == right.length) { return NSOrderedSame; }
+    return left.length < right.length ? NSOrderedAscending : NSOrderedDescending;
+  }
+  return result < 0 ? NSOrderedAscending : NSOrderedDescending;
+}
+
+@implementation FUIKeyBuffer {
+  // The keys' bytes, in the order they were added. Removed keys leave gaps.
+  NSMutableData *_bytes;
+  // One FUIKeySlot per key, in the array's order.
+  NSMutableData *_slots;
+  // The number of bytes in _bytes belonging to keys still in the array.
+  NSUInteger _liveByteCount;
+}
+
+- (instancetype)init {
+  return [self initWithCapacity:0];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)numItems {
+  self = [super init];
+  if (self != nil) {
+    _bytes = [NSMutableData dataWithCapacity:numItems * 20];
+    _slots = [NSMutableData dataWithCapacity:numItems * sizeof(FUIKeySlot)];
+  }
+  return self;
+}
+
+- (NSUInteger)byteCount {
+  return _bytes.length;
+}
+
+#pragma mark - Slots
+
+- (FUIKeySlot)slotAtIndex:(NSUInteger)index {
+  return ((const FUIKeySlot *)_slots.bytes)[index];
+}
+
+- (FUIKeyBytes)keyBytesAtIndex:(NSUInteger)index {
+  FUIKeySlot slot = [self slotAtIndex:index];
+  return FUIKeyBytesMake((const char *)_bytes.bytes + slot.offset, slot.length);
+}
+
+// Appends the key's bytes to the buffer and returns a slot pointing at them.
+- (FUIKeySlot)storeKey:(NSString *)key {
+  NSParameterAssert(key != nil);
+  NSUInteger length = [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+  NSAssert(_bytes.length + length <= UINT32_MAX, @"Key buffer is too large");
+
+  FUIKeySlot slot = { (uint32_t)_bytes.length, (uint32_t)length };
+  [_bytes appendBytes:key.UTF8String length:length];
+  _liveByteCount += length;
+  return slot;
+}
+
+- (void)releaseSlot:(FUIKeySlot)slot {
+  _liveByteCount -= slot.length;
+  if (_slots.length == 0) {
+    _bytes.length = 0;
+    _liveByteCount = 0;
+    return;
+  }
+  // Compact once more than half the buffer belongs to removed keys.
+  NSUInteger garbage = _bytes.length - _liveByteCount;
+  if (garbage > 4096 && garbage > _liveByteCount) {
+    [self compact];
+  }
+}
+
+- (void)compact {
+  NSMutableData *bytes = [NSMutableData dataWithCapacity:_liveByteCount];
+  FUIKeySlot *slots = (FUIKeySlot *)_slots.mutableBytes;
+  NSUInteger count = self.count;
+  for (NSUInteger i = 0; i < count; i++) {
+    uint32_t offset = (uint32_t)bytes.length;
+    [bytes appendBytes:(const char *)_bytes.bytes + slots[i].offset length:slots[i].length];
+    slots[i].offset = offset;
+  }
+  _bytes = bytes;
+}
+
+#pragma mark - NSArray primitives
+
+- (NSUInteger)count {
+  return _slots.length / sizeof(FUIKeySlot);
+}
+
+- (NSString *)objectAtIndex:(NSUInteger)index {
+  if (index >= self.count) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of key buffer with %lu keys",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+  FUIKeySlot slot = [self slotAtIndex:index];
+  return [[NSString alloc] initWithBytes:(const char *)_bytes.bytes + slot.offset
+                                  length:slot.length
+                                encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - NSMutableArray primitives
+
+- (void)insertObject:(NSString *)key atIndex:(NSUInteger)index {
+  if (index > self.count) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of key buffer with %lu keys",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+  FUIKeySlot slot = [self storeKey:key];
+  [_slots replaceBytesInRange:NSMakeRange(index * sizeof(FUIKeySlot), 0)
+                    withBytes:&slot
+                       length:sizeof(FUIKeySlot)];
+}
+
+- (void)removeObjectAtIndex:(NSUInteger)index {
+  if (index >= self.count) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of key buffer with %lu keys",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+  FUIKeySlot slot = [self slotAtIndex:index];
+  [_slots replaceBytesInRange:NSMakeRange(index * sizeof(FUIKeySlot), sizeof(FUIKeySlot))
+                    withBytes:NULL
+                       length:0];
+  [self releaseSlot:slot];
+}
+
+- (void)addObject:(NSString *)key {
+  [self insertObject:key atIndex:self.count];
+}
+
+- (void)removeLastObject {
+  if (self.count == 0) {
+    [NSException raise:NSRangeException format:@"Cannot remove the last key of an empty key buffer"];
+  }
+  [self removeObjectAtIndex:self.count - 1];
+}
+
+- (void)replaceObjectAtIndex:(NSUInteger)index withObject:(NSString *)key {
+  // Changed snapshots keep their keys, so this is usually a no-op.
+  if ([self keyAtIndex:index isEqualToKey:key]) { return; }
+  FUIKeySlot old = [self slotAtIndex:index];
+  FUIKeySlot slot = [self storeKey:key];
+  ((FUIKeySlot *)_slots.mutableBytes)[index] = slot;
+  [self releaseSlot:old];
+}
+
+#pragma mark - Lookups
+
+- (BOOL)keyAtIndex:(NSUInteger)index isEqualToKey:(NSString *)key {
+  if (index >= self.count) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of key buffer with %lu keys",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+  FUIKeySlot slot = [self slotAtIndex:index];
+  NSUInteger length = [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+  return slot.length == length &&
+      memcmp((const char *)_bytes.bytes + slot.offset, key.UTF8String, length) == 0;
+}
+
+// Overridden so the linear scans FUIArray does with indexOfObject: compare bytes
+// instead of creating a string for every key.
+- (NSUInteger)indexOfObject:(id)object {
+  if (![object isKindOfClass:[NSString class]]) { return NSNotFound; }
+  NSString *key = object;
+  NSUInteger length = [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+  const char *keyBytes = key.UTF8String;
+  const char *bytes = _bytes.bytes;
+  const FUIKeySlot *slots = _slots.bytes;
+  NSUInteger count = self.count;
+  for (NSUInteger i = 0; i < count; i++) {
+    if (slots[i].length == length && memcmp(bytes + slots[i].offset, keyBytes, length) == 0) {
+      return i;
+    }
+  }
+  return NSNotFound;
+}
+
+- (NSUInteger)insertionIndexForSortedKey:(NSString *)key {
+  NSUInteger count = self.count;
+  FUIKeyBytes target = FUIKeyBytesMake(key.UTF8String,
+                                       [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
+  if (count == 0 ||
+      FUIKeyBytesCompare([self keyBytesAtIndex:count - 1], target) == NSOrderedAscending) {
+    return count;
+  }
+
+  NSUInteger low = 0;
+  NSUInteger high = count - 1;
+  while (low < high) {
+    NSUInteger middle = low + (high - low) / 2;
+    if (FUIKeyBytesCompare([self keyBytesAtIndex:middle], target) == NSOrderedAscending) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+- (NSUInteger)indexOfSortedKey:(NSString *)key {
+  NSUInteger index = [self insertionIndexForSortedKey:key];
+  if (index < self.count && [self keyAtIndex:index isEqualToKey:key]) {
+    return index;
+  }
+  return NSNotFound;
+}
+
+@end
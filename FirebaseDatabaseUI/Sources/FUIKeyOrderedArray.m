@@ -0,0 +1,105 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIKeyOrderedArray.h"
+#import "FirebaseDatabaseUI/Sources/FUIArray_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+#import "FirebaseDatabaseUI/Sources/FUIKeyBuffer.h"
+
+@interface FUIKeyOrderedArray ()
+
+/**
+ * The backing collection that holds all of the array's data.
+ */
+@property (strong, nonatomic) NSMutableArray<FIRDataSnapshot *> *snapshots;
+
+/**
+ * The backing collection that holds all of the array's keys. Always a FUIKeyBuffer.
+ */
+@property (strong, nonatomic) NSMutableArray<NSString *> *keys;
+
+/**
+ * The primary delegate and any additional delegates.
+ */
+@property (strong, nonatomic) FUICollectionDelegateList *delegates;
+
+@property (nonatomic, readwrite, getter=isKeyOrdered) BOOL keyOrdered;
+
+@end
+
+@implementation FUIKeyOrderedArray
+// Shares FUIArray's storage, like FUISortedArray.
+@dynamic snapshots, keys, delegates;
+
+- (instancetype)initWithQuery:(id<FUIDataObservable>)query
+                     delegate:(id<FUICollectionDelegate>)delegate {
+  self = [super initWithQuery:query delegate:delegate];
+  if (self != nil) {
+    self.keys = [[FUIKeyBuffer alloc] init];
+    _keyOrdered = YES;
+  }
+  return self;
+}
+
+- (FUIKeyBuffer *)keyBuffer {
+  return (FUIKeyBuffer *)self.keys;
+}
+
+- (void)invalidate {
+  [super invalidate];
+  self.keyOrdered = YES;
+}
+
+- (NSUInteger)indexForKey:(NSString *)key {
+  NSParameterAssert(key != nil);
+  if (!self.isKeyOrdered) {
+    return [super indexForKey:key];
+  }
+  return [self.keyBuffer indexOfSortedKey:key];
+}
+
+- (void)insertSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
+  if (!self.isKeyOrdered) {
+    [super insertSnapshot:snap withPreviousChildKey:previous];
+    return;
+  }
+
+  FUIKeyBuffer *keys = self.keyBuffer;
+  NSUInteger index = [keys insertionIndexForSortedKey:snap.key];
+  BOOL isDuplicate = index < keys.count && [keys keyAtIndex:index isEqualToKey:snap.key];
+  BOOL followsPrevious = previous == nil ?
+      index == 0 : index > 0 && [keys keyAtIndex:index - 1 isEqualToKey:previous];
+  if (isDuplicate || !followsPrevious) {
+    self.keyOrdered = NO;
+    [super insertSnapshot:snap withPreviousChildKey:previous];
+    return;
+  }
+
+  [self insertSnapshot:snap atIndex:index];
+  [self.delegates array:self didAddObject:snap atIndex:index];
+}
+
+- (void)moveSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
+  // Children of queries ordered by key never move.
+  self.keyOrdered = NO;
+  [super moveSnapshot:snap withPreviousChildKey:previous];
+}
+
+@end
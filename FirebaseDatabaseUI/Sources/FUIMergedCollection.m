@@ -0,0 +1,398 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIMergedCollection.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+
+@class FUIMergedSource;
+
+/// A child in the merged list.
+@interface FUIMergedEntry : NSObject
+@property (nonatomic, strong) FIRDataSnapshot *snapshot;
+@property (nonatomic, weak) FUIMergedSource *source;
+@end
+
+@implementation FUIMergedEntry
+@end
+
+/// A query whose children are merged, and its listeners and children.
+@interface FUIMergedSource : NSObject
+@property (nonatomic, strong) id<FUIDataObservable> query;
+/// Breaks ties between children of different queries that compare equal.
+@property (nonatomic, assign) NSUInteger order;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *handles;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, FUIMergedEntry *> *entries;
+@end
+
+@implementation FUIMergedSource
+@end
+
+@interface FUIMergedCollection ()
+
+@property (nonatomic, copy) NSComparisonResult (^sortDescriptor)(FIRDataSnapshot *, FIRDataSnapshot *);
+
+@property (nonatomic, strong) NSMutableArray<FUIMergedSource *> *sources;
+
+/**
+ * Every child of every query, sorted, as the objects of a rank tree with a weight of
+ * 1 each, so that finding, inserting and removing an entry are all O(log n).
+ */
+@property (nonatomic, strong) FUIRankTree *entries;
+
+/**
+ * The primary delegate and any additional delegates.
+ */
+@property (nonatomic, strong) FUICollectionDelegateList *delegates;
+
+@property (nonatomic, assign) NSUInteger nextSourceOrder;
+
+@property (nonatomic, assign) BOOL isObserving;
+
+/**
+ * YES between the first event of a batch and the value event ending it.
+ */
+@property (nonatomic, assign) BOOL isSendingUpdates;
+
+@end
+
+@implementation FUIMergedCollection
+
+- (instancetype)initWithQueries:(NSArray<id<FUIDataObservable>> *)queries
+                       delegate:(id<FUICollectionDelegate>)delegate
+                 sortDescriptor:(NSComparisonResult (^)(FIRDataSnapshot *,
+                                                        FIRDataSnapshot *))sortDescriptor {
+  NSParameterAssert(sortDescriptor != nil);
+  self = [super init];
+  if (self != nil) {
+    _sortDescriptor = [sortDescriptor copy];
+    _sources = [NSMutableArray arrayWithCapacity:queries.count];
+    _entries = [[FUIRankTree alloc] init];
+    _delegates = [[FUICollectionDelegateList alloc] init];
+    _delegates.primaryDelegate = delegate;
+    for (id<FUIDataObservable> query in queries) {
+      [self addQuery:query];
+    }
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (void)dealloc {
+  [self invalidate];
+}
+
+#pragma mark - Queries
+
+- (NSArray<id<FUIDataObservable>> *)queries {
+  NSMutableArray<id<FUIDataObservable>> *queries = [NSMutableArray arrayWithCapacity:self.sources.count];
+  for (FUIMergedSource *source in self.sources) {
+    [queries addObject:source.query];
+  }
+  return [queries copy];
+}
+
+- (FUIMergedSource *)sourceForQuery:(id<FUIDataObservable>)query {
+  for (FUIMergedSource *source in self.sources) {
+    if (source.query == query) { return source; }
+  }
+  return nil;
+}
+
+- (void)addQuery:(id<FUIDataObservable>)query {
+  NSParameterAssert(query != nil);
+  if ([self sourceForQuery:query] != nil) { return; }
+
+  FUIMergedSource *source = [[FUIMergedSource alloc] init];
+  source.query = query;
+  source.order = self.nextSourceOrder++;
+  source.handles = [NSMutableArray arrayWithCapacity:4];
+  source.entries = [NSMutableDictionary dictionary];
+  [self.sources addObject:source];
+
+  if (self.isObserving) {
+    [self observeSource:source];
+  }
+}
+
+- (void)removeQuery:(id<FUIDataObservable>)query {
+  FUIMergedSource *source = [self sourceForQuery:query];
+  if (source == nil) { return; }
+  [self stopObservingSource:source];
+  [self.sources removeObject:source];
+}
+
+- (void)observeSource:(FUIMergedSource *)source {
+  __weak typeof(self) wSelf = self;
+  __weak FUIMergedSource *wSource = source;
+  id<FUIDataObservable> query = source.query;
+  void (^cancelBlock)(NSError *) = ^(NSError *error) {
+    [wSelf.delegates array:wSelf queryCancelledWithError:error];
+  };
+
+  FIRDatabaseHandle handle;
+  handle = [query observeEventType:FIRDataEventTypeChildAdded
+      andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        [wSelf didUpdate];
+        [wSelf insertSnapshot:snapshot fromSource:wSource];
+      }
+      withCancelBlock:cancelBlock];
+  [source.handles addObject:@(handle)];
+
+  handle = [query observeEventType:FIRDataEventTypeChildChanged
+      andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        [wSelf didUpdate];
+        [wSelf changeSnapshot:snapshot fromSource:wSource];
+      }
+      withCancelBlock:cancelBlock];
+  [source.handles addObject:@(handle)];
+
+  handle = [query observeEventType:FIRDataEventTypeChildRemoved
+      andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        [wSelf didUpdate];
+        [wSelf removeSnapshot:snapshot fromSource:wSource];
+      }
+      withCancelBlock:cancelBlock];
+  [source.handles addObject:@(handle)];
+
+  // Moves are ignored, since the merged collection does its own ordering.
+
+  handle = [query observeEventType:FIRDataEventTypeValue
+      andPreviousSiblingKeyWithBlock:^(FIRDataSnapshot *snapshot, NSString *previousChildKey) {
+        [wSelf didFinishUpdates];
+      }
+      withCancelBlock:cancelBlock];
+  [source.handles addObject:@(handle)];
+}
+
+// Removes the source's listeners and children.
+- (void)stopObservingSource:(FUIMergedSource *)source {
+  for (NSNumber *handle in source.handles) {
+    [source.query removeObserverWithHandle:handle.unsignedIntegerValue];
+  }
+  [source.handles removeAllObjects];
+  if (source.entries.count == 0) { return; }
+
+  NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+  for (FUIMergedEntry *entry in source.entries.allValues) {
+    [indexes addIndex:[self indexOfEntry:entry]];
+  }
+  [source.entries removeAllObjects];
+
+  BOOL startsBatch = !self.isSendingUpdates;
+  if (startsBatch) {
+    [self didUpdate];
+  }
+  for (NSUInteger index = indexes.lastIndex; index != NSNotFound;
+       index = [indexes indexLessThanIndex:index]) {
+    FUIMergedEntry *entry = [self.entries objectAtIndex:index];
+    [self.entries removeWeightAtIndex:index];
+    [self.delegates array:self didRemoveObject:entry.snapshot atIndex:index];
+  }
+  if (startsBatch) {
+    [self didFinishUpdates];
+  }
+}
+
+#pragma mark - Ordering
+
+// Orders entries by the sort descriptor, then by query, then by key, so that every
+// entry has exactly one position.
+- (NSComparisonResult)compareEntry:(FUIMergedEntry *)entry
+                       toSnapshot:(FIRDataSnapshot *)snapshot
+                           source:(FUIMergedSource *)source {
+  NSComparisonResult result = self.sortDescriptor(entry.snapshot, snapshot);
+  if (result != NSOrderedSame) { return result; }
+  if (entry.source.order != source.order) {
+    return entry.source.order < source.order ? NSOrderedAscending : NSOrderedDescending;
+  }
+  return [entry.snapshot.key compare:snapshot.key options:NSLiteralSearch];
+}
+
+// Returns the index of the first entry that isn't ordered before the given child.
+- (NSUInteger)insertionIndexForSnapshot:(FIRDataSnapshot *)snapshot
+                                 source:(FUIMergedSource *)source {
+  return [self.entries indexOfFirstObjectPassingTest:^BOOL(FUIMergedEntry *entry) {
+    return [self compareEntry:entry toSnapshot:snapshot source:source] != NSOrderedAscending;
+  }];
+}
+
+- (NSUInteger)indexOfEntry:(FUIMergedEntry *)entry {
+  NSUInteger index = [self insertionIndexForSnapshot:entry.snapshot source:entry.source];
+  if (index < self.entries.count && [self.entries objectAtIndex:index] == entry) {
+    return index;
+  }
+  NSString *reason = [NSString stringWithFormat:@"FUIMergedCollection %@'s sort descriptor "
+                      @"returned inconsistent results", self];
+  @throw [NSException exceptionWithName:NSInternalInconsistencyException
+                                 reason:reason
+                               userInfo:nil];
+}
+
+- (BOOL)entryKeepsPositionAtIndex:(NSUInteger)index {
+  FUIMergedEntry *entry = [self.entries objectAtIndex:index];
+  if (index > 0 &&
+      [self compareEntry:[self.entries objectAtIndex:index - 1]
+              toSnapshot:entry.snapshot
+                  source:entry.source] == NSOrderedDescending) {
+    return NO;
+  }
+  if (index + 1 < self.entries.count &&
+      [self compareEntry:[self.entries objectAtIndex:index + 1]
+              toSnapshot:entry.snapshot
+                  source:entry.source] == NSOrderedAscending) {
+    return NO;
+  }
+  return YES;
+}
+
+#pragma mark - Events
+
+- (void)didUpdate {
+  if (self.isSendingUpdates) { return; }
+  self.isSendingUpdates = YES;
+  [self.delegates arrayDidBeginUpdates:self];
+}
+
+- (void)didFinishUpdates {
+  if (!self.isSendingUpdates) { return; }
+  self.isSendingUpdates = NO;
+  [self.delegates arrayDidEndUpdates:self];
+}
+
+- (void)insertSnapshot:(FIRDataSnapshot *)snapshot fromSource:(FUIMergedSource *)source {
+  if (source == nil) { return; }
+  if (source.entries[snapshot.key] != nil) {
+    [self changeSnapshot:snapshot fromSource:source];
+    return;
+  }
+
+  FUIMergedEntry *entry = [[FUIMergedEntry alloc] init];
+  entry.snapshot = snapshot;
+  entry.source = source;
+  source.entries[snapshot.key] = entry;
+
+  NSUInteger index = [self insertionIndexForSnapshot:snapshot source:source];
+  [self.entries insertObject:entry weight:1 atIndex:index];
+  [self.delegates array:self didAddObject:snapshot atIndex:index];
+}
+
+- (void)changeSnapshot:(FIRDataSnapshot *)snapshot fromSource:(FUIMergedSource *)source {
+  FUIMergedEntry *entry = source.entries[snapshot.key];
+  if (entry == nil) { return; }
+
+  // Like a Firebase query ordered by a child, a change that reorders the child is
+  // sent as a change in place followed by a move.
+  NSUInteger index = [self indexOfEntry:entry];
+  entry.snapshot = snapshot;
+  [self.delegates array:self didChangeObject:snapshot atIndex:index];
+  if ([self entryKeepsPositionAtIndex:index]) { return; }
+
+  [self.entries removeWeightAtIndex:index];
+  NSUInteger newIndex = [self insertionIndexForSnapshot:snapshot source:source];
+  [self.entries insertObject:entry weight:1 atIndex:newIndex];
+  [self.delegates array:self didMoveObject:snapshot fromIndex:index toIndex:newIndex];
+}
+
+- (void)removeSnapshot:(FIRDataSnapshot *)snapshot fromSource:(FUIMergedSource *)source {
+  FUIMergedEntry *entry = source.entries[snapshot.key];
+  if (entry == nil) { return; }
+
+  NSUInteger index = [self indexOfEntry:entry];
+  [self.entries removeWeightAtIndex:index];
+  [source.entries removeObjectForKey:snapshot.key];
+  [self.delegates array:self didRemoveObject:entry.snapshot atIndex:index];
+}
+
+#pragma mark - FUICollection
+
+- (NSArray<FIRDataSnapshot *> *)items {
+  NSMutableArray<FIRDataSnapshot *> *items = [NSMutableArray arrayWithCapacity:self.entries.count];
+  for (FUIMergedEntry *entry in [self.entries allObjects]) {
+    [items addObject:entry.snapshot];
+  }
+  return [items copy];
+}
+
+- (NSUInteger)count {
+  return self.entries.count;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index {
+  FUIMergedEntry *entry = [self.entries objectAtIndex:index];
+  return entry.snapshot;
+}
+
+- (void)observeQuery {
+  if (self.isObserving) { return; }
+  self.isObserving = YES;
+  for (FUIMergedSource *source in self.sources) {
+    [self observeSource:source];
+  }
+}
+
+- (void)invalidate {
+  if (!self.isObserving) { return; }
+  self.isObserving = NO;
+
+  [self didUpdate];
+  for (FUIMergedSource *source in self.sources) {
+    [self stopObservingSource:source];
+  }
+  [self didFinishUpdates];
+}
+
+- (id<FUICollectionDelegate>)delegate {
+  return self.delegates.primaryDelegate;
+}
+
+- (void)setDelegate:(id<FUICollectionDelegate>)delegate {
+  self.delegates.primaryDelegate = delegate;
+}
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates addDelegate:delegate];
+}
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates removeDelegate:delegate];
+}
+
+#pragma mark - Lookups
+
+- (id<FUIDataObservable>)queryForItemAtIndex:(NSUInteger)index {
+  FUIMergedEntry *entry = [self.entries objectAtIndex:index];
+  return entry.source.query;
+}
+
+- (NSUInteger)indexForKey:(NSString *)key inQuery:(id<FUIDataObservable>)query {
+  FUIMergedEntry *entry = [self sourceForQuery:query].entries[key];
+  if (entry == nil) { return NSNotFound; }
+  return [self indexOfEntry:entry];
+}
+
+@end
@@ -14,12 +14,11 @@
 //  limitations under the License.
 //
 
-#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIQueryObserver.h"
+#import "FirebaseDatabaseUI/Sources/FUIQueryObserver_Private.h"
 
 @interface FUIQueryObserver ()
 
 @property (nonatomic, readonly) NSMutableSet<NSNumber *> *handles;
-@property (nonatomic, readwrite) FIRDataSnapshot *contents;
 
 @end
 
@@ -49,19 +48,25 @@
                                                  FIRDataSnapshot *snap,
                                                  NSError *error))completion {
   FUIQueryObserver *obs = [[FUIQueryObserver alloc] initWithQuery:query];
+  [obs observeValueWithCompletion:completion];
+  return obs;
+}
 
+- (void)observeValueWithCompletion:(void (^)(FUIQueryObserver *obs,
+                                             FIRDataSnapshot *snap,
+                                             NSError *error))completion {
+  FUIQueryObserver *obs = self;
   void (^observerBlock)(FIRDataSnapshot *, NSString *) = ^(FIRDataSnapshot *snap,
                                                            NSString *previous) {
     obs.contents = snap;
-    completion(obs, snap, nil);
+    if (completion != nil) { completion(obs, snap, nil); }
   };
   void (^cancelBlock)(NSError *) = ^(NSError *error) {
-    completion(obs, nil, error);
+    if (completion != nil) { completion(obs, nil, error); }
   };
 
-  [obs observeEventType:FIRDataEventTypeValue
+  [self observeEventType:FIRDataEventTypeValue
     andPreviousSiblingKeyWithBlock:observerBlock withCancelBlock:cancelBlock];
-  return obs;
 }
 
 - (void)observeEventType:(FIRDataEventType)eventType
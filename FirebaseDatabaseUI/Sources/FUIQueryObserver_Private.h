@@ -0,0 +1,40 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIQueryObserver.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FUIQueryObserver ()
+
+/// Writable so FUIIndexArray can fill in rows loaded by a range query.
+@property (nonatomic, readwrite, nullable) FIRDataSnapshot *contents;
+
+/**
+ * Starts observing value events on the observer's query. Used to start loading
+ * an observer that was created with @c initWithQuery:.
+ */
+- (void)observeValueWithCompletion:(void (^)(FUIQueryObserver *obs,
+                                             FIRDataSnapshot *_Nullable snap,
+                                             NSError *_Nullable error))completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,111 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An internal sequence of weights that supports inserting, removing and reweighing
+ * elements anywhere, and finding prefix sums of weights, in O(log n) expected time.
+ * Collections use it to map between their own indexes and those of the collections
+ * they're built on, for instance with a weight of 1 for each visible item and 0 for
+ * each hidden one.
+ *
+ * Elements can also carry an object, which makes the tree an order-statistic list:
+ * objects can be read by index, and a sorted list can be searched in O(log n).
+ *
+ * Implemented as an implicit treap: a randomized balanced binary tree ordered by
+ * position, where each node stores the size and total weight of its subtree.
+ */
+@interface FUIRankTree : NSObject
+
+/**
+ * The number of elements.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * The sum of every element's weight.
+ */
+@property (nonatomic, readonly) NSUInteger totalWeight;
+
+- (void)insertWeight:(NSUInteger)weight atIndex:(NSUInteger)index;
+
+/**
+ * Inserts an element that carries the given object, which the tree retains until
+ * the element is removed.
+ */
+- (void)insertObject:(nullable id)object weight:(NSUInteger)weight atIndex:(NSUInteger)index;
+
+- (void)removeWeightAtIndex:(NSUInteger)index;
+
+- (NSUInteger)weightAtIndex:(NSUInteger)index;
+
+- (void)setWeight:(NSUInteger)weight atIndex:(NSUInteger)index;
+
+/**
+ * Returns the sum of the weights of the elements before the given index. The index
+ * may be equal to @c count, in which case this returns @c totalWeight.
+ */
+- (NSUInteger)weightBeforeIndex:(NSUInteger)index;
+
+/**
+ * Returns the index of the element whose weight covers the given offset, which is
+ * the element for which @c weightBeforeIndex: is at most the offset and
+ * @c weightBeforeIndex: plus its weight is greater than it. Returns NSNotFound if the
+ * offset isn't less than @c totalWeight.
+ */
+- (NSUInteger)indexContainingWeightOffset:(NSUInteger)offset;
+
+/**
+ * Returns the object of the element at the given index, or nil if it has none.
+ */
+- (nullable id)objectAtIndex:(NSUInteger)index;
+
+/**
+ * Returns the index of the first element whose object passes the test, or @c count
+ * if none does. The test must fail for every element before some index and pass for
+ * every element from it on, as comparing against a sorted list does, and is called
+ * O(log n) times.
+ */
+- (NSUInteger)indexOfFirstObjectPassingTest:(BOOL (NS_NOESCAPE ^)(id _Nullable object))predicate;
+
+/**
+ * The objects of every element in order, with NSNull for elements without one.
+ */
+- (NSArray *)allObjects;
+
+/**
+ * Removes every element.
+ */
+- (void)removeAllWeights;
+
+/**
+ * Replaces every element with @c count new ones, whose weights are returned by the
+ * block for each index in order. Builds the tree in O(n) time, rather than the
+ * O(n log n) of inserting the elements one by one.
+ */
+- (void)replaceAllWeightsWithCount:(NSUInteger)count
+                           weights:(NSUInteger (NS_NOESCAPE ^)(NSUInteger index))weightBlock;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,338 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+
+// Nodes are stored in one array and refer to each other by index. Index 0 is the
+// empty tree.
+typedef struct {
+  uint32_t left;
+  uint32_t right;
+  uint32_t priority;
+  uint32_t size;
+  NSUInteger weight;
+  NSUInteger sum;
+} FUIRankNode;
+
+@implementation FUIRankTree {
+  FUIRankNode *_nodes;
+  uint32_t _capacity;
+  // The next node that has never been used, and a list of removed nodes linked
+  // through their left fields.
+  uint32_t _nextNode;
+  uint32_t _freeList;
+  uint32_t _root;
+  uint32_t _seed;
+  // Each node's object, indexed like the nodes, with NSNull for nodes without one.
+  NSMutableArray *_objects;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _capacity = 64;
+    _nodes = calloc(_capacity, sizeof(FUIRankNode));
+    _nextNode = 1;
+    _seed = 0x9E3779B9;
+    _objects = [NSMutableArray arrayWithObject:[NSNull null]];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_nodes);
+}
+
+- (NSUInteger)count {
+  return _nodes[_root].size;
+}
+
+- (NSUInteger)totalWeight {
+  return _nodes[_root].sum;
+}
+
+#pragma mark - Nodes
+
+// xorshift32, which is random enough to keep the tree balanced.
+- (uint32_t)nextPriority {
+  _seed ^= _seed << 13;
+  _seed ^= _seed >> 17;
+  _seed ^= _seed << 5;
+  return _seed;
+}
+
+- (uint32_t)allocateNodeWithWeight:(NSUInteger)weight object:(nullable id)object {
+  uint32_t node = _freeList;
+  if (node != 0) {
+    _freeList = _nodes[node].left;
+    _objects[node] = object ?: [NSNull null];
+  } else {
+    if (_nextNode == _capacity) {
+      NSAssert(_capacity < UINT32_MAX / 2, @"Rank tree is too large");
+      _capacity *= 2;
+      _nodes = realloc(_nodes, _capacity * sizeof(FUIRankNode));
+    }
+    node = _nextNode++;
+    [_objects addObject:object ?: [NSNull null]];
+  }
+  _nodes[node] = (FUIRankNode){ 0, 0, [self nextPriority], 1, weight, weight };
+  return node;
+}
+
+- (void)freeNode:(uint32_t)node {
+  _nodes[node].left = _freeList;
+  _freeList = node;
+  _objects[node] = [NSNull null];
+}
+
+static inline void FUIRankNodeUpdate(FUIRankNode *nodes, uint32_t node) {
+  FUIRankNode *n = &nodes[node];
+  n->size = 1 + nodes[n->left].size + nodes[n->right].size;
+  n->sum = n->weight + nodes[n->left].sum + nodes[n->right].sum;
+}
+
+// Splits a tree into its first `index` elements and the rest.
+static void FUIRankSplit(FUIRankNode *nodes, uint32_t node, NSUInteger index,
+                         uint32_t *left, uint32_t *right) {
+  if (node == 0) {
+    *left = 0;
+    *right = 0;
+    return;
+  }
+  NSUInteger leftSize = nodes[nodes[node].left].size;
+  if (index <= leftSize) {
+    FUIRankSplit(nodes, nodes[node].left, index, left, &nodes[node].left);
+    *right = node;
+  } else {
+    FUIRankSplit(nodes, nodes[node].right, index - leftSize - 1, &nodes[node].right, right);
+    *left = node;
+  }
+  FUIRankNodeUpdate(nodes, node);
+}
+
+// Joins two trees, with every element of the left one first.
+static uint32_t FUIRankMerge(FUIRankNode *nodes, uint32_t left, uint32_t right) {
+  if (left == 0) { return right; }
+  if (right == 0) { return left; }
+  if (nodes[left].priority > nodes[right].priority) {
+    nodes[left].right = FUIRankMerge(nodes, nodes[left].right, right);
+    FUIRankNodeUpdate(nodes, left);
+    return left;
+  }
+  nodes[right].left = FUIRankMerge(nodes, left, nodes[right].left);
+  FUIRankNodeUpdate(nodes, right);
+  return right;
+}
+
+// Sets the weight of the element at the given index and updates the sums above it.
+static void FUIRankSetWeight(FUIRankNode *nodes, uint32_t node, NSUInteger index,
+                             NSUInteger weight) {
+  NSUInteger leftSize = nodes[nodes[node].left].size;
+  if (index < leftSize) {
+    FUIRankSetWeight(nodes, nodes[node].left, index, weight);
+  } else if (index > leftSize) {
+    FUIRankSetWeight(nodes, nodes[node].right, index - leftSize - 1, weight);
+  } else {
+    nodes[node].weight = weight;
+  }
+  FUIRankNodeUpdate(nodes, node);
+}
+
+- (void)raiseIfIndex:(NSUInteger)index isBeyond:(NSUInteger)bound {
+  if (index > bound) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of rank tree with %lu elements",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+}
+
+// Separate from the above, since a bound of count - 1 would wrap around when empty.
+- (void)raiseIfIndexIsNotBelowCount:(NSUInteger)index {
+  if (index >= self.count) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds of rank tree with %lu elements",
+                       (unsigned long)index, (unsigned long)self.count];
+  }
+}
+
+#pragma mark - Public API
+
+- (void)insertWeight:(NSUInteger)weight atIndex:(NSUInteger)index {
+  [self insertObject:nil weight:weight atIndex:index];
+}
+
+- (void)insertObject:(nullable id)object weight:(NSUInteger)weight atIndex:(NSUInteger)index {
+  [self raiseIfIndex:index isBeyond:self.count];
+  uint32_t node = [self allocateNodeWithWeight:weight object:object];
+  uint32_t left, right;
+  FUIRankSplit(_nodes, _root, index, &left, &right);
+  _root = FUIRankMerge(_nodes, FUIRankMerge(_nodes, left, node), right);
+}
+
+- (void)removeWeightAtIndex:(NSUInteger)index {
+  [self raiseIfIndexIsNotBelowCount:index];
+  uint32_t left, middle, right;
+  FUIRankSplit(_nodes, _root, index, &left, &right);
+  FUIRankSplit(_nodes, right, 1, &middle, &right);
+  [self freeNode:middle];
+  _root = FUIRankMerge(_nodes, left, right);
+}
+
+- (NSUInteger)weightAtIndex:(NSUInteger)index {
+  return [self weightBeforeIndex:index + 1] - [self weightBeforeIndex:index];
+}
+
+- (void)setWeight:(NSUInteger)weight atIndex:(NSUInteger)index {
+  [self raiseIfIndexIsNotBelowCount:index];
+  FUIRankSetWeight(_nodes, _root, index, weight);
+}
+
+- (NSUInteger)weightBeforeIndex:(NSUInteger)index {
+  [self raiseIfIndex:index isBeyond:self.count];
+  NSUInteger sum = 0;
+  uint32_t node = _root;
+  while (node != 0) {
+    FUIRankNode *n = &_nodes[node];
+    NSUInteger leftSize = _nodes[n->left].size;
+    if (index <= leftSize) {
+      node = n->left;
+    } else {
+      sum += _nodes[n->left].sum + n->weight;
+      index -= leftSize + 1;
+      node = n->right;
+    }
+  }
+  return sum;
+}
+
+- (NSUInteger)indexContainingWeightOffset:(NSUInteger)offset {
+  if (offset >= self.totalWeight) { return NSNotFound; }
+  NSUInteger index = 0;
+  uint32_t node = _root;
+  while (node != 0) {
+    FUIRankNode *n = &_nodes[node];
+    NSUInteger leftSum = _nodes[n->left].sum;
+    if (offset < leftSum) {
+      node = n->left;
+    } else if (offset < leftSum + n->weight) {
+      return index + _nodes[n->left].size;
+    } else {
+      offset -= leftSum + n->weight;
+      index += _nodes[n->left].size + 1;
+      node = n->right;
+    }
+  }
+  return NSNotFound;
+}
+
+- (nullable id)objectAtIndex:(NSUInteger)index {
+  [self raiseIfIndexIsNotBelowCount:index];
+  uint32_t node = _root;
+  while (YES) {
+    NSUInteger leftSize = _nodes[_nodes[node].left].size;
+    if (index < leftSize) {
+      node = _nodes[node].left;
+    } else if (index > leftSize) {
+      index -= leftSize + 1;
+      node = _nodes[node].right;
+    } else {
+      id object = _objects[node];
+      return object == [NSNull null] ? nil : object;
+    }
+  }
+}
+
+- (NSUInteger)indexOfFirstObjectPassingTest:(BOOL (NS_NOESCAPE ^)(id _Nullable))predicate {
+  NSUInteger found = self.count;
+  NSUInteger index = 0;
+  uint32_t node = _root;
+  while (node != 0) {
+    id object = _objects[node];
+    NSUInteger nodeIndex = index + _nodes[_nodes[node].left].size;
+    if (predicate(object == [NSNull null] ? nil : object)) {
+      found = nodeIndex;
+      node = _nodes[node].left;
+    } else {
+      index = nodeIndex + 1;
+      node = _nodes[node].right;
+    }
+  }
+  return found;
+}
+
+- (NSArray *)allObjects {
+  NSMutableArray *objects = [NSMutableArray arrayWithCapacity:self.count];
+  if (_root == 0) { return objects; }
+
+  // An in-order walk with an explicit stack of the nodes whose right subtrees remain.
+  NSMutableData *stackData = [NSMutableData dataWithLength:self.count * sizeof(uint32_t)];
+  uint32_t *stack = stackData.mutableBytes;
+  NSUInteger depth = 0;
+  uint32_t node = _root;
+  while (node != 0 || depth > 0) {
+    while (node != 0) {
+      stack[depth++] = node;
+      node = _nodes[node].left;
+    }
+    node = stack[--depth];
+    [objects addObject:_objects[node]];
+    node = _nodes[node].right;
+  }
+  return objects;
+}
+
+- (void)removeAllWeights {
+  _root = 0;
+  _nextNode = 1;
+  _freeList = 0;
+  [_objects removeObjectsInRange:NSMakeRange(1, _objects.count - 1)];
+}
+
+- (void)replaceAllWeightsWithCount:(NSUInteger)count
+                           weights:(NSUInteger (NS_NOESCAPE ^)(NSUInteger index))weightBlock {
+  [self removeAllWeights];
+  if (count == 0) { return; }
+
+  // Each element is appended to the tree's rightmost path, below the last node with a
+  // higher priority, and the nodes it displaces from the path become its left subtree.
+  // A node's subtree is complete once it leaves the path, so that's when it's updated.
+  NSMutableData *pathData = [NSMutableData dataWithLength:count * sizeof(uint32_t)];
+  uint32_t *path = pathData.mutableBytes;
+  NSUInteger depth = 0;
+  for (NSUInteger i = 0; i < count; i++) {
+    uint32_t node = [self allocateNodeWithWeight:weightBlock(i) object:nil];
+    uint32_t displaced = 0;
+    while (depth > 0 && _nodes[path[depth - 1]].priority < _nodes[node].priority) {
+      displaced = path[--depth];
+      FUIRankNodeUpdate(_nodes, displaced);
+    }
+    _nodes[node].left = displaced;
+    if (depth > 0) {
+      _nodes[path[depth - 1]].right = node;
+    }
+    path[depth++] = node;
+  }
+  for (NSUInteger i = depth; i > 0; i--) {
+    FUIRankNodeUpdate(_nodes, path[i - 1]);
+  }
+  _root = path[0];
+}
+
+@end
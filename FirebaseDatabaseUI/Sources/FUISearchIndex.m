@@ -0,0 +1,383 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUISearchIndex.h"
+
+#import <FirebaseDatabase/FirebaseDatabase.h>
+
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
+#import "FirebaseDatabaseUI/Sources/FUIFilteredCollection_Private.h"
+
+// Splits text into distinct words, folded so that searches ignore case, diacritics
+// and character widths.
+static NSArray<NSString *> *FUISearchWords(NSString *text) {
+  if (text.length == 0) { return @[]; }
+  NSString *folded = [text stringByFoldingWithOptions:NSCaseInsensitiveSearch |
+                                                      NSDiacriticInsensitiveSearch |
+                                                      NSWidthInsensitiveSearch
+                                               locale:nil];
+  NSMutableOrderedSet<NSString *> *words = [NSMutableOrderedSet orderedSet];
+  [folded enumerateSubstringsInRange:NSMakeRange(0, folded.length)
+                             options:NSStringEnumerationByWords
+                          usingBlock:^(NSString *word, NSRange wordRange,
+                                       NSRange enclosingRange, BOOL *stop) {
+    if (word.length > 0) {
+      [words addObject:word];
+    }
+  }];
+  return words.array;
+}
+
+static NSComparisonResult FUISearchCompareTerms(NSString *left, NSString *right) {
+  return [left compare:right options:NSLiteralSearch];
+}
+
+@interface FUISearchIndex () <FUICollectionDelegate>
+
+@property (nonatomic, copy) NSString *_Nullable (^textBlock)(FIRDataSnapshot *);
+
+/**
+ * The words of each indexed item, by key.
+ */
+@property (strong, nonatomic) NSMutableDictionary<NSString *, NSArray<NSString *> *> *wordsByKey;
+
+/**
+ * The keys of the items containing each word.
+ */
+@property (strong, nonatomic) NSMutableDictionary<NSString *, NSMutableSet<NSString *> *> *postings;
+
+/**
+ * Every word in the index as of the last query, sorted so the words starting with a
+ * prefix are adjacent and can be found by binary search.
+ */
+@property (copy, nonatomic) NSArray<NSString *> *sortedTerms;
+
+/**
+ * The words added to and removed from the index since @c sortedTerms was last
+ * brought up to date. They're merged in once before the next query, rather than
+ * shifting the sorted array on every change.
+ */
+@property (strong, nonatomic) NSMutableSet<NSString *> *addedTerms;
+@property (strong, nonatomic) NSMutableSet<NSString *> *removedTerms;
+
+/**
+ * The primary delegate and any additional delegates.
+ */
+@property (strong, nonatomic) FUICollectionDelegateList *delegates;
+
+@end
+
+@implementation FUISearchIndex
+
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                   textForSnapshot:(NSString *(^)(FIRDataSnapshot *))textBlock {
+  NSParameterAssert(collection != nil);
+  NSParameterAssert(textBlock != nil);
+  self = [super init];
+  if (self != nil) {
+    _collection = collection;
+    _textBlock = [textBlock copy];
+    _wordsByKey = [NSMutableDictionary dictionary];
+    _postings = [NSMutableDictionary dictionary];
+    _sortedTerms = @[];
+    _addedTerms = [NSMutableSet set];
+    _removedTerms = [NSMutableSet set];
+    _delegates = [[FUICollectionDelegateList alloc] init];
+
+    for (FIRDataSnapshot *snapshot in collection.items) {
+      [self indexSnapshot:snapshot];
+    }
+    if ([collection respondsToSelector:@selector(addDelegate:)]) {
+      [collection addDelegate:self];
+    } else {
+      collection.delegate = self;
+    }
+  }
+  return self;
+}
+
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                        fieldPaths:(NSArray<NSString *> *)fieldPaths {
+  NSArray<NSString *> *paths = [fieldPaths copy];
+  return [self initWithCollection:collection textForSnapshot:^NSString *(FIRDataSnapshot *snapshot) {
+    NSMutableArray<NSString *> *fields = [NSMutableArray arrayWithCapacity:paths.count];
+    for (NSString *path in paths) {
+      id value = [snapshot childSnapshotForPath:path].value;
+      if ([value isKindOfClass:[NSString class]]) {
+        [fields addObject:value];
+      } else if ([value isKindOfClass:[NSNumber class]]) {
+        [fields addObject:[value stringValue]];
+      }
+    }
+    return [fields componentsJoinedByString:@" "];
+  }];
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+#pragma mark - Indexing
+
+- (void)indexSnapshot:(FIRDataSnapshot *)snapshot {
+  NSString *key = snapshot.key;
+  [self removeKey:key];
+
+  NSArray<NSString *> *words = FUISearchWords(self.textBlock(snapshot));
+  if (words.count == 0) { return; }
+  self.wordsByKey[key] = words;
+  for (NSString *word in words) {
+    NSMutableSet<NSString *> *keys = self.postings[word];
+    if (keys == nil) {
+      keys = [NSMutableSet set];
+      self.postings[word] = keys;
+      if ([self.removedTerms containsObject:word]) {
+        [self.removedTerms removeObject:word];
+      } else {
+        [self.addedTerms addObject:word];
+      }
+    }
+    [keys addObject:key];
+  }
+}
+
+- (void)removeKey:(NSString *)key {
+  NSArray<NSString *> *words = self.wordsByKey[key];
+  if (words == nil) { return; }
+  [self.wordsByKey removeObjectForKey:key];
+  for (NSString *word in words) {
+    NSMutableSet<NSString *> *keys = self.postings[word];
+    [keys removeObject:key];
+    if (keys.count > 0) { continue; }
+
+    [self.postings removeObjectForKey:word];
+    if ([self.addedTerms containsObject:word]) {
+      [self.addedTerms removeObject:word];
+    } else {
+      [self.removedTerms addObject:word];
+    }
+  }
+}
+
+// Merges the words added and removed since the last query into the sorted words, in
+// O(T + A log A) for T words and A additions.
+- (void)mergeChangedTerms {
+  if (self.addedTerms.count == 0 && self.removedTerms.count == 0) { return; }
+  NSArray<NSString *> *added =
+      [self.addedTerms.allObjects sortedArrayUsingComparator:^NSComparisonResult(NSString *left,
+                                                                                 NSString *right) {
+    return FUISearchCompareTerms(left, right);
+  }];
+  NSArray<NSString *> *terms = self.sortedTerms;
+  NSMutableArray<NSString *> *merged = [NSMutableArray arrayWithCapacity:self.postings.count];
+  NSUInteger termIndex = 0;
+  NSUInteger addedIndex = 0;
+  while (termIndex < terms.count || addedIndex < added.count) {
+    if (addedIndex == added.count ||
+        (termIndex < terms.count &&
+         FUISearchCompareTerms(terms[termIndex], added[addedIndex]) == NSOrderedAscending)) {
+      NSString *term = terms[termIndex++];
+      if (![self.removedTerms containsObject:term]) {
+        [merged addObject:term];
+      }
+    } else {
+      [merged addObject:added[addedIndex++]];
+    }
+  }
+  self.sortedTerms = merged;
+  [self.addedTerms removeAllObjects];
+  [self.removedTerms removeAllObjects];
+}
+
+- (NSUInteger)termCount {
+  return self.postings.count;
+}
+
+#pragma mark - Queries
+
+// Returns the keys of the items with a word starting with the given prefix.
+- (NSSet<NSString *> *)keysForPrefix:(NSString *)prefix {
+  [self mergeChangedTerms];
+  NSArray<NSString *> *terms = self.sortedTerms;
+  NSUInteger index = [terms indexOfObject:prefix
+                            inSortedRange:NSMakeRange(0, terms.count)
+                                  options:NSBinarySearchingInsertionIndex
+                          usingComparator:^NSComparisonResult(NSString *left, NSString *right) {
+    return FUISearchCompareTerms(left, right);
+  }];
+
+  NSMutableSet<NSString *> *keys = nil;
+  for (; index < terms.count && [terms[index] hasPrefix:prefix]; index++) {
+    NSSet<NSString *> *termKeys = self.postings[terms[index]];
+    if (keys == nil) {
+      keys = [termKeys mutableCopy];
+    } else {
+      [keys unionSet:termKeys];
+    }
+  }
+  return keys ?: [NSSet set];
+}
+
+- (NSSet<NSString *> *)keysMatchingQuery:(NSString *)query {
+  NSArray<NSString *> *words = FUISearchWords(query);
+  if (words.count == 0) {
+    NSMutableSet<NSString *> *keys = [NSMutableSet setWithCapacity:self.collection.count];
+    for (FIRDataSnapshot *snapshot in self.collection.items) {
+      [keys addObject:snapshot.key];
+    }
+    return keys;
+  }
+
+  // Longer words usually match fewer items, so they narrow the result fastest.
+  words = [words sortedArrayUsingComparator:^NSComparisonResult(NSString *left, NSString *right) {
+    if (left.length == right.length) { return NSOrderedSame; }
+    return left.length > right.length ? NSOrderedAscending : NSOrderedDescending;
+  }];
+  NSMutableSet<NSString *> *matches = nil;
+  for (NSString *word in words) {
+    NSSet<NSString *> *keys = [self keysForPrefix:word];
+    if (matches == nil) {
+      matches = [keys mutableCopy];
+    } else {
+      [matches intersectSet:keys];
+    }
+    if (matches.count == 0) { break; }
+  }
+  return matches;
+}
+
+- (BOOL)itemWithKey:(NSString *)key matchesQuery:(NSString *)query {
+  return [self itemWithKey:key matchesWords:FUISearchWords(query)];
+}
+
+- (BOOL)itemWithKey:(NSString *)key matchesWords:(NSArray<NSString *> *)words {
+  if (words.count == 0) { return YES; }
+  NSArray<NSString *> *itemWords = self.wordsByKey[key];
+  for (NSString *word in words) {
+    BOOL found = NO;
+    for (NSString *itemWord in itemWords) {
+      if ([itemWord hasPrefix:word]) {
+        found = YES;
+        break;
+      }
+    }
+    if (!found) { return NO; }
+  }
+  return YES;
+}
+
+- (FUIFilteredCollection *)collectionMatchingQuery:(NSString *)query {
+  NSArray<NSString *> *words = FUISearchWords(query);
+  // The index sends each event to its delegates after updating itself, so the
+  // predicate sees an item's new words.
+  FUIFilteredCollection *matches =
+      [[FUIFilteredCollection alloc] initWithCollection:self
+                                              predicate:^BOOL(FIRDataSnapshot *snapshot) {
+    return [self itemWithKey:snapshot.key matchesWords:words];
+  }];
+  matches.observesCollection = NO;
+  // The items present when the results are observed are found from the postings, so
+  // only the items added or changed afterwards are matched one by one.
+  NSString *matchedQuery = [query copy];
+  matches.matchingKeysBlock = ^NSSet<NSString *> *{
+    return [self keysMatchingQuery:matchedQuery];
+  };
+  return matches;
+}
+
+#pragma mark - FUICollection
+
+- (NSArray<FIRDataSnapshot *> *)items {
+  return self.collection.items;
+}
+
+- (NSUInteger)count {
+  return self.collection.count;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index {
+  return [self.collection snapshotAtIndex:index];
+}
+
+- (void)observeQuery {
+  [self.collection observeQuery];
+}
+
+- (void)invalidate {
+  [self.collection invalidate];
+}
+
+- (id<FUICollectionDelegate>)delegate {
+  return self.delegates.primaryDelegate;
+}
+
+- (void)setDelegate:(id<FUICollectionDelegate>)delegate {
+  self.delegates.primaryDelegate = delegate;
+}
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates addDelegate:delegate];
+}
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate {
+  [self.delegates removeDelegate:delegate];
+}
+
+#pragma mark - FUICollectionDelegate
+
+- (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
+  [self.delegates arrayDidBeginUpdates:self];
+}
+
+- (void)arrayDidEndUpdates:(id<FUICollection>)collection {
+  [self.delegates arrayDidEndUpdates:self];
+}
+
+- (void)array:(id<FUICollection>)array didAddObject:(id)object atIndex:(NSUInteger)index {
+  [self indexSnapshot:object];
+  [self.delegates array:self didAddObject:object atIndex:index];
+}
+
+- (void)array:(id<FUICollection>)array didChangeObject:(id)object atIndex:(NSUInteger)index {
+  [self indexSnapshot:object];
+  [self.delegates array:self didChangeObject:object atIndex:index];
+}
+
+- (void)array:(id<FUICollection>)array didRemoveObject:(id)object atIndex:(NSUInteger)index {
+  [self removeKey:[object key]];
+  [self.delegates array:self didRemoveObject:object atIndex:index];
+}
+
+- (void)array:(id<FUICollection>)array
+    didMoveObject:(id)object
+        fromIndex:(NSUInteger)fromIndex
+          toIndex:(NSUInteger)toIndex {
+  [self.delegates array:self didMoveObject:object fromIndex:fromIndex toIndex:toIndex];
+}
+
+- (void)array:(id<FUICollection>)array queryCancelledWithError:(NSError *)error {
+  [self.delegates array:self queryCancelledWithError:error];
+}
+
+@end
@@ -0,0 +1,677 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUISectionedCollection.h"
+#import "FirebaseDatabaseUI/Sources/FUIRankTree.h"
+
+static NSIndexPath *FUISectionIndexPath(NSUInteger section, NSUInteger item) {
+  NSUInteger indexes[] = { section, item };
+  return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+@interface FUISectionChangeset ()
+
+@property (nonatomic, readonly) NSMutableIndexSet *mutableDeletedSections;
+@property (nonatomic, readonly) NSMutableIndexSet *mutableInsertedSections;
+@property (nonatomic, readonly) NSMutableArray<NSIndexPath *> *mutableDeletedItems;
+@property (nonatomic, readonly) NSMutableArray<NSIndexPath *> *mutableInsertedItems;
+@property (nonatomic, readonly) NSMutableArray<NSIndexPath *> *mutableReloadedItems;
+
+- (instancetype)initChangeset;
+
+@end
+
+@implementation FUISectionChangeset
+
+- (instancetype)initChangeset {
+  self = [super init];
+  if (self != nil) {
+    _mutableDeletedSections = [NSMutableIndexSet indexSet];
+    _mutableInsertedSections = [NSMutableIndexSet indexSet];
+    _mutableDeletedItems = [NSMutableArray array];
+    _mutableInsertedItems = [NSMutableArray array];
+    _mutableReloadedItems = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Changesets are created by FUISectionedCollection."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (NSIndexSet *)deletedSections {
+  return [self.mutableDeletedSections copy];
+}
+
+- (NSIndexSet *)insertedSections {
+  return [self.mutableInsertedSections copy];
+}
+
+- (NSArray<NSIndexPath *> *)deletedItems {
+  return [self.mutableDeletedItems copy];
+}
+
+- (NSArray<NSIndexPath *> *)insertedItems {
+  return [self.mutableInsertedItems copy];
+}
+
+- (NSArray<NSIndexPath *> *)reloadedItems {
+  return [self.mutableReloadedItems copy];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p deletedSections: %@ insertedSections: %@ "
+                                    @"deletedItems: %@ insertedItems: %@ reloadedItems: %@>",
+          NSStringFromClass([self class]), self, self.mutableDeletedSections,
+          self.mutableInsertedSections, self.mutableDeletedItems, self.mutableInsertedItems,
+          self.mutableReloadedItems];
+}
+
+@end
+
+// Returns the index after a changeset of a section that it neither inserts nor deletes.
+static NSUInteger FUISectionIndexAfterChangeset(NSUInteger section, FUISectionChangeset *changeset) {
+  NSIndexSet *deletedSections = changeset.mutableDeletedSections;
+  NSIndexSet *insertedSections = changeset.mutableInsertedSections;
+  NSUInteger index = section - [deletedSections countOfIndexesInRange:NSMakeRange(0, section)];
+  for (NSUInteger inserted = insertedSections.firstIndex;
+       inserted != NSNotFound && inserted <= index;
+       inserted = [insertedSections indexGreaterThanIndex:inserted]) {
+    index++;
+  }
+  return index;
+}
+
+/**
+ * Where a section came from during a batch of updates: the section it was when the
+ * batch began, or none if it was inserted since.
+ */
+@interface FUISectionOrigin : NSObject
+
+- (instancetype)initWithOldSection:(NSUInteger)oldSection;
+
+/**
+ * The section's index when the batch began, or NSNotFound if it was inserted since.
+ */
+@property (nonatomic, readonly) NSUInteger oldSection;
+
+/**
+ * The index each of the section's items had when the batch began, or NSNotFound for
+ * the items inserted since. nil while the section's items are the ones it began with.
+ */
+@property (strong, nonatomic, nullable) NSMutableArray<NSNumber *> *oldItems;
+
+/**
+ * The number of items the section began with, once oldItems is set.
+ */
+@property (nonatomic, assign) NSUInteger oldItemCount;
+
+/**
+ * The indexes, when the batch began, of the section's items that changed since.
+ */
+@property (nonatomic, readonly) NSMutableIndexSet *reloadedOldItems;
+
+/**
+ * Starts tracking the section's items, which are the given number it began with.
+ */
+- (void)trackItemsWithCount:(NSUInteger)count;
+
+@end
+
+@implementation FUISectionOrigin
+
+- (instancetype)initWithOldSection:(NSUInteger)oldSection {
+  self = [super init];
+  if (self != nil) {
+    _oldSection = oldSection;
+    _reloadedOldItems = [NSMutableIndexSet indexSet];
+  }
+  return self;
+}
+
+- (void)trackItemsWithCount:(NSUInteger)count {
+  self.oldItemCount = count;
+  self.oldItems = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    [self.oldItems addObject:@(i)];
+  }
+}
+
+@end
+
+/**
+ * Combines the changesets of a batch of events into one, given in terms of the
+ * sections and items the batch began with, so that views can apply the batch in a
+ * single batch of updates. A batch with one changeset passes it on as is. From the
+ * second changeset on, the origin of every section is tracked, and of every item in
+ * the sections whose items change, so combining costs O(s + m) for s sections and m
+ * items in the changed sections.
+ */
+@interface FUISectionChangesetBuilder : NSObject
+
+- (void)addChangeset:(FUISectionChangeset *)changeset sectionSizes:(FUIRankTree *)sectionSizes;
+
+/**
+ * The combined changeset, or nil if none was added.
+ */
+@property (nonatomic, readonly, nullable) FUISectionChangeset *changeset;
+
+@end
+
+@interface FUISectionChangesetBuilder ()
+
+@property (strong, nonatomic, nullable) FUISectionChangeset *firstChangeset;
+
+/**
+ * The number of items left by the first changeset in each section whose items it
+ * changed, kept in case another changeset follows.
+ */
+@property (strong, nonatomic, nullable) NSDictionary<NSNumber *, NSNumber *> *firstItemCounts;
+
+@property (nonatomic, assign) NSUInteger oldSectionCount;
+
+/**
+ * The origin of each section, once there's more than one changeset.
+ */
+@property (strong, nonatomic, nullable) NSMutableArray<FUISectionOrigin *> *origins;
+
+@end
+
+@implementation FUISectionChangesetBuilder
+
+- (void)addChangeset:(FUISectionChangeset *)changeset sectionSizes:(FUIRankTree *)sectionSizes {
+  if (self.firstChangeset == nil) {
+    self.firstChangeset = changeset;
+    self.oldSectionCount = sectionSizes.count + changeset.mutableDeletedSections.count -
+                           changeset.mutableInsertedSections.count;
+    NSMutableDictionary<NSNumber *, NSNumber *> *counts = [NSMutableDictionary dictionary];
+    for (NSIndexPath *indexPath in changeset.mutableDeletedItems) {
+      NSUInteger section = FUISectionIndexAfterChangeset([indexPath indexAtPosition:0], changeset);
+      counts[@(section)] = @([sectionSizes weightAtIndex:section]);
+    }
+    for (NSIndexPath *indexPath in changeset.mutableInsertedItems) {
+      NSUInteger section = [indexPath indexAtPosition:0];
+      counts[@(section)] = @([sectionSizes weightAtIndex:section]);
+    }
+    self.firstItemCounts = counts;
+    return;
+  }
+
+  if (self.origins == nil) {
+    self.origins = [NSMutableArray arrayWithCapacity:self.oldSectionCount];
+    for (NSUInteger section = 0; section < self.oldSectionCount; section++) {
+      [self.origins addObject:[[FUISectionOrigin alloc] initWithOldSection:section]];
+    }
+    NSDictionary<NSNumber *, NSNumber *> *counts = self.firstItemCounts;
+    [self applyChangeset:self.firstChangeset itemCounts:^NSUInteger(NSUInteger section) {
+      return counts[@(section)].unsignedIntegerValue;
+    }];
+    self.firstItemCounts = nil;
+  }
+  [self applyChangeset:changeset itemCounts:^NSUInteger(NSUInteger section) {
+    return [sectionSizes weightAtIndex:section];
+  }];
+}
+
+// Updates the origins with a changeset. The block returns the number of items in a
+// section right after the changeset, which is needed the first time the items of a
+// section change.
+- (void)applyChangeset:(FUISectionChangeset *)changeset
+            itemCounts:(NSUInteger (NS_NOESCAPE ^)(NSUInteger section))itemCounts {
+  NSMutableArray<FUISectionOrigin *> *origins = self.origins;
+  [origins removeObjectsAtIndexes:changeset.mutableDeletedSections];
+  NSIndexSet *insertedSections = changeset.mutableInsertedSections;
+  for (NSUInteger section = insertedSections.firstIndex;
+       section != NSNotFound;
+       section = [insertedSections indexGreaterThanIndex:section]) {
+    [origins insertObject:[[FUISectionOrigin alloc] initWithOldSection:NSNotFound]
+                  atIndex:section];
+  }
+
+  // Items in sections inserted during the batch are part of their section's insertion.
+  NSCountedSet<NSNumber *> *insertedItemCounts = [NSCountedSet set];
+  for (NSIndexPath *indexPath in changeset.mutableInsertedItems) {
+    [insertedItemCounts addObject:@([indexPath indexAtPosition:0])];
+  }
+  NSMutableDictionary<NSNumber *, NSMutableIndexSet *> *deletedItems = [NSMutableDictionary dictionary];
+  for (NSIndexPath *indexPath in changeset.mutableDeletedItems) {
+    NSNumber *section = @([indexPath indexAtPosition:0]);
+    if (deletedItems[section] == nil) {
+      deletedItems[section] = [NSMutableIndexSet indexSet];
+    }
+    [deletedItems[section] addIndex:[indexPath indexAtPosition:1]];
+  }
+  [deletedItems enumerateKeysAndObjectsUsingBlock:^(NSNumber *oldSection, NSIndexSet *items,
+                                                    BOOL *stop) {
+    NSUInteger section = FUISectionIndexAfterChangeset(oldSection.unsignedIntegerValue, changeset);
+    FUISectionOrigin *origin = origins[section];
+    if (origin.oldSection == NSNotFound) { return; }
+    if (origin.oldItems == nil) {
+      [origin trackItemsWithCount:itemCounts(section) + items.count -
+                                  [insertedItemCounts countForObject:@(section)]];
+    }
+    [items enumerateIndexesWithOptions:NSEnumerationReverse
+                            usingBlock:^(NSUInteger item, BOOL *stopItems) {
+      NSUInteger oldItem = origin.oldItems[item].unsignedIntegerValue;
+      if (oldItem != NSNotFound) {
+        [origin.reloadedOldItems removeIndex:oldItem];
+      }
+      [origin.oldItems removeObjectAtIndex:item];
+    }];
+  }];
+
+  NSArray<NSIndexPath *> *insertedItems =
+      [changeset.mutableInsertedItems sortedArrayUsingSelector:@selector(compare:)];
+  for (NSIndexPath *indexPath in insertedItems) {
+    NSUInteger section = [indexPath indexAtPosition:0];
+    FUISectionOrigin *origin = origins[section];
+    if (origin.oldSection == NSNotFound) { continue; }
+    if (origin.oldItems == nil) {
+      [origin trackItemsWithCount:itemCounts(section) -
+                                  [insertedItemCounts countForObject:@(section)]];
+    }
+    [origin.oldItems insertObject:@(NSNotFound) atIndex:[indexPath indexAtPosition:1]];
+  }
+
+  for (NSIndexPath *indexPath in changeset.mutableReloadedItems) {
+    FUISectionOrigin *origin = origins[[indexPath indexAtPosition:0]];
+    if (origin.oldSection == NSNotFound) { continue; }
+    NSUInteger item = [indexPath indexAtPosition:1];
+    NSUInteger oldItem = origin.oldItems != nil ? origin.oldItems[item].unsignedIntegerValue : item;
+    if (oldItem != NSNotFound) {
+      [origin.reloadedOldItems addIndex:oldItem];
+    }
+  }
+}
+
+- (FUISectionChangeset *)changeset {
+  if (self.origins == nil) { return self.firstChangeset; }
+
+  FUISectionChangeset *changeset = [[FUISectionChangeset alloc] initChangeset];
+  NSMutableIndexSet *deletedSections =
+      [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.oldSectionCount)];
+  [self.origins enumerateObjectsUsingBlock:^(FUISectionOrigin *origin, NSUInteger section,
+                                             BOOL *stop) {
+    if (origin.oldSection == NSNotFound) {
+      [changeset.mutableInsertedSections addIndex:section];
+      return;
+    }
+    [deletedSections removeIndex:origin.oldSection];
+    if (origin.oldItems != nil) {
+      NSMutableIndexSet *deletedItems =
+          [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, origin.oldItemCount)];
+      [origin.oldItems enumerateObjectsUsingBlock:^(NSNumber *oldItem, NSUInteger item,
+                                                    BOOL *stopItems) {
+        if (oldItem.unsignedIntegerValue == NSNotFound) {
+          [changeset.mutableInsertedItems addObject:FUISectionIndexPath(section, item)];
+        } else {
+          [deletedItems removeIndex:oldItem.unsignedIntegerValue];
+        }
+      }];
+      [deletedItems enumerateIndexesUsingBlock:^(NSUInteger oldItem, BOOL *stopItems) {
+        [changeset.mutableDeletedItems addObject:FUISectionIndexPath(origin.oldSection, oldItem)];
+      }];
+    }
+    [origin.reloadedOldItems enumerateIndexesUsingBlock:^(NSUInteger oldItem, BOOL *stopItems) {
+      [changeset.mutableReloadedItems addObject:FUISectionIndexPath(origin.oldSection, oldItem)];
+    }];
+  }];
+  [changeset.mutableDeletedSections addIndexes:deletedSections];
+  return changeset;
+}
+
+@end
+
+@interface FUISectionedCollection () <FUICollectionDelegate>
+
+@property (nonatomic, copy) NSString *(^sectionKey)(FIRDataSnapshot *snapshot);
+
+/**
+ * The number of items in each section, so the section of a wrapped collection's item
+ * is the one whose weight covers its index.
+ */
+@property (strong, nonatomic) FUIRankTree *sectionSizes;
+
+/**
+ * The key of each section, parallel to sectionSizes.
+ */
+@property (strong, nonatomic) NSMutableArray<NSString *> *sectionKeys;
+
+/**
+ * Combines the changesets of the wrapped collection's current batch of events, or
+ * of a move, into the one sent when it ends. nil outside of a batch.
+ */
+@property (strong, nonatomic, nullable) FUISectionChangesetBuilder *pendingChanges;
+
+@property (nonatomic, assign) BOOL isObserving;
+
+@end
+
+@implementation FUISectionedCollection
+
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                        sectionKey:(NSString *(^)(FIRDataSnapshot *))sectionKey {
+  NSParameterAssert(collection != nil);
+  NSParameterAssert(sectionKey != nil);
+  self = [super init];
+  if (self != nil) {
+    _collection = collection;
+    _sectionKey = [sectionKey copy];
+    _sectionSizes = [[FUIRankTree alloc] init];
+    _sectionKeys = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+#pragma mark - Sections
+
+- (NSUInteger)numberOfSections {
+  return self.sectionSizes.count;
+}
+
+- (NSArray<NSNumber *> *)itemCountsBySection {
+  NSUInteger count = self.sectionSizes.count;
+  NSMutableArray<NSNumber *> *counts = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    [counts addObject:@([self.sectionSizes weightAtIndex:i])];
+  }
+  return [counts copy];
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section {
+  [self checkSection:section];
+  return [self.sectionSizes weightAtIndex:section];
+}
+
+- (NSString *)keyForSection:(NSUInteger)section {
+  [self checkSection:section];
+  return self.sectionKeys[section];
+}
+
+- (FIRDataSnapshot *)snapshotAtIndexPath:(NSIndexPath *)indexPath {
+  NSUInteger collectionIndex = [self collectionIndexForIndexPath:indexPath];
+  if (collectionIndex == NSNotFound) {
+    [NSException raise:NSRangeException
+                format:@"Index path %@ beyond bounds of sectioned collection with %lu sections",
+                       indexPath, (unsigned long)self.numberOfSections];
+  }
+  return [self.collection snapshotAtIndex:collectionIndex];
+}
+
+- (NSIndexPath *)indexPathForCollectionIndex:(NSUInteger)collectionIndex {
+  NSUInteger section = [self.sectionSizes indexContainingWeightOffset:collectionIndex];
+  if (section == NSNotFound) { return nil; }
+  NSUInteger item = collectionIndex - [self.sectionSizes weightBeforeIndex:section];
+  return FUISectionIndexPath(section, item);
+}
+
+- (NSUInteger)collectionIndexForIndexPath:(NSIndexPath *)indexPath {
+  if (indexPath.length != 2) { return NSNotFound; }
+  NSUInteger section = [indexPath indexAtPosition:0];
+  NSUInteger item = [indexPath indexAtPosition:1];
+  if (section >= self.sectionSizes.count || item >= [self.sectionSizes weightAtIndex:section]) {
+    return NSNotFound;
+  }
+  return [self.sectionSizes weightBeforeIndex:section] + item;
+}
+
+- (void)checkSection:(NSUInteger)section {
+  if (section >= self.sectionSizes.count) {
+    [NSException raise:NSRangeException
+                format:@"Section %lu beyond bounds of sectioned collection with %lu sections",
+                       (unsigned long)section, (unsigned long)self.sectionSizes.count];
+  }
+}
+
+#pragma mark - Observing
+
+- (void)observeQuery {
+  if (self.isObserving) { return; }
+  self.isObserving = YES;
+
+  if ([self.collection respondsToSelector:@selector(addDelegate:)]) {
+    [self.collection addDelegate:self];
+  } else {
+    self.collection.delegate = self;
+  }
+
+  // The wrapped collection may already contain items, whose sections are sent as a
+  // single changeset so that views can start out with them.
+  [self removeAllSections];
+  for (FIRDataSnapshot *snapshot in self.collection.items) {
+    NSString *key = self.sectionKey(snapshot);
+    NSUInteger last = self.sectionKeys.count;
+    if (last > 0 && [self.sectionKeys[last - 1] isEqualToString:key]) {
+      [self.sectionSizes setWeight:[self.sectionSizes weightAtIndex:last - 1] + 1
+                           atIndex:last - 1];
+    } else {
+      [self.sectionSizes insertWeight:1 atIndex:last];
+      [self.sectionKeys addObject:key];
+    }
+  }
+  if (self.sectionKeys.count > 0) {
+    FUISectionChangeset *changeset = [[FUISectionChangeset alloc] initChangeset];
+    [changeset.mutableInsertedSections addIndexesInRange:NSMakeRange(0, self.sectionKeys.count)];
+    [self sendChangeset:changeset];
+  }
+
+  [self.collection observeQuery];
+}
+
+- (void)invalidate {
+  if (!self.isObserving) { return; }
+  // The wrapped collection sends removals for its items, which are surfaced as changesets.
+  [self.collection invalidate];
+
+  if ([self.collection respondsToSelector:@selector(removeDelegate:)]) {
+    [self.collection removeDelegate:self];
+  } else if (self.collection.delegate == self) {
+    self.collection.delegate = nil;
+  }
+  [self removeAllSections];
+  self.pendingChanges = nil;
+  self.isObserving = NO;
+}
+
+- (void)removeAllSections {
+  [self.sectionSizes removeAllWeights];
+  [self.sectionKeys removeAllObjects];
+}
+
+#pragma mark - Incremental maintenance
+
+- (void)insertSectionWithKey:(NSString *)key count:(NSUInteger)count atIndex:(NSUInteger)section {
+  [self.sectionSizes insertWeight:count atIndex:section];
+  [self.sectionKeys insertObject:key atIndex:section];
+}
+
+- (void)removeSectionAtIndex:(NSUInteger)section {
+  [self.sectionSizes removeWeightAtIndex:section];
+  [self.sectionKeys removeObjectAtIndex:section];
+}
+
+- (FUISectionChangeset *)insertItemWithKey:(NSString *)key atCollectionIndex:(NSUInteger)index {
+  FUISectionChangeset *changeset = [[FUISectionChangeset alloc] initChangeset];
+  FUIRankTree *sizes = self.sectionSizes;
+  NSUInteger before = index > 0 ? [sizes indexContainingWeightOffset:index - 1] : NSNotFound;
+  NSUInteger after = [sizes indexContainingWeightOffset:index];
+
+  if (before != NSNotFound && [self.sectionKeys[before] isEqualToString:key]) {
+    // Joins the end or middle of the section before it.
+    NSUInteger item = index - [sizes weightBeforeIndex:before];
+    [sizes setWeight:[sizes weightAtIndex:before] + 1 atIndex:before];
+    [changeset.mutableInsertedItems addObject:FUISectionIndexPath(before, item)];
+  } else if (after != NSNotFound && after != before &&
+             [self.sectionKeys[after] isEqualToString:key]) {
+    // Starts the section after it.
+    [sizes setWeight:[sizes weightAtIndex:after] + 1 atIndex:after];
+    [changeset.mutableInsertedItems addObject:FUISectionIndexPath(after, 0)];
+  } else if (before != NSNotFound && before == after) {
+    // Lands inside a section with another key, which is split around it. The items
+    // after it move to a new section of their own.
+    NSUInteger section = before;
+    NSUInteger item = index - [sizes weightBeforeIndex:section];
+    NSUInteger count = [sizes weightAtIndex:section];
+    for (NSUInteger i = item; i < count; i++) {
+      [changeset.mutableDeletedItems addObject:FUISectionIndexPath(section, i)];
+    }
+    [sizes setWeight:item atIndex:section];
+    [self insertSectionWithKey:key count:1 atIndex:section + 1];
+    [self insertSectionWithKey:self.sectionKeys[section] count:count - item atIndex:section + 2];
+    [changeset.mutableInsertedSections addIndexesInRange:NSMakeRange(section + 1, 2)];
+  } else {
+    // Falls between two sections with other keys, or at either end.
+    NSUInteger section = after != NSNotFound ? after : sizes.count;
+    [self insertSectionWithKey:key count:1 atIndex:section];
+    [changeset.mutableInsertedSections addIndex:section];
+  }
+  return changeset;
+}
+
+- (FUISectionChangeset *)removeItemAtCollectionIndex:(NSUInteger)index {
+  FUISectionChangeset *changeset = [[FUISectionChangeset alloc] initChangeset];
+  FUIRankTree *sizes = self.sectionSizes;
+  NSUInteger section = [sizes indexContainingWeightOffset:index];
+  NSAssert(section != NSNotFound, @"Sectioned collection is out of sync with %@", self.collection);
+  NSUInteger count = [sizes weightAtIndex:section];
+
+  if (count > 1) {
+    NSUInteger item = index - [sizes weightBeforeIndex:section];
+    [sizes setWeight:count - 1 atIndex:section];
+    [changeset.mutableDeletedItems addObject:FUISectionIndexPath(section, item)];
+    return changeset;
+  }
+
+  [self removeSectionAtIndex:section];
+  if (section > 0 && section < sizes.count &&
+      [self.sectionKeys[section - 1] isEqualToString:self.sectionKeys[section]]) {
+    // The sections on either side of the removed one have the same key, so they
+    // become one run of items and are merged into the first.
+    NSUInteger previousCount = [sizes weightAtIndex:section - 1];
+    NSUInteger mergedCount = [sizes weightAtIndex:section];
+    [sizes setWeight:previousCount + mergedCount atIndex:section - 1];
+    [self removeSectionAtIndex:section];
+    [changeset.mutableDeletedSections addIndexesInRange:NSMakeRange(section, 2)];
+    for (NSUInteger i = 0; i < mergedCount; i++) {
+      [changeset.mutableInsertedItems addObject:FUISectionIndexPath(section - 1, previousCount + i)];
+    }
+  } else {
+    [changeset.mutableDeletedSections addIndex:section];
+  }
+  return changeset;
+}
+
+// The removal and insertion are combined into one changeset even outside of a batch,
+// since the item is already in its new place in the wrapped collection.
+- (void)moveItemWithKey:(NSString *)key
+    fromCollectionIndex:(NSUInteger)fromIndex
+      toCollectionIndex:(NSUInteger)toIndex {
+  BOOL startsBatch = self.pendingChanges == nil;
+  if (startsBatch) {
+    self.pendingChanges = [[FUISectionChangesetBuilder alloc] init];
+  }
+  [self sendChangeset:[self removeItemAtCollectionIndex:fromIndex]];
+  [self sendChangeset:[self insertItemWithKey:key atCollectionIndex:toIndex]];
+  if (startsBatch) {
+    [self sendPendingChanges];
+  }
+}
+
+- (void)sendChangeset:(FUISectionChangeset *)changeset {
+  if (self.pendingChanges != nil) {
+    [self.pendingChanges addChangeset:changeset sectionSizes:self.sectionSizes];
+    return;
+  }
+  [self.delegate sectionedCollection:self didApplyChangeset:changeset];
+}
+
+- (void)sendPendingChanges {
+  FUISectionChangeset *changeset = self.pendingChanges.changeset;
+  self.pendingChanges = nil;
+  if (changeset != nil) {
+    [self sendChangeset:changeset];
+  }
+}
+
+#pragma mark - FUICollectionDelegate
+
+- (void)arrayDidBeginUpdates:(id<FUICollection>)collection {
+  if (self.pendingChanges == nil) {
+    self.pendingChanges = [[FUISectionChangesetBuilder alloc] init];
+  }
+  if ([self.delegate respondsToSelector:@selector(sectionedCollectionDidBeginUpdates:)]) {
+    [self.delegate sectionedCollectionDidBeginUpdates:self];
+  }
+}
+
+- (void)arrayDidEndUpdates:(id<FUICollection>)collection {
+  [self sendPendingChanges];
+  if ([self.delegate respondsToSelector:@selector(sectionedCollectionDidEndUpdates:)]) {
+    [self.delegate sectionedCollectionDidEndUpdates:self];
+  }
+}
+
+- (void)array:(id<FUICollection>)array didAddObject:(id)object atIndex:(NSUInteger)index {
+  [self sendChangeset:[self insertItemWithKey:self.sectionKey(object) atCollectionIndex:index]];
+}
+
+- (void)array:(id<FUICollection>)array didChangeObject:(id)object atIndex:(NSUInteger)index {
+  NSString *key = self.sectionKey(object);
+  NSUInteger section = [self.sectionSizes indexContainingWeightOffset:index];
+  NSAssert(section != NSNotFound, @"Sectioned collection is out of sync with %@", self.collection);
+  if ([self.sectionKeys[section] isEqualToString:key]) {
+    FUISectionChangeset *changeset = [[FUISectionChangeset alloc] initChangeset];
+    NSUInteger item = index - [self.sectionSizes weightBeforeIndex:section];
+    [changeset.mutableReloadedItems addObject:FUISectionIndexPath(section, item)];
+    [self sendChangeset:changeset];
+    return;
+  }
+  // The item changed sections, which may split or merge its neighbours.
+  [self moveItemWithKey:key fromCollectionIndex:index toCollectionIndex:index];
+}
+
+- (void)array:(id<FUICollection>)array didRemoveObject:(id)object atIndex:(NSUInteger)index {
+  [self sendChangeset:[self removeItemAtCollectionIndex:index]];
+}
+
+- (void)array:(id<FUICollection>)array didMoveObject:(id)object
+    fromIndex:(NSUInteger)fromIndex toIndex:(NSUInteger)toIndex {
+  [self moveItemWithKey:self.sectionKey(object) fromCollectionIndex:fromIndex toCollectionIndex:toIndex];
+}
+
+- (void)array:(id<FUICollection>)array queryCancelledWithError:(NSError *)error {
+  if ([self.delegate respondsToSelector:@selector(sectionedCollection:queryCancelledWithError:)]) {
+    [self.delegate sectionedCollection:self queryCancelledWithError:error];
+  }
+}
+
+@end
@@ -0,0 +1,177 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIArray.h"
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUISectionedCollectionViewDataSource.h"
+
+@interface FUISectionedCollectionViewDataSource () <FUISectionedCollectionDelegate>
+
+/**
+ * The number of items in each section is tracked separately from the sectioned
+ * collection to make sure counts aren't invalid during an animated update.
+ */
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *itemCounts;
+
+/**
+ * The callback to populate a subclass of UICollectionViewCell with an object
+ * provided by the datasource.
+ */
+@property (strong, nonatomic, readonly) UICollectionViewCell *(^populateCellAtIndexPath)
+  (UICollectionView *collectionView, NSIndexPath *indexPath, FIRDataSnapshot *object);
+
+@end
+
+@implementation FUISectionedCollectionViewDataSource
+
+#pragma mark - FUIDataSource initializer methods
+
+- (instancetype)initWithSectionedCollection:(FUISectionedCollection *)sectionedCollection
+                               populateCell:(UICollectionViewCell *(^)(UICollectionView *,
+                                                                       NSIndexPath *,
+                                                                       FIRDataSnapshot *))populateCell {
+  self = [super init];
+  if (self != nil) {
+    _sectionedCollection = sectionedCollection;
+    _sectionedCollection.delegate = self;
+    _populateCellAtIndexPath = populateCell;
+    _itemCounts = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (instancetype)initWithQuery:(FIRDatabaseQuery *)query
+                   sectionKey:(NSString *(^)(FIRDataSnapshot *))sectionKey
+                 populateCell:(UICollectionViewCell *(^)(UICollectionView *,
+                                                         NSIndexPath *,
+                                                         FIRDataSnapshot *))populateCell {
+  FUIArray *array = [[FUIArray alloc] initWithQuery:query];
+  FUISectionedCollection *sectionedCollection =
+    [[FUISectionedCollection alloc] initWithCollection:array sectionKey:sectionKey];
+  return [self initWithSectionedCollection:sectionedCollection populateCell:populateCell];
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.sectionedCollection snapshotAtIndexPath:indexPath];
+}
+
+- (void)bindToView:(UICollectionView *)view {
+  self.collectionView = view;
+  view.dataSource = self;
+  [self.sectionedCollection observeQuery];
+}
+
+- (void)unbind {
+  self.collectionView.dataSource = nil;
+  self.collectionView = nil;
+  [self.sectionedCollection invalidate];
+  [self.itemCounts removeAllObjects];
+}
+
+// Brings the tracked counts up to date with a changeset, in the order the collection
+// view applies it: deletions by their old indexes, then insertions by their new ones.
+- (void)updateItemCountsWithChangeset:(FUISectionChangeset *)changeset {
+  NSMutableArray<NSNumber *> *counts = self.itemCounts;
+  for (NSIndexPath *indexPath in changeset.deletedItems) {
+    NSUInteger section = [indexPath indexAtPosition:0];
+    counts[section] = @(counts[section].unsignedIntegerValue - 1);
+  }
+  [counts removeObjectsAtIndexes:changeset.deletedSections];
+  NSIndexSet *insertedSections = changeset.insertedSections;
+  for (NSUInteger section = insertedSections.firstIndex;
+       section != NSNotFound;
+       section = [insertedSections indexGreaterThanIndex:section]) {
+    [counts insertObject:@([self.sectionedCollection numberOfItemsInSection:section])
+                 atIndex:section];
+  }
+  for (NSIndexPath *indexPath in changeset.insertedItems) {
+    NSUInteger section = [indexPath indexAtPosition:0];
+    counts[section] = @(counts[section].unsignedIntegerValue + 1);
+  }
+}
+
+#pragma mark - FUISectionedCollectionDelegate methods
+
+// performBatchUpdates: is used for every changeset because of this radar:
+// https://openradar.appspot.com/26484150
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+          didApplyChangeset:(FUISectionChangeset *)changeset {
+  UICollectionView *collectionView = self.collectionView;
+  if (collectionView == nil) {
+    [self updateItemCountsWithChangeset:changeset];
+    return;
+  }
+  [collectionView performBatchUpdates:^{
+    [self updateItemCountsWithChangeset:changeset];
+    [collectionView deleteItemsAtIndexPaths:changeset.deletedItems];
+    [collectionView deleteSections:changeset.deletedSections];
+    [collectionView insertSections:changeset.insertedSections];
+    [collectionView insertItemsAtIndexPaths:changeset.insertedItems];
+    [collectionView reloadItemsAtIndexPaths:changeset.reloadedItems];
+  } completion:^(BOOL finished) {}];
+}
+
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+    queryCancelledWithError:(NSError *)error {
+  if (self.queryErrorHandler != NULL) {
+    self.queryErrorHandler(error);
+  }
+}
+
+#pragma mark - UICollectionViewDataSource methods
+
+- (nonnull UICollectionViewCell *)collectionView:(nonnull UICollectionView *)collectionView
+                          cellForItemAtIndexPath:(nonnull NSIndexPath *)indexPath {
+  FIRDataSnapshot *snap = [self.sectionedCollection snapshotAtIndexPath:indexPath];
+
+  UICollectionViewCell *cell = self.populateCellAtIndexPath(collectionView, indexPath, snap);
+
+  return cell;
+}
+
+- (NSInteger)numberOfSectionsInCollectionView:(nonnull UICollectionView *)collectionView {
+  return self.itemCounts.count;
+}
+
+- (NSInteger)collectionView:(nonnull UICollectionView *)collectionView
+     numberOfItemsInSection:(NSInteger)section {
+  return self.itemCounts[section].integerValue;
+}
+
+- (nonnull UICollectionReusableView *)collectionView:(nonnull UICollectionView *)collectionView
+                   viewForSupplementaryElementOfKind:(nonnull NSString *)kind
+                                         atIndexPath:(nonnull NSIndexPath *)indexPath {
+  if (self.populateSupplementaryView == NULL) {
+    [NSException raise:NSInternalInconsistencyException
+                format:@"%@ has no populateSupplementaryView closure to create a view of kind %@",
+                       self, kind];
+  }
+  NSString *key = [self.sectionedCollection keyForSection:indexPath.section];
+  return self.populateSupplementaryView(collectionView, kind, indexPath, key);
+}
+
+@end
@@ -0,0 +1,130 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUIArray.h"
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUISectionedTableViewDataSource.h"
+
+@interface FUISectionedTableViewDataSource () <FUISectionedCollectionDelegate>
+
+@property (strong, nonatomic, readwrite) UITableViewCell *(^populateCell)
+  (UITableView *tableView, NSIndexPath *indexPath, FIRDataSnapshot *snap);
+
+@end
+
+@implementation FUISectionedTableViewDataSource
+
+#pragma mark - FUIDataSource initializer methods
+
+- (instancetype)initWithSectionedCollection:(FUISectionedCollection *)sectionedCollection
+                               populateCell:(UITableViewCell *(^)(UITableView *,
+                                                                  NSIndexPath *,
+                                                                  FIRDataSnapshot *))populateCell {
+  self = [super init];
+  if (self != nil) {
+    _sectionedCollection = sectionedCollection;
+    _sectionedCollection.delegate = self;
+    _populateCell = populateCell;
+  }
+  return self;
+}
+
+- (instancetype)initWithQuery:(FIRDatabaseQuery *)query
+                   sectionKey:(NSString *(^)(FIRDataSnapshot *))sectionKey
+                 populateCell:(UITableViewCell *(^)(UITableView *,
+                                                    NSIndexPath *,
+                                                    FIRDataSnapshot *))populateCell {
+  FUIArray *array = [[FUIArray alloc] initWithQuery:query];
+  FUISectionedCollection *sectionedCollection =
+    [[FUISectionedCollection alloc] initWithCollection:array sectionKey:sectionKey];
+  return [self initWithSectionedCollection:sectionedCollection populateCell:populateCell];
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (FIRDataSnapshot *)snapshotAtIndexPath:(NSIndexPath *)indexPath {
+  return [self.sectionedCollection snapshotAtIndexPath:indexPath];
+}
+
+- (void)bindToView:(UITableView *)view {
+  self.tableView = view;
+  view.dataSource = self;
+  [self.sectionedCollection observeQuery];
+}
+
+- (void)unbind {
+  self.tableView.dataSource = nil;
+  self.tableView = nil;
+  [self.sectionedCollection invalidate];
+}
+
+#pragma mark - FUISectionedCollectionDelegate methods
+
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+          didApplyChangeset:(FUISectionChangeset *)changeset {
+  UITableView *tableView = self.tableView;
+  UITableViewRowAnimation animation = UITableViewRowAnimationAutomatic;
+  [tableView beginUpdates];
+  [tableView deleteRowsAtIndexPaths:changeset.deletedItems withRowAnimation:animation];
+  [tableView deleteSections:changeset.deletedSections withRowAnimation:animation];
+  [tableView insertSections:changeset.insertedSections withRowAnimation:animation];
+  [tableView insertRowsAtIndexPaths:changeset.insertedItems withRowAnimation:animation];
+  [tableView reloadRowsAtIndexPaths:changeset.reloadedItems withRowAnimation:animation];
+  [tableView endUpdates];
+}
+
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+    queryCancelledWithError:(NSError *)error {
+  if (self.queryErrorHandler != NULL) {
+    self.queryErrorHandler(error);
+  }
+}
+
+#pragma mark - UITableViewDataSource methods
+
+- (id)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
+  FIRDataSnapshot *snap = [self.sectionedCollection snapshotAtIndexPath:indexPath];
+
+  UITableViewCell *cell = self.populateCell(tableView, indexPath, snap);
+  return cell;
+}
+
+- (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView {
+  return self.sectionedCollection.numberOfSections;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
+  return [self.sectionedCollection numberOfItemsInSection:section];
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForHeaderInSection:(NSInteger)section {
+  NSString *key = [self.sectionedCollection keyForSection:section];
+  if (self.titleForSection != NULL) {
+    return self.titleForSection(key);
+  }
+  return key;
+}
+
+@end
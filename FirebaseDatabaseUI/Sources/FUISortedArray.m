@@ -15,6 +15,8 @@
 //
 
 #import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUISortedArray.h"
+#import "FirebaseDatabaseUI/Sources/FUIArray_Private.h"
+#import "FirebaseDatabaseUI/Sources/FUICollectionDelegateList.h"
 
 @interface FUISortedArray ()
 
@@ -39,12 +41,17 @@
  */
 @property(strong, nonatomic) NSMutableSet<NSNumber *> *handles;
 
+/**
+ * The primary delegate and any additional delegates.
+ */
+@property (strong, nonatomic) FUICollectionDelegateList *delegates;
+
 @end
 
 @implementation FUISortedArray
 // Cheating at subclassing, but this @dynamic avoids
 // duplicating storage without exposing mutability publicly
-@dynamic snapshots, handles;
+@dynamic snapshots, handles, delegates;
 
 - (instancetype)initWithQuery:(FIRDatabaseQuery *)query
                      delegate:(id<FUICollectionDelegate>)delegate
@@ -59,9 +66,7 @@
 
 - (void)insertSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
   NSInteger index = [self insertSnapshot:snap];
-  if ([self.delegate respondsToSelector:@selector(array:didAddObject:atIndex:)]) {
-    [self.delegate array:self didAddObject:snap atIndex:index];
-  }
+  [self.delegates array:self didAddObject:snap atIndex:index];
 }
 
 - (void)removeSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -70,9 +75,8 @@
 
   [self.snapshots removeObjectAtIndex:index];
   [self.keys removeObjectAtIndex:index];
-  if ([self.delegate respondsToSelector:@selector(array:didRemoveObject:atIndex:)]) {
-    [self.delegate array:self didRemoveObject:snap atIndex:index];
-  }
+  [self cancelThrottledChangeForKey:snap.key];
+  [self.delegates array:self didRemoveObject:snap atIndex:index];
 }
 
 - (void)changeSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -81,18 +85,23 @@
   NSInteger index = [self indexForKey:snap.key];
   if (index == NSNotFound) { /* error */ return; }
 
+  // When throttling, changes that leave the snapshot in place are sent as changes
+  // so they can be coalesced. Changes that reorder the array are never held back.
+  if (self.changeThrottleInterval > 0 && [self snapshot:snap keepsPositionAtIndex:index]) {
+    [self.snapshots replaceObjectAtIndex:index withObject:snap];
+    [self didChangeSnapshot:snap atIndex:index];
+    return;
+  }
+  [self cancelThrottledChangeForKey:snap.key];
+
   // Since changes can change ordering, model changes as a deletion and an insertion.
   FIRDataSnapshot *removed = [self snapshotAtIndex:index];
   [self.snapshots removeObjectAtIndex:index];
   [self.keys removeObjectAtIndex:index];
-  if ([self.delegate respondsToSelector:@selector(array:didRemoveObject:atIndex:)]) {
-    [self.delegate array:self didRemoveObject:removed atIndex:index];
-  }
+  [self.delegates array:self didRemoveObject:removed atIndex:index];
 
   NSInteger newIndex = [self insertSnapshot:snap];
-  if ([self.delegate respondsToSelector:@selector(array:didAddObject:atIndex:)]) {
-    [self.delegate array:self didAddObject:snap atIndex:newIndex];
-  }
+  [self.delegates array:self didAddObject:snap atIndex:newIndex];
 }
 
 - (void)moveSnapshot:(FIRDataSnapshot *)snap withPreviousChildKey:(NSString *)previous {
@@ -103,6 +112,30 @@
   return super.items;
 }
 
+- (void)setPayloadBudget:(NSUInteger)payloadBudget {
+  if (payloadBudget > 0) {
+    NSException *e =
+      [NSException exceptionWithName:NSInvalidArgumentException
+                              reason:@"FUISortedArray doesn't support payload budgets, since "
+                                     @"sorting needs every snapshot's payload."
+                            userInfo:nil];
+    @throw e;
+  }
+  [super setPayloadBudget:payloadBudget];
+}
+
+- (BOOL)snapshot:(FIRDataSnapshot *)snap keepsPositionAtIndex:(NSUInteger)index {
+  if (index > 0 &&
+      self.sortDescriptor([self snapshotAtIndex:index - 1], snap) == NSOrderedDescending) {
+    return NO;
+  }
+  if (index + 1 < self.count &&
+      self.sortDescriptor(snap, [self snapshotAtIndex:index + 1]) == NSOrderedDescending) {
+    return NO;
+  }
+  return YES;
+}
+
 - (NSInteger)insertSnapshot:(FIRDataSnapshot *)snapshot {
   if (self.count == 0) {
     [self.snapshots addObject:snapshot];
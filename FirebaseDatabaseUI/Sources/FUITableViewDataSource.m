@@ -117,7 +117,7 @@
 #pragma mark - UITableViewDataSource methods
 
 - (id)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
-  FIRDataSnapshot *snap = [self.collection.items objectAtIndex:indexPath.row];
+  FIRDataSnapshot *snap = [self.collection snapshotAtIndex:indexPath.row];
 
   UITableViewCell *cell = self.populateCell(tableView, indexPath, snap);
   return cell;
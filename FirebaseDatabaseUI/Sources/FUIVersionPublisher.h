@@ -0,0 +1,45 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/Public/FirebaseDatabaseUI/FUICollectionVersion.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An internal helper used by the collection classes to publish FUICollectionVersion
+ * instances. Publishing must always happen on the same thread as the collection's
+ * other mutations; reading the current version is lock-free and may happen on any thread.
+ */
+@interface FUIVersionPublisher : NSObject
+
+/**
+ * Returns the most recently published version. Safe to call from any thread.
+ */
+- (FUICollectionVersion *)currentVersion;
+
+/**
+ * Publishes a new version containing the given items and returns it. Older
+ * versions are released once no reader can still be in the middle of loading them.
+ */
+- (FUICollectionVersion *)publishItems:(NSArray<FIRDataSnapshot *> *)items;
+
+@end
+
+NS_ASSUME_NONNULL_END
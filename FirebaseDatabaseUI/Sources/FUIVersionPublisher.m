@@ -0,0 +1,87 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FirebaseDatabaseUI/Sources/FUIVersionPublisher.h"
+
+#import <stdatomic.h>
+
+@implementation FUIVersionPublisher {
+  // The current version, retained (+1) by the publisher.
+  _Atomic(void *) _current;
+
+  // The number of readers between loading _current and retaining what they loaded.
+  atomic_long _activeReaders;
+
+  // Writer-only state.
+  uint64_t _lastVersion;
+  NSMutableArray<FUICollectionVersion *> *_retired;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    FUICollectionVersion *empty = [[FUICollectionVersion alloc] initWithVersion:0 items:@[]];
+    atomic_init(&_current, (__bridge_retained void *)empty);
+    atomic_init(&_activeReaders, 0);
+    _retired = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  void *current = atomic_exchange(&_current, NULL);
+  if (current != NULL) {
+    CFRelease(current);
+  }
+}
+
+- (FUICollectionVersion *)currentVersion {
+  // Announce the read before loading the pointer so a concurrent publish can't free
+  // the loaded version before it's retained here. See -reclaimRetiredVersions.
+  atomic_fetch_add(&_activeReaders, 1);
+  void *current = atomic_load(&_current);
+  FUICollectionVersion *version = CFBridgingRelease(CFRetain(current));
+  atomic_fetch_sub(&_activeReaders, 1);
+  return version;
+}
+
+- (FUICollectionVersion *)publishItems:(NSArray<FIRDataSnapshot *> *)items {
+  _lastVersion++;
+  FUICollectionVersion *version = [[FUICollectionVersion alloc] initWithVersion:_lastVersion
+                                                                          items:items];
+  void *previous = atomic_exchange(&_current, (__bridge_retained void *)version);
+  [_retired addObject:CFBridgingRelease(previous)];
+  [self reclaimRetiredVersions];
+  return version;
+}
+
+- (void)reclaimRetiredVersions {
+  // Every retired version was swapped out before this load. If no reader is active
+  // now, any reader that starts later is guaranteed to load a newer pointer, so the
+  // publisher's references can be dropped. Readers that already retained a retired
+  // version keep it alive until they release it. If readers are active, the retired
+  // versions are kept until a later publish observes a quiescent moment.
+  if (_retired.count == 0) { return; }
+  if (atomic_load(&_activeReaders) == 0) {
+    [_retired removeAllObjects];
+  }
+}
+
+@end
@@ -17,6 +17,8 @@
 #import <FirebaseDatabase/FirebaseDatabase.h>
 
 #import "FUICollection.h"
+#import "FUICollectionVersion.h"
+#import "FUICollectionMetrics.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -31,6 +33,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (id<FUIDataObservable>)child:(NSString *)path;
 
+@optional
+
+// Used by FUIIndexArray to load contiguous runs of index keys with a single
+// key range query. See FUIIndexJoinPlanner.
+
+- (id<FUIDataObservable>)queryOrderedByKey;
+
+- (id<FUIDataObservable>)queryStartingAtValue:(nullable id)startValue;
+
+- (id<FUIDataObservable>)queryEndingAtValue:(nullable id)endValue;
+
 @end
 
 @interface FIRDatabaseQuery (FUIDataObservable) <FUIDataObservable>
@@ -61,10 +74,98 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly) NSUInteger count;
 
 /**
- * The items currently in the array.
+ * The items currently in the array. Rows whose snapshots are evicted under
+ * @c payloadBudget are left out until they're reloaded.
  */
 @property (nonatomic, readonly, copy) NSArray *items;
 
+/**
+ * An immutable copy of the array's contents as of the end of the most recent batch
+ * of updates (i.e. the last @c arrayDidEndUpdates: sent to the delegate). Unlike the
+ * rest of this class, this property may be read from any thread without locking or
+ * copying, which makes it suitable for handing the array's contents to background work.
+ * Like @c items, it leaves out rows whose snapshots are evicted under @c payloadBudget.
+ */
+@property (nonatomic, readonly) FUICollectionVersion *currentVersion;
+
+/**
+ * When greater than zero, repeated changes to the same child are coalesced. The
+ * first change to a child is sent to the delegate right away; further changes to it
+ * within this many seconds are held back and sent as one
+ * @c array:didChangeObject:atIndex: event with the latest snapshot once the interval
+ * has passed. Insertions, removals and moves are never held back, and the array's
+ * contents are always up to date. Useful for children that change many times a
+ * second, like typing indicators or live counters. Defaults to 0, which sends every
+ * change immediately.
+ */
+@property (nonatomic, assign) NSTimeInterval changeThrottleInterval;
+
+/**
+ * The clock used by @c changeThrottleInterval, returning the current time in
+ * seconds. Defaults to the system uptime. Replace it to control time in tests.
+ */
+@property (nonatomic, copy, null_resettable) NSTimeInterval (^throttleClock)(void);
+
+/**
+ * Receives measurements of each batch of updates: how many events of each type were
+ * applied, how long the array spent updating its storage and its delegates spent
+ * in callbacks, and how many callbacks ran over @c slowCallbackThreshold. The array
+ * only takes measurements while it has a sink. Held weakly. Defaults to nil.
+ */
+@property (nonatomic, weak, nullable) id<FUICollectionMetricsSink> metricsSink;
+
+/**
+ * Delegate callbacks that take longer than this many seconds are counted as slow in
+ * the metrics sent to @c metricsSink. Defaults to one frame at 60Hz.
+ */
+@property (nonatomic, assign) NSTimeInterval slowCallbackThreshold;
+
+/**
+ * When greater than zero, limits the memory held by the rows' snapshots to about this
+ * many bytes, as estimated by @c payloadCostEstimator. At the end of each batch of
+ * updates, the array evicts the snapshots of rows outside @c payloadWindow of the most
+ * recently accessed row, farthest first, until the budget holds. An evicted row keeps
+ * its key and position, so @c count and @c indexForKey: are unaffected, but the array
+ * lets go of its snapshot.
+ *
+ * Like the unloaded rows of FUIIndexArray, evicted rows are left out of @c items and
+ * @c currentVersion. Accessing one with @c snapshotAtIndex: or @c valueAtIndex:
+ * reloads it with a single-value listener on its location, which the database answers
+ * from its local cache when it can, and the reloaded snapshot is sent to delegates as
+ * a change. Until then, @c snapshotAtIndex: returns a placeholder with the row's key
+ * and ref and no value. Delegate events carry snapshots received from the database,
+ * except that @c invalidate removes evicted rows with their placeholders.
+ *
+ * Not supported by FUISortedArray, which compares every row's snapshot to stay sorted.
+ * Defaults to 0, which keeps every snapshot.
+ */
+@property (nonatomic, assign) NSUInteger payloadBudget;
+
+/**
+ * The number of rows on either side of the most recently accessed row whose snapshots
+ * are never evicted. Should cover the visible rows. Defaults to 20.
+ */
+@property (nonatomic, assign) NSUInteger payloadWindow;
+
+/**
+ * Estimates how many bytes a row's snapshot holds from its key and value. Defaults to
+ * an estimate based on the size of the key and value. Replacing it estimates every
+ * held snapshot again.
+ */
+@property (nonatomic, copy, null_resettable) NSUInteger (^payloadCostEstimator)(NSString *key, id _Nullable value);
+
+/**
+ * The estimated number of bytes held by the snapshots of rows that aren't evicted.
+ * Kept up to date with every change while @c payloadBudget is greater than zero, and
+ * 0 otherwise.
+ */
+@property (nonatomic, readonly) NSUInteger residentPayloadBytes;
+
+/**
+ * The number of rows whose snapshots aren't evicted.
+ */
+@property (nonatomic, readonly) NSUInteger residentPayloadCount;
+
 #pragma mark - Initializer methods
 
 /**
@@ -95,12 +196,47 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - Public API methods
 
 /**
- * Returns an object at a specific index in the array.
+ * Returns an object at a specific index in the array. While @c payloadBudget is
+ * greater than zero, the row becomes the one around which snapshots are kept, and an
+ * evicted row is reloaded.
  * @param index The index of the item to retrieve
  * @return The snapshot at the given index
  */
 - (FIRDataSnapshot *)snapshotAtIndex:(NSInteger)index;
 
+/**
+ * Returns the value of the snapshot at a specific index, like @c snapshotAtIndex:.
+ * Returns nil while the row's evicted snapshot is being reloaded.
+ * @param index The index of the value to retrieve
+ * @return The value of the snapshot at the given index
+ */
+- (nullable id)valueAtIndex:(NSUInteger)index;
+
+/**
+ * Returns NO if the snapshot of the row at the given index was evicted under
+ * @c payloadBudget and hasn't been reloaded yet. Doesn't count as accessing the row.
+ */
+- (BOOL)isPayloadResidentAtIndex:(NSUInteger)index;
+
+/**
+ * Immediately sends all change events currently held back by @c changeThrottleInterval.
+ */
+- (void)flushThrottledChanges;
+
+/**
+ * Registers an additional delegate. Each event is sent to the @c delegate property
+ * first and then to additional delegates in the order they were added. Which
+ * delegate methods a delegate implements is looked up once, when it's registered.
+ * @param delegate The delegate to add. It is held weakly.
+ */
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+/**
+ * Unregisters a delegate previously added with @c addDelegate:.
+ * @param delegate The delegate to remove.
+ */
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
 /**
  * Returns a Firebase reference for an object at a specific index in the array.
  * @param index The index of the item to retrieve a reference for
@@ -67,6 +67,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)invalidate;
 
+@optional
+
+/**
+ * Registers an additional delegate that receives every FUICollectionDelegate event
+ * after the @c delegate property does. Additional delegates are held weakly, and
+ * adding one doesn't add any observers on the underlying query.
+ * @param delegate The delegate to add. Adding the same delegate twice has no effect.
+ */
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+/**
+ * Unregisters a delegate previously added with @c addDelegate:.
+ * @param delegate The delegate to remove.
+ */
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
 @end
 
 /**
@@ -0,0 +1,111 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <FirebaseDatabase/FirebaseDatabase.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Measurements of one batch of updates to a collection, from the event that began
+ * the batch up to and including the collection's @c arrayDidEndUpdates: callbacks.
+ * Durations are in seconds.
+ */
+@interface FUICollectionBatchMetrics : NSObject
+
+/**
+ * When the batch began, in the same timebase as NSProcessInfo's @c systemUptime.
+ * Together with @c duration and the event counts, this lets sinks compute event
+ * rates over whatever window they like.
+ */
+@property (nonatomic, readonly) NSTimeInterval startTime;
+
+/**
+ * The time from the start of the batch to the end of its last callback. Includes
+ * time spent outside the collection between events.
+ */
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+/**
+ * The number of child events the collection applied during the batch.
+ */
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+ * The number of child events of the given type applied during the batch. Value
+ * events only mark the end of a batch and aren't counted.
+ */
+- (NSUInteger)eventCountForType:(FIRDataEventType)eventType;
+
+/**
+ * The time spent applying events to the collection's own storage, excluding
+ * delegate callbacks.
+ */
+@property (nonatomic, readonly) NSTimeInterval storageDuration;
+
+/**
+ * The time spent in delegate callbacks, including @c arrayDidBeginUpdates: and
+ * @c arrayDidEndUpdates:.
+ */
+@property (nonatomic, readonly) NSTimeInterval delegateDuration;
+
+/**
+ * The time spent computing diffs. Zero for collections that apply events as they
+ * arrive instead of diffing snapshots.
+ */
+@property (nonatomic, readonly) NSTimeInterval diffDuration;
+
+/**
+ * The number of items in the collection at the end of the batch.
+ */
+@property (nonatomic, readonly) NSUInteger itemCount;
+
+/**
+ * The number of delegate callbacks that took longer than the collection's
+ * @c slowCallbackThreshold.
+ */
+@property (nonatomic, readonly) NSUInteger slowCallbackCount;
+
+/**
+ * The duration of the longest delegate callback in the batch.
+ */
+@property (nonatomic, readonly) NSTimeInterval longestCallbackDuration;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * Receives the metrics of every batch of updates to a collection. Collections only
+ * measure batches while they have a sink, so instrumentation costs next to nothing
+ * when it isn't used.
+ */
+@protocol FUICollectionMetricsSink <NSObject>
+
+/**
+ * Called on the main thread at the end of every batch, after the collection's
+ * delegates have been sent @c arrayDidEndUpdates:.
+ * @param collection The FUIArray, FUISortedArray or FUIIndexArray that was updated.
+ * @param metrics The batch's measurements.
+ */
+- (void)collection:(id)collection didFinishBatchWithMetrics:(FUICollectionBatchMetrics *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
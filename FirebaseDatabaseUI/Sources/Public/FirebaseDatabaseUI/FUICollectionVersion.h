@@ -0,0 +1,66 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <Foundation/Foundation.h>
+
+@class FIRDataSnapshot;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An immutable copy of a collection's contents at a point in time. Versions are
+ * published by FUIArray and FUIIndexArray after each batch of updates and, unlike
+ * the collections themselves, may be read from any thread.
+ *
+ * Holding on to a version keeps its contents alive; a version is freed once the
+ * collection has published a newer one and the last reader releases it.
+ */
+@interface FUICollectionVersion : NSObject
+
+/**
+ * A number that increases every time the owning collection publishes a new version.
+ * The empty version a collection starts with is version 0.
+ */
+@property (nonatomic, readonly) uint64_t version;
+
+/**
+ * The snapshots in the collection at the time this version was published.
+ */
+@property (nonatomic, readonly, copy) NSArray<FIRDataSnapshot *> *items;
+
+/**
+ * The number of snapshots in this version.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+- (instancetype)initWithVersion:(uint64_t)version
+                          items:(NSArray<FIRDataSnapshot *> *)items NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns the snapshot at the given index. Raises a fatal error if the index
+ * is out of bounds.
+ */
+- (FIRDataSnapshot *)snapshotAtIndex:(NSUInteger)index;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,78 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUIArray.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Records the events Firebase Database delivers to a collection into a compact binary
+ * trace file, so that the same sequence of events can later be fed to a collection
+ * with @c FUIDataTraceReplayer. Useful for reproducing and profiling hitches caused
+ * by real-world event sequences.
+ *
+ * Wrap each query the collection observes with @c recordingObservable:name: and
+ * create the collection from the wrapped queries. Every listener the collection
+ * attaches, including listeners on children and key range queries, is recorded
+ * along with every event and cancellation delivered to it: the event's snapshot,
+ * its previous child key and when it arrived. Priorities and references aren't
+ * recorded.
+ */
+@interface FUIDataTraceRecorder : NSObject
+
+/**
+ * Creates a recorder writing to a new trace file, replacing any file at the URL.
+ * @param url A file URL to write the trace to.
+ * @param error Set if the file couldn't be created.
+ * @return A recorder, or nil if the file couldn't be created.
+ */
+- (nullable instancetype)initWithURL:(NSURL *)url
+                               error:(NSError **)error NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns an observable that forwards to the given one and records everything
+ * delivered to its listeners.
+ * @param observable The query to record.
+ * @param name A name for the query, unique within the trace, that identifies it
+ *   when the trace is replayed.
+ */
+- (id<FUIDataObservable>)recordingObservable:(id<FUIDataObservable>)observable
+                                        name:(NSString *)name;
+
+/**
+ * The number of events and cancellations recorded so far.
+ */
+@property (nonatomic, readonly) NSUInteger recordedEventCount;
+
+/**
+ * Writes out any buffered events and closes the trace file. Events delivered
+ * afterwards are still forwarded, but no longer recorded. The trace is also
+ * finished when the recorder is deallocated: recording observables don't retain
+ * the recorder's file, so collections still observing them don't keep it open.
+ * @param error Set if the trace couldn't be written.
+ * @return YES if the trace was written.
+ */
+- (BOOL)finishRecordingWithError:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,121 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUIArray.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The error domain of errors reading traces.
+ */
+FOUNDATION_EXPORT NSErrorDomain const FUIDataTraceErrorDomain;
+
+typedef NS_ERROR_ENUM(FUIDataTraceErrorDomain, FUIDataTraceErrorCode) {
+  /** The file isn't a trace, or is truncated or corrupt. */
+  FUIDataTraceErrorCorruptTrace = 1,
+  /** The trace was written by a newer, incompatible version. */
+  FUIDataTraceErrorUnsupportedVersion = 2,
+};
+
+/**
+ * How fast a trace is replayed.
+ */
+typedef NS_ENUM(NSInteger, FUIDataTraceReplaySpeed) {
+  /** Events are delivered on the main queue with the gaps they were recorded with. */
+  FUIDataTraceReplaySpeedOriginal,
+  /** Events are delivered back to back on the calling thread. */
+  FUIDataTraceReplaySpeedMaximum,
+};
+
+/**
+ * Feeds the events of a trace written by @c FUIDataTraceRecorder back to a
+ * collection, so that a recorded workload can be profiled deterministically and
+ * without a network connection.
+ *
+ * Create the collection the trace was recorded with from the observables returned
+ * by @c observableNamed:, start it observing, and call @c replayWithSpeed:completion:.
+ * Listeners are matched to the recorded ones by query, event type and the order
+ * they're attached in, so the collection must be configured the same way it was
+ * during recording. Listeners that don't match a recorded one receive no events.
+ *
+ * Replayed snapshots aren't FIRDataSnapshots, which can't be created outside of the
+ * Firebase SDK. They implement the parts of FIRDataSnapshot's interface that
+ * describe data, such as @c key, @c value and @c children, but have no @c ref.
+ *
+ * Replayers aren't thread-safe and should be used from the main thread.
+ */
+@interface FUIDataTraceReplayer : NSObject
+
+/**
+ * Loads a trace.
+ * @param url The file URL of a trace written by @c FUIDataTraceRecorder.
+ * @param error Set if the trace couldn't be read.
+ * @return A replayer, or nil if the trace couldn't be read.
+ */
+- (nullable instancetype)initWithContentsOfURL:(NSURL *)url
+                                         error:(NSError **)error NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns an observable standing in for the query that was recorded under the
+ * given name. Its children and key range queries stand in for the recorded ones.
+ */
+- (id<FUIDataObservable>)observableNamed:(NSString *)name;
+
+/**
+ * Delivers every event of the trace to the listeners attached to the replayer's
+ * observables. Events for listeners that have been removed are dropped.
+ * @param speed How fast to deliver events. At maximum speed every event has been
+ *   delivered, and completion called, by the time this method returns.
+ * @param completion Called once every event has been delivered.
+ */
+- (void)replayWithSpeed:(FUIDataTraceReplaySpeed)speed
+             completion:(nullable void (^)(void))completion;
+
+/**
+ * Stops a replay at original speed. The completion block isn't called.
+ */
+- (void)cancelReplay;
+
+/**
+ * The number of events and cancellations in the trace.
+ */
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+ * The number of events dropped so far because their listener had been removed.
+ */
+@property (nonatomic, readonly) NSUInteger droppedEventCount;
+
+/**
+ * The number of listeners attached so far that didn't match a recorded listener.
+ * Nonzero when the collection isn't configured the way it was during recording.
+ */
+@property (nonatomic, readonly) NSUInteger unmatchedListenerCount;
+
+/**
+ * The time between the first and last event of the trace.
+ */
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,99 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUICollection.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A live view of the items of another collection that match a predicate. The
+ * predicate is evaluated once for each item added or changed, and the wrapped
+ * collection's events are forwarded to the filtered collection's delegates with
+ * their indexes translated in O(log n), so a filtered collection can back a data
+ * source like any other collection.
+ *
+ * By default the filtered collection observes and invalidates the wrapped collection
+ * when it is itself observed and invalidated, so the wrapped collection shouldn't be
+ * observed separately. See @c observesCollection for wrapping a collection that's
+ * observed elsewhere. The filtered collection registers itself with the wrapped collection using @c addDelegate:
+ * if available, and otherwise as its @c delegate.
+ *
+ * An item that stops matching because it changed is removed with its new contents.
+ * Filtered collections aren't thread-safe and should be used from the main thread.
+ */
+@interface FUIFilteredCollection : NSObject <FUICollection>
+
+/**
+ * Creates a filtered view of a collection.
+ * @param collection The collection to filter.
+ * @param predicate Returns YES for the snapshots the filtered collection contains.
+ *   Must be deterministic, since it's only evaluated again when a snapshot changes.
+ */
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                         predicate:(BOOL (^)(FIRDataSnapshot *snapshot))predicate
+    NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * The collection being filtered.
+ */
+@property (nonatomic, readonly) id<FUICollection> collection;
+
+/**
+ * Whether @c observeQuery and @c invalidate also observe and invalidate the wrapped
+ * collection. Defaults to YES. When NO, they only start and stop following the
+ * wrapped collection's events, and @c invalidate sends a removal for each item.
+ * Must not be changed while observing.
+ */
+@property (nonatomic, assign) BOOL observesCollection;
+
+/**
+ * The predicate deciding which snapshots are contained. Setting it evaluates the
+ * new predicate on every item and sends the items that appear and disappear to the
+ * delegates in one batch of updates: removals first, from the last to the first,
+ * then insertions, from the first to the last.
+ */
+@property (nonatomic, copy) BOOL (^predicate)(FIRDataSnapshot *snapshot);
+
+/**
+ * The delegate object that filtered events are surfaced to.
+ */
+@property (weak, nonatomic, nullable) id<FUICollectionDelegate> delegate;
+
+/**
+ * Returns the index in the wrapped collection of the item at the given index, or
+ * NSNotFound if the index is out of bounds.
+ */
+- (NSUInteger)collectionIndexForIndex:(NSUInteger)index;
+
+/**
+ * Returns the index of the wrapped collection's item at the given index, or
+ * NSNotFound if the item doesn't match the predicate.
+ */
+- (NSUInteger)indexForCollectionIndex:(NSUInteger)collectionIndex;
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
+@end
+
+NS_ASSUME_NONNULL_END
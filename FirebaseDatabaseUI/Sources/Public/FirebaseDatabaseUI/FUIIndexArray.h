@@ -19,6 +19,7 @@
 // clang-format on
 
 #import "FUIArray.h"
+#import "FUIIndexJoinPlanner.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -129,11 +130,40 @@ didFailLoadWithError:(NSError *)error;
  */
 @property(nonatomic, weak) id<FUIIndexArrayDelegate> delegate;
 
+/**
+ * An optional planner that groups index keys into key ranges, so runs of nearby
+ * keys are loaded from the data node with one range query each instead of one
+ * listener per key. Must be set before @c observeQuery is called, and is only used
+ * if the data observable implements FUIDataObservable's optional range query
+ * methods. Defaults to nil, which loads every key with its own listener.
+ */
+@property(nonatomic, strong, nullable) id<FUIIndexJoinPlanner> joinPlanner;
+
+/**
+ * Receives measurements of each batch of updates to the index, like
+ * FUIArray's @c metricsSink. Storage time includes managing the rows' listeners.
+ * Row loads happen outside of index batches and aren't measured. Held weakly.
+ */
+@property(nonatomic, weak, nullable) id<FUICollectionMetricsSink> metricsSink;
+
+/**
+ * Delegate callbacks that take longer than this many seconds are counted as slow in
+ * the metrics sent to @c metricsSink. Defaults to one frame at 60Hz.
+ */
+@property(nonatomic, assign) NSTimeInterval slowCallbackThreshold;
+
 /**
  * Returns the number of items in the array.
  */
 @property(nonatomic, readonly) NSUInteger count;
 
+/**
+ * An immutable copy of the loaded contents in the array, as of the end of the
+ * last batch of index updates or the last completed load, whichever is most recent.
+ * May be read from any thread.
+ */
+@property(nonatomic, readonly) FUICollectionVersion *currentVersion;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 /**
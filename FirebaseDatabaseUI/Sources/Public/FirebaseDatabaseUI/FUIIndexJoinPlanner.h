@@ -0,0 +1,129 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A contiguous run of keys, in Firebase Database key order, that FUIIndexArray
+ * loads with a single key range query instead of one listener per key.
+ */
+@interface FUIIndexJoinRange : NSObject
+
+/**
+ * The first key in the range.
+ */
+@property (nonatomic, readonly, copy) NSString *startKey;
+
+/**
+ * The last key in the range.
+ */
+@property (nonatomic, readonly, copy) NSString *endKey;
+
+/**
+ * The index keys the range was planned for, sorted in key order. The range query
+ * also returns any other children of the data node between the start and end keys.
+ */
+@property (nonatomic, readonly, copy) NSArray<NSString *> *keys;
+
+/**
+ * Initializes a range covering the given keys.
+ * @param keys A nonempty array of keys, sorted in Firebase Database key order.
+ */
+- (instancetype)initWithKeys:(NSArray<NSString *> *)keys NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns YES if the given key falls between the range's start and end keys,
+ * whether or not it is one of the range's planned keys.
+ */
+- (BOOL)containsKey:(NSString *)key;
+
+@end
+
+/**
+ * A join planner decides how FUIIndexArray loads the data rows for its index keys.
+ * Keys the planner groups into a range are loaded with one
+ * @c queryOrderedByKey / @c queryStartingAtValue: / @c queryEndingAtValue: listener
+ * on the data node; all other keys get their own listener, as they would without
+ * a planner.
+ */
+@protocol FUIIndexJoinPlanner <NSObject>
+
+/**
+ * Groups index keys into ranges. Keys that aren't part of any returned range are
+ * loaded individually. Returned ranges must not overlap.
+ * @param keys The index keys that need to be loaded, in no particular order.
+ */
+- (NSArray<FUIIndexJoinRange *> *)rangesForKeys:(NSArray<NSString *> *)keys;
+
+@optional
+
+/**
+ * Called once after a range first loads. Return NO to split the range back into
+ * per-key listeners, for example when most of the children it loaded aren't
+ * referenced by the index.
+ * @param range The range that finished loading.
+ * @param childCount The number of children of the data node within the range.
+ */
+- (BOOL)shouldKeepRange:(FUIIndexJoinRange *)range loadedChildCount:(NSUInteger)childCount;
+
+@end
+
+/**
+ * The default join planner. Groups runs of index keys into ranges when they are
+ * dense enough that a range query won't load many rows that aren't in the index.
+ *
+ * The density of a run of integer keys is estimated from the keys themselves. Other
+ * keys, like push IDs, are grouped optimistically, and a range whose loaded density
+ * turns out to be below @c minimumDensity is split back into per-key listeners.
+ */
+@interface FUIIndexRangeJoinPlanner : NSObject <FUIIndexJoinPlanner>
+
+/**
+ * The smallest number of index keys worth loading with a range query. Defaults to 4.
+ */
+@property (nonatomic, assign) NSUInteger minimumRangeSize;
+
+/**
+ * The largest number of index keys grouped into a single range. Since any change to
+ * a child inside a range redelivers the whole range, very large ranges are split.
+ * Defaults to 50.
+ */
+@property (nonatomic, assign) NSUInteger maximumRangeSize;
+
+/**
+ * The minimum fraction of children within a range that must be referenced by the
+ * index. Defaults to 0.5.
+ */
+@property (nonatomic, assign) double minimumDensity;
+
+/**
+ * Compares two keys the way Firebase Database orders children by key: keys that
+ * parse as 32-bit integers come first in numeric order, followed by all other keys
+ * in lexicographical order.
+ */
++ (NSComparisonResult)compareKey:(NSString *)key toKey:(NSString *)otherKey;
+
+@end
+
+NS_ASSUME_NONNULL_END
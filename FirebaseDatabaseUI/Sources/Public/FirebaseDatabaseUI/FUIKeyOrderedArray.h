@@ -0,0 +1,47 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUIArray.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An FUIArray for queries ordered by key, such as references, which are ordered
+ * by key by default, and queries created with @c queryOrderedByKey. Since a child's
+ * position is determined by its key, it's found by binary search instead of by
+ * scanning for the previous child's key, and children added after the last one,
+ * such as those with new push IDs, are appended without searching. Keys are
+ * stored in a single contiguous buffer instead of as separate strings.
+ *
+ * Every event's previous child key is checked against the position found by
+ * binary search. If they disagree, for instance because the query isn't actually
+ * ordered by key, the array switches to FUIArray's behavior until it's invalidated.
+ */
+@interface FUIKeyOrderedArray : FUIArray
+
+/**
+ * YES while children are placed by key. Becomes NO when an event arrives out of key
+ * order, and YES again once the array is invalidated.
+ */
+@property (nonatomic, readonly, getter=isKeyOrdered) BOOL keyOrdered;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,92 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUIArray.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A collection merging the children of several queries, such as the same kind of
+ * data sharded across several locations, into one list sorted by a sort descriptor.
+ * Each query's events are translated into events on the merged list: a child's
+ * position is found by binary search, and a change that reorders a child is sent as
+ * a change followed by a move. Queries can be added and removed while observing,
+ * which inserts or removes only their own children.
+ *
+ * Children that compare equal are ordered by the order their queries were added in,
+ * then by key. Merged collections aren't thread-safe and should be used from the
+ * main thread.
+ */
+@interface FUIMergedCollection : NSObject <FUICollection>
+
+/**
+ * Creates a merged collection.
+ * @param queries The queries whose children are merged.
+ * @param delegate The delegate object that should receive events from the collection.
+ * @param sortDescriptor The block used to order the merged children. It must always
+ *   return consistent results.
+ */
+- (instancetype)initWithQueries:(NSArray<id<FUIDataObservable>> *)queries
+                       delegate:(nullable id<FUICollectionDelegate>)delegate
+                 sortDescriptor:(NSComparisonResult (^)(FIRDataSnapshot *left,
+                                                        FIRDataSnapshot *right))sortDescriptor
+    NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * The queries whose children are merged, in the order they were added.
+ */
+@property (nonatomic, readonly, copy) NSArray<id<FUIDataObservable>> *queries;
+
+/**
+ * The delegate object that collection changes are surfaced to.
+ */
+@property (weak, nonatomic, nullable) id<FUICollectionDelegate> delegate;
+
+/**
+ * Adds a query. If the collection is observing, the query is observed right away and
+ * its children are inserted as they arrive. Adding a query twice has no effect.
+ */
+- (void)addQuery:(id<FUIDataObservable>)query;
+
+/**
+ * Removes a query. If the collection is observing, the query's listeners are removed
+ * and its children are removed in one batch of updates.
+ */
+- (void)removeQuery:(id<FUIDataObservable>)query;
+
+/**
+ * Returns the query the child at the given index came from.
+ */
+- (id<FUIDataObservable>)queryForItemAtIndex:(NSUInteger)index;
+
+/**
+ * Returns the index of a query's child, or NSNotFound if it isn't in the collection.
+ */
+- (NSUInteger)indexForKey:(NSString *)key inQuery:(id<FUIDataObservable>)query;
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
+@end
+
+NS_ASSUME_NONNULL_END
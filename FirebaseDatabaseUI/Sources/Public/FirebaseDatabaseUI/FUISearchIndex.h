@@ -0,0 +1,103 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUIFilteredCollection.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A full-text index over the items of a collection, kept up to date from the
+ * collection's delegate events, for searching synchronized lists as the user types.
+ * Each item's text is tokenized once when it's added or changed, into words folded
+ * to ignore case and diacritics. Queries are answered from an inverted index of those
+ * words without reading any snapshot.
+ *
+ * A query matches an item when every word of the query is a prefix of one of the
+ * item's words, so "ann sm" matches "Anna Smith".
+ *
+ * The index registers itself with the collection using @c addDelegate: if
+ * available, and otherwise as its @c delegate. It's a collection itself, with the
+ * same items as the one it indexes, whose delegates receive each event after the
+ * index has been updated. Its @c observeQuery and @c invalidate observe and invalidate
+ * the indexed collection. Search indexes aren't thread-safe and should be used from
+ * the main thread.
+ */
+@interface FUISearchIndex : NSObject <FUICollection>
+
+/**
+ * Creates an index and indexes the collection's current items.
+ * @param collection The collection to index.
+ * @param textBlock Returns the text to index for a snapshot, or nil for none.
+ */
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                   textForSnapshot:(NSString *_Nullable (^)(FIRDataSnapshot *snapshot))textBlock
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Creates an index of the values at the given child paths of each snapshot, such as
+ * @c \@[\@"name", \@"address/city"]. String and number values are indexed.
+ */
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                        fieldPaths:(NSArray<NSString *> *)fieldPaths;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * The indexed collection.
+ */
+@property (nonatomic, readonly) id<FUICollection> collection;
+
+/**
+ * The delegate object that the indexed collection's events are surfaced to.
+ */
+@property (weak, nonatomic, nullable) id<FUICollectionDelegate> delegate;
+
+/**
+ * The number of distinct words in the index.
+ */
+@property (nonatomic, readonly) NSUInteger termCount;
+
+/**
+ * Returns the keys of the items matching a query. A query without any words matches
+ * every item.
+ */
+- (NSSet<NSString *> *)keysMatchingQuery:(NSString *)query;
+
+/**
+ * Returns YES if the item with the given key matches a query.
+ */
+- (BOOL)itemWithKey:(NSString *)key matchesQuery:(NSString *)query;
+
+/**
+ * Returns a live collection of the items matching a query, in the indexed
+ * collection's order. Its @c observesCollection is NO, so observing and invalidating
+ * it doesn't affect the indexed collection. Like any collection, it's empty until it's
+ * observed. Observing it finds the items already present from the index, without
+ * evaluating the query on each of them, and later events are matched one by one.
+ */
+- (FUIFilteredCollection *)collectionMatchingQuery:(NSString *)query;
+
+- (void)addDelegate:(id<FUICollectionDelegate>)delegate;
+
+- (void)removeDelegate:(id<FUICollectionDelegate>)delegate;
+
+@end
+
+NS_ASSUME_NONNULL_END
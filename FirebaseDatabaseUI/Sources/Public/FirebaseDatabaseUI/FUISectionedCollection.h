@@ -0,0 +1,193 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import "FUICollection.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUISectionedCollection;
+
+/**
+ * The changes made to a sectioned collection by a batch of its wrapped collection's
+ * events, in the form UITableView and UICollectionView batch updates expect:
+ * deleted sections and items are given by their indexes before the change, and
+ * inserted sections and items by their indexes after it. Reloaded items are given by
+ * their indexes before the change, like deleted ones, and are in sections that are
+ * neither inserted nor deleted. Inserted sections contain every item they're created
+ * with, which isn't listed in @c insertedItems.
+ */
+@interface FUISectionChangeset : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSIndexSet *deletedSections;
+
+@property (nonatomic, readonly) NSIndexSet *insertedSections;
+
+@property (nonatomic, readonly) NSArray<NSIndexPath *> *deletedItems;
+
+@property (nonatomic, readonly) NSArray<NSIndexPath *> *insertedItems;
+
+@property (nonatomic, readonly) NSArray<NSIndexPath *> *reloadedItems;
+
+@end
+
+/**
+ * A protocol to allow instances of FUISectionedCollection to surface changes to
+ * their sections through a delegate.
+ */
+@protocol FUISectionedCollectionDelegate <NSObject>
+
+/**
+ * Delegate method called with the changes made by each batch of the wrapped
+ * collection's events, just before @c sectionedCollectionDidEndUpdates:. Events the
+ * wrapped collection sends outside of a batch get a changeset each, and a move or a
+ * change of an item's section key is always a single changeset. Each changeset
+ * should be applied in a single batch of updates.
+ * @param collection The sectioned collection that changed.
+ * @param changeset The sections and items that were inserted, deleted and reloaded.
+ */
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+        didApplyChangeset:(FUISectionChangeset *)changeset;
+
+@optional
+
+/**
+ * Called when the wrapped collection begins sending a batch of events.
+ */
+- (void)sectionedCollectionDidBeginUpdates:(FUISectionedCollection *)collection;
+
+/**
+ * Called when the wrapped collection has finished sending a batch of events, after
+ * the batch's changeset.
+ */
+- (void)sectionedCollectionDidEndUpdates:(FUISectionedCollection *)collection;
+
+/**
+ * Delegate method which is called whenever the backing query is canceled.
+ * @param collection The sectioned collection whose query was canceled.
+ * @param error The error that occurred.
+ */
+- (void)sectionedCollection:(FUISectionedCollection *)collection
+    queryCancelledWithError:(NSError *)error;
+
+@end
+
+/**
+ * Groups the items of another collection into sections by a key computed from each
+ * snapshot. A section is a run of adjacent items with the same key, so the wrapped
+ * collection must be ordered by the section key, for instance by querying ordered
+ * by the child the key is derived from. This isn't checked: items with the same key
+ * that aren't adjacent form separate sections.
+ *
+ * Section boundaries and the number of items in each section are kept up to date as
+ * the wrapped collection changes, in O(log n) per event, including events that create,
+ * split, delete or merge sections. The events of each of the wrapped collection's
+ * batches are surfaced to the delegate as one @c FUISectionChangeset. Combining the
+ * events of a batch takes time proportional to the number of sections and to the
+ * number of items in the sections whose items change.
+ *
+ * The sectioned collection observes and invalidates the wrapped collection when it's
+ * itself observed and invalidated, so the wrapped collection shouldn't be observed
+ * separately. It registers itself with the wrapped collection using @c addDelegate:
+ * if available, and otherwise as its @c delegate.
+ *
+ * Sectioned collections aren't thread-safe and should be used from the main thread.
+ */
+@interface FUISectionedCollection : NSObject
+
+/**
+ * Creates a sectioned view of a collection.
+ * @param collection The collection to group into sections.
+ * @param sectionKey Returns the key of the section a snapshot belongs in. Must be
+ *   deterministic, since it's only evaluated again when a snapshot changes.
+ */
+- (instancetype)initWithCollection:(id<FUICollection>)collection
+                        sectionKey:(NSString *(^)(FIRDataSnapshot *snapshot))sectionKey
+    NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * The collection being grouped.
+ */
+@property (nonatomic, readonly) id<FUICollection> collection;
+
+/**
+ * The delegate object that changesets are surfaced to.
+ */
+@property (weak, nonatomic, nullable) id<FUISectionedCollectionDelegate> delegate;
+
+/**
+ * The number of sections.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfSections;
+
+/**
+ * The number of items in every section, in order.
+ */
+@property (nonatomic, readonly) NSArray<NSNumber *> *itemCountsBySection;
+
+/**
+ * Returns the number of items in a section. Throws an exception if the section is
+ * out of bounds.
+ */
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section;
+
+/**
+ * Returns the key shared by the items of a section. Throws an exception if the
+ * section is out of bounds.
+ */
+- (NSString *)keyForSection:(NSUInteger)section;
+
+/**
+ * Returns the snapshot at the given section and item. Throws an exception if the
+ * index path is out of bounds.
+ */
+- (FIRDataSnapshot *)snapshotAtIndexPath:(NSIndexPath *)indexPath;
+
+/**
+ * Returns the section and item of the wrapped collection's item at the given index,
+ * or nil if the index is out of bounds.
+ */
+- (nullable NSIndexPath *)indexPathForCollectionIndex:(NSUInteger)collectionIndex;
+
+/**
+ * Returns the index in the wrapped collection of the item at the given section and
+ * item, or NSNotFound if the index path is out of bounds.
+ */
+- (NSUInteger)collectionIndexForIndexPath:(NSIndexPath *)indexPath;
+
+/**
+ * Attaches to the wrapped collection and begins observing its query. If the wrapped
+ * collection already contains items, a changeset inserting their sections is sent
+ * first.
+ */
+- (void)observeQuery;
+
+/**
+ * Stops observing the wrapped collection's query. The wrapped collection's removals
+ * are surfaced as changesets, so the sectioned collection is empty afterward.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,120 @@
+// clang-format off
+
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// clang-format on
+
+#import <UIKit/UIKit.h>
+
+#import "FUISectionedCollection.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FIRDatabaseQuery;
+
+/**
+ * FUISectionedCollectionViewDataSource populates a UICollectionView with one section
+ * for each section of a @c FUISectionedCollection. The collection combines each
+ * batch of database events into one changeset, which is applied to the collection
+ * view in a single @c performBatchUpdates:completion:. The collection's items must be
+ * ordered by section key.
+ */
+@interface FUISectionedCollectionViewDataSource : NSObject <UICollectionViewDataSource>
+
+/**
+ * The UICollectionView instance that operations (inserts, removals, reloads, etc.)
+ * are performed against. This collection view must be receiving data from
+ * this data source otherwise data inconsistency crashes will occur.
+ */
+@property (nonatomic, readwrite, weak, nullable) UICollectionView *collectionView;
+
+/**
+ * The sectioned collection backing the data source.
+ */
+@property (nonatomic, readonly) FUISectionedCollection *sectionedCollection;
+
+/**
+ * A closure that should be invoked when the query encounters a fatal error.
+ * After this is invoked, the query is no longer valid and the data source should
+ * be recreated.
+ */
+@property (nonatomic, copy, readwrite) void (^queryErrorHandler)(NSError *);
+
+/**
+ * A closure used to create/reuse supplementary views, such as section headers, and
+ * populate their content. Must be set if the collection view's layout displays
+ * supplementary views.
+ */
+@property (nonatomic, copy, readwrite, nullable) UICollectionReusableView *(^populateSupplementaryView)
+    (UICollectionView *collectionView, NSString *kind, NSIndexPath *indexPath, NSString *sectionKey);
+
+/**
+ * Returns the snapshot at the given index path. Throws an exception if the index
+ * path is out of bounds.
+ */
+- (FIRDataSnapshot *)snapshotAtIndexPath:(NSIndexPath *)indexPath;
+
+/**
+ * Initialize an instance of FUISectionedCollectionViewDataSource.
+ * @param sectionedCollection The sectioned collection used by the data source to
+ *   pull data from Firebase Database.
+ * @param populateCell A closure used by the data source to create/reuse
+ *   collection view cells and populate their content. This closure is retained
+ *   by the data source, so if you capture self in the closure and also claim ownership
+ *   of the data source, be sure to avoid retain cycles by capturing a weak reference to self.
+ * @return An instance of FUISectionedCollectionViewDataSource.
+ */
+- (instancetype)initWithSectionedCollection:(FUISectionedCollection *)sectionedCollection
+                               populateCell:(UICollectionViewCell *(^)(UICollectionView *collectionView,
+                                                                       NSIndexPath *indexPath,
+                                                                       FIRDataSnapshot *object))populateCell
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Initialize an instance of FUISectionedCollectionViewDataSource with contents
+ * ordered by the query and grouped into sections by key.
+ * @param query A Firebase query to bind the data source to. It must be ordered so
+ *   that snapshots with the same section key are adjacent, or they're shown in
+ *   separate sections.
+ * @param sectionKey Returns the key of the section a snapshot belongs in.
+ * @param populateCell A closure used by the data source to create/reuse
+ *   collection view cells and populate their content.
+ * @return An instance of FUISectionedCollectionViewDataSource.
+ */
+- (instancetype)initWithQuery:(FIRDatabaseQuery *)query
+                   sectionKey:(NSString *(^)(FIRDataSnapshot *snapshot))sectionKey
+                 populateCell:(UICollectionViewCell *(^)(UICollectionView *collectionView,
+                                                         NSIndexPath *indexPath,
+                                                         FIRDataSnapshot *object))populateCell;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Attaches the data source to a collection view and begins sending updates immediately.
+ * @param view An instance of UICollectionView that the data source should push
+ *   updates to.
+ */
+- (void)bindToView:(UICollectionView *)view;
+
+/**
+ * Detaches the data source from a view and stops sending any updates.
+ */
+- (void)unbind;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -27,7 +27,19 @@ FOUNDATION_EXPORT const unsigned char FirebaseDatabaseUIVersionString[];
 #import "FUIIndexCollectionViewDataSource.h"
 #import "FUIArray.h"
 #import "FUISortedArray.h"
+#import "FUIKeyOrderedArray.h"
 #import "FUICollection.h"
+#import "FUICollectionVersion.h"
+#import "FUIFilteredCollection.h"
+#import "FUISearchIndex.h"
+#import "FUIMergedCollection.h"
+#import "FUISectionedCollection.h"
+#import "FUICollectionMetrics.h"
 #import "FUICollectionViewDataSource.h"
 #import "FUITableViewDataSource.h"
+#import "FUISectionedCollectionViewDataSource.h"
+#import "FUISectionedTableViewDataSource.h"
 #import "FUIQueryObserver.h"
+#import "FUIIndexJoinPlanner.h"
+#import "FUIDataTraceRecorder.h"
+#import "FUIDataTraceReplayer.h"
@@ -0,0 +1,234 @@
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+@import XCTest;
+
+#import "FUIBatchedArray.h"
+#import "FUIDocumentChange.h"
+
+@interface FUIBatchedArray (Testing)
+- (void)applySnapshot:(FIRQuerySnapshot *)snapshot error:(NSError *)error;
+@end
+
+@interface FUIBatchedArrayTestDelegate : NSObject <FUIBatchedArrayDelegate>
+@property (nonatomic, readwrite) FUISnapshotArrayDiff<FIRDocumentSnapshot *> *lastDiff;
+@end
+
+@implementation FUIBatchedArrayTestDelegate
+
+- (void)batchedArray:(FUIBatchedArray *)array
+    didUpdateWithDiff:(FUISnapshotArrayDiff<FIRDocumentSnapshot *> *)diff {
+  self.lastDiff = diff;
+}
+
+- (void)batchedArray:(FUIBatchedArray *)array queryDidFailWithError:(NSError *)error {}
+
+@end
+
+@interface FUIBatchedArrayTestMetricsSink : NSObject <FUIBatchedArrayMetricsSink>
+@property (nonatomic, readonly) NSMutableArray<FUIBatchedArrayMetrics *> *updates;
+@end
+
+@implementation FUIBatchedArrayTestMetricsSink
+
+- (instancetype)init {
+  self = [super init];
+  if (self != nil) {
+    _updates = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)batchedArray:(FUIBatchedArray *)array
+    didFinishUpdateWithMetrics:(FUIBatchedArrayMetrics *)metrics {
+  [self.updates addObject:metrics];
+}
+
+@end
+
+@interface FUIBatchedArrayTest : XCTestCase
+
+@property (nonatomic, readwrite) FUIBatchedArray *array;
+@property (nonatomic, readwrite) FUIBatchedArrayTestDelegate *delegate;
+
+@end
+
+@implementation FUIBatchedArrayTest
+
+- (void)setUp {
+  [super setUp];
+  self.delegate = [[FUIBatchedArrayTestDelegate alloc] init];
+  // The query is never observed, since snapshots are applied directly.
+  FIRQuery *query = (FIRQuery *)[[NSObject alloc] init];
+  self.array = [[FUIBatchedArray alloc] initWithQuery:query delegate:self.delegate];
+}
+
+- (void)tearDown {
+  self.array = nil;
+  self.delegate = nil;
+  [super tearDown];
+}
+
+- (NSArray *)documentsWithIDs:(NSArray<NSString *> *)identifiers {
+  NSMutableArray *documents = [NSMutableArray arrayWithCapacity:identifiers.count];
+  for (NSString *identifier in identifiers) {
+    [documents addObject:[FUIDocumentSnapshot documentWithID:identifier]];
+  }
+  return documents;
+}
+
+- (void)applyDocuments:(NSArray *)documents changes:(NSArray<FUIDocumentChange *> *)changes {
+  FUIQuerySnapshot *snapshot = [FUIQuerySnapshot snapshotWithDocuments:documents
+                                                       documentChanges:changes];
+  [self.array applySnapshot:(FIRQuerySnapshot *)snapshot error:nil];
+}
+
+- (void)applyInitialDocuments:(NSArray *)documents {
+  NSMutableArray *changes = [NSMutableArray arrayWithCapacity:documents.count];
+  for (NSUInteger i = 0; i < documents.count; i++) {
+    [changes addObject:[FUIDocumentChange changeWithType:FIRDocumentChangeTypeAdded
+                                                document:documents[i]
+                                                oldIndex:NSNotFound
+                                                newIndex:i]];
+  }
+  [self applyDocuments:documents changes:changes];
+}
+
+// Checks every document's index against a linear scan of the array.
+- (void)assertIndexMatchesContents {
+  for (NSInteger i = 0; i < self.array.count; i++) {
+    FIRDocumentSnapshot *document = self.array[i];
+    XCTAssertEqual([self.array indexOfDocumentID:document.documentID], i,
+                   @"expected %@ to be indexed at %ld", document.documentID, (long)i);
+    XCTAssertEqual([self.array documentWithID:document.documentID], document);
+  }
+}
+
+- (void)testEmptyArrayFindsNothing {
+  XCTAssertEqual([self.array indexOfDocumentID:@"a"], NSNotFound);
+  XCTAssertNil([self.array documentWithID:@"a"]);
+}
+
+- (void)testInitialInsertionsAreIndexed {
+  NSArray *documents = [self documentsWithIDs:@[@"a", @"b", @"c"]];
+  [self applyInitialDocuments:documents];
+
+  XCTAssertEqual([self.array indexOfDocumentID:@"c"], 2);
+  XCTAssertEqual([self.array documentWithID:@"b"], documents[1]);
+  XCTAssertEqual([self.array indexOfDocumentID:@"z"], NSNotFound);
+  [self assertIndexMatchesContents];
+}
+
+- (void)testRemovalShiftsLaterIndexes {
+  NSArray *documents = [self documentsWithIDs:@[@"a", @"b", @"c", @"d"]];
+  [self applyInitialDocuments:documents];
+
+  NSArray *result = @[documents[0], documents[2], documents[3]];
+  [self applyDocuments:result changes:@[
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeRemoved
+                             document:documents[1]
+                             oldIndex:1
+                             newIndex:NSNotFound],
+  ]];
+
+  XCTAssertEqual([self.array indexOfDocumentID:@"b"], NSNotFound,
+                 @"expected removed document to be dropped from the index");
+  XCTAssertEqual([self.array indexOfDocumentID:@"d"], 2);
+  [self assertIndexMatchesContents];
+  XCTAssertEqualObjects(self.delegate.lastDiff.deletedIndexes, @[@1]);
+}
+
+- (void)testMoveAndInPlaceChange {
+  NSArray *documents = [self documentsWithIDs:@[@"a", @"b", @"c", @"d", @"e"]];
+  [self applyInitialDocuments:documents];
+
+  // "a" changes in place while "e" moves to the middle.
+  NSArray *result = @[documents[0], documents[1], documents[4], documents[2], documents[3]];
+  [self applyDocuments:result changes:@[
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeModified
+                             document:documents[0]
+                             oldIndex:0
+                             newIndex:0],
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeModified
+                             document:documents[4]
+                             oldIndex:4
+                             newIndex:2],
+  ]];
+
+  [self assertIndexMatchesContents];
+  XCTAssertEqualObjects(self.delegate.lastDiff.changedIndexes, @[@0],
+                        @"expected in place change before the moved range to be reported");
+  XCTAssertEqualObjects(self.delegate.lastDiff.movedInitialIndexes, @[@4]);
+  XCTAssertEqualObjects(self.delegate.lastDiff.movedResultIndexes, @[@2]);
+}
+
+- (void)testChangesWithoutIndexesReindexEverything {
+  NSArray *documents = [self documentsWithIDs:@[@"a", @"b", @"c"]];
+  [self applyInitialDocuments:documents];
+
+  NSArray *result = @[[FUIDocumentSnapshot documentWithID:@"z"], documents[0], documents[2]];
+  [self applyDocuments:result changes:@[
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeRemoved document:documents[1]],
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeAdded document:result[0]],
+  ]];
+
+  XCTAssertEqual([self.array indexOfDocumentID:@"b"], NSNotFound);
+  [self assertIndexMatchesContents];
+}
+
+- (void)testErrorEmptiesIndex {
+  [self applyInitialDocuments:[self documentsWithIDs:@[@"a", @"b"]]];
+  NSError *error = [NSError errorWithDomain:@"FUIBatchedArrayTest" code:0 userInfo:nil];
+  [self.array applySnapshot:nil error:error];
+
+  XCTAssertEqual(self.array.count, 0);
+  XCTAssertEqual([self.array indexOfDocumentID:@"a"], NSNotFound);
+}
+
+- (void)testMetricsSinkReceivesEachUpdate {
+  FUIBatchedArrayTestMetricsSink *sink = [[FUIBatchedArrayTestMetricsSink alloc] init];
+  self.array.metricsSink = sink;
+  NSArray *documents = [self documentsWithIDs:@[@"a", @"b", @"c"]];
+  [self applyInitialDocuments:documents];
+
+  [self applyDocuments:@[documents[0], documents[2]] changes:@[
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeRemoved
+                             document:documents[1]
+                             oldIndex:1
+                             newIndex:NSNotFound],
+  ]];
+
+  XCTAssertEqual(sink.updates.count, 2);
+  FUIBatchedArrayMetrics *initial = sink.updates[0];
+  XCTAssertEqual(initial.changeCount, 3);
+  XCTAssertEqual([initial changeCountForType:FIRDocumentChangeTypeAdded], 3);
+  XCTAssertEqual(initial.itemCount, 3);
+  XCTAssertGreaterThan(initial.diffDuration, 0);
+  XCTAssertGreaterThanOrEqual(initial.duration,
+                              initial.diffDuration + initial.storageDuration + initial.delegateDuration);
+
+  FUIBatchedArrayMetrics *removal = sink.updates[1];
+  XCTAssertEqual([removal changeCountForType:FIRDocumentChangeTypeRemoved], 1);
+  XCTAssertEqual([removal changeCountForType:FIRDocumentChangeTypeAdded], 0);
+  XCTAssertEqual(removal.itemCount, 2);
+  XCTAssertEqual(removal.slowCallbackCount, 0);
+
+  self.array.metricsSink = nil;
+  [self applyDocuments:@[documents[0], documents[2]] changes:@[]];
+  XCTAssertEqual(sink.updates.count, 2);
+}
+
+@end
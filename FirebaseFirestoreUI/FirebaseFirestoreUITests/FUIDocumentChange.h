@@ -20,9 +20,17 @@
 
 @property (nonatomic, readwrite) FIRDocumentChangeType type;
 @property (nonatomic, readwrite) id document;
+@property (nonatomic, readwrite) NSUInteger oldIndex;
+@property (nonatomic, readwrite) NSUInteger newIndex;
 
+/// Creates a change whose oldIndex and newIndex are NSNotFound.
 + (instancetype)changeWithType:(FIRDocumentChangeType)type document:(id)document;
 
++ (instancetype)changeWithType:(FIRDocumentChangeType)type
+                      document:(id)document
+                      oldIndex:(NSUInteger)oldIndex
+                      newIndex:(NSUInteger)newIndex;
+
 @end
 
 @interface FUIDocumentSnapshot: NSObject
@@ -32,3 +40,13 @@
 + (instancetype)documentWithID:(NSString *)identifier;
 
 @end
+
+@interface FUIQuerySnapshot : NSObject
+
+@property (nonatomic, readwrite) NSArray *documents;
+@property (nonatomic, readwrite) NSArray<FUIDocumentChange *> *documentChanges;
+
++ (instancetype)snapshotWithDocuments:(NSArray *)documents
+                      documentChanges:(NSArray<FUIDocumentChange *> *)documentChanges;
+
+@end
@@ -20,9 +20,18 @@
 
 + (instancetype)changeWithType:(FIRDocumentChangeType)type
                       document:(id)document {
+  return [self changeWithType:type document:document oldIndex:NSNotFound newIndex:NSNotFound];
+}
+
++ (instancetype)changeWithType:(FIRDocumentChangeType)type
+                      document:(id)document
+                      oldIndex:(NSUInteger)oldIndex
+                      newIndex:(NSUInteger)newIndex {
   FUIDocumentChange *change = [[FUIDocumentChange alloc] init];
   change.type = type;
   change.document = document;
+  change.oldIndex = oldIndex;
+  change.newIndex = newIndex;
   return change;
 }
 
@@ -37,3 +46,15 @@
 }
 
 @end
+
+@implementation FUIQuerySnapshot
+
++ (instancetype)snapshotWithDocuments:(NSArray *)documents
+                      documentChanges:(NSArray<FUIDocumentChange *> *)documentChanges {
+  FUIQuerySnapshot *snapshot = [[FUIQuerySnapshot alloc] init];
+  snapshot.documents = documents;
+  snapshot.documentChanges = documentChanges;
+  return snapshot;
+}
+
+@end
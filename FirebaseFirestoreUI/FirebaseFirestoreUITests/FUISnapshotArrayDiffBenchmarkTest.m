@@ -0,0 +1,497 @@
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+@import XCTest;
+
+#import <mach/mach.h>
+
+#import "FUISnapshotArrayDiff.h"
+#import "FUIDocumentChange.h"
+
+// Measures how FUISnapshotArrayDiff scales, through both the LCS-based initializer and
+// the document changes initializer, on generated pairs of arrays. Skipped unless the
+// FUI_RUN_BENCHMARKS environment variable is set. When running through xcodebuild,
+// prefix each variable with TEST_RUNNER_ to pass it to the test process.
+//
+//   FUI_RUN_BENCHMARKS              Set to 1 to run the benchmarks.
+//   FUI_DIFF_BENCHMARK_SIZES        Comma separated array sizes. Defaults to
+//                                   10,100,1000,10000,100000.
+//   FUI_DIFF_BENCHMARK_TIME_LIMIT   Seconds a single diff may be projected to take
+//                                   before larger sizes are skipped. Defaults to 10.
+//   FUI_DIFF_BENCHMARK_MOVES        Number of moves in the k-random-moves pairs.
+//                                   Defaults to 10.
+//   FUI_BENCHMARK_ITERATIONS        Runs per pair; the median is attached to the test
+//                                   result. Defaults to 3.
+//   FUI_DIFF_BENCHMARK_REPORT       Path to write a JSON report of every result to.
+//
+// The report lists each measurement along with the growth exponent between
+// consecutive sizes (1 for linear, 2 for quadratic), so that algorithm changes can be
+// compared by their curves rather than by a single number.
+
+typedef NS_ENUM(NSInteger, FUIDiffBenchmarkGenerator) {
+  // A tenth of the elements are deleted and as many are inserted, at random positions.
+  FUIDiffBenchmarkGeneratorRandomInsertDelete,
+  // The array is rotated by a third of its length.
+  FUIDiffBenchmarkGeneratorRotation,
+  // The array is reversed.
+  FUIDiffBenchmarkGeneratorReversal,
+  // A fixed number of elements are moved to random positions.
+  FUIDiffBenchmarkGeneratorRandomMoves,
+  // Elements are drawn from a small alphabet, and a tenth of them are replaced.
+  // Documents are unique, so this only applies to the LCS-based initializer.
+  FUIDiffBenchmarkGeneratorDuplicates,
+};
+
+static NSString *FUIDiffBenchmarkGeneratorName(FUIDiffBenchmarkGenerator generator) {
+  switch (generator) {
+    case FUIDiffBenchmarkGeneratorRandomInsertDelete: return @"randomInsertDelete";
+    case FUIDiffBenchmarkGeneratorRotation: return @"rotation";
+    case FUIDiffBenchmarkGeneratorReversal: return @"reversal";
+    case FUIDiffBenchmarkGeneratorRandomMoves: return @"randomMoves";
+    case FUIDiffBenchmarkGeneratorDuplicates: return @"duplicates";
+  }
+}
+
+static NSString *FUIDiffBenchmarkEnvironment(NSString *name) {
+  NSString *value = NSProcessInfo.processInfo.environment[name];
+  return value.length > 0 ? value : nil;
+}
+
+// xorshift64*, so that pairs are identical across runs.
+static uint64_t FUIDiffBenchmarkRandom(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static NSUInteger FUIDiffBenchmarkRandomIndex(uint64_t *state, NSUInteger bound) {
+  return bound == 0 ? 0 : (NSUInteger)(FUIDiffBenchmarkRandom(state) % bound);
+}
+
+static uint64_t FUIDiffBenchmarkFootprint(void) {
+  task_vm_info_data_t info;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  kern_return_t result = task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count);
+  return result == KERN_SUCCESS ? info.phys_footprint : 0;
+}
+
+// The LCS recurses once per element, which overflows the default stacks on large
+// inputs, so diffs are computed on a thread with a stack this large.
+static const NSUInteger FUIDiffBenchmarkStackSize = 256 * 1024 * 1024;
+
+// How often the physical footprint is sampled while a diff is computed.
+static const uint64_t FUIDiffBenchmarkFootprintSampleInterval = NSEC_PER_MSEC;
+
+@interface FUIDiffBenchmarkPair : NSObject
+@property (nonatomic, copy) NSArray<NSString *> *initial;
+@property (nonatomic, copy) NSArray<NSString *> *result;
+@end
+
+@implementation FUIDiffBenchmarkPair
+@end
+
+@interface FUIDiffBenchmarkMeasurement : NSObject
+@property (nonatomic, assign) uint64_t nanoseconds;
+@property (nonatomic, assign) int64_t peakFootprintGrowth;
+// The number of deletions, insertions, moves and changes in the diff.
+@property (nonatomic, assign) NSUInteger operationCount;
+@end
+
+@implementation FUIDiffBenchmarkMeasurement
+@end
+
+@interface FUISnapshotArrayDiffBenchmarkTest : XCTestCase
+@property (nonatomic, strong) NSMutableArray<NSDictionary *> *results;
+@end
+
+@implementation FUISnapshotArrayDiffBenchmarkTest
+
+- (BOOL)setUpWithError:(NSError *__autoreleasing *)error {
+  XCTSkipUnless(FUIDiffBenchmarkEnvironment(@"FUI_RUN_BENCHMARKS") != nil,
+                @"Set FUI_RUN_BENCHMARKS=1 to run benchmarks");
+  self.results = [NSMutableArray array];
+  return YES;
+}
+
+- (void)testScalingCurves {
+  NSArray<NSNumber *> *generators = @[
+    @(FUIDiffBenchmarkGeneratorRandomInsertDelete),
+    @(FUIDiffBenchmarkGeneratorRotation),
+    @(FUIDiffBenchmarkGeneratorReversal),
+    @(FUIDiffBenchmarkGeneratorRandomMoves),
+    @(FUIDiffBenchmarkGeneratorDuplicates),
+  ];
+  for (NSNumber *generator in generators) {
+    [self measureCurveForGenerator:generator.integerValue documentChanges:NO];
+    if (generator.integerValue != FUIDiffBenchmarkGeneratorDuplicates) {
+      [self measureCurveForGenerator:generator.integerValue documentChanges:YES];
+    }
+  }
+
+  NSString *reportPath = FUIDiffBenchmarkEnvironment(@"FUI_DIFF_BENCHMARK_REPORT");
+  if (reportPath != nil) {
+    NSDictionary *report = @{
+      @"os": NSProcessInfo.processInfo.operatingSystemVersionString,
+      @"processorCount": @(NSProcessInfo.processInfo.activeProcessorCount),
+      @"results": self.results,
+    };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report
+                                                   options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                     error:NULL];
+    XCTAssertTrue([data writeToFile:reportPath atomically:YES],
+                  @"Failed to write benchmark report to %@", reportPath);
+  }
+}
+
+#pragma mark - Measuring
+
+- (NSArray<NSNumber *> *)sizes {
+  NSString *sizes = FUIDiffBenchmarkEnvironment(@"FUI_DIFF_BENCHMARK_SIZES") ?: @"10,100,1000,10000,100000";
+  NSMutableArray<NSNumber *> *result = [NSMutableArray array];
+  for (NSString *size in [sizes componentsSeparatedByString:@","]) {
+    NSInteger value = [size stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet].integerValue;
+    if (value > 0) {
+      [result addObject:@(value)];
+    }
+  }
+  return result;
+}
+
+- (void)measureCurveForGenerator:(FUIDiffBenchmarkGenerator)generator
+                 documentChanges:(BOOL)documentChanges {
+  NSString *path = documentChanges ? @"documentChanges" : @"initializer";
+  NSString *timeLimitString = FUIDiffBenchmarkEnvironment(@"FUI_DIFF_BENCHMARK_TIME_LIMIT");
+  double timeLimit = timeLimitString != nil ? timeLimitString.doubleValue : 10;
+  NSInteger iterations = FUIDiffBenchmarkEnvironment(@"FUI_BENCHMARK_ITERATIONS").integerValue;
+  if (iterations <= 0) { iterations = 3; }
+
+  NSUInteger previousSize = 0;
+  uint64_t previousNanoseconds = 0;
+  for (NSNumber *sizeNumber in [self sizes]) {
+    NSUInteger size = sizeNumber.unsignedIntegerValue;
+    NSMutableDictionary *entry = [@{
+      @"path": path,
+      @"generator": FUIDiffBenchmarkGeneratorName(generator),
+      @"size": @(size),
+    } mutableCopy];
+
+    // The LCS is at least quadratic, so a size that's projected to blow the time
+    // limit is skipped rather than left to run for hours.
+    if (previousSize > 0) {
+      double growth = (double)size / previousSize;
+      double projected = previousNanoseconds * growth * growth / NSEC_PER_SEC;
+      if (projected > timeLimit) {
+        entry[@"skipped"] = [NSString stringWithFormat:@"projected to take %.0f s", projected];
+        [self.results addObject:entry];
+        [self attachSummary:entry[@"skipped"] forEntry:entry];
+        continue;
+      }
+    }
+
+    FUIDiffBenchmarkPair *pair = [self pairWithGenerator:generator size:size];
+    NSMutableArray<FUIDiffBenchmarkMeasurement *> *measurements = [NSMutableArray array];
+    for (NSInteger i = 0; i < iterations; i++) {
+      [measurements addObject:[self measurePair:pair documentChanges:documentChanges]];
+    }
+    [measurements sortUsingComparator:^NSComparisonResult(FUIDiffBenchmarkMeasurement *left,
+                                                          FUIDiffBenchmarkMeasurement *right) {
+      return [@(left.nanoseconds) compare:@(right.nanoseconds)];
+    }];
+    FUIDiffBenchmarkMeasurement *median = measurements[measurements.count / 2];
+
+    entry[@"ns"] = @(median.nanoseconds);
+    entry[@"peakFootprintGrowthBytes"] = @(median.peakFootprintGrowth);
+    entry[@"operations"] = @(median.operationCount);
+    if (previousSize > 0 && previousNanoseconds > 0 && median.nanoseconds > 0) {
+      entry[@"growthExponent"] = @(log((double)median.nanoseconds / previousNanoseconds) /
+                                   log((double)size / previousSize));
+    }
+    [self.results addObject:entry];
+    if (![pair.initial isEqualToArray:pair.result]) {
+      XCTAssertGreaterThan(median.operationCount, 0, @"%@/%@/%lu: diff of different arrays is empty",
+                           path, FUIDiffBenchmarkGeneratorName(generator), (unsigned long)size);
+    }
+    NSString *summary =
+        [NSString stringWithFormat:@"%.3f ms, peak footprint +%lld bytes, %lu operations",
+                                   (double)median.nanoseconds / NSEC_PER_MSEC,
+                                   median.peakFootprintGrowth, (unsigned long)median.operationCount];
+    [self attachSummary:summary forEntry:entry];
+
+    previousSize = size;
+    previousNanoseconds = median.nanoseconds;
+  }
+}
+
+// Attaches a measurement to the test's result, where it's kept with the run, unlike
+// console output.
+- (void)attachSummary:(NSString *)summary forEntry:(NSDictionary *)entry {
+  NSString *name = [NSString stringWithFormat:@"%@/%@/%@", entry[@"path"], entry[@"generator"], entry[@"size"]];
+  [XCTContext runActivityNamed:name block:^(id<XCTActivity> activity) {
+    XCTAttachment *attachment = [XCTAttachment attachmentWithString:summary];
+    attachment.name = name;
+    attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+    [activity addAttachment:attachment];
+  }];
+}
+
+- (FUIDiffBenchmarkMeasurement *)measurePair:(FUIDiffBenchmarkPair *)pair
+                             documentChanges:(BOOL)useDocumentChanges {
+  // Snapshots and changes are built outside of the timed region, since Firestore
+  // hands them to the diff ready-made.
+  NSArray<FUIDocumentSnapshot *> *initialDocuments;
+  NSArray<FUIDocumentSnapshot *> *resultDocuments;
+  NSArray<FUIDocumentChange *> *documentChanges;
+  if (useDocumentChanges) {
+    initialDocuments = [self documentsWithIDs:pair.initial];
+    resultDocuments = [self documentsWithIDs:pair.result];
+    documentChanges = [self documentChangesFromInitial:initialDocuments result:resultDocuments];
+  }
+
+  __block FUISnapshotArrayDiff *diff;
+  __block uint64_t nanoseconds = 0;
+  dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+  NSThread *thread = [[NSThread alloc] initWithBlock:^{
+    @autoreleasepool {
+      uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+      if (useDocumentChanges) {
+        diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:(NSArray *)initialDocuments
+                                                      resultArray:(NSArray *)resultDocuments
+                                                  documentChanges:(NSArray *)documentChanges];
+      } else {
+        diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:pair.initial
+                                                      resultArray:pair.result];
+      }
+      nanoseconds = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+    }
+    dispatch_semaphore_signal(finished);
+  }];
+  thread.stackSize = FUIDiffBenchmarkStackSize;
+
+  // Sampled from another queue, since the diff is a single call.
+  dispatch_queue_t samplerQueue =
+      dispatch_queue_create("com.firebaseui.diffbenchmark.footprint", DISPATCH_QUEUE_SERIAL);
+  uint64_t footprintBefore = FUIDiffBenchmarkFootprint();
+  __block uint64_t footprintPeak = footprintBefore;
+  dispatch_source_t sampler = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, samplerQueue);
+  dispatch_source_set_timer(sampler, DISPATCH_TIME_NOW, FUIDiffBenchmarkFootprintSampleInterval, 0);
+  dispatch_source_set_event_handler(sampler, ^{
+    footprintPeak = MAX(footprintPeak, FUIDiffBenchmarkFootprint());
+  });
+  dispatch_resume(sampler);
+
+  [thread start];
+  dispatch_semaphore_wait(finished, DISPATCH_TIME_FOREVER);
+
+  dispatch_source_cancel(sampler);
+  dispatch_sync(samplerQueue, ^{
+    footprintPeak = MAX(footprintPeak, FUIDiffBenchmarkFootprint());
+  });
+
+  XCTAssertEqual((NSInteger)diff.insertedIndexes.count - (NSInteger)diff.deletedIndexes.count,
+                 (NSInteger)pair.result.count - (NSInteger)pair.initial.count,
+                 @"Diff doesn't account for the change in size");
+
+  FUIDiffBenchmarkMeasurement *measurement = [[FUIDiffBenchmarkMeasurement alloc] init];
+  measurement.nanoseconds = nanoseconds;
+  measurement.peakFootprintGrowth = (int64_t)footprintPeak - (int64_t)footprintBefore;
+  measurement.operationCount = diff.deletedIndexes.count + diff.insertedIndexes.count +
+      diff.movedInitialIndexes.count + diff.changedIndexes.count;
+  return measurement;
+}
+
+#pragma mark - Generators
+
+- (FUIDiffBenchmarkPair *)pairWithGenerator:(FUIDiffBenchmarkGenerator)generator size:(NSUInteger)size {
+  uint64_t seed = 0x9E3779B97F4A7C15ULL ^ size ^ ((uint64_t)generator << 32);
+  __block NSUInteger nextID = 0;
+  NSString *(^newID)(void) = ^NSString *{
+    return [NSString stringWithFormat:@"doc-%010lu", (unsigned long)nextID++];
+  };
+
+  NSMutableArray<NSString *> *initial = [NSMutableArray arrayWithCapacity:size];
+  if (generator == FUIDiffBenchmarkGeneratorDuplicates) {
+    NSUInteger alphabet = MAX(size / 10, 2);
+    for (NSUInteger i = 0; i < size; i++) {
+      [initial addObject:[NSString stringWithFormat:@"doc-%010lu",
+                          (unsigned long)FUIDiffBenchmarkRandomIndex(&seed, alphabet)]];
+    }
+  } else {
+    for (NSUInteger i = 0; i < size; i++) {
+      [initial addObject:newID()];
+    }
+  }
+
+  NSMutableArray<NSString *> *result = [initial mutableCopy];
+  NSUInteger tenth = MAX(size / 10, 1);
+  switch (generator) {
+    case FUIDiffBenchmarkGeneratorRandomInsertDelete:
+      for (NSUInteger i = 0; i < tenth && result.count > 0; i++) {
+        [result removeObjectAtIndex:FUIDiffBenchmarkRandomIndex(&seed, result.count)];
+      }
+      for (NSUInteger i = 0; i < tenth; i++) {
+        [result insertObject:newID() atIndex:FUIDiffBenchmarkRandomIndex(&seed, result.count + 1)];
+      }
+      break;
+    case FUIDiffBenchmarkGeneratorRotation: {
+      NSUInteger offset = size / 3;
+      NSArray<NSString *> *head = [initial subarrayWithRange:NSMakeRange(0, offset)];
+      [result removeObjectsInRange:NSMakeRange(0, offset)];
+      [result addObjectsFromArray:head];
+      break;
+    }
+    case FUIDiffBenchmarkGeneratorReversal:
+      result = [[[initial reverseObjectEnumerator] allObjects] mutableCopy];
+      break;
+    case FUIDiffBenchmarkGeneratorRandomMoves: {
+      NSInteger moves = FUIDiffBenchmarkEnvironment(@"FUI_DIFF_BENCHMARK_MOVES").integerValue;
+      if (moves <= 0) { moves = 10; }
+      for (NSInteger i = 0; i < moves && result.count > 1; i++) {
+        NSUInteger from = FUIDiffBenchmarkRandomIndex(&seed, result.count);
+        NSString *moved = result[from];
+        [result removeObjectAtIndex:from];
+        [result insertObject:moved atIndex:FUIDiffBenchmarkRandomIndex(&seed, result.count + 1)];
+      }
+      break;
+    }
+    case FUIDiffBenchmarkGeneratorDuplicates: {
+      NSUInteger alphabet = MAX(size / 10, 2);
+      for (NSUInteger i = 0; i < tenth && result.count > 0; i++) {
+        result[FUIDiffBenchmarkRandomIndex(&seed, result.count)] =
+            [NSString stringWithFormat:@"doc-%010lu",
+             (unsigned long)FUIDiffBenchmarkRandomIndex(&seed, alphabet)];
+      }
+      break;
+    }
+  }
+
+  FUIDiffBenchmarkPair *pair = [[FUIDiffBenchmarkPair alloc] init];
+  pair.initial = initial;
+  pair.result = result;
+  return pair;
+}
+
+- (NSArray<FUIDocumentSnapshot *> *)documentsWithIDs:(NSArray<NSString *> *)identifiers {
+  NSMutableArray<FUIDocumentSnapshot *> *documents = [NSMutableArray arrayWithCapacity:identifiers.count];
+  for (NSString *identifier in identifiers) {
+    [documents addObject:[FUIDocumentSnapshot documentWithID:identifier]];
+  }
+  return documents;
+}
+
+// The changes Firestore would report between two query results: removals, then
+// additions, then modifications. Documents only change position in a query when
+// their contents change, so Firestore reports a modification for each document that
+// moved relative to its neighbours, and nothing for documents that merely shifted
+// because others were added, removed or moved around them. The documents that kept
+// their relative order are a longest increasing run of old indexes in result order;
+// every other surviving document is reported as modified.
+//
+// The indexes are positions in the initial and result arrays rather than
+// Firestore's sequential ones. FUISnapshotArrayDiff recomputes them from the arrays.
+- (NSArray<FUIDocumentChange *> *)documentChangesFromInitial:(NSArray<FUIDocumentSnapshot *> *)initial
+                                                      result:(NSArray<FUIDocumentSnapshot *> *)result {
+  NSMutableDictionary<NSString *, NSNumber *> *initialIndexes =
+      [NSMutableDictionary dictionaryWithCapacity:initial.count];
+  for (NSUInteger i = 0; i < initial.count; i++) {
+    initialIndexes[initial[i].documentID] = @(i);
+  }
+  NSMutableDictionary<NSString *, NSNumber *> *resultIndexes =
+      [NSMutableDictionary dictionaryWithCapacity:result.count];
+  for (NSUInteger i = 0; i < result.count; i++) {
+    resultIndexes[result[i].documentID] = @(i);
+  }
+
+  NSMutableArray<FUIDocumentChange *> *changes = [NSMutableArray array];
+  for (NSUInteger i = 0; i < initial.count; i++) {
+    if (resultIndexes[initial[i].documentID] == nil) {
+      [changes addObject:[FUIDocumentChange changeWithType:FIRDocumentChangeTypeRemoved
+                                                  document:initial[i]
+                                                  oldIndex:i
+                                                  newIndex:NSNotFound]];
+    }
+  }
+  for (NSUInteger i = 0; i < result.count; i++) {
+    if (initialIndexes[result[i].documentID] == nil) {
+      [changes addObject:[FUIDocumentChange changeWithType:FIRDocumentChangeTypeAdded
+                                                  document:result[i]
+                                                  oldIndex:NSNotFound
+                                                  newIndex:i]];
+    }
+  }
+
+  // The surviving documents' result and old indexes, in result order.
+  NSMutableData *survivorData = [NSMutableData dataWithLength:result.count * sizeof(NSUInteger)];
+  NSMutableData *oldIndexData = [NSMutableData dataWithLength:result.count * sizeof(NSUInteger)];
+  NSUInteger *survivors = survivorData.mutableBytes;
+  NSUInteger *oldIndexes = oldIndexData.mutableBytes;
+  NSUInteger survivorCount = 0;
+  for (NSUInteger i = 0; i < result.count; i++) {
+    NSNumber *oldIndex = initialIndexes[result[i].documentID];
+    if (oldIndex != nil) {
+      survivors[survivorCount] = i;
+      oldIndexes[survivorCount] = oldIndex.unsignedIntegerValue;
+      survivorCount++;
+    }
+  }
+  NSIndexSet *unmoved = [self longestIncreasingRunOfIndexes:oldIndexes count:survivorCount];
+  for (NSUInteger i = 0; i < survivorCount; i++) {
+    if ([unmoved containsIndex:i]) { continue; }
+    [changes addObject:[FUIDocumentChange changeWithType:FIRDocumentChangeTypeModified
+                                                document:result[survivors[i]]
+                                                oldIndex:oldIndexes[i]
+                                                newIndex:survivors[i]]];
+  }
+  return changes;
+}
+
+// Returns the positions of a longest strictly increasing subsequence of values, found
+// by patience sorting in O(n log n).
+- (NSIndexSet *)longestIncreasingRunOfIndexes:(const NSUInteger *)values count:(NSUInteger)count {
+  NSMutableData *tailData = [NSMutableData dataWithLength:count * sizeof(NSUInteger)];
+  NSMutableData *previousData = [NSMutableData dataWithLength:count * sizeof(NSUInteger)];
+  // tails[k] is the position of the smallest value ending an increasing run of k + 1.
+  NSUInteger *tails = tailData.mutableBytes;
+  NSUInteger *previous = previousData.mutableBytes;
+  NSUInteger length = 0;
+  for (NSUInteger i = 0; i < count; i++) {
+    NSUInteger low = 0;
+    NSUInteger high = length;
+    while (low < high) {
+      NSUInteger middle = low + (high - low) / 2;
+      if (values[tails[middle]] < values[i]) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    previous[i] = low > 0 ? tails[low - 1] : NSNotFound;
+    tails[low] = i;
+    if (low == length) {
+      length++;
+    }
+  }
+
+  NSMutableIndexSet *run = [NSMutableIndexSet indexSet];
+  NSUInteger position = length > 0 ? tails[length - 1] : NSNotFound;
+  while (position != NSNotFound) {
+    [run addIndex:position];
+    position = previous[position];
+  }
+  return run;
+}
+
+@end
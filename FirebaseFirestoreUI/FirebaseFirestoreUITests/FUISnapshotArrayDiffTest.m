@@ -405,4 +405,48 @@
                         expectedChanges, diff.changedObjects);
 }
 
+- (void)testPartialIndexesProduceSameDiff {
+  NSArray *initial = @[
+    [FUIDocumentSnapshot documentWithID:@"a"],
+    [FUIDocumentSnapshot documentWithID:@"b"],
+    [FUIDocumentSnapshot documentWithID:@"c"],
+    [FUIDocumentSnapshot documentWithID:@"d"],
+    [FUIDocumentSnapshot documentWithID:@"e"],
+  ];
+  NSArray *result = @[
+    initial[0],
+    initial[1],
+    initial[3],
+    [FUIDocumentSnapshot documentWithID:@"f"],
+    initial[4],
+  ];
+  NSArray *changes = @[
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeModified document:initial[0]],
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeRemoved document:initial[2]],
+    [FUIDocumentChange changeWithType:FIRDocumentChangeTypeAdded document:result[3]],
+  ];
+
+  FUISnapshotArrayDiff *expected = [[FUISnapshotArrayDiff alloc] initWithInitialArray:initial
+                                                                          resultArray:result
+                                                                      documentChanges:changes];
+
+  // Only the changed documents need to be indexed.
+  NSDictionary *initialIndexes = @{ @"a": @0, @"c": @2 };
+  NSDictionary *resultIndexes = @{ @"a": @0, @"f": @3 };
+  FUISnapshotArrayDiff *diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:initial
+                                                                      resultArray:result
+                                                                  documentChanges:changes
+                                                                   initialIndexes:initialIndexes
+                                                                    resultIndexes:resultIndexes];
+
+  XCTAssertEqualObjects(diff.deletedIndexes, expected.deletedIndexes);
+  XCTAssertEqualObjects(diff.insertedIndexes, expected.insertedIndexes);
+  XCTAssertEqualObjects(diff.changedIndexes, expected.changedIndexes);
+  XCTAssertEqualObjects(diff.movedInitialIndexes, expected.movedInitialIndexes);
+  XCTAssertEqualObjects(diff.movedResultIndexes, expected.movedResultIndexes);
+  XCTAssertEqualObjects(diff.deletedIndexes, @[@2]);
+  XCTAssertEqualObjects(diff.insertedIndexes, @[@3]);
+  XCTAssertEqualObjects(diff.changedIndexes, @[@0]);
+}
+
 @end
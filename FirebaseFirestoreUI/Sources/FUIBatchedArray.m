@@ -15,6 +15,72 @@
 //
 
 #import "FirebaseFirestoreUI/Sources/Public/FirebaseFirestoreUI/FUIBatchedArray.h"
+#import "FirebaseFirestoreUI/Sources/FUIBatchedArrayMetrics_Private.h"
+
+/// The FUIBatchedArrayDelegate methods a delegate implements, looked up once when
+/// the delegate is registered instead of on every update.
+typedef NS_OPTIONS(NSUInteger, FUIBatchedArrayDelegateCapabilities) {
+  FUIBatchedArrayDelegateCapabilityWillUpdate = 1 << 0,
+  FUIBatchedArrayDelegateCapabilityDidUpdate  = 1 << 1,
+  FUIBatchedArrayDelegateCapabilityFail       = 1 << 2,
+};
+
+@interface FUIBatchedArrayDelegateEntry : NSObject
+
+@property (nonatomic, readonly, weak) id<FUIBatchedArrayDelegate> delegate;
+@property (nonatomic, readonly) FUIBatchedArrayDelegateCapabilities capabilities;
+
+- (instancetype)initWithDelegate:(id<FUIBatchedArrayDelegate>)delegate;
+
+@end
+
+@implementation FUIBatchedArrayDelegateEntry
+
+- (instancetype)initWithDelegate:(id<FUIBatchedArrayDelegate>)delegate {
+  self = [super init];
+  if (self != nil) {
+    _delegate = delegate;
+    if ([delegate respondsToSelector:@selector(batchedArray:willUpdateWithDiff:)]) {
+      _capabilities |= FUIBatchedArrayDelegateCapabilityWillUpdate;
+    }
+    if ([delegate respondsToSelector:@selector(batchedArray:didUpdateWithDiff:)]) {
+      _capabilities |= FUIBatchedArrayDelegateCapabilityDidUpdate;
+    }
+    if ([delegate respondsToSelector:@selector(batchedArray:queryDidFailWithError:)]) {
+      _capabilities |= FUIBatchedArrayDelegateCapabilityFail;
+    }
+  }
+  return self;
+}
+
+@end
+
+// Returns the lowest index at which applying the changes in order could have
+// modified the array. Every position before it holds the same document before and
+// after the changes.
+static NSUInteger FUIFirstAffectedIndex(NSArray<FIRDocumentChange *> *changes) {
+  NSUInteger first = NSUIntegerMax;
+  for (FIRDocumentChange *change in changes) {
+    NSUInteger index;
+    switch (change.type) {
+      case FIRDocumentChangeTypeAdded:
+        index = change.newIndex;
+        break;
+      case FIRDocumentChangeTypeRemoved:
+        index = change.oldIndex;
+        break;
+      case FIRDocumentChangeTypeModified:
+        // Changes in place don't affect any document's index.
+        if (change.oldIndex == change.newIndex) { continue; }
+        index = MIN(change.oldIndex, change.newIndex);
+        break;
+    }
+    // Without usable indexes, everything has to be reindexed.
+    if (index == NSNotFound) { return 0; }
+    first = MIN(first, index);
+  }
+  return first;
+}
 
 @interface FUIBatchedArray ()
 
@@ -27,6 +93,16 @@
 /// so we need to keep track of it somehow.
 @property (nonatomic, readwrite) BOOL isInSync;
 
+/// Maps the ID of each document in items to its index.
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSNumber *> *documentIndexes;
+
+/// The primary delegate's entry, if any. Also the first element of delegateEntries.
+@property (nonatomic, readwrite, nullable) FUIBatchedArrayDelegateEntry *primaryDelegateEntry;
+
+/// The primary delegate followed by all additional delegates. This array is never
+/// mutated in place, so delegates may be added or removed while an update is sent.
+@property (nonatomic, readwrite, copy) NSArray<FUIBatchedArrayDelegateEntry *> *delegateEntries;
+
 @end
 
 @implementation FUIBatchedArray
@@ -34,9 +110,12 @@
 - (instancetype)initWithQuery:(FIRQuery *)query delegate:(id<FUIBatchedArrayDelegate>)delegate {
   self = [super init];
   if (self != nil) {
-    _delegate = delegate;
+    _delegateEntries = @[];
     _query = query;
     _items = @[];
+    _documentIndexes = [NSMutableDictionary dictionary];
+    _slowCallbackThreshold = 1.0 / 60.0;
+    self.delegate = delegate;
 
     // Firestore sends initial data as insertions, so this can be YES on init.
     _isInSync = YES;
@@ -50,38 +129,111 @@
   __weak typeof(self) weakSelf = self;
 
   self.observer = [self.query addSnapshotListener:^(FIRQuerySnapshot *snapshot, NSError *error) {
-    __strong typeof(weakSelf) sself = weakSelf;
-    if (sself == nil) { return; }
-    if (error != nil) {
-      NSLog(@"Firestore error: %@", error);
+    [weakSelf applySnapshot:snapshot error:error];
+  }];
+}
 
-      if ([sself.delegate respondsToSelector:@selector(batchedArray:queryDidFailWithError:)]) {
-        [sself.delegate batchedArray:sself queryDidFailWithError:error];
-      }
-    }
+- (void)applySnapshot:(FIRQuerySnapshot *)snapshot error:(NSError *)error {
+  id<FUIBatchedArrayMetricsSink> metricsSink = self.metricsSink;
+  FUIBatchedArrayMetrics *metrics = metricsSink != nil
+      ? [[FUIBatchedArrayMetrics alloc] initWithSlowCallbackThreshold:self.slowCallbackThreshold]
+      : nil;
 
-    FUISnapshotArrayDiff *diff;
+  if (error != nil) {
+    NSLog(@"Firestore error: %@", error);
 
-    if (sself.isInSync) {
-      diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:sself.items
-                                                    resultArray:snapshot.documents
-                                                documentChanges:snapshot.documentChanges];
-    } else {
-      diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:sself.items
-                                                    resultArray:snapshot.documents];
+    for (FUIBatchedArrayDelegateEntry *entry in self.delegateEntries) {
+      if ((entry.capabilities & FUIBatchedArrayDelegateCapabilityFail) == 0) { continue; }
+      uint64_t callback = [metrics mark];
+      [entry.delegate batchedArray:self queryDidFailWithError:error];
+      [metrics endCallback:callback];
     }
+  }
 
-    if ([sself.delegate respondsToSelector:@selector(batchedArray:willUpdateWithDiff:)]) {
-      [sself.delegate batchedArray:sself willUpdateWithDiff:diff];
+  uint64_t mark = [metrics mark];
+  NSArray<FIRDocumentSnapshot *> *initial = self.items;
+  NSArray<FIRDocumentSnapshot *> *result = snapshot.documents ?: @[];
+  NSArray<FIRDocumentChange *> *changes = snapshot.documentChanges;
+  [metrics countChanges:changes];
+
+  FUISnapshotArrayDiff *diff;
+  NSUInteger firstAffectedIndex = 0;
+  NSDictionary<NSString *, NSNumber *> *resultIndexes = nil;
+
+  if (self.isInSync) {
+    // Only documents at or after the first affected index can have moved, so only
+    // that part of the result needs to be indexed; the rest of the index is reused.
+    firstAffectedIndex = MIN(FUIFirstAffectedIndex(changes), MIN(initial.count, result.count));
+    resultIndexes = [self indexesOfDocuments:result fromIndex:firstAffectedIndex];
+
+    NSMutableDictionary<NSString *, NSNumber *> *changedIndexes =
+        [NSMutableDictionary dictionaryWithDictionary:resultIndexes];
+    for (FIRDocumentChange *change in changes) {
+      NSString *documentID = change.document.documentID;
+      NSNumber *index = self.documentIndexes[documentID];
+      if (changedIndexes[documentID] == nil && index.unsignedIntegerValue < firstAffectedIndex) {
+        changedIndexes[documentID] = index;
+      }
     }
+    diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:initial
+                                                  resultArray:result
+                                              documentChanges:changes
+                                               initialIndexes:self.documentIndexes
+                                                resultIndexes:changedIndexes];
+  } else {
+    diff = [[FUISnapshotArrayDiff alloc] initWithInitialArray:initial
+                                                  resultArray:result];
+  }
+  [metrics addDiffTimeSince:mark];
+
+  NSArray<FUIBatchedArrayDelegateEntry *> *entries = self.delegateEntries;
+  for (FUIBatchedArrayDelegateEntry *entry in entries) {
+    if ((entry.capabilities & FUIBatchedArrayDelegateCapabilityWillUpdate) == 0) { continue; }
+    uint64_t callback = [metrics mark];
+    [entry.delegate batchedArray:self willUpdateWithDiff:diff];
+    [metrics endCallback:callback];
+  }
 
-    sself.items = snapshot.documents;
-    sself.isInSync = YES;
-
-    if ([sself.delegate respondsToSelector:@selector(batchedArray:didUpdateWithDiff:)]) {
-      [sself.delegate batchedArray:sself didUpdateWithDiff:diff];
+  mark = [metrics mark];
+  self.items = snapshot.documents;
+  if (resultIndexes != nil) {
+    for (NSUInteger i = firstAffectedIndex; i < initial.count; i++) {
+      [self.documentIndexes removeObjectForKey:initial[i].documentID];
     }
-  }];
+    [self.documentIndexes addEntriesFromDictionary:resultIndexes];
+  }
+  // Rebuild the index if the query changed, or if the document changes didn't
+  // describe the new snapshot.
+  if (resultIndexes == nil || self.documentIndexes.count != result.count) {
+    [self.documentIndexes removeAllObjects];
+    [self.documentIndexes addEntriesFromDictionary:[self indexesOfDocuments:result fromIndex:0]];
+  }
+  self.isInSync = YES;
+  [metrics addStorageTimeSince:mark];
+
+  // Delegates registered in willUpdateWithDiff: didn't see the old contents,
+  // so they shouldn't be sent the matching didUpdateWithDiff: either.
+  for (FUIBatchedArrayDelegateEntry *entry in entries) {
+    if ((entry.capabilities & FUIBatchedArrayDelegateCapabilityDidUpdate) == 0) { continue; }
+    uint64_t callback = [metrics mark];
+    [entry.delegate batchedArray:self didUpdateWithDiff:diff];
+    [metrics endCallback:callback];
+  }
+
+  if (metrics != nil) {
+    [metrics finishWithItemCount:self.items.count];
+    [metricsSink batchedArray:self didFinishUpdateWithMetrics:metrics];
+  }
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)indexesOfDocuments:(NSArray<FIRDocumentSnapshot *> *)documents
+                                                   fromIndex:(NSUInteger)start {
+  NSMutableDictionary<NSString *, NSNumber *> *indexes =
+      [NSMutableDictionary dictionaryWithCapacity:documents.count - MIN(start, documents.count)];
+  for (NSUInteger i = start; i < documents.count; i++) {
+    indexes[documents[i].documentID] = @(i);
+  }
+  return indexes;
 }
 
 - (void)stopObserving {
@@ -101,10 +253,69 @@
   }
 }
 
+- (id<FUIBatchedArrayDelegate>)delegate {
+  return self.primaryDelegateEntry.delegate;
+}
+
+- (void)setDelegate:(id<FUIBatchedArrayDelegate>)delegate {
+  NSMutableArray<FUIBatchedArrayDelegateEntry *> *entries = [NSMutableArray array];
+  FUIBatchedArrayDelegateEntry *oldPrimary = self.primaryDelegateEntry;
+  self.primaryDelegateEntry = delegate != nil
+      ? [[FUIBatchedArrayDelegateEntry alloc] initWithDelegate:delegate]
+      : nil;
+  if (self.primaryDelegateEntry != nil) {
+    [entries addObject:self.primaryDelegateEntry];
+  }
+  for (FUIBatchedArrayDelegateEntry *entry in self.delegateEntries) {
+    id<FUIBatchedArrayDelegate> existing = entry.delegate;
+    if (entry == oldPrimary || existing == nil || existing == delegate) { continue; }
+    [entries addObject:entry];
+  }
+  self.delegateEntries = entries;
+}
+
+- (void)addDelegate:(id<FUIBatchedArrayDelegate>)delegate {
+  NSParameterAssert(delegate != nil);
+  NSMutableArray<FUIBatchedArrayDelegateEntry *> *entries = [NSMutableArray array];
+  for (FUIBatchedArrayDelegateEntry *entry in self.delegateEntries) {
+    id<FUIBatchedArrayDelegate> existing = entry.delegate;
+    if (existing == delegate) { return; }
+    if (existing == nil && entry != self.primaryDelegateEntry) { continue; }
+    [entries addObject:entry];
+  }
+  [entries addObject:[[FUIBatchedArrayDelegateEntry alloc] initWithDelegate:delegate]];
+  self.delegateEntries = entries;
+}
+
+- (void)removeDelegate:(id<FUIBatchedArrayDelegate>)delegate {
+  NSParameterAssert(delegate != nil);
+  NSMutableArray<FUIBatchedArrayDelegateEntry *> *entries = [NSMutableArray array];
+  for (FUIBatchedArrayDelegateEntry *entry in self.delegateEntries) {
+    if (entry == self.primaryDelegateEntry) {
+      [entries addObject:entry];
+      continue;
+    }
+    id<FUIBatchedArrayDelegate> existing = entry.delegate;
+    if (existing == nil || existing == delegate) { continue; }
+    [entries addObject:entry];
+  }
+  self.delegateEntries = entries;
+}
+
 - (NSInteger)count {
   return self.items.count;
 }
 
+- (NSInteger)indexOfDocumentID:(NSString *)documentID {
+  NSNumber *index = self.documentIndexes[documentID];
+  return index != nil ? index.integerValue : NSNotFound;
+}
+
+- (FIRDocumentSnapshot *)documentWithID:(NSString *)documentID {
+  NSNumber *index = self.documentIndexes[documentID];
+  return index != nil ? self.items[index.integerValue] : nil;
+}
+
 - (FIRDocumentSnapshot *)objectAtIndex:(NSInteger)index {
   return self.items[index];
 }
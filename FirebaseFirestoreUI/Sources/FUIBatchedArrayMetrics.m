@@ -0,0 +1,118 @@
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "FirebaseFirestoreUI/Sources/FUIBatchedArrayMetrics_Private.h"
+
+#import <time.h>
+
+static inline uint64_t FUIBatchedArrayMetricsNow(void) {
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static inline NSTimeInterval FUIBatchedArrayMetricsSeconds(uint64_t nanoseconds) {
+  return (NSTimeInterval)nanoseconds / NSEC_PER_SEC;
+}
+
+// Added, modified and removed.
+enum { FUIBatchedArrayMetricsChangeTypeCount = FIRDocumentChangeTypeRemoved + 1 };
+
+@implementation FUIBatchedArrayMetrics {
+  uint64_t _start;
+  uint64_t _diffTime;
+  uint64_t _storageTime;
+  uint64_t _callbackTime;
+  NSTimeInterval _slowCallbackThreshold;
+  NSUInteger _changeCounts[FUIBatchedArrayMetricsChangeTypeCount];
+}
+
+- (instancetype)initWithSlowCallbackThreshold:(NSTimeInterval)slowCallbackThreshold {
+  self = [super init];
+  if (self != nil) {
+    _slowCallbackThreshold = slowCallbackThreshold;
+    _start = FUIBatchedArrayMetricsNow();
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Metrics are created by batched arrays."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (uint64_t)mark {
+  return FUIBatchedArrayMetricsNow();
+}
+
+- (void)addDiffTimeSince:(uint64_t)mark {
+  _diffTime += FUIBatchedArrayMetricsNow() - mark;
+}
+
+- (void)addStorageTimeSince:(uint64_t)mark {
+  _storageTime += FUIBatchedArrayMetricsNow() - mark;
+}
+
+- (void)endCallback:(uint64_t)mark {
+  uint64_t elapsed = FUIBatchedArrayMetricsNow() - mark;
+  _callbackTime += elapsed;
+  NSTimeInterval duration = FUIBatchedArrayMetricsSeconds(elapsed);
+  _longestCallbackDuration = MAX(_longestCallbackDuration, duration);
+  if (duration > _slowCallbackThreshold) {
+    _slowCallbackCount++;
+  }
+}
+
+- (void)countChanges:(NSArray<FIRDocumentChange *> *)changes {
+  for (FIRDocumentChange *change in changes) {
+    if ((NSUInteger)change.type < FUIBatchedArrayMetricsChangeTypeCount) {
+      _changeCounts[change.type]++;
+    }
+  }
+}
+
+- (void)finishWithItemCount:(NSUInteger)itemCount {
+  _itemCount = itemCount;
+  _startTime = FUIBatchedArrayMetricsSeconds(_start);
+  _duration = FUIBatchedArrayMetricsSeconds(FUIBatchedArrayMetricsNow() - _start);
+  _diffDuration = FUIBatchedArrayMetricsSeconds(_diffTime);
+  _storageDuration = FUIBatchedArrayMetricsSeconds(_storageTime);
+  _delegateDuration = FUIBatchedArrayMetricsSeconds(_callbackTime);
+}
+
+- (NSUInteger)changeCount {
+  NSUInteger count = 0;
+  for (NSUInteger i = 0; i < FUIBatchedArrayMetricsChangeTypeCount; i++) {
+    count += _changeCounts[i];
+  }
+  return count;
+}
+
+- (NSUInteger)changeCountForType:(FIRDocumentChangeType)type {
+  if ((NSUInteger)type >= FUIBatchedArrayMetricsChangeTypeCount) { return 0; }
+  return _changeCounts[type];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, changes: %lu, items: %lu, diff: %.3fms, "
+                                    @"storage: %.3fms, delegates: %.3fms, slow callbacks: %lu>",
+      NSStringFromClass([self class]), self, (unsigned long)self.changeCount,
+      (unsigned long)_itemCount, _diffDuration * 1000, _storageDuration * 1000,
+      _delegateDuration * 1000, (unsigned long)_slowCallbackCount];
+}
+
+@end
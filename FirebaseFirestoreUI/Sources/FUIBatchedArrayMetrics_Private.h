@@ -0,0 +1,39 @@
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "FirebaseFirestoreUI/Sources/Public/FirebaseFirestoreUI/FUIBatchedArrayMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// The methods used to fill in metrics. Arrays message a nil metrics object when
+/// they have no sink, which turns every measurement into a no-op.
+@interface FUIBatchedArrayMetrics ()
+
+- (instancetype)initWithSlowCallbackThreshold:(NSTimeInterval)slowCallbackThreshold;
+
+/// Returns the current time, to pass to the methods below.
+- (uint64_t)mark;
+
+- (void)addDiffTimeSince:(uint64_t)mark;
+- (void)addStorageTimeSince:(uint64_t)mark;
+- (void)endCallback:(uint64_t)mark;
+
+- (void)countChanges:(NSArray<FIRDocumentChange *> *)changes;
+- (void)finishWithItemCount:(NSUInteger)itemCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -368,28 +368,45 @@ FUIUnorderedPair *FUIUnorderedPairMake(id left, id right) {
   if (self != nil) {
     _initial = [initial copy];
     _result = [result copy];
-    [self buildDiffsFromDocumentChanges:documentChanges];
+
+    NSMutableDictionary<NSString *, NSNumber *> *oldIndexes =
+        [NSMutableDictionary dictionaryWithCapacity:_initial.count];
+    NSMutableDictionary<NSString *, NSNumber *> *newIndexes =
+        [NSMutableDictionary dictionaryWithCapacity:_result.count];
+
+    // Ignore the FIRDocumentChange indexing, since we do our own
+    for (NSInteger i = 0; i < initial.count; i++) {
+      oldIndexes[initial[i].documentID] = @(i);
+    }
+    for (NSInteger i = 0; i < result.count; i++) {
+      newIndexes[result[i].documentID] = @(i);
+    }
+    [self buildDiffsFromDocumentChanges:documentChanges
+                             oldIndexes:oldIndexes
+                             newIndexes:newIndexes];
   }
   return self;
 }
 
-- (void)buildDiffsFromDocumentChanges:(NSArray<FIRDocumentChange *> *)documentChanges {
-  NSMutableDictionary<NSString *, NSNumber *> *oldIndexes =
-      [NSMutableDictionary dictionaryWithCapacity:_initial.count];
-  NSMutableDictionary<NSString *, NSNumber *> *newIndexes =
-      [NSMutableDictionary dictionaryWithCapacity:_result.count];
-
-  NSArray<FIRDocumentSnapshot *> *initial = _initial;
-  NSArray<FIRDocumentSnapshot *> *result = _result;
-
-  // Ignore the FIRDocumentChange indexing, since we do our own
-  for (NSInteger i = 0; i < _initial.count; i++) {
-    oldIndexes[initial[i].documentID] = @(i);
-  }
-  for (NSInteger i = 0; i < _result.count; i++) {
-    newIndexes[result[i].documentID] = @(i);
+- (instancetype)initWithInitialArray:(NSArray<FIRDocumentSnapshot *> *)initial
+                         resultArray:(NSArray<FIRDocumentSnapshot *> *)result
+                     documentChanges:(NSArray<FIRDocumentChange *> *)documentChanges
+                      initialIndexes:(NSDictionary<NSString *, NSNumber *> *)initialIndexes
+                       resultIndexes:(NSDictionary<NSString *, NSNumber *> *)resultIndexes {
+  self = [super init];
+  if (self != nil) {
+    _initial = [initial copy];
+    _result = [result copy];
+    [self buildDiffsFromDocumentChanges:documentChanges
+                             oldIndexes:initialIndexes
+                             newIndexes:resultIndexes];
   }
+  return self;
+}
 
+- (void)buildDiffsFromDocumentChanges:(NSArray<FIRDocumentChange *> *)documentChanges
+                           oldIndexes:(NSDictionary<NSString *, NSNumber *> *)oldIndexes
+                           newIndexes:(NSDictionary<NSString *, NSNumber *> *)newIndexes {
   NSMutableArray<NSNumber *> *deletedIndexes = [NSMutableArray array];
   NSMutableArray *deletedObjects = [NSMutableArray array];
 
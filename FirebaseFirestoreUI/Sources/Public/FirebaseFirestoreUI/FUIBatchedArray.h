@@ -16,6 +16,7 @@
 
 #import <FirebaseFirestore/FirebaseFirestore.h>
 
+#import "FUIBatchedArrayMetrics.h"
 #import "FUISnapshotArrayDiff.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -60,6 +61,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, readwrite, weak) id<FUIBatchedArrayDelegate> delegate;
 
+/**
+ * Receives measurements of each update: the number of document changes, and how
+ * long the array spent diffing, updating its contents, and in delegate callbacks.
+ * The array only takes measurements while it has a sink. Held weakly.
+ */
+@property (nonatomic, readwrite, weak, nullable) id<FUIBatchedArrayMetricsSink> metricsSink;
+
+/**
+ * Delegate callbacks that take longer than this many seconds are counted as slow in
+ * the metrics sent to @c metricsSink. Defaults to one frame at 60Hz.
+ */
+@property (nonatomic, readwrite, assign) NSTimeInterval slowCallbackThreshold;
+
 /**
  * The number of items in the array.
  */
@@ -78,6 +92,18 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)init NS_UNAVAILABLE;
 
+/**
+ * Registers an additional delegate that receives every event after the @c delegate
+ * property does. Additional delegates are held weakly and share the array's single
+ * snapshot listener. Adding the same delegate twice has no effect.
+ */
+- (void)addDelegate:(id<FUIBatchedArrayDelegate>)delegate;
+
+/**
+ * Unregisters a delegate previously added with @c addDelegate:.
+ */
+- (void)removeDelegate:(id<FUIBatchedArrayDelegate>)delegate;
+
 /**
  * Retrieves the snapshot at a given index. Raises an out of bounds error if the index is
  * out of bounds.
@@ -89,6 +115,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FIRDocumentSnapshot *)objectAtIndexedSubscript:(NSInteger)index;
 
+/**
+ * Returns the index of the document with the given ID, or NSNotFound if the array
+ * doesn't contain it. The array keeps an index of its documents up to date as
+ * snapshots arrive, so this lookup doesn't scan the array.
+ */
+- (NSInteger)indexOfDocumentID:(NSString *)documentID;
+
+/**
+ * Returns the document with the given ID, or nil if the array doesn't contain it.
+ * See indexOfDocumentID:.
+ */
+- (nullable FIRDocumentSnapshot *)documentWithID:(NSString *)documentID;
+
 /**
  * Starts observing the array's query. Before this method is called no events will be sent
  * and the array will be empty.
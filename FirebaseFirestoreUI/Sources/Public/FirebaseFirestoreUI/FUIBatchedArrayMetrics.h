@@ -0,0 +1,105 @@
+//
+//  Copyright (c) 2016 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <FirebaseFirestore/FirebaseFirestore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUIBatchedArray;
+
+/**
+ * Measurements of how a batched array applied one query snapshot, from the
+ * snapshot's arrival to the end of the delegates' @c batchedArray:didUpdateWithDiff:
+ * callbacks. Durations are in seconds.
+ */
+@interface FUIBatchedArrayMetrics : NSObject
+
+/**
+ * When the snapshot arrived, in the same timebase as NSProcessInfo's
+ * @c systemUptime. Together with @c duration and the change counts, this lets
+ * sinks compute change rates over whatever window they like.
+ */
+@property (nonatomic, readonly) NSTimeInterval startTime;
+
+/**
+ * The time from the snapshot's arrival to the end of the last delegate callback.
+ */
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+/**
+ * The number of document changes in the snapshot.
+ */
+@property (nonatomic, readonly) NSUInteger changeCount;
+
+/**
+ * The number of document changes of the given type in the snapshot.
+ */
+- (NSUInteger)changeCountForType:(FIRDocumentChangeType)type;
+
+/**
+ * The time spent computing the diff handed to delegates, including indexing the
+ * documents it covers.
+ */
+@property (nonatomic, readonly) NSTimeInterval diffDuration;
+
+/**
+ * The time spent replacing the array's contents and updating its document index.
+ */
+@property (nonatomic, readonly) NSTimeInterval storageDuration;
+
+/**
+ * The time spent in delegate callbacks.
+ */
+@property (nonatomic, readonly) NSTimeInterval delegateDuration;
+
+/**
+ * The number of documents in the array after the update.
+ */
+@property (nonatomic, readonly) NSUInteger itemCount;
+
+/**
+ * The number of delegate callbacks that took longer than the array's
+ * @c slowCallbackThreshold.
+ */
+@property (nonatomic, readonly) NSUInteger slowCallbackCount;
+
+/**
+ * The duration of the longest delegate callback.
+ */
+@property (nonatomic, readonly) NSTimeInterval longestCallbackDuration;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * Receives the metrics of every update of a batched array. Arrays only measure
+ * updates while they have a sink, so instrumentation costs next to nothing when it
+ * isn't used.
+ */
+@protocol FUIBatchedArrayMetricsSink <NSObject>
+
+/**
+ * Called after the array's delegates have been sent @c batchedArray:didUpdateWithDiff:,
+ * on the queue the array's snapshot listener runs on.
+ */
+- (void)batchedArray:(FUIBatchedArray *)array
+    didFinishUpdateWithMetrics:(FUIBatchedArrayMetrics *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -173,6 +173,17 @@ FUIUnorderedPair *FUIUnorderedPairMake(id left, id right);
                          resultArray:(NSArray<FIRDocumentSnapshot *> *)result
                      documentChanges:(NSArray<FIRDocumentChange *> *)documentChanges;
 
+/**
+ * Creates a diff between two arrays from the document changes array, using
+ * precomputed maps of document IDs to indexes instead of building them from both
+ * arrays. The maps only need to contain the documents in the document changes array.
+ */
+- (instancetype)initWithInitialArray:(NSArray<FIRDocumentSnapshot *> *)initial
+                         resultArray:(NSArray<FIRDocumentSnapshot *> *)result
+                     documentChanges:(NSArray<FIRDocumentChange *> *)documentChanges
+                      initialIndexes:(NSDictionary<NSString *, NSNumber *> *)initialIndexes
+                       resultIndexes:(NSDictionary<NSString *, NSNumber *> *)resultIndexes;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 @end
@@ -23,6 +23,7 @@ FOUNDATION_EXPORT double FirebaseFirestoreUIVersionNumber;
 FOUNDATION_EXPORT const unsigned char FirebaseFirestoreUIVersionString[];
 
 #import "FUISnapshotArrayDiff.h"
+#import "FUIBatchedArrayMetrics.h"
 #import "FUIBatchedArray.h"
 #import "FUIFirestoreCollectionViewDataSource.h"
 #import "FUIFirestoreTableViewDataSource.h"
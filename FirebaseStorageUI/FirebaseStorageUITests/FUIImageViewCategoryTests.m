@@ -40,7 +40,10 @@
   }
   self.ref = OCMClassMock([FIRStorageReference class]);
   OCMStub([self.ref bucket]).andReturn(@"bucket");
-  OCMStub([self.ref fullPath]).andReturn(@"path/to/image.png");
+  // Use a distinct object per test so downloads left in flight by earlier tests,
+  // which the loader shares between requests, aren't reused.
+  NSString *path = [NSString stringWithFormat:@"path/to/%@.png", [NSUUID UUID].UUIDString];
+  OCMStub([self.ref fullPath]).andReturn(path);
   self.imageView = [[UIImageView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
 }
 
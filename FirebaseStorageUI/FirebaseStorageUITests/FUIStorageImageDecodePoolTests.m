@@ -0,0 +1,155 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+@import XCTest;
+
+@import FirebaseStorageUI;
+
+@interface FUIStorageImageDecodePool (Testing)
+- (NSOperation *)addDecodeWithPriority:(FUIStorageImagePriority)priority
+                            dependency:(NSOperation *)dependency
+                                 block:(dispatch_block_t)block;
+@end
+
+@interface FUIStorageImageDecodePoolTests : XCTestCase
+@property (nonatomic, readwrite) FUIStorageImageDecodePool *pool;
+@property (nonatomic, readwrite) dispatch_semaphore_t gate;
+@end
+
+@implementation FUIStorageImageDecodePoolTests
+
+- (void)setUp {
+  [super setUp];
+  self.pool = [[FUIStorageImageDecodePool alloc] initWithMaxConcurrentDecodeCount:1];
+  self.gate = dispatch_semaphore_create(0);
+}
+
+// Occupies the pool's only thread until the gate is opened, so decodes added in the
+// meantime are started in priority order.
+- (void)blockPool {
+  dispatch_semaphore_t gate = self.gate;
+  dispatch_semaphore_t started = dispatch_semaphore_create(0);
+  [self.pool addDecodeWithPriority:FUIStorageImagePriorityVisible dependency:nil block:^{
+    dispatch_semaphore_signal(started);
+    dispatch_semaphore_wait(gate, DISPATCH_TIME_FOREVER);
+  }];
+  dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+}
+
+- (void)testDecodesStartInPriorityOrder {
+  [self blockPool];
+  NSMutableArray<NSNumber *> *order = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  expectation.expectedFulfillmentCount = 3;
+  for (NSNumber *priority in @[@(FUIStorageImagePriorityBackground),
+                               @(FUIStorageImagePriorityPrefetch),
+                               @(FUIStorageImagePriorityVisible)]) {
+    [self.pool addDecodeWithPriority:priority.integerValue dependency:nil block:^{
+      @synchronized (order) {
+        [order addObject:priority];
+      }
+      [expectation fulfill];
+    }];
+  }
+  XCTAssertEqual(self.pool.queuedDecodeCount, 3);
+  dispatch_semaphore_signal(self.gate);
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+
+  NSArray *expected = @[@(FUIStorageImagePriorityVisible),
+                        @(FUIStorageImagePriorityPrefetch),
+                        @(FUIStorageImagePriorityBackground)];
+  XCTAssertEqualObjects(order, expected, @"expected visible images to be decoded first");
+  XCTAssertEqual(self.pool.peakQueuedDecodeCount, 3);
+}
+
+- (void)testRaisedPriorityIsDecodedFirst {
+  [self blockPool];
+  NSMutableArray<NSString *> *order = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  expectation.expectedFulfillmentCount = 2;
+  [self.pool addDecodeWithPriority:FUIStorageImagePriorityPrefetch dependency:nil block:^{
+    @synchronized (order) {
+      [order addObject:@"first"];
+    }
+    [expectation fulfill];
+  }];
+  NSOperation *bumped = [self.pool addDecodeWithPriority:FUIStorageImagePriorityBackground
+                                              dependency:nil
+                                                   block:^{
+    @synchronized (order) {
+      [order addObject:@"bumped"];
+    }
+    [expectation fulfill];
+  }];
+  bumped.queuePriority = NSOperationQueuePriorityHigh;
+  dispatch_semaphore_signal(self.gate);
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+
+  NSArray *expected = @[@"bumped", @"first"];
+  XCTAssertEqualObjects(order, expected);
+}
+
+- (void)testCancelledDecodesAreDropped {
+  [self blockPool];
+  __block BOOL ran = NO;
+  NSOperation *cancelled = [self.pool addDecodeWithPriority:FUIStorageImagePriorityVisible
+                                                 dependency:nil
+                                                      block:^{
+    ran = YES;
+  }];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  [self.pool addDecodeWithPriority:FUIStorageImagePriorityBackground dependency:nil block:^{
+    [expectation fulfill];
+  }];
+  [cancelled cancel];
+  dispatch_semaphore_signal(self.gate);
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+  [cancelled waitUntilFinished];
+
+  XCTAssertFalse(ran, @"expected cancelled decode to not run");
+  XCTAssertEqual(self.pool.droppedDecodeCount, 1);
+  XCTAssertEqual(self.pool.completedDecodeCount, 2);
+  XCTAssertEqual(self.pool.queuedDecodeCount, 0);
+}
+
+- (void)testDependentDecodesRunInOrder {
+  [self blockPool];
+  NSMutableArray<NSString *> *order = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  NSOperation *partial = [self.pool addDecodeWithPriority:FUIStorageImagePriorityBackground
+                                               dependency:nil
+                                                    block:^{
+    @synchronized (order) {
+      [order addObject:@"partial"];
+    }
+  }];
+  [self.pool addDecodeWithPriority:FUIStorageImagePriorityVisible
+                        dependency:partial
+                             block:^{
+    @synchronized (order) {
+      [order addObject:@"final"];
+    }
+    [expectation fulfill];
+  }];
+  dispatch_semaphore_signal(self.gate);
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+
+  NSArray *expected = @[@"partial", @"final"];
+  XCTAssertEqualObjects(order, expected);
+}
+
+@end
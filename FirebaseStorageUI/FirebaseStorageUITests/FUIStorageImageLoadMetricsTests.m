@@ -0,0 +1,59 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+@import XCTest;
+
+@import FirebaseStorageUI;
+
+@interface FUIStorageImageLoadMetricsTests : XCTestCase
+@end
+
+@implementation FUIStorageImageLoadMetricsTests
+
+- (void)testHistogramBucketsDoubleFromOneMillisecond {
+  FUIStorageImageLoadHistogram *histogram = [[FUIStorageImageLoadHistogram alloc] init];
+  [histogram recordDuration:0.0005];
+  [histogram recordDuration:0.003];
+  [histogram recordDuration:0.004];
+  [histogram recordDuration:3600];
+
+  NSArray<NSNumber *> *buckets = histogram.bucketCounts;
+  XCTAssertEqual(histogram.count, 4);
+  XCTAssertEqualObjects(buckets[0], @1, @"expected sub-millisecond durations in the first bucket");
+  XCTAssertEqualObjects(buckets[2], @2, @"expected 3ms and 4ms in the bucket up to 4ms");
+  XCTAssertEqualObjects(buckets.lastObject, @1, @"expected an hour in the overflow bucket");
+}
+
+- (void)testHistogramPercentiles {
+  FUIStorageImageLoadHistogram *histogram = [[FUIStorageImageLoadHistogram alloc] init];
+  XCTAssertEqual([histogram durationAtPercentile:50], 0);
+  for (NSInteger i = 0; i < 90; i++) {
+    [histogram recordDuration:0.010];
+  }
+  for (NSInteger i = 0; i < 10; i++) {
+    [histogram recordDuration:0.500];
+  }
+
+  XCTAssertEqualWithAccuracy([histogram durationAtPercentile:50], 0.016, 1e-9);
+  XCTAssertEqualWithAccuracy([histogram durationAtPercentile:90], 0.016, 1e-9);
+  XCTAssertEqualWithAccuracy([histogram durationAtPercentile:95], 0.512, 1e-9);
+
+  [histogram reset];
+  XCTAssertEqual(histogram.count, 0);
+}
+
+@end
@@ -0,0 +1,718 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+@import XCTest;
+
+@import FirebaseCore;
+@import FirebaseStorageUI;
+@import OCMock;
+
+typedef void (^FUIDataCompletion)(NSData *_Nullable, NSError *_Nullable);
+typedef void (^FUIFileCompletion)(NSURL *_Nullable, NSError *_Nullable);
+typedef void (^FUISnapshotHandler)(FIRStorageTaskSnapshot *);
+typedef void (^FUIMetadataCompletion)(FIRStorageMetadata *_Nullable, NSError *_Nullable);
+typedef void (^FUIDownloadURLCompletion)(NSURL *_Nullable, NSError *_Nullable);
+
+static NSData *FUIStubResponseData;
+static NSInteger FUIStubStatusCode = 200;
+static const NSUInteger FUIStubChunkSize = 1024;
+
+/**
+ * Stands in for the Storage HTTP server, serving the stub response in chunks to
+ * requests for storage.test.
+ */
+@interface FUIStorageStubURLProtocol : NSURLProtocol
+@end
+
+@implementation FUIStorageStubURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+  return [request.URL.host isEqualToString:@"storage.test"];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+  return request;
+}
+
+- (void)startLoading {
+  NSData *data = FUIStubStatusCode == 200 ? FUIStubResponseData : [NSData data];
+  NSDictionary *headers = @{
+    @"Content-Type": @"image/jpeg",
+    @"Content-Length": @(data.length).stringValue,
+  };
+  NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                            statusCode:FUIStubStatusCode
+                                                           HTTPVersion:@"HTTP/1.1"
+                                                          headerFields:headers];
+  [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+  for (NSUInteger offset = 0; offset < data.length; offset += FUIStubChunkSize) {
+    NSRange chunk = NSMakeRange(offset, MIN(FUIStubChunkSize, data.length - offset));
+    [self.client URLProtocol:self didLoadData:[data subdataWithRange:chunk]];
+  }
+  [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)stopLoading {
+}
+
+@end
+
+/**
+ * Keeps every metrics object a loader reports.
+ */
+@interface FUIStorageMetricsRecorder : NSObject <FUIStorageImageLoadMetricsObserver>
+@property (nonatomic, readonly) NSArray<FUIStorageImageLoadMetrics *> *samples;
+@end
+
+@implementation FUIStorageMetricsRecorder {
+  NSMutableArray<FUIStorageImageLoadMetrics *> *_samples;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _samples = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (NSArray<FUIStorageImageLoadMetrics *> *)samples {
+  @synchronized (self) {
+    return [_samples copy];
+  }
+}
+
+- (void)imageLoader:(FUIStorageImageLoader *)loader didCollectMetrics:(FUIStorageImageLoadMetrics *)metrics {
+  @synchronized (self) {
+    [_samples addObject:metrics];
+  }
+}
+
+@end
+
+@interface FUIStorageImageLoaderTests : XCTestCase
+@property (nonatomic, readwrite) FUIStorageImageLoader *loader;
+@property (nonatomic, readwrite) FIRStorageReference *ref;
+@property (nonatomic, readwrite) FIRStorageDownloadTask *task;
+@property (nonatomic, readwrite) NSMutableArray<FUIDataCompletion> *downloads;
+@property (nonatomic, readwrite) NSMutableArray<FUIFileCompletion> *fileDownloads;
+@property (nonatomic, readwrite) NSMutableArray<NSURL *> *fileURLs;
+@property (nonatomic, readwrite, nullable) FUISnapshotHandler progressHandler;
+@property (nonatomic, readwrite) NSMutableArray<FUIMetadataCompletion> *metadataFetches;
+@property (nonatomic, readwrite) NSUInteger downloadURLRequests;
+@property (nonatomic, readwrite) NSMutableArray<NSNumber *> *downloadSizes;
+@end
+
+@implementation FUIStorageImageLoaderTests
+
+- (void)setUp {
+  [super setUp];
+  if ([FIRApp defaultApp] == nil) {
+    FIROptions *options =
+        [[FIROptions alloc] initWithGoogleAppID:@"0:0000000000000:ios:0000000000000000"
+                                    GCMSenderID:@"1234567891011"];
+    [FIRApp configureWithOptions:options];
+  }
+  self.loader = [[FUIStorageImageLoader alloc] init];
+  self.downloads = [NSMutableArray array];
+  self.fileDownloads = [NSMutableArray array];
+  self.fileURLs = [NSMutableArray array];
+  self.metadataFetches = [NSMutableArray array];
+  self.downloadURLRequests = 0;
+  self.downloadSizes = [NSMutableArray array];
+  FUIStubResponseData = nil;
+  FUIStubStatusCode = 200;
+  NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+  configuration.protocolClasses = @[[FUIStorageStubURLProtocol class]];
+  self.loader.streamingSessionConfiguration = configuration;
+  self.task = OCMClassMock(NSClassFromString(@"FIRStorageDownloadTask"));
+  self.ref = OCMClassMock([FIRStorageReference class]);
+  OCMStub([self.ref bucket]).andReturn(@"bucket");
+  OCMStub([self.ref fullPath]).andReturn(@"path/to/image.png");
+
+  // Record each download that's started so tests can finish it.
+  __weak typeof(self) weakSelf = self;
+  OCMStub([self.ref dataWithMaxSize:0 completion:[OCMArg any]]).ignoringNonObjectArgs().andDo(^(NSInvocation *invocation) {
+    int64_t maxSize;
+    __unsafe_unretained FUIDataCompletion completion;
+    [invocation getArgument:&maxSize atIndex:2];
+    [invocation getArgument:&completion atIndex:3];
+    @synchronized (weakSelf) {
+      [weakSelf.downloads addObject:[completion copy]];
+      [weakSelf.downloadSizes addObject:@(maxSize)];
+    }
+    __unsafe_unretained FIRStorageDownloadTask *task = weakSelf.task;
+    [invocation setReturnValue:&task];
+  });
+  OCMStub([self.ref writeToFile:[OCMArg any] completion:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
+    __unsafe_unretained NSURL *fileURL;
+    __unsafe_unretained FUIFileCompletion completion;
+    [invocation getArgument:&fileURL atIndex:2];
+    [invocation getArgument:&completion atIndex:3];
+    [weakSelf.fileURLs addObject:fileURL];
+    [weakSelf.fileDownloads addObject:[completion copy]];
+    __unsafe_unretained FIRStorageDownloadTask *task = weakSelf.task;
+    [invocation setReturnValue:&task];
+  });
+  OCMStub([self.ref metadataWithCompletion:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
+    __unsafe_unretained FUIMetadataCompletion completion;
+    [invocation getArgument:&completion atIndex:2];
+    [weakSelf.metadataFetches addObject:[completion copy]];
+  });
+  OCMStub([self.ref downloadURLWithCompletion:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
+    __unsafe_unretained FUIDownloadURLCompletion completion;
+    [invocation getArgument:&completion atIndex:2];
+    weakSelf.downloadURLRequests += 1;
+    completion([NSURL URLWithString:@"https://storage.test/bucket/image.jpg"], nil);
+  });
+  OCMStub([self.task observeStatus:FIRStorageTaskStatusProgress handler:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
+    __unsafe_unretained FUISnapshotHandler handler;
+    [invocation getArgument:&handler atIndex:3];
+    weakSelf.progressHandler = [handler copy];
+  });
+}
+
+- (id<SDWebImageOperation>)requestWithCompletion:(SDImageLoaderCompletedBlock)completion {
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  return [self.loader requestImageWithURL:url
+                                  options:0
+                                  context:@{SDWebImageContextFUIStorageMaxImageSize: @512}
+                                 progress:nil
+                                completed:completion];
+}
+
+- (void)testConcurrentRequestsShareOneDownload {
+  __block NSUInteger completions = 0;
+  SDImageLoaderCompletedBlock completion =
+      ^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    XCTAssertNotNil(error, @"expected failed download to be sent to every request");
+    XCTAssertTrue(finished);
+    completions += 1;
+  };
+  for (NSInteger i = 0; i < 3; i++) {
+    [self requestWithCompletion:completion];
+  }
+
+  XCTAssertEqual(self.downloads.count, 1, @"expected in-flight requests to share a download");
+  XCTAssertEqual(self.loader.downloadCount, 1);
+  XCTAssertEqual(self.loader.coalescedRequestCount, 2);
+
+  NSError *error = [NSError errorWithDomain:@"FIRStorageErrorDomain" code:-13010 userInfo:nil];
+  self.downloads.firstObject(nil, error);
+  XCTAssertEqual(completions, 3, @"expected every request to receive the result");
+
+  // Requests made after the download finished start a new one.
+  [self requestWithCompletion:nil];
+  XCTAssertEqual(self.downloads.count, 2, @"expected finished download to not be reused");
+}
+
+- (void)testDifferentMaxSizesDontShareDownloads {
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  [self requestWithCompletion:nil];
+  [self.loader requestImageWithURL:url
+                           options:0
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @1024}
+                          progress:nil
+                         completed:nil];
+
+  XCTAssertEqual(self.loader.downloadCount, 2);
+  XCTAssertEqual(self.loader.coalescedRequestCount, 0);
+}
+
+- (void)testDownloadIsCancelledWhenLastRequestIsCancelled {
+  __block NSUInteger cancels = 0;
+  OCMStub([self.task cancel]).andDo(^(NSInvocation *invocation) {
+    cancels += 1;
+  });
+  __block NSError *cancellationError;
+  id<SDWebImageOperation> first = [self requestWithCompletion:^(UIImage *image,
+                                                                NSData *data,
+                                                                NSError *error,
+                                                                BOOL finished) {
+    cancellationError = error;
+  }];
+  id<SDWebImageOperation> second = [self requestWithCompletion:nil];
+
+  [first cancel];
+  XCTAssertEqualObjects(cancellationError.domain, SDWebImageErrorDomain);
+  XCTAssertEqual(cancellationError.code, SDWebImageErrorCancelled,
+                 @"expected cancelled request to be told it was cancelled");
+  XCTAssertEqual(cancels, 0, @"expected download to continue while a request still needs it");
+
+  [second cancel];
+  XCTAssertEqual(cancels, 1, @"expected download to be cancelled with its last request");
+
+  // The cancelled download can't be joined anymore.
+  [self requestWithCompletion:nil];
+  XCTAssertEqual(self.downloads.count, 2);
+}
+
+#pragma mark - Downsampling
+
+// A photo-sized JPEG, much larger than anything it would be displayed in.
+- (NSData *)largeImageData {
+  UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat preferredFormat];
+  format.scale = 1;
+  UIGraphicsImageRenderer *renderer =
+      [[UIGraphicsImageRenderer alloc] initWithSize:CGSizeMake(4000, 3000) format:format];
+  UIImage *image = [renderer imageWithActions:^(UIGraphicsImageRendererContext *context) {
+    [[UIColor orangeColor] setFill];
+    [context fillRect:CGRectMake(0, 0, 4000, 3000)];
+    [[UIColor blueColor] setFill];
+    [context fillRect:CGRectMake(1000, 1000, 2000, 1000)];
+  }];
+  return UIImageJPEGRepresentation(image, 0.8);
+}
+
+- (void)testWaitingDownloadsStartNewestFirst {
+  self.loader.maxConcurrentDownloadsPerBucket = 1;
+  [self requestWithMaxSize:1];
+  [self requestWithMaxSize:2];
+  [self requestWithMaxSize:3];
+  XCTAssertEqualObjects(self.downloadSizes, @[@1], @"expected one download per bucket");
+
+  NSError *error = [NSError errorWithDomain:@"FIRStorageErrorDomain" code:-13000 userInfo:nil];
+  self.downloads[0](nil, error);
+  XCTAssertEqualObjects(self.downloadSizes, (@[@1, @3]), @"expected newest request to start next");
+  self.downloads[1](nil, error);
+  XCTAssertEqualObjects(self.downloadSizes, (@[@1, @3, @2]));
+}
+
+- (void)testVisibleDownloadsStartBeforePrefetches {
+  self.loader.maxConcurrentDownloadsPerBucket = 1;
+  [self requestWithMaxSize:1];
+  [self requestWithMaxSize:2];
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  [self.loader requestImageWithURL:url
+                           options:0
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @3,
+                                     SDWebImageContextFUIStorageImagePriority: @(FUIStorageImagePriorityPrefetch)}
+                          progress:nil
+                         completed:nil];
+
+  self.downloads[0](nil, [NSError errorWithDomain:@"FIRStorageErrorDomain" code:-13000 userInfo:nil]);
+  XCTAssertEqualObjects(self.downloadSizes, (@[@1, @2]), @"expected prefetch to wait for visible loads");
+}
+
+- (void)testCancelledWaitingDownloadNeverStarts {
+  self.loader.maxConcurrentDownloadsPerBucket = 1;
+  [self requestWithMaxSize:1];
+  id<SDWebImageOperation> waiting = [self requestWithMaxSize:2];
+  [waiting cancel];
+  XCTAssertEqual(self.loader.unstartedCancellationCount, 1);
+
+  self.downloads[0](nil, [NSError errorWithDomain:@"FIRStorageErrorDomain" code:-13000 userInfo:nil]);
+  XCTAssertEqualObjects(self.downloadSizes, @[@1], @"expected cancelled download to never start");
+}
+
+- (void)testDownloadsWaitForStartDelay {
+  self.loader.downloadStartDelay = 0.05;
+  id<SDWebImageOperation> scrolledPast = [self requestWithMaxSize:1];
+  [self requestWithMaxSize:2];
+  XCTAssertEqual(self.downloadSizes.count, 0, @"expected downloads to be held back");
+  [scrolledPast cancel];
+
+  NSPredicate *started = [NSPredicate predicateWithBlock:^BOOL(FUIStorageImageLoaderTests *test,
+                                                               NSDictionary *bindings) {
+    @synchronized (test) {
+      return test.downloadSizes.count > 0;
+    }
+  }];
+  [self waitForExpectations:@[[[XCTNSPredicateExpectation alloc] initWithPredicate:started object:self]]
+                    timeout:5];
+  @synchronized (self) {
+    XCTAssertEqualObjects(self.downloadSizes, @[@2]);
+  }
+  XCTAssertEqual(self.loader.unstartedCancellationCount, 1);
+}
+
+- (void)testCancelledDownloadsCountWastedBytes {
+  id<SDWebImageOperation> request = [self requestWithMaxSize:1024];
+  NSProgress *progress = [NSProgress progressWithTotalUnitCount:1024];
+  progress.completedUnitCount = 300;
+  FIRStorageTaskSnapshot *snapshot = OCMClassMock([FIRStorageTaskSnapshot class]);
+  OCMStub([snapshot progress]).andReturn(progress);
+  self.progressHandler(snapshot);
+
+  [request cancel];
+  XCTAssertEqual(self.loader.wastedByteCount, 300);
+  XCTAssertEqual(self.loader.unstartedCancellationCount, 0);
+}
+
+- (void)testMetricsAreReportedToObserver {
+  FUIStorageImageLoadMetricsAggregator *aggregator = [[FUIStorageImageLoadMetricsAggregator alloc] init];
+  self.loader.metricsObserver = aggregator;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  [self requestWithCompletion:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    [expectation fulfill];
+  }];
+  [self requestWithCompletion:nil];
+  NSData *imageData = UIImagePNGRepresentation([self imageWithSize:CGSizeMake(8, 8)]);
+  self.downloads.firstObject(imageData, nil);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertEqual([aggregator loadCountForOutcome:FUIStorageImageLoadOutcomeDownloaded], 1);
+  XCTAssertEqual([aggregator loadCountForOutcome:FUIStorageImageLoadOutcomeCoalesced], 1);
+  XCTAssertEqual(aggregator.coalescedRequestCount, 1);
+  XCTAssertEqual(aggregator.receivedByteCount, (int64_t)imageData.length);
+  XCTAssertEqual(aggregator.totalHistogram.count, 2, @"expected the joined request's total to be recorded");
+  XCTAssertEqual(aggregator.decodeHistogram.count, 1);
+
+  [[self requestWithMaxSize:1] cancel];
+  XCTAssertEqual([aggregator loadCountForOutcome:FUIStorageImageLoadOutcomeCancelled], 1);
+}
+
+- (void)testEveryCoalescedRequestReportsMetrics {
+  FUIStorageMetricsRecorder *recorder = [[FUIStorageMetricsRecorder alloc] init];
+  self.loader.metricsObserver = recorder;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  [self requestWithCompletion:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    [expectation fulfill];
+  }];
+  [self requestWithCompletion:nil];
+  [self requestWithCompletion:nil];
+  [[self requestWithCompletion:nil] cancel];
+  XCTAssertEqual(self.downloads.count, 1);
+  XCTAssertEqual(recorder.samples.count, 1, @"expected the cancelled request to report right away");
+  XCTAssertEqual(recorder.samples.firstObject.outcome, FUIStorageImageLoadOutcomeCancelled);
+
+  NSData *imageData = UIImagePNGRepresentation([self imageWithSize:CGSizeMake(8, 8)]);
+  self.downloads.firstObject(imageData, nil);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  NSArray<FUIStorageImageLoadMetrics *> *samples = recorder.samples;
+  XCTAssertEqual(samples.count, 4, @"expected one sample per request");
+  NSUInteger downloaded = 0;
+  NSUInteger coalesced = 0;
+  for (FUIStorageImageLoadMetrics *metrics in samples) {
+    if (metrics.outcome == FUIStorageImageLoadOutcomeDownloaded) {
+      downloaded += 1;
+      XCTAssertEqual(metrics.coalescedRequestCount, 3);
+    } else if (metrics.outcome == FUIStorageImageLoadOutcomeCoalesced) {
+      coalesced += 1;
+      XCTAssertNil(metrics.error);
+    }
+  }
+  XCTAssertEqual(downloaded, 1);
+  XCTAssertEqual(coalesced, 2);
+}
+
+- (void)testInvalidURLWithoutCompletionReportsMetrics {
+  FUIStorageMetricsRecorder *recorder = [[FUIStorageMetricsRecorder alloc] init];
+  self.loader.metricsObserver = recorder;
+  [self.loader requestImageWithURL:[NSURL URLWithString:@"gs:///image.jpg"]
+                           options:0
+                           context:nil
+                          progress:nil
+                         completed:nil];
+
+  XCTAssertEqual(recorder.samples.count, 1);
+  XCTAssertEqual(recorder.samples.firstObject.outcome, FUIStorageImageLoadOutcomeFailed);
+}
+
+- (id<SDWebImageOperation>)requestWithMaxSize:(UInt64)maxSize {
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  return [self.loader requestImageWithURL:url
+                                  options:0
+                                  context:@{SDWebImageContextFUIStorageMaxImageSize: @(maxSize)}
+                                 progress:nil
+                                completed:nil];
+}
+
+- (void)testTargetPixelSizeDownsamplesDecode {
+  NSData *data = [self largeImageData];
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  NSValue *target = [NSValue valueWithCGSize:CGSizeMake(120, 120)];
+  [self.loader requestImageWithURL:url
+                           options:0
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @512,
+                                     SDWebImageContextFUIStorageTargetPixelSize: target}
+                          progress:nil
+                         completed:nil];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  __block UIImage *decoded;
+  // Join the download to receive its decoded image.
+  [self.loader requestImageWithURL:url
+                           options:0
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @512,
+                                     SDWebImageContextFUIStorageTargetPixelSize: target}
+                          progress:nil
+                         completed:^(UIImage *image, NSData *imageData, NSError *error, BOOL finished) {
+    decoded = image;
+    [expectation fulfill];
+  }];
+  XCTAssertEqual(self.downloads.count, 1);
+  self.downloads.firstObject(data, nil);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  CGFloat width = decoded.size.width * decoded.scale;
+  CGFloat height = decoded.size.height * decoded.scale;
+  XCTAssertLessThanOrEqual(width, 120, @"expected image to be decoded at the target size");
+  XCTAssertLessThanOrEqual(height, 120, @"expected image to be decoded at the target size");
+  XCTAssertEqualWithAccuracy(width / height, 4.0 / 3.0, 0.05,
+                             @"expected downsampling to preserve the aspect ratio");
+}
+
+// Compare the peak physical memory reported by these two tests to see what decoding
+// avatars at their displayed size saves.
+- (void)testFullSizeDecodeMemory {
+  NSData *data = [self largeImageData];
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  [self measureWithMetrics:@[[[XCTMemoryMetric alloc] init]] block:^{
+    UIImage *image = SDImageLoaderDecodeImageData(data, url, 0, nil);
+    XCTAssertNotNil(image);
+  }];
+}
+
+- (void)testDownsampledDecodeMemory {
+  NSData *data = [self largeImageData];
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  SDWebImageContext *context = @{
+    SDWebImageContextImageThumbnailPixelSize: [NSValue valueWithCGSize:CGSizeMake(120, 120)],
+    SDWebImageContextImagePreserveAspectRatio: @YES,
+  };
+  [self measureWithMetrics:@[[[XCTMemoryMetric alloc] init]] block:^{
+    UIImage *image = SDImageLoaderDecodeImageData(data, url, 0, context);
+    XCTAssertNotNil(image);
+  }];
+}
+
+#pragma mark - Streaming to disk
+
+- (void)testStreamedDownloadIsDecodedFromFile {
+  self.loader.streamsDownloadsToDisk = YES;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  __block UIImage *decoded;
+  __block NSData *decodedData;
+  [self requestWithCompletion:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    XCTAssertNil(error);
+    decoded = image;
+    decodedData = data;
+    [expectation fulfill];
+  }];
+  XCTAssertEqual(self.downloads.count, 0, @"expected download to not be kept in memory");
+  XCTAssertEqual(self.fileDownloads.count, 1);
+
+  NSData *imageData = UIImagePNGRepresentation([self imageWithSize:CGSizeMake(8, 8)]);
+  NSURL *fileURL = self.fileURLs.firstObject;
+  XCTAssertTrue([imageData writeToURL:fileURL atomically:YES]);
+  self.fileDownloads.firstObject(fileURL, nil);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertNotNil(decoded);
+  XCTAssertEqualObjects(decodedData, imageData);
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path],
+                 @"expected temporary file to be removed");
+}
+
+- (void)testStreamedDownloadEnforcesMaxSize {
+  self.loader.streamsDownloadsToDisk = YES;
+  __block NSUInteger cancels = 0;
+  OCMStub([self.task cancel]).andDo(^(NSInvocation *invocation) {
+    cancels += 1;
+  });
+  __block NSError *failure;
+  [self requestWithCompletion:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    failure = error;
+  }];
+
+  NSProgress *progress = [NSProgress progressWithTotalUnitCount:4096];
+  progress.completedUnitCount = 256;
+  FIRStorageTaskSnapshot *snapshot = OCMClassMock([FIRStorageTaskSnapshot class]);
+  OCMStub([snapshot progress]).andReturn(progress);
+  XCTAssertNotNil(self.progressHandler);
+  self.progressHandler(snapshot);
+
+  XCTAssertEqual(cancels, 1, @"expected oversized download to be cancelled");
+  XCTAssertEqual(failure.code, FIRStorageErrorCodeDownloadSizeExceeded);
+}
+
+- (void)testProgressiveLoadsAreStreamed {
+  FUIStubResponseData = UIImageJPEGRepresentation([self imageWithSize:CGSizeMake(256, 256)], 1);
+  self.loader.streamsDownloadsToDisk = YES;
+
+  UIImage *image = [self progressiveLoadWithMaxSize:10e6 error:nil partialImageCount:nil];
+  XCTAssertEqual(image.size.width * image.scale, 256);
+  XCTAssertEqual(self.downloads.count, 0, @"expected progressive load to not use a download task");
+  XCTAssertEqual(self.fileDownloads.count, 0);
+
+  [self progressiveLoadWithMaxSize:10e6 error:nil partialImageCount:nil];
+  XCTAssertEqual(self.downloadURLRequests, 1, @"expected download URL to be resolved once");
+}
+
+- (void)testPartialDecodesAreThrottled {
+  FUIStubResponseData = UIImageJPEGRepresentation([self imageWithSize:CGSizeMake(512, 512)], 1);
+  self.loader.progressiveDecodeInterval = 60;
+
+  NSUInteger partialImages = 0;
+  UIImage *image = [self progressiveLoadWithMaxSize:10e6 error:nil partialImageCount:&partialImages];
+  XCTAssertNotNil(image);
+  XCTAssertLessThanOrEqual(partialImages, 1, @"expected at most one partial decode per interval");
+}
+
+- (void)testStreamedLoadEnforcesMaxSize {
+  FUIStubResponseData = UIImageJPEGRepresentation([self imageWithSize:CGSizeMake(256, 256)], 1);
+
+  NSError *error;
+  UIImage *image = [self progressiveLoadWithMaxSize:512 error:&error partialImageCount:nil];
+  XCTAssertNil(image);
+  XCTAssertEqual(error.code, FIRStorageErrorCodeDownloadSizeExceeded);
+}
+
+- (void)testMissingObjectResolvesDownloadURLAgain {
+  FUIStubStatusCode = 404;
+
+  NSError *error;
+  [self progressiveLoadWithMaxSize:10e6 error:&error partialImageCount:nil];
+  XCTAssertEqual(error.code, FIRStorageErrorCodeObjectNotFound);
+  XCTAssertTrue([self.loader shouldBlockFailedURLWithURL:[NSURL sd_URLWithStorageReference:self.ref]
+                                                   error:error]);
+
+  [self progressiveLoadWithMaxSize:10e6 error:&error partialImageCount:nil];
+  XCTAssertEqual(self.downloadURLRequests, 2, @"expected stale download URL to be dropped");
+}
+
+- (UIImage *)progressiveLoadWithMaxSize:(UInt64)maxSize
+                                  error:(NSError **)errorPtr
+                      partialImageCount:(NSUInteger *)partialImageCount {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"loaded"];
+  __block UIImage *result;
+  __block NSError *failure;
+  __block NSUInteger partialImages = 0;
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  [self.loader requestImageWithURL:url
+                           options:SDWebImageProgressiveLoad
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @(maxSize)}
+                          progress:nil
+                         completed:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    if (!finished) {
+      partialImages += 1;
+      return;
+    }
+    result = image;
+    failure = error;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  if (errorPtr) {
+    *errorPtr = failure;
+  }
+  if (partialImageCount) {
+    *partialImageCount = partialImages;
+  }
+  return result;
+}
+
+- (void)testDownloadedImagesCarryObjectVersion {
+  self.loader.revalidatesCachedImages = YES;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"decoded"];
+  __block UIImage *decoded;
+  [self requestWithCompletion:^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    decoded = image;
+    [expectation fulfill];
+  }];
+  XCTAssertEqual(self.metadataFetches.count, 1);
+  XCTAssertEqual(self.downloads.count, 0, @"expected download to wait for the object's metadata");
+
+  self.metadataFetches.firstObject([self metadataWithGeneration:1], nil);
+  XCTAssertEqual(self.downloads.count, 1);
+  self.downloads.firstObject(UIImagePNGRepresentation([self imageWithSize:CGSizeMake(8, 8)]), nil);
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertNotNil(decoded);
+  XCTAssertEqualObjects(decoded.sd_extendedObject, [self versionWithGeneration:1],
+                        @"expected object version to be stored with the image");
+}
+
+- (void)testUnchangedObjectIsNotDownloadedAgain {
+  self.loader.revalidatesCachedImages = YES;
+  UIImage *cachedImage = [self imageWithSize:CGSizeMake(8, 8)];
+  cachedImage.sd_extendedObject = [self versionWithGeneration:1];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"revalidated"];
+  expectation.expectedFulfillmentCount = 2;
+  SDImageLoaderCompletedBlock completion =
+      ^(UIImage *image, NSData *data, NSError *error, BOOL finished) {
+    XCTAssertNil(image);
+    XCTAssertEqualObjects(error.domain, SDWebImageErrorDomain);
+    XCTAssertEqual(error.code, SDWebImageErrorCacheNotModified);
+    [expectation fulfill];
+  };
+  [self refreshCachedImage:cachedImage completion:completion];
+  self.metadataFetches.firstObject([self metadataWithGeneration:1], nil);
+  // Metadata is reused within the revalidation interval.
+  [self refreshCachedImage:cachedImage completion:completion];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertEqual(self.metadataFetches.count, 1);
+  XCTAssertEqual(self.downloads.count, 0, @"expected unchanged object to not be downloaded");
+}
+
+- (void)testChangedObjectIsDownloadedAgain {
+  self.loader.revalidatesCachedImages = YES;
+  self.loader.revalidationInterval = 0;
+  UIImage *cachedImage = [self imageWithSize:CGSizeMake(8, 8)];
+  cachedImage.sd_extendedObject = [self versionWithGeneration:1];
+
+  [self refreshCachedImage:cachedImage completion:nil];
+  self.metadataFetches.lastObject([self metadataWithGeneration:2], nil);
+  XCTAssertEqual(self.downloads.count, 1, @"expected changed object to be downloaded");
+
+  // Without a cached version to compare against, the image is downloaded again.
+  [self refreshCachedImage:[self imageWithSize:CGSizeMake(8, 8)] completion:nil];
+  XCTAssertEqual(self.metadataFetches.count, 2, @"expected expired metadata to be fetched again");
+  self.metadataFetches.lastObject([self metadataWithGeneration:2], nil);
+  XCTAssertEqual(self.loader.coalescedRequestCount, 1,
+                 @"expected second load to join the download in flight");
+}
+
+- (void)refreshCachedImage:(UIImage *)cachedImage completion:(SDImageLoaderCompletedBlock)completion {
+  NSURL *url = [NSURL sd_URLWithStorageReference:self.ref];
+  [self.loader requestImageWithURL:url
+                           options:SDWebImageRefreshCached
+                           context:@{SDWebImageContextFUIStorageMaxImageSize: @512,
+                                     SDWebImageContextLoaderCachedImage: cachedImage}
+                          progress:nil
+                         completed:completion];
+}
+
+- (FIRStorageMetadata *)metadataWithGeneration:(int64_t)generation {
+  FIRStorageMetadata *metadata = OCMClassMock([FIRStorageMetadata class]);
+  OCMStub([metadata generation]).andReturn(generation);
+  OCMStub([metadata md5Hash]).andReturn(@"hash");
+  OCMStub([metadata updated]).andReturn([NSDate dateWithTimeIntervalSince1970:generation]);
+  return metadata;
+}
+
+- (NSDictionary *)versionWithGeneration:(int64_t)generation {
+  return @{
+    @"FUIStorageGeneration": @(generation),
+    @"FUIStorageMD5Hash": @"hash",
+    @"FUIStorageUpdated": @((NSTimeInterval)generation),
+  };
+}
+
+- (UIImage *)imageWithSize:(CGSize)size {
+  UIGraphicsImageRenderer *renderer = [[UIGraphicsImageRenderer alloc] initWithSize:size];
+  return [renderer imageWithActions:^(UIGraphicsImageRendererContext *context) {
+    [[UIColor greenColor] setFill];
+    [context fillRect:CGRectMake(0, 0, size.width, size.height)];
+  }];
+}
+
+@end
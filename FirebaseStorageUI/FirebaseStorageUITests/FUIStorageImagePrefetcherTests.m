@@ -0,0 +1,152 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+@import XCTest;
+
+@import FirebaseCore;
+@import FirebaseStorage;
+@import FirebaseStorageUI;
+@import OCMock;
+
+@interface FUIStorageImagePrefetcherTests : XCTestCase
+@property (nonatomic, readwrite) FUIStorageImageLoader *loader;
+@property (nonatomic, readwrite) FUIStorageImagePrefetcher *prefetcher;
+@property (nonatomic, readwrite) FIRStorage *storage;
+@end
+
+@implementation FUIStorageImagePrefetcherTests
+
+- (void)setUp {
+  [super setUp];
+  if ([FIRApp defaultApp] == nil) {
+    FIROptions *options =
+        [[FIROptions alloc] initWithGoogleAppID:@"0:0000000000000:ios:0000000000000000"
+                                    GCMSenderID:@"1234567891011"];
+    [FIRApp configureWithOptions:options];
+  }
+  self.storage = [FUIStorageReferenceCache.sharedCache storageForBucket:@"bucket"];
+  self.loader = OCMClassMock([FUIStorageImageLoader class]);
+  OCMStub([self.loader canRequestImageForURL:[OCMArg any]]).andReturn(YES);
+  self.prefetcher = [[FUIStorageImagePrefetcher alloc] initWithLoader:self.loader];
+  self.prefetcher.storage = self.storage;
+}
+
+- (void)testReferencesAreDerivedFromRows {
+  FIRStorageReference *reference = [self.storage referenceWithPath:@"images/first.png"];
+  NSArray *rows = @[
+    @{@"photo": reference},
+    @{@"photo": @"gs://bucket/images/second.png"},
+    @{@"photo": [NSURL URLWithString:@"gs://bucket/images/third.png"]},
+    @{@"name": @"no photo"},
+    @{@"photo": @"images/fifth.png"},
+  ];
+
+  NSArray<FIRStorageReference *> *references =
+      [self.prefetcher referencesInRange:NSMakeRange(1, 10)
+                            ofCollection:rows
+                        referenceKeyPath:@"photo"];
+
+  NSArray *paths = [references valueForKey:@"fullPath"];
+  NSArray *expected = @[@"images/second.png", @"images/third.png", @"images/fifth.png"];
+  XCTAssertEqualObjects(paths, expected,
+                        @"expected range to be clipped and rows without a photo to be skipped");
+  XCTAssertEqualObjects([self.prefetcher referencesInRange:NSMakeRange(5, 1)
+                                              ofCollection:rows
+                                          referenceKeyPath:@"photo"], @[]);
+}
+
+- (void)testPrefetchesAreLimitedAndLowPriority {
+  self.prefetcher.maxConcurrentPrefetchCount = 2;
+  __block NSUInteger requests = 0;
+  __block NSUInteger inFlight = 0;
+  __block NSUInteger peakInFlight = 0;
+  __block NSMutableArray<SDWebImageContext *> *contexts = [NSMutableArray array];
+  __block SDWebImageOptions requestOptions = 0;
+  OCMStub([self.loader requestImageWithURL:[OCMArg any]
+                                   options:0
+                                   context:[OCMArg any]
+                                  progress:[OCMArg any]
+                                 completed:[OCMArg any]]).ignoringNonObjectArgs().andDo(^(NSInvocation *invocation) {
+    __unsafe_unretained SDWebImageContext *context;
+    __unsafe_unretained SDImageLoaderCompletedBlock completion;
+    [invocation getArgument:&requestOptions atIndex:3];
+    [invocation getArgument:&context atIndex:4];
+    [invocation getArgument:&completion atIndex:6];
+    [contexts addObject:context];
+    requests += 1;
+    inFlight += 1;
+    peakInFlight = MAX(peakInFlight, inFlight);
+    SDImageLoaderCompletedBlock finish = [completion copy];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_MSEC), dispatch_get_main_queue(), ^{
+      inFlight -= 1;
+      finish(nil, nil, [NSError errorWithDomain:@"FIRStorageErrorDomain" code:-13000 userInfo:nil], YES);
+    });
+  });
+
+  NSString *directory = [NSUUID UUID].UUIDString;
+  NSMutableArray<FIRStorageReference *> *references = [NSMutableArray array];
+  for (NSInteger i = 0; i < 5; i++) {
+    NSString *path = [NSString stringWithFormat:@"%@/%ld.png", directory, (long)i];
+    [references addObject:[self.storage referenceWithPath:path]];
+  }
+  XCTestExpectation *expectation = [self expectationWithDescription:@"batch finished"];
+  [self.prefetcher prefetchReferences:references
+                             progress:nil
+                            completed:^(NSUInteger finishedCount, NSUInteger skippedCount) {
+    XCTAssertEqual(skippedCount, 5);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+
+  XCTAssertEqual(requests, 5);
+  XCTAssertLessThanOrEqual(peakInFlight, 2);
+  XCTAssertTrue(requestOptions & SDWebImageLowPriority);
+  for (SDWebImageContext *context in contexts) {
+    XCTAssertEqualObjects(context[SDWebImageContextFUIStorageImagePriority],
+                          @(FUIStorageImagePriorityPrefetch));
+  }
+}
+
+- (void)testCancellingBatchStopsRemainingPrefetches {
+  self.prefetcher.maxConcurrentPrefetchCount = 1;
+  __block NSUInteger requests = 0;
+  OCMStub([self.loader requestImageWithURL:[OCMArg any]
+                                   options:0
+                                   context:[OCMArg any]
+                                  progress:[OCMArg any]
+                                 completed:[OCMArg any]]).ignoringNonObjectArgs().andDo(^(NSInvocation *invocation) {
+    requests += 1;
+  });
+
+  NSString *directory = [NSUUID UUID].UUIDString;
+  NSArray<FIRStorageReference *> *references = @[
+    [self.storage referenceWithPath:[directory stringByAppendingPathComponent:@"a.png"]],
+    [self.storage referenceWithPath:[directory stringByAppendingPathComponent:@"b.png"]],
+  ];
+  SDWebImagePrefetchToken *token = [self.prefetcher prefetchReferences:references];
+  XCTAssertNotNil(token);
+  [token cancel];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"idle"];
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 100 * NSEC_PER_MSEC), dispatch_get_main_queue(), ^{
+    [expectation fulfill];
+  });
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertLessThanOrEqual(requests, 1, @"expected cancelled batch to not start more prefetches");
+}
+
+@end
@@ -0,0 +1,122 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+@import XCTest;
+
+@import FirebaseCore;
+@import FirebaseStorage;
+@import FirebaseStorageUI;
+
+@interface FUIStorageReferenceCacheTests : XCTestCase
+@property (nonatomic, readwrite) FUIStorageReferenceCache *cache;
+@end
+
+@implementation FUIStorageReferenceCacheTests
+
+- (void)setUp {
+  [super setUp];
+  if ([FIRApp defaultApp] == nil) {
+    FIROptions *options =
+        [[FIROptions alloc] initWithGoogleAppID:@"0:0000000000000:ios:0000000000000000"
+                                    GCMSenderID:@"1234567891011"];
+    [FIRApp configureWithOptions:options];
+  }
+  self.cache = [[FUIStorageReferenceCache alloc] init];
+}
+
+- (FIRStorageReference *)referenceWithPath:(NSString *)path {
+  return [[self.cache storageForBucket:@"bucket"] referenceWithPath:path];
+}
+
+- (void)testStorageIsCreatedOncePerBucket {
+  FIRStorage *storage = [self.cache storageForBucket:@"bucket"];
+  XCTAssertNotNil(storage);
+  XCTAssertEqual([self.cache storageForBucket:@"bucket"], storage,
+                 @"expected storage instance to be reused");
+  XCTAssertNotEqual([self.cache storageForBucket:@"other-bucket"], storage);
+}
+
+- (void)testURLRoundTripsToReference {
+  FIRStorageReference *reference = [self referenceWithPath:@"images/my avatar.png"];
+  NSURL *url = [self.cache URLForReference:reference];
+
+  XCTAssertEqualObjects(url.absoluteString, @"gs://bucket/images/my%20avatar.png",
+                        @"expected path to be percent-encoded");
+  XCTAssertEqual(url.sd_storageReference, reference);
+
+  // A URL rebuilt from its string, as from a cache key, has no attached reference.
+  NSURL *restored = [NSURL URLWithString:url.absoluteString];
+  FIRStorageReference *resolved = [self.cache referenceForURL:restored];
+  XCTAssertEqualObjects(resolved.bucket, @"bucket");
+  XCTAssertEqualObjects(resolved.fullPath, @"images/my avatar.png");
+}
+
+- (void)testRepeatedLookupsAreCached {
+  FIRStorageReference *reference = [self referenceWithPath:@"images/a.png"];
+  NSURL *url = [self.cache URLForReference:reference];
+  NSURL *restored = [NSURL URLWithString:url.absoluteString];
+  FIRStorageReference *resolved = [self.cache referenceForURL:restored];
+  XCTAssertEqual([self.cache referenceForURL:restored], resolved,
+                 @"expected reference to be reused for an equal URL");
+}
+
+- (void)testEachURLCarriesItsOwnReference {
+  FIRStorageReference *reference = [self referenceWithPath:@"images/a.png"];
+  // Same bucket and path, but from a different Storage instance.
+  FIRStorage *otherStorage = [FIRStorage storageWithURL:@"gs://bucket"];
+  otherStorage.maxDownloadRetryTime = 1;
+  FIRStorageReference *other = [otherStorage referenceWithPath:@"images/a.png"];
+
+  NSURL *url = [self.cache URLForReference:reference];
+  NSURL *otherURL = [self.cache URLForReference:other];
+  XCTAssertEqualObjects(otherURL, url, @"expected equal URLs for the same object");
+  XCTAssertEqual(url.sd_storageReference, reference);
+  XCTAssertEqual(otherURL.sd_storageReference, other,
+                 @"expected a later reference to keep its own Storage instance");
+}
+
+- (void)testURLWithoutBucketHasNoReference {
+  XCTAssertNil([self.cache referenceForURL:[NSURL URLWithString:@"gs:///path.png"]]);
+}
+
+#pragma mark - Performance
+
+// Binding a cell resolves its reference's URL, and the loader resolves the reference
+// of URLs restored from cache keys. Measures both for a screen's worth of rows that
+// are bound over and over while scrolling.
+- (void)testBindTimeResolutionPerformance {
+  NSMutableArray<FIRStorageReference *> *references = [NSMutableArray array];
+  for (NSInteger i = 0; i < 50; i++) {
+    NSString *path = [NSString stringWithFormat:@"users/%ld/avatar image.png", (long)i];
+    [references addObject:[self referenceWithPath:path]];
+  }
+  NSMutableArray<NSURL *> *urls = [NSMutableArray array];
+  for (FIRStorageReference *reference in references) {
+    [urls addObject:[NSURL URLWithString:[self.cache URLForReference:reference].absoluteString]];
+  }
+
+  [self measureBlock:^{
+    for (NSInteger pass = 0; pass < 200; pass++) {
+      for (NSUInteger i = 0; i < references.count; i++) {
+        [self.cache URLForReference:references[i]];
+        [self.cache referenceForURL:urls[i]];
+      }
+    }
+  }];
+}
+
+@end
@@ -15,5 +15,21 @@
 //
 
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageDefine.h"
+#import "FirebaseStorageUI/Sources/FUIStorageDefine_Private.h"
 
 SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageMaxImageSize = @"FUIStorageMaxImageSize";
+SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageImagePriority = @"FUIStorageImagePriority";
+SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageTargetPixelSize = @"FUIStorageTargetPixelSize";
+
+SDWebImageContext *FUIStorageImageContextApplyingTargetPixelSize(SDWebImageContext *context) {
+  NSValue *targetPixelSize = context[SDWebImageContextFUIStorageTargetPixelSize];
+  if (!targetPixelSize || context[SDWebImageContextImageThumbnailPixelSize]) {
+    return context;
+  }
+  SDWebImageMutableContext *mutableContext = [context mutableCopy];
+  mutableContext[SDWebImageContextImageThumbnailPixelSize] = targetPixelSize;
+  if (!mutableContext[SDWebImageContextImagePreserveAspectRatio]) {
+    mutableContext[SDWebImageContextImagePreserveAspectRatio] = @YES;
+  }
+  return [mutableContext copy];
+}
@@ -0,0 +1,32 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <SDWebImage/SDWebImage.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Returns the context with SDWebImageContextFUIStorageTargetPixelSize translated into
+ * SDWebImageContextImageThumbnailPixelSize and SDWebImageContextImagePreserveAspectRatio,
+ * which SDWebImage uses to downsample while decoding and to build the cache key.
+ * Returns the context unchanged if it has no target size or already asks for a
+ * thumbnail.
+ */
+FOUNDATION_EXTERN SDWebImageContext *_Nullable
+FUIStorageImageContextApplyingTargetPixelSize(SDWebImageContext *_Nullable context);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,216 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImageDecodePool.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageDecodePool_Private.h"
+
+NSOperationQueuePriority FUIStorageImageDecodeQueuePriority(FUIStorageImagePriority priority) {
+  switch (priority) {
+    case FUIStorageImagePriorityVisible:
+      return NSOperationQueuePriorityHigh;
+    case FUIStorageImagePriorityPrefetch:
+      return NSOperationQueuePriorityNormal;
+    case FUIStorageImagePriorityBackground:
+      return NSOperationQueuePriorityLow;
+  }
+  return NSOperationQueuePriorityNormal;
+}
+
+@interface FUIStorageImageDecodePool ()
+
+- (void)decodeDidStartAfterWaiting:(NSTimeInterval)wait;
+- (void)decodeDidFinishWithDuration:(NSTimeInterval)duration;
+- (void)decodeWasDropped;
+
+@end
+
+@interface FUIStorageImageDecodeOperation : NSOperation
+
+@property (nonatomic, readonly, weak) FUIStorageImageDecodePool *pool;
+@property (nonatomic, readonly, copy) dispatch_block_t block;
+@property (nonatomic, readonly) NSTimeInterval enqueueTime;
+
+@end
+
+@implementation FUIStorageImageDecodeOperation
+
+- (instancetype)initWithPool:(FUIStorageImageDecodePool *)pool block:(dispatch_block_t)block {
+  self = [super init];
+  if (self) {
+    _pool = pool;
+    _block = [block copy];
+    _enqueueTime = [NSProcessInfo processInfo].systemUptime;
+  }
+  return self;
+}
+
+- (void)start {
+  // NSOperation doesn't call -main for operations cancelled before they start.
+  if (self.isCancelled) {
+    [self.pool decodeWasDropped];
+  }
+  [super start];
+}
+
+- (void)main {
+  NSTimeInterval start = [NSProcessInfo processInfo].systemUptime;
+  [self.pool decodeDidStartAfterWaiting:start - self.enqueueTime];
+  self.block();
+  [self.pool decodeDidFinishWithDuration:[NSProcessInfo processInfo].systemUptime - start];
+}
+
+@end
+
+@implementation FUIStorageImageDecodePool {
+  NSOperationQueue *_queue;
+
+  // Guards the statistics below.
+  NSLock *_lock;
+  NSUInteger _queuedDecodeCount;
+  NSUInteger _peakQueuedDecodeCount;
+  NSUInteger _completedDecodeCount;
+  NSUInteger _droppedDecodeCount;
+  NSUInteger _startedDecodeCount;
+  NSTimeInterval _totalQueueLatency;
+  NSTimeInterval _totalDecodeDuration;
+}
+
++ (FUIStorageImageDecodePool *)sharedPool {
+  static dispatch_once_t onceToken;
+  static FUIStorageImageDecodePool *pool;
+  dispatch_once(&onceToken, ^{
+    pool = [[FUIStorageImageDecodePool alloc] init];
+  });
+  return pool;
+}
+
+- (instancetype)init {
+  return [self initWithMaxConcurrentDecodeCount:[NSProcessInfo processInfo].activeProcessorCount];
+}
+
+- (instancetype)initWithMaxConcurrentDecodeCount:(NSUInteger)maxConcurrentDecodeCount {
+  NSParameterAssert(maxConcurrentDecodeCount > 0);
+  self = [super init];
+  if (self) {
+    _maxConcurrentDecodeCount = MAX(maxConcurrentDecodeCount, 1);
+    _queue = [[NSOperationQueue alloc] init];
+    _queue.name = @"com.firebaseui.storage.decode";
+    _queue.maxConcurrentOperationCount = _maxConcurrentDecodeCount;
+    _queue.qualityOfService = NSQualityOfServiceUserInitiated;
+    _lock = [[NSLock alloc] init];
+  }
+  return self;
+}
+
+- (NSOperation *)addDecodeWithPriority:(FUIStorageImagePriority)priority
+                            dependency:(NSOperation *)dependency
+                                 block:(dispatch_block_t)block {
+  FUIStorageImageDecodeOperation *operation =
+      [[FUIStorageImageDecodeOperation alloc] initWithPool:self block:block];
+  operation.queuePriority = FUIStorageImageDecodeQueuePriority(priority);
+  if (dependency) {
+    [operation addDependency:dependency];
+  }
+
+  [_lock lock];
+  _queuedDecodeCount += 1;
+  _peakQueuedDecodeCount = MAX(_peakQueuedDecodeCount, _queuedDecodeCount);
+  [_lock unlock];
+
+  [_queue addOperation:operation];
+  return operation;
+}
+
+#pragma mark - Statistics
+
+- (void)decodeDidStartAfterWaiting:(NSTimeInterval)wait {
+  [_lock lock];
+  _queuedDecodeCount -= 1;
+  _startedDecodeCount += 1;
+  _totalQueueLatency += wait;
+  [_lock unlock];
+}
+
+- (void)decodeDidFinishWithDuration:(NSTimeInterval)duration {
+  [_lock lock];
+  _completedDecodeCount += 1;
+  _totalDecodeDuration += duration;
+  [_lock unlock];
+}
+
+- (void)decodeWasDropped {
+  [_lock lock];
+  _queuedDecodeCount -= 1;
+  _droppedDecodeCount += 1;
+  [_lock unlock];
+}
+
+- (NSUInteger)queuedDecodeCount {
+  [_lock lock];
+  NSUInteger count = _queuedDecodeCount;
+  [_lock unlock];
+  return count;
+}
+
+- (NSUInteger)peakQueuedDecodeCount {
+  [_lock lock];
+  NSUInteger count = _peakQueuedDecodeCount;
+  [_lock unlock];
+  return count;
+}
+
+- (NSUInteger)completedDecodeCount {
+  [_lock lock];
+  NSUInteger count = _completedDecodeCount;
+  [_lock unlock];
+  return count;
+}
+
+- (NSUInteger)droppedDecodeCount {
+  [_lock lock];
+  NSUInteger count = _droppedDecodeCount;
+  [_lock unlock];
+  return count;
+}
+
+- (NSTimeInterval)averageQueueLatency {
+  [_lock lock];
+  NSTimeInterval average = _startedDecodeCount > 0 ? _totalQueueLatency / _startedDecodeCount : 0;
+  [_lock unlock];
+  return average;
+}
+
+- (NSTimeInterval)averageDecodeDuration {
+  [_lock lock];
+  NSTimeInterval average =
+      _completedDecodeCount > 0 ? _totalDecodeDuration / _completedDecodeCount : 0;
+  [_lock unlock];
+  return average;
+}
+
+- (void)resetStatistics {
+  [_lock lock];
+  _peakQueuedDecodeCount = _queuedDecodeCount;
+  _completedDecodeCount = 0;
+  _droppedDecodeCount = 0;
+  _startedDecodeCount = 0;
+  _totalQueueLatency = 0;
+  _totalDecodeDuration = 0;
+  [_lock unlock];
+}
+
+@end
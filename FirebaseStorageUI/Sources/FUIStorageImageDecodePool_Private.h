@@ -0,0 +1,43 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImageDecodePool.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Returns the queue priority decodes with the given priority are scheduled at.
+ */
+NSOperationQueuePriority FUIStorageImageDecodeQueuePriority(FUIStorageImagePriority priority);
+
+@interface FUIStorageImageDecodePool ()
+
+/**
+ * Schedules a decode. Cancelling the returned operation before it starts drops the
+ * decode; the operation's queuePriority can be raised while it's waiting.
+ *
+ * @param priority   The priority the decode starts with.
+ * @param dependency An operation that must finish before the decode can start, if any.
+ * @param block      The decode.
+ */
+- (NSOperation *)addDecodeWithPriority:(FUIStorageImagePriority)priority
+                            dependency:(nullable NSOperation *)dependency
+                                 block:(dispatch_block_t)block;
+
+@end
+
+NS_ASSUME_NONNULL_END
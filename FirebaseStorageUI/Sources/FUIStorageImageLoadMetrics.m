@@ -0,0 +1,379 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadMetrics_Private.h"
+
+// Buckets 0-16 hold durations up to 2^i milliseconds; the last one holds the rest.
+static const NSUInteger FUIStorageImageLoadHistogramBucketCount = 18;
+
+// Returns the time between two marks, or 0 if either wasn't reached.
+static NSTimeInterval FUIStorageImageLoadDuration(NSTimeInterval from, NSTimeInterval to) {
+  if (from <= 0 || to <= 0) {
+    return 0;
+  }
+  return MAX(to - from, 0);
+}
+
+static NSTimeInterval FUIStorageImageLoadNow(void) {
+  return [NSProcessInfo processInfo].systemUptime;
+}
+
+@implementation FUIStorageImageLoadMetrics {
+  // Guarded by @synchronized (self). Marks are system uptimes, or 0 if not reached.
+  NSTimeInterval _requestTime;
+  NSTimeInterval _resolvedTime;
+  NSTimeInterval _queuedTime;
+  NSTimeInterval _startTime;
+  NSTimeInterval _firstByteTime;
+  NSTimeInterval _transferEndTime;
+  NSTimeInterval _decodeStartTime;
+  NSTimeInterval _decodeEndTime;
+  NSTimeInterval _endTime;
+  void (^_reportHandler)(FUIStorageImageLoadMetrics *);
+}
+
+@synthesize outcome = _outcome;
+@synthesize error = _error;
+@synthesize coalescedRequestCount = _coalescedRequestCount;
+@synthesize receivedByteCount = _receivedByteCount;
+@synthesize expectedByteCount = _expectedByteCount;
+
+- (instancetype)initWithURL:(NSURL *)URL
+              reportHandler:(void (^)(FUIStorageImageLoadMetrics *))reportHandler {
+  self = [super init];
+  if (self) {
+    _URL = [URL copy];
+    _reportHandler = [reportHandler copy];
+    _requestTime = FUIStorageImageLoadNow();
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+#pragma mark - Recording
+
+- (void)markResolved {
+  @synchronized (self) {
+    _resolvedTime = FUIStorageImageLoadNow();
+  }
+}
+
+- (void)markQueued {
+  @synchronized (self) {
+    _queuedTime = FUIStorageImageLoadNow();
+  }
+}
+
+- (void)markStarted {
+  @synchronized (self) {
+    _startTime = FUIStorageImageLoadNow();
+  }
+}
+
+- (void)markReceivedSize:(int64_t)receivedSize expectedSize:(int64_t)expectedSize {
+  @synchronized (self) {
+    if (receivedSize > 0 && _firstByteTime == 0) {
+      _firstByteTime = FUIStorageImageLoadNow();
+    }
+    _receivedByteCount = MAX(_receivedByteCount, receivedSize);
+    _expectedByteCount = MAX(_expectedByteCount, expectedSize);
+  }
+}
+
+- (void)markTransferFinishedWithByteCount:(int64_t)byteCount {
+  @synchronized (self) {
+    NSTimeInterval now = FUIStorageImageLoadNow();
+    // Downloads that arrive in one piece may not report progress first.
+    if (byteCount > 0 && _firstByteTime == 0) {
+      _firstByteTime = now;
+    }
+    _transferEndTime = now;
+    _receivedByteCount = MAX(_receivedByteCount, byteCount);
+  }
+}
+
+- (void)markDecodeStarted {
+  @synchronized (self) {
+    _decodeStartTime = FUIStorageImageLoadNow();
+  }
+}
+
+- (void)markDecodeFinished {
+  @synchronized (self) {
+    _decodeEndTime = FUIStorageImageLoadNow();
+  }
+}
+
+- (void)incrementCoalescedRequestCount {
+  @synchronized (self) {
+    _coalescedRequestCount += 1;
+  }
+}
+
+- (void)finishWithOutcome:(FUIStorageImageLoadOutcome)outcome error:(NSError *)error {
+  void (^reportHandler)(FUIStorageImageLoadMetrics *);
+  @synchronized (self) {
+    if (_endTime > 0) {
+      return;
+    }
+    _endTime = FUIStorageImageLoadNow();
+    _outcome = outcome;
+    _error = error;
+    reportHandler = _reportHandler;
+    _reportHandler = nil;
+  }
+  if (reportHandler) {
+    reportHandler(self);
+  }
+}
+
+#pragma mark - Accessors
+
+- (FUIStorageImageLoadOutcome)outcome {
+  @synchronized (self) {
+    return _outcome;
+  }
+}
+
+- (NSError *)error {
+  @synchronized (self) {
+    return _error;
+  }
+}
+
+- (NSUInteger)coalescedRequestCount {
+  @synchronized (self) {
+    return _coalescedRequestCount;
+  }
+}
+
+- (int64_t)receivedByteCount {
+  @synchronized (self) {
+    return _receivedByteCount;
+  }
+}
+
+- (int64_t)expectedByteCount {
+  @synchronized (self) {
+    return _expectedByteCount;
+  }
+}
+
+- (NSTimeInterval)resolveDuration {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_requestTime, _resolvedTime);
+  }
+}
+
+- (NSTimeInterval)queueDuration {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_queuedTime, _startTime);
+  }
+}
+
+- (NSTimeInterval)timeToFirstByte {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_startTime, _firstByteTime);
+  }
+}
+
+- (NSTimeInterval)transferDuration {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_firstByteTime, _transferEndTime);
+  }
+}
+
+- (NSTimeInterval)decodeDuration {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_decodeStartTime, _decodeEndTime);
+  }
+}
+
+- (NSTimeInterval)totalDuration {
+  @synchronized (self) {
+    return FUIStorageImageLoadDuration(_requestTime, _endTime);
+  }
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p; URL = %@; outcome = %ld; bytes = %lld; "
+                                    @"resolve = %.3fs; queue = %.3fs; ttfb = %.3fs; "
+                                    @"transfer = %.3fs; decode = %.3fs; total = %.3fs>",
+          NSStringFromClass(self.class), self, self.URL, (long)self.outcome,
+          self.receivedByteCount, self.resolveDuration, self.queueDuration,
+          self.timeToFirstByte, self.transferDuration, self.decodeDuration, self.totalDuration];
+}
+
+@end
+
+@implementation FUIStorageImageLoadHistogram {
+  // Guarded by @synchronized (self).
+  NSUInteger _buckets[FUIStorageImageLoadHistogramBucketCount];
+  NSUInteger _count;
+}
+
+- (NSUInteger)count {
+  @synchronized (self) {
+    return _count;
+  }
+}
+
+- (NSArray<NSNumber *> *)bucketCounts {
+  NSMutableArray<NSNumber *> *counts =
+      [NSMutableArray arrayWithCapacity:FUIStorageImageLoadHistogramBucketCount];
+  @synchronized (self) {
+    for (NSUInteger i = 0; i < FUIStorageImageLoadHistogramBucketCount; i++) {
+      [counts addObject:@(_buckets[i])];
+    }
+  }
+  return [counts copy];
+}
+
+- (void)recordDuration:(NSTimeInterval)duration {
+  double milliseconds = MAX(duration, 0) * 1000;
+  NSUInteger bucket = 0;
+  if (milliseconds > 1) {
+    bucket = MIN((NSUInteger)ceil(log2(milliseconds)), FUIStorageImageLoadHistogramBucketCount - 1);
+  }
+  @synchronized (self) {
+    _buckets[bucket] += 1;
+    _count += 1;
+  }
+}
+
+- (NSTimeInterval)durationAtPercentile:(double)percentile {
+  @synchronized (self) {
+    if (_count == 0) {
+      return 0;
+    }
+    double clamped = MIN(MAX(percentile, 0), 100);
+    NSUInteger target = MAX((NSUInteger)ceil(clamped / 100 * _count), 1);
+    NSUInteger seen = 0;
+    for (NSUInteger i = 0; i < FUIStorageImageLoadHistogramBucketCount; i++) {
+      seen += _buckets[i];
+      if (seen >= target) {
+        NSUInteger bound = MIN(i, FUIStorageImageLoadHistogramBucketCount - 2);
+        return ldexp(1, (int)bound) / 1000;
+      }
+    }
+    return ldexp(1, (int)FUIStorageImageLoadHistogramBucketCount - 2) / 1000;
+  }
+}
+
+- (void)reset {
+  @synchronized (self) {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+  }
+}
+
+@end
+
+@implementation FUIStorageImageLoadMetricsAggregator {
+  // Guarded by @synchronized (self).
+  NSUInteger _outcomeCounts[FUIStorageImageLoadOutcomeCoalesced + 1];
+  NSUInteger _coalescedRequestCount;
+  int64_t _receivedByteCount;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _resolveHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+    _queueHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+    _timeToFirstByteHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+    _transferHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+    _decodeHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+    _totalHistogram = [[FUIStorageImageLoadHistogram alloc] init];
+  }
+  return self;
+}
+
+- (void)imageLoader:(FUIStorageImageLoader *)loader didCollectMetrics:(FUIStorageImageLoadMetrics *)metrics {
+  FUIStorageImageLoadOutcome outcome = metrics.outcome;
+  @synchronized (self) {
+    if (outcome >= 0 && outcome <= FUIStorageImageLoadOutcomeCoalesced) {
+      _outcomeCounts[outcome] += 1;
+    }
+    _coalescedRequestCount += metrics.coalescedRequestCount;
+    _receivedByteCount += metrics.receivedByteCount;
+  }
+  NSTimeInterval duration;
+  if ((duration = metrics.resolveDuration) > 0) {
+    [self.resolveHistogram recordDuration:duration];
+  }
+  if ((duration = metrics.queueDuration) > 0) {
+    [self.queueHistogram recordDuration:duration];
+  }
+  if ((duration = metrics.timeToFirstByte) > 0) {
+    [self.timeToFirstByteHistogram recordDuration:duration];
+  }
+  if ((duration = metrics.transferDuration) > 0) {
+    [self.transferHistogram recordDuration:duration];
+  }
+  if ((duration = metrics.decodeDuration) > 0) {
+    [self.decodeHistogram recordDuration:duration];
+  }
+  if (outcome == FUIStorageImageLoadOutcomeDownloaded || outcome == FUIStorageImageLoadOutcomeNotModified ||
+      (outcome == FUIStorageImageLoadOutcomeCoalesced && metrics.error == nil)) {
+    [self.totalHistogram recordDuration:metrics.totalDuration];
+  }
+}
+
+- (NSUInteger)loadCountForOutcome:(FUIStorageImageLoadOutcome)outcome {
+  if (outcome < 0 || outcome > FUIStorageImageLoadOutcomeCoalesced) {
+    return 0;
+  }
+  @synchronized (self) {
+    return _outcomeCounts[outcome];
+  }
+}
+
+- (NSUInteger)coalescedRequestCount {
+  @synchronized (self) {
+    return _coalescedRequestCount;
+  }
+}
+
+- (int64_t)receivedByteCount {
+  @synchronized (self) {
+    return _receivedByteCount;
+  }
+}
+
+- (void)reset {
+  @synchronized (self) {
+    memset(_outcomeCounts, 0, sizeof(_outcomeCounts));
+    _coalescedRequestCount = 0;
+    _receivedByteCount = 0;
+  }
+  [self.resolveHistogram reset];
+  [self.queueHistogram reset];
+  [self.timeToFirstByteHistogram reset];
+  [self.transferHistogram reset];
+  [self.decodeHistogram reset];
+  [self.totalHistogram reset];
+}
+
+@end
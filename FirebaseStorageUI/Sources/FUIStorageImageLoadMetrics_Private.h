@@ -0,0 +1,60 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImageLoadMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Recording side of FUIStorageImageLoadMetrics. Phases may be marked from any thread.
+ */
+@interface FUIStorageImageLoadMetrics ()
+
+/**
+ * Initializes metrics whose total duration starts now. The report handler is
+ * invoked once, when the load ends.
+ */
+- (instancetype)initWithURL:(NSURL *)URL
+              reportHandler:(void (^)(FUIStorageImageLoadMetrics *metrics))reportHandler NS_DESIGNATED_INITIALIZER;
+
+- (void)markResolved;
+
+- (void)markQueued;
+
+- (void)markStarted;
+
+/**
+ * Marks the first bytes, the first time it's called with a positive received size.
+ */
+- (void)markReceivedSize:(int64_t)receivedSize expectedSize:(int64_t)expectedSize;
+
+- (void)markTransferFinishedWithByteCount:(int64_t)byteCount;
+
+- (void)markDecodeStarted;
+
+- (void)markDecodeFinished;
+
+- (void)incrementCoalescedRequestCount;
+
+/**
+ * Ends the load and reports the metrics. Later calls have no effect.
+ */
+- (void)finishWithOutcome:(FUIStorageImageLoadOutcome)outcome error:(nullable NSError *)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,192 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <SDWebImage/SDWebImage.h>
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageDefine.h"
+#import "FirebaseStorageUI/Sources/FUIStorageObjectVersionCache.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadMetrics_Private.h"
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  @import FirebaseStorage;
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUIStorageImageLoadOperation;
+
+/**
+ * One caller's subscription to a shared FUIStorageImageLoadOperation. This is the
+ * operation FUIStorageImageLoader hands back to SDWebImage; cancelling it only
+ * unsubscribes its caller, and the shared download is cancelled once every
+ * subscriber has gone away.
+ */
+@interface FUIStorageImageLoadToken : NSObject <SDWebImageOperation>
+
+/**
+ * The download shared by all of the operation's subscribers, if it has started.
+ */
+@property (nonatomic, readonly, nullable) FIRStorageDownloadTask *downloadTask;
+
+/**
+ * Whether the subscriber has been cancelled.
+ */
+@property (nonatomic, readonly, getter=isCancelled) BOOL cancelled;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * A download and decode of a single Storage object that is shared by every request
+ * for it made while it's in flight. Subscribers can be added from any thread until
+ * the operation finishes. Completion blocks are invoked on the main queue, and
+ * progress blocks on the queue that reports the download's progress.
+ */
+@interface FUIStorageImageLoadOperation : NSObject
+
+/**
+ * The key the loader uses to find in-flight operations.
+ */
+@property (nonatomic, readonly, copy) NSString *key;
+
+/**
+ * The underlying download. Setting a download after the last subscriber has
+ * cancelled cancels it immediately.
+ */
+@property (atomic, strong, nullable) FIRStorageDownloadTask *downloadTask;
+
+/**
+ * The underlying streamed download, for progressive loads. Like downloadTask, it's
+ * cancelled immediately if it's set after the last subscriber has cancelled.
+ */
+@property (atomic, strong, nullable) id<SDWebImageOperation> streamingTask;
+
+/**
+ * The highest priority any subscriber has requested.
+ */
+@property (atomic, readonly) FUIStorageImagePriority priority;
+
+/**
+ * The operation's decode while it's waiting to run or running, if any. It's
+ * cancelled along with the operation, and its queue priority follows the
+ * operation's priority.
+ */
+@property (atomic, strong, nullable) NSOperation *decodeOperation;
+
+/**
+ * The number of bytes downloaded so far, as last reported through
+ * sendProgressWithReceivedSize:expectedSize:.
+ */
+@property (atomic, readonly) int64_t receivedSize;
+
+/**
+ * The version of the object being downloaded, if known. It's stored with the
+ * decoded image so the image can be revalidated later.
+ */
+@property (atomic, copy, nullable) FUIStorageObjectVersion *objectVersion;
+
+/**
+ * The operation's metrics, if the loader is collecting them. Progress and the
+ * outcome are recorded by the operation; the loader records the other phases.
+ */
+@property (atomic, strong, nullable) FUIStorageImageLoadMetrics *metrics;
+
+/**
+ * Invoked once when the last subscriber cancels before the operation finishes,
+ * before the download is cancelled.
+ */
+@property (nonatomic, copy, nullable) void (^cancellationHandler)(FUIStorageImageLoadOperation *operation);
+
+- (instancetype)initWithKey:(NSString *)key
+                   priority:(FUIStorageImagePriority)priority NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Subscribes to the operation, raising its priority to the subscriber's if that's
+ * higher. Returns nil if the operation has already finished or been cancelled, in
+ * which case the caller should start a new operation.
+ * @param metrics The metrics of a subscriber that joins the operation in flight, which
+ *     are finished as coalesced when the operation finishes, or as cancelled if the
+ *     subscriber cancels first. Nil for the subscriber that started the operation.
+ */
+- (nullable FUIStorageImageLoadToken *)addSubscriberWithURL:(NSURL *)url
+                                                   priority:(FUIStorageImagePriority)priority
+                                                    metrics:(nullable FUIStorageImageLoadMetrics *)metrics
+                                                   progress:(nullable SDImageLoaderProgressBlock)progressBlock
+                                                  completed:(nullable SDImageLoaderCompletedBlock)completedBlock;
+
+/**
+ * Sends download progress to every subscriber.
+ */
+- (void)sendProgressWithReceivedSize:(NSInteger)receivedSize expectedSize:(NSInteger)expectedSize;
+
+/**
+ * Sends a partially decoded image to every subscriber without finishing the operation.
+ */
+- (void)sendPartialImage:(UIImage *)image data:(NSData *)data;
+
+/**
+ * Finishes the operation and sends its result to every subscriber. Later calls
+ * have no effect.
+ */
+- (void)finishWithImage:(nullable UIImage *)image
+                   data:(nullable NSData *)data
+                  error:(nullable NSError *)error;
+
+@end
+
+/**
+ * A request that first checks whether the object behind a cached image has changed.
+ * If it hasn't, the request completes with SDWebImageErrorCacheNotModified so the
+ * cached image is kept; otherwise it starts a load, which cancelling the request
+ * cancels too.
+ */
+@interface FUIStorageImageRevalidationOperation : NSObject <SDWebImageOperation>
+
+/**
+ * The load started after the object turned out to have changed, if any.
+ */
+@property (atomic, readonly, nullable) id<SDWebImageOperation> loadOperation;
+
+/**
+ * Whether the request has been cancelled.
+ */
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+- (instancetype)initWithCompletion:(nullable SDImageLoaderCompletedBlock)completedBlock NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Completes the request with SDWebImageErrorCacheNotModified unless it has been
+ * cancelled.
+ */
+- (void)finishNotModified;
+
+/**
+ * Starts the load unless the request has been cancelled.
+ */
+- (void)startLoadOperation:(id<SDWebImageOperation> _Nullable (^)(void))startBlock;
+
+@end
+
+NS_ASSUME_NONNULL_END
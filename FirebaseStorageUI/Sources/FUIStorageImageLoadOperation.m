@@ -0,0 +1,341 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadOperation.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageDecodePool_Private.h"
+
+@interface FUIStorageImageLoadToken ()
+
+@property (nonatomic, readonly, weak) FUIStorageImageLoadOperation *operation;
+@property (nonatomic, readonly) NSURL *url;
+@property (nonatomic, readonly, nullable) FUIStorageImageLoadMetrics *metrics;
+@property (nonatomic, readonly, copy, nullable) SDImageLoaderProgressBlock progressBlock;
+@property (nonatomic, readonly, copy, nullable) SDImageLoaderCompletedBlock completedBlock;
+@property (atomic, readwrite, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@interface FUIStorageImageLoadOperation ()
+
+@property (atomic, readwrite) FUIStorageImagePriority priority;
+@property (atomic, readwrite) int64_t receivedSize;
+
+- (void)cancelSubscriber:(FUIStorageImageLoadToken *)token;
+
+@end
+
+@implementation FUIStorageImageLoadToken
+
+- (instancetype)initWithOperation:(FUIStorageImageLoadOperation *)operation
+                              url:(NSURL *)url
+                          metrics:(FUIStorageImageLoadMetrics *)metrics
+                         progress:(SDImageLoaderProgressBlock)progressBlock
+                        completed:(SDImageLoaderCompletedBlock)completedBlock {
+  self = [super init];
+  if (self) {
+    _operation = operation;
+    _url = url;
+    _metrics = metrics;
+    _progressBlock = [progressBlock copy];
+    _completedBlock = [completedBlock copy];
+  }
+  return self;
+}
+
+- (FIRStorageDownloadTask *)downloadTask {
+  return self.operation.downloadTask;
+}
+
+- (void)cancel {
+  [self.operation cancelSubscriber:self];
+}
+
+@end
+
+@implementation FUIStorageImageLoadOperation {
+  // Guards _subscribers, _finished and _cancelled.
+  NSLock *_lock;
+  NSMutableArray<FUIStorageImageLoadToken *> *_subscribers;
+  BOOL _finished;
+  BOOL _cancelled;
+}
+
+@synthesize downloadTask = _downloadTask;
+@synthesize streamingTask = _streamingTask;
+
+- (instancetype)initWithKey:(NSString *)key priority:(FUIStorageImagePriority)priority {
+  self = [super init];
+  if (self) {
+    _key = [key copy];
+    _priority = priority;
+    _lock = [[NSLock alloc] init];
+    _subscribers = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (FIRStorageDownloadTask *)downloadTask {
+  [_lock lock];
+  FIRStorageDownloadTask *downloadTask = _downloadTask;
+  [_lock unlock];
+  return downloadTask;
+}
+
+- (void)setDownloadTask:(FIRStorageDownloadTask *)downloadTask {
+  [_lock lock];
+  _downloadTask = downloadTask;
+  BOOL cancelled = _cancelled;
+  [_lock unlock];
+  // Everyone went away before the download was started.
+  if (cancelled) {
+    [downloadTask cancel];
+  }
+}
+
+- (id<SDWebImageOperation>)streamingTask {
+  [_lock lock];
+  id<SDWebImageOperation> streamingTask = _streamingTask;
+  [_lock unlock];
+  return streamingTask;
+}
+
+- (void)setStreamingTask:(id<SDWebImageOperation>)streamingTask {
+  [_lock lock];
+  _streamingTask = streamingTask;
+  BOOL cancelled = _cancelled;
+  [_lock unlock];
+  if (cancelled) {
+    [streamingTask cancel];
+  }
+}
+
+- (FUIStorageImageLoadToken *)addSubscriberWithURL:(NSURL *)url
+                                          priority:(FUIStorageImagePriority)priority
+                                           metrics:(FUIStorageImageLoadMetrics *)metrics
+                                          progress:(SDImageLoaderProgressBlock)progressBlock
+                                         completed:(SDImageLoaderCompletedBlock)completedBlock {
+  FUIStorageImageLoadToken *token = [[FUIStorageImageLoadToken alloc] initWithOperation:self
+                                                                                    url:url
+                                                                                metrics:metrics
+                                                                               progress:progressBlock
+                                                                              completed:completedBlock];
+  [_lock lock];
+  BOOL joined = !_finished && !_cancelled;
+  BOOL raisesPriority = joined && priority > self.priority;
+  if (joined) {
+    [_subscribers addObject:token];
+  }
+  if (raisesPriority) {
+    self.priority = priority;
+  }
+  [_lock unlock];
+
+  // A prefetched image that's now on screen shouldn't wait behind other prefetches.
+  if (raisesPriority) {
+    self.decodeOperation.queuePriority = FUIStorageImageDecodeQueuePriority(priority);
+  }
+  return joined ? token : nil;
+}
+
+- (void)cancelSubscriber:(FUIStorageImageLoadToken *)token {
+  [_lock lock];
+  if (_finished || token.isCancelled) {
+    [_lock unlock];
+    return;
+  }
+  token.cancelled = YES;
+  [_subscribers removeObjectIdenticalTo:token];
+  BOOL cancelOperation = _subscribers.count == 0;
+  if (cancelOperation) {
+    _cancelled = YES;
+  }
+  FIRStorageDownloadTask *downloadTask = _downloadTask;
+  id<SDWebImageOperation> streamingTask = _streamingTask;
+  [_lock unlock];
+
+  [token.metrics finishWithOutcome:FUIStorageImageLoadOutcomeCancelled error:nil];
+  // Like SDWebImage's own downloader, report the cancellation to the subscriber.
+  SDImageLoaderCompletedBlock completedBlock = token.completedBlock;
+  if (completedBlock) {
+    NSError *error = [NSError errorWithDomain:SDWebImageErrorDomain
+                                         code:SDWebImageErrorCancelled
+                                     userInfo:@{NSLocalizedDescriptionKey : @"Operation cancelled by user during sending the request"}];
+    dispatch_main_async_safe(^{
+      completedBlock(nil, nil, error, YES);
+    });
+  }
+
+  if (cancelOperation) {
+    if (self.cancellationHandler) {
+      self.cancellationHandler(self);
+    }
+    [self.decodeOperation cancel];
+    [downloadTask cancel];
+    [streamingTask cancel];
+    [self.metrics finishWithOutcome:FUIStorageImageLoadOutcomeCancelled error:nil];
+  }
+}
+
+- (NSArray<FUIStorageImageLoadToken *> *)currentSubscribers {
+  [_lock lock];
+  NSArray<FUIStorageImageLoadToken *> *subscribers = _finished ? @[] : [_subscribers copy];
+  [_lock unlock];
+  return subscribers;
+}
+
+- (void)sendProgressWithReceivedSize:(NSInteger)receivedSize expectedSize:(NSInteger)expectedSize {
+  self.receivedSize = receivedSize;
+  [self.metrics markReceivedSize:receivedSize expectedSize:expectedSize];
+  for (FUIStorageImageLoadToken *token in [self currentSubscribers]) {
+    if (token.progressBlock) {
+      token.progressBlock(receivedSize, expectedSize, token.url);
+    }
+  }
+}
+
+- (void)sendPartialImage:(UIImage *)image data:(NSData *)data {
+  NSArray<FUIStorageImageLoadToken *> *subscribers = [self currentSubscribers];
+  dispatch_main_async_safe(^{
+    for (FUIStorageImageLoadToken *token in subscribers) {
+      // Subscribers may have cancelled since the image was decoded.
+      if (token.isCancelled || !token.completedBlock) { continue; }
+      token.completedBlock(image, data, nil, NO);
+    }
+  });
+}
+
+- (void)finishWithImage:(UIImage *)image data:(NSData *)data error:(NSError *)error {
+  [_lock lock];
+  if (_finished || _cancelled) {
+    [_lock unlock];
+    return;
+  }
+  _finished = YES;
+  NSArray<FUIStorageImageLoadToken *> *subscribers = [_subscribers copy];
+  [_subscribers removeAllObjects];
+  [_lock unlock];
+
+  [self.metrics finishWithOutcome:image ? FUIStorageImageLoadOutcomeDownloaded
+                                        : FUIStorageImageLoadOutcomeFailed
+                            error:error];
+  for (FUIStorageImageLoadToken *token in subscribers) {
+    [token.metrics finishWithOutcome:FUIStorageImageLoadOutcomeCoalesced error:error];
+  }
+
+  dispatch_main_async_safe(^{
+    for (FUIStorageImageLoadToken *token in subscribers) {
+      if (token.completedBlock) {
+        token.completedBlock(image, data, error, YES);
+      }
+    }
+  });
+}
+
+@end
+
+@implementation FUIStorageImageRevalidationOperation {
+  // All guarded by @synchronized (self). _finished is set once the request has
+  // completed or handed its completion to the load.
+  SDImageLoaderCompletedBlock _completedBlock;
+  id<SDWebImageOperation> _loadOperation;
+  BOOL _cancelled;
+  BOOL _finished;
+}
+
+- (instancetype)initWithCompletion:(SDImageLoaderCompletedBlock)completedBlock {
+  self = [super init];
+  if (self) {
+    _completedBlock = [completedBlock copy];
+  }
+  return self;
+}
+
+- (id<SDWebImageOperation>)loadOperation {
+  @synchronized (self) {
+    return _loadOperation;
+  }
+}
+
+- (BOOL)isCancelled {
+  @synchronized (self) {
+    return _cancelled;
+  }
+}
+
+- (void)cancel {
+  id<SDWebImageOperation> loadOperation;
+  SDImageLoaderCompletedBlock completedBlock;
+  @synchronized (self) {
+    if (_cancelled) {
+      return;
+    }
+    _cancelled = YES;
+    loadOperation = _loadOperation;
+    completedBlock = _finished ? nil : _completedBlock;
+    _finished = YES;
+  }
+  // A started load reports its own cancellation.
+  [loadOperation cancel];
+  if (completedBlock) {
+    NSError *error = [NSError errorWithDomain:SDWebImageErrorDomain
+                                         code:SDWebImageErrorCancelled
+                                     userInfo:@{NSLocalizedDescriptionKey : @"Operation cancelled by user during sending the request"}];
+    dispatch_main_async_safe(^{
+      completedBlock(nil, nil, error, YES);
+    });
+  }
+}
+
+- (void)finishNotModified {
+  SDImageLoaderCompletedBlock completedBlock;
+  @synchronized (self) {
+    if (_finished) {
+      return;
+    }
+    _finished = YES;
+    completedBlock = _completedBlock;
+  }
+  if (completedBlock) {
+    NSError *error = [NSError errorWithDomain:SDWebImageErrorDomain
+                                         code:SDWebImageErrorCacheNotModified
+                                     userInfo:@{NSLocalizedDescriptionKey : @"The Storage object has not changed since the image was cached"}];
+    dispatch_main_async_safe(^{
+      completedBlock(nil, nil, error, YES);
+    });
+  }
+}
+
+- (void)startLoadOperation:(id<SDWebImageOperation> (^)(void))startBlock {
+  @synchronized (self) {
+    if (_finished) {
+      return;
+    }
+    // The load takes over the request's completion.
+    _finished = YES;
+    _loadOperation = startBlock();
+  }
+}
+
+@end
@@ -16,6 +16,14 @@
 
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImageLoader.h"
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FIRStorageDownloadTask+SDWebImage.h"
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageReferenceCache.h"
+#import "FirebaseStorageUI/Sources/FUIStorageDefine_Private.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadOperation.h"
+#import "FirebaseStorageUI/Sources/FUIStorageObjectVersionCache.h"
+#import "FirebaseStorageUI/Sources/FUIStorageStreamingDownloader.h"
+#import "FirebaseStorageUI/Sources/FUIStorageRequestScheduler.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadMetrics_Private.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageDecodePool_Private.h"
 
 #import <FirebaseCore/FirebaseCore.h>
 #if __has_include(<FirebaseStorage/FirebaseStorage.h>)
@@ -28,26 +36,77 @@
   @import FirebaseStorage;
 #endif
 
-#if SWIFT_PACKAGE
-@import GTMSessionFetcherCore;
-#else
-#import <GTMSessionFetcher/GTMSessionFetcher.h>
-#endif // SWIFT_PACKAGE
-
 @interface NSURL ()
 
 @property (nonatomic, strong, readwrite, nullable) FIRStorageReference *sd_storageReference;
 
 @end
 
-@interface FIRStorageTask ()
+// The options that change how downloaded data is decoded. Requests that differ in
+// any of these can't share a decoded image.
+static const SDWebImageOptions FUIStorageImageDecodeOptions =
+    SDWebImageProgressiveLoad | SDWebImageDecodeFirstFrameOnly | SDWebImagePreloadAllFrames |
+    SDWebImageAvoidDecodeImage | SDWebImageScaleDownLargeImages | SDWebImageMatchAnimatedImageClass;
+
+// Returns the key under which requests for the same object share a single download
+// and decode.
+static NSString *FUIStorageImageLoadKey(FIRStorageReference *storageRef,
+                                        UInt64 maxSize,
+                                        SDWebImageOptions options,
+                                        SDWebImageContext *context) {
+  NSMutableString *key = [NSMutableString stringWithFormat:@"gs://%@/%@|%llu|%lu",
+                          storageRef.bucket, storageRef.fullPath, maxSize,
+                          (unsigned long)(options & FUIStorageImageDecodeOptions)];
+  NSArray<SDWebImageContextOption> *decodeContextOptions = @[
+    SDWebImageContextImageScaleFactor,
+    SDWebImageContextImagePreserveAspectRatio,
+    SDWebImageContextImageThumbnailPixelSize,
+    SDWebImageContextAnimatedImageClass,
+  ];
+  for (SDWebImageContextOption option in decodeContextOptions) {
+    id value = context[option];
+    if (value) {
+      [key appendFormat:@"|%@=%@", option, value];
+    }
+  }
+  return key;
+}
+
+static FUIStorageImagePriority FUIStorageImagePriorityForRequest(SDWebImageOptions options,
+                                                                 SDWebImageContext *context) {
+  NSNumber *priority = context[SDWebImageContextFUIStorageImagePriority];
+  if (priority) {
+    return (FUIStorageImagePriority)priority.integerValue;
+  }
+  return (options & SDWebImageLowPriority) ? FUIStorageImagePriorityBackground
+                                           : FUIStorageImagePriorityVisible;
+}
+
+@interface FUIStorageImageLoader ()
+
+/// The operations that are currently downloading or decoding, by load key.
+/// Guarded by operationsLock, as are updates to the counters below.
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, FUIStorageImageLoadOperation *> *operations;
+@property (nonatomic, readonly) NSLock *operationsLock;
+
+/// The current versions of objects, used to revalidate cached images.
+@property (nonatomic, readonly) FUIStorageObjectVersionCache *versionCache;
+
+/// Decides when downloads start.
+@property (nonatomic, readonly) FUIStorageRequestScheduler *scheduler;
 
-@property(strong, atomic) GTMSessionFetcher *fetcher;
+/// Streams progressive loads. Created on first use with streamingSessionConfiguration.
+@property (nonatomic, readonly) FUIStorageStreamingDownloader *streamingDownloader;
+
+@property (atomic, readwrite) NSUInteger downloadCount;
+@property (atomic, readwrite) NSUInteger coalescedRequestCount;
 
 @end
 
 @implementation FUIStorageImageLoader
 
+@synthesize streamingDownloader = _streamingDownloader;
+
 + (FUIStorageImageLoader *)sharedLoader {
   static dispatch_once_t onceToken;
   static FUIStorageImageLoader *loader;
@@ -61,10 +120,67 @@
   self = [super init];
   if (self) {
     _defaultMaxImageSize = 10e6;
+    _decodePool = FUIStorageImageDecodePool.sharedPool;
+    _operations = [NSMutableDictionary dictionary];
+    _operationsLock = [[NSLock alloc] init];
+    _revalidationInterval = 300;
+    _progressiveDecodeInterval = 0.1;
+    _streamingSessionConfiguration = [NSURLSessionConfiguration defaultSessionConfiguration];
+    _versionCache = [[FUIStorageObjectVersionCache alloc] init];
+    _scheduler = [[FUIStorageRequestScheduler alloc] init];
+    _scheduler.maxConcurrentRequestsPerBucket = 6;
   }
   return self;
 }
 
+- (NSUInteger)maxConcurrentDownloadsPerBucket {
+  return self.scheduler.maxConcurrentRequestsPerBucket;
+}
+
+- (void)setMaxConcurrentDownloadsPerBucket:(NSUInteger)maxConcurrentDownloadsPerBucket {
+  self.scheduler.maxConcurrentRequestsPerBucket = maxConcurrentDownloadsPerBucket;
+}
+
+- (NSTimeInterval)downloadStartDelay {
+  return self.scheduler.startDelay;
+}
+
+- (void)setDownloadStartDelay:(NSTimeInterval)downloadStartDelay {
+  self.scheduler.startDelay = downloadStartDelay;
+}
+
+- (NSUInteger)unstartedCancellationCount {
+  return self.scheduler.unstartedCancellationCount;
+}
+
+- (int64_t)wastedByteCount {
+  return self.scheduler.wastedByteCount;
+}
+
+- (void)dealloc {
+  // The session retains the downloader until it's invalidated.
+  [_streamingDownloader invalidate];
+}
+
+- (FUIStorageStreamingDownloader *)streamingDownloader {
+  @synchronized (self) {
+    if (!_streamingDownloader) {
+      _streamingDownloader =
+          [[FUIStorageStreamingDownloader alloc] initWithSessionConfiguration:self.streamingSessionConfiguration];
+    }
+    return _streamingDownloader;
+  }
+}
+
+- (void)setStreamingSessionConfiguration:(NSURLSessionConfiguration *)streamingSessionConfiguration {
+  @synchronized (self) {
+    _streamingSessionConfiguration = [streamingSessionConfiguration copy];
+    // Loads already streaming finish on the old session.
+    [_streamingDownloader invalidate];
+    _streamingDownloader = nil;
+  }
+}
+
 #pragma mark - SDImageLoader Protocol
 
 - (BOOL)canRequestImageForURL:(NSURL *)url {
@@ -78,20 +194,24 @@
 }
 
 - (id<SDWebImageOperation>)requestImageWithURL:(NSURL *)url options:(SDWebImageOptions)options context:(SDWebImageContext *)context progress:(SDImageLoaderProgressBlock)progressBlock completed:(SDImageLoaderCompletedBlock)completedBlock {
+  // Only measure loads someone is listening to.
+  FUIStorageImageLoadMetrics *metrics = self.metricsObserver ? [self metricsForURL:url] : nil;
+  // Downsample while decoding when a target size is given.
+  context = FUIStorageImageContextApplyingTargetPixelSize(context);
   FIRStorageReference *storageRef = url.sd_storageReference;
-  if (!storageRef) {
+  if (!storageRef && url) {
     // Create Storage Reference from URL
-    NSString *bucketUrl = [NSString stringWithFormat:@"gs://%@", url.host];
-    FIRStorage *storage = [FIRStorage storageWithURL:bucketUrl];
-    storageRef = [storage referenceWithPath:url.path];
+    storageRef = [FUIStorageReferenceCache.sharedCache referenceForURL:url];
     url.sd_storageReference = storageRef;
   }
   
   if (!storageRef) {
+    NSError *error = [NSError errorWithDomain:SDWebImageErrorDomain code:SDWebImageErrorInvalidURL userInfo:@{NSLocalizedDescriptionKey : @"The provided image url must have an associated FIRStorageReference."}];
+    [metrics finishWithOutcome:FUIStorageImageLoadOutcomeFailed error:error];
     if (completedBlock) {
-      NSError *error = [NSError errorWithDomain:SDWebImageErrorDomain code:SDWebImageErrorInvalidURL userInfo:@{NSLocalizedDescriptionKey : @"The provided image url must have an associated FIRStorageReference."}];
       completedBlock(nil, nil, error, YES);
     }
+    return nil;
   }
   
   UInt64 size;
@@ -100,69 +220,346 @@
   } else {
     size = self.defaultMaxImageSize;
   }
+
+  if (!self.revalidatesCachedImages) {
+    [metrics markResolved];
+    return [self loadImageWithURL:url
+                       storageRef:storageRef
+                          maxSize:size
+                    objectVersion:nil
+                          metrics:metrics
+                          options:options
+                          context:context
+                         progress:progressBlock
+                        completed:completedBlock];
+  }
+
+  // Look up the object's current version before downloading, so it can be stored
+  // with the image. A cached image being refreshed is kept if its object hasn't
+  // changed since it was downloaded.
+  id cachedVersion = nil;
+  if (options & SDWebImageRefreshCached) {
+    UIImage *cachedImage = context[SDWebImageContextLoaderCachedImage];
+    cachedVersion = cachedImage.sd_extendedObject;
+  }
+  FUIStorageImageRevalidationOperation *revalidation =
+      [[FUIStorageImageRevalidationOperation alloc] initWithCompletion:completedBlock];
+  __weak typeof(self) weakSelf = self;
+  [self.versionCache fetchVersionForReference:storageRef
+                                       maxAge:self.revalidationInterval
+                                   completion:^(FUIStorageObjectVersion *version) {
+    [metrics markResolved];
+    if (revalidation.isCancelled) {
+      [metrics finishWithOutcome:FUIStorageImageLoadOutcomeCancelled error:nil];
+      return;
+    }
+    if (version && FUIStorageObjectIsVersion(cachedVersion) && [version isEqual:cachedVersion]) {
+      [metrics finishWithOutcome:FUIStorageImageLoadOutcomeNotModified error:nil];
+      [revalidation finishNotModified];
+      return;
+    }
+    // If the metadata couldn't be fetched, the download reports why.
+    [revalidation startLoadOperation:^id<SDWebImageOperation> {
+      return [weakSelf loadImageWithURL:url
+                             storageRef:storageRef
+                                maxSize:size
+                          objectVersion:version
+                                metrics:metrics
+                                options:options
+                                context:context
+                               progress:progressBlock
+                              completed:completedBlock];
+    }];
+  }];
+  return revalidation;
+}
+
+- (id<SDWebImageOperation>)loadImageWithURL:(NSURL *)url
+                                 storageRef:(FIRStorageReference *)storageRef
+                                    maxSize:(UInt64)size
+                              objectVersion:(FUIStorageObjectVersion *)objectVersion
+                                    metrics:(FUIStorageImageLoadMetrics *)metrics
+                                    options:(SDWebImageOptions)options
+                                    context:(SDWebImageContext *)context
+                                   progress:(SDImageLoaderProgressBlock)progressBlock
+                                  completed:(SDImageLoaderCompletedBlock)completedBlock {
+  // Join the download for the same object if one is already in flight, so an image
+  // shown in many places at once is only downloaded and decoded once.
+  NSString *key = FUIStorageImageLoadKey(storageRef, size, options, context);
+  FUIStorageImagePriority priority = FUIStorageImagePriorityForRequest(options, context);
+  [self.operationsLock lock];
+  FUIStorageImageLoadOperation *existing = self.operations[key];
+  FUIStorageImageLoadToken *token = [existing addSubscriberWithURL:url
+                                                          priority:priority
+                                                           metrics:metrics
+                                                          progress:progressBlock
+                                                         completed:completedBlock];
+  if (token) {
+    self.coalescedRequestCount += 1;
+    [self.operationsLock unlock];
+    [existing.metrics incrementCoalescedRequestCount];
+    return token;
+  }
+  FUIStorageImageLoadOperation *operation =
+      [[FUIStorageImageLoadOperation alloc] initWithKey:key priority:priority];
+  operation.objectVersion = objectVersion;
+  operation.metrics = metrics;
+  token = [operation addSubscriberWithURL:url
+                                 priority:priority
+                                  metrics:nil
+                                 progress:progressBlock
+                                completed:completedBlock];
+  self.operations[key] = operation;
+  self.downloadCount += 1;
+  [self.operationsLock unlock];
+
+  __weak typeof(self) weakSelf = self;
+  operation.cancellationHandler = ^(FUIStorageImageLoadOperation *cancelled) {
+    [weakSelf removeOperation:cancelled];
+    [weakSelf.scheduler cancelOperation:cancelled];
+  };
+  // The download may be held back, and never start if everyone cancels first.
+  [metrics markQueued];
+  [self.scheduler scheduleOperation:operation bucket:storageRef.bucket start:^{
+    [operation.metrics markStarted];
+    [weakSelf startTransferForOperation:operation
+                             storageRef:storageRef
+                                maxSize:size
+                                    url:url
+                                options:options
+                                context:context];
+  }];
+  return token;
+}
+
+- (void)startTransferForOperation:(FUIStorageImageLoadOperation *)operation
+                       storageRef:(FIRStorageReference *)storageRef
+                          maxSize:(UInt64)size
+                              url:(NSURL *)url
+                          options:(SDWebImageOptions)options
+                          context:(SDWebImageContext *)context {
+  if (options & SDWebImageProgressiveLoad) {
+    // FIRStorageDownloadTask doesn't expose partial data, so stream the object instead.
+    operation.streamingTask = [self startStreamingDownloadForOperation:operation
+                                                            storageRef:storageRef
+                                                               maxSize:size
+                                                                   url:url
+                                                               options:options
+                                                               context:context];
+  } else if (self.streamsDownloadsToDisk) {
+    operation.downloadTask = [self startFileDownloadForOperation:operation
+                                                      storageRef:storageRef
+                                                         maxSize:size
+                                                             url:url
+                                                         options:options
+                                                         context:context];
+  } else {
+    operation.downloadTask = [self startDownloadForOperation:operation
+                                                  storageRef:storageRef
+                                                     maxSize:size
+                                                         url:url
+                                                     options:options
+                                                     context:context];
+  }
+}
+
+- (void)transferDidFinishForOperation:(FUIStorageImageLoadOperation *)operation byteCount:(int64_t)byteCount {
+  [operation.metrics markTransferFinishedWithByteCount:byteCount];
+  [self.scheduler finishOperation:operation];
+}
+
+- (FUIStorageImageLoadMetrics *)metricsForURL:(NSURL *)url {
+  __weak typeof(self) weakSelf = self;
+  return [[FUIStorageImageLoadMetrics alloc] initWithURL:url
+                                           reportHandler:^(FUIStorageImageLoadMetrics *metrics) {
+    FUIStorageImageLoader *loader = weakSelf;
+    if (loader) {
+      [loader.metricsObserver imageLoader:loader didCollectMetrics:metrics];
+    }
+  }];
+}
+
+- (void)removeOperation:(FUIStorageImageLoadOperation *)operation {
+  [self.operationsLock lock];
+  // A newer operation may have replaced this one.
+  if (self.operations[operation.key] == operation) {
+    [self.operations removeObjectForKey:operation.key];
+  }
+  [self.operationsLock unlock];
+}
+
+- (FIRStorageDownloadTask *)startDownloadForOperation:(FUIStorageImageLoadOperation *)operation
+                                          storageRef:(FIRStorageReference *)storageRef
+                                             maxSize:(UInt64)size
+                                                 url:(NSURL *)url
+                                             options:(SDWebImageOptions)options
+                                             context:(SDWebImageContext *)context {
   // Download the image from Firebase Storage
-  // Each download task use independent serial coder queue, to ensure callback in order during prorgessive decoding
-  NSOperationQueue *coderQueue = [NSOperationQueue new];
-  coderQueue.maxConcurrentOperationCount = 1;
+  __weak typeof(self) weakSelf = self;
   FIRStorageDownloadTask * download = [storageRef dataWithMaxSize:size completion:^(NSData * _Nullable data, NSError * _Nullable error) {
+    [weakSelf transferDidFinishForOperation:operation byteCount:data ? (int64_t)data.length : operation.receivedSize];
     if (error) {
-      dispatch_main_async_safe(^{
-        if (completedBlock) {
-          completedBlock(nil, nil, error, YES);
-        }
-      });
+      [weakSelf removeOperation:operation];
+      [operation finishWithImage:nil data:nil error:error];
       return;
     }
-    // Decode the image with data
-    [coderQueue cancelAllOperations];
-    [coderQueue addOperationWithBlock:^{
-      UIImage *image = SDImageLoaderDecodeImageData(data, url, options, context);
-      dispatch_main_async_safe(^{
-        if (completedBlock) {
-          completedBlock(image, data, nil, YES);
-        }
-      });
-    }];
+    [weakSelf decodeData:data forOperation:operation url:url options:options context:context];
   }];
   // Observe the progress changes
   [download observeStatus:FIRStorageTaskStatusProgress handler:^(FIRStorageTaskSnapshot * _Nonnull snapshot) {
-    // Progressive decoding requires access to partial data via the internal GTMSessionFetcher,
-    // which was removed in Firebase Storage 9.0.0. Guard to prevent crash; progressive rendering
-    // is silently skipped on Firebase 9+.
-    if (options & SDWebImageProgressiveLoad) {
-      FIRStorageDownloadTask *task = (FIRStorageDownloadTask *)snapshot.task;
-      if ([task respondsToSelector:@selector(fetcher)]) {
-        GTMSessionFetcher *fetcher = [task performSelector:@selector(fetcher)];
-        NSData *partialData = [fetcher.downloadedData copy];
-        int64_t expectedSize = fetcher.response.expectedContentLength;
-        expectedSize = expectedSize > 0 ? expectedSize : 0;
-        int64_t receivedSize = fetcher.downloadedLength;
-        if (expectedSize != 0) {
-          BOOL finished = receivedSize >= expectedSize;
-          if (coderQueue.operationCount == 0) {
-            [coderQueue addOperationWithBlock:^{
-              UIImage *image = SDImageLoaderDecodeProgressiveImageData(partialData, url, finished, task, options, context);
-              if (image) {
-                dispatch_main_async_safe(^{
-                  if (completedBlock) {
-                    completedBlock(image, partialData, nil, NO);
-                  }
-                });
-              }
-            }];
-          }
-        }
+    NSProgress *progress = snapshot.progress;
+    [operation sendProgressWithReceivedSize:(NSInteger)progress.completedUnitCount
+                               expectedSize:(NSInteger)progress.totalUnitCount];
+  }];
+  
+  return download;
+}
+
+- (id<SDWebImageOperation>)startStreamingDownloadForOperation:(FUIStorageImageLoadOperation *)operation
+                                                   storageRef:(FIRStorageReference *)storageRef
+                                                      maxSize:(UInt64)size
+                                                          url:(NSURL *)url
+                                                      options:(SDWebImageOptions)options
+                                                      context:(SDWebImageContext *)context {
+  // Partial decodes run in the shared pool, at most one at a time per download and
+  // no more often than progressiveDecodeInterval, since each one decodes everything
+  // received so far. The final decode depends on the last partial one, to ensure
+  // callback in order.
+  FUIStorageImageDecodePool *decodePool = self.decodePool;
+  NSTimeInterval decodeInterval = self.progressiveDecodeInterval;
+  // Only touched on the downloader's serial queue.
+  __block NSTimeInterval lastDecodeTime = -DBL_MAX;
+  __weak typeof(self) weakSelf = self;
+  return [self.streamingDownloader streamReference:storageRef
+                                           maxSize:size
+                                          progress:^(FUIStorageStreamingTask *task,
+                                                     int64_t receivedSize,
+                                                     int64_t expectedSize) {
+    [operation sendProgressWithReceivedSize:(NSInteger)receivedSize
+                               expectedSize:(NSInteger)expectedSize];
+    if (expectedSize == 0 || receivedSize >= expectedSize) {
+      return;
+    }
+    NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+    NSOperation *previousDecode = operation.decodeOperation;
+    if (now - lastDecodeTime < decodeInterval || (previousDecode && !previousDecode.isFinished)) {
+      return;
+    }
+    lastDecodeTime = now;
+    NSData *partialData = [task receivedData];
+    operation.decodeOperation = [decodePool addDecodeWithPriority:operation.priority
+                                                       dependency:nil
+                                                            block:^{
+      UIImage *image = SDImageLoaderDecodeProgressiveImageData(partialData, url, NO, task, options, context);
+      if (image) {
+        [operation sendPartialImage:image data:partialData];
       }
+    }];
+  } completion:^(NSData *data, NSError *error) {
+    [weakSelf transferDidFinishForOperation:operation byteCount:data ? (int64_t)data.length : operation.receivedSize];
+    if (error) {
+      [weakSelf removeOperation:operation];
+      [operation finishWithImage:nil data:nil error:error];
+      return;
+    }
+    [weakSelf decodeData:data forOperation:operation url:url options:options context:context];
+  }];
+}
+
+- (FIRStorageDownloadTask *)startFileDownloadForOperation:(FUIStorageImageLoadOperation *)operation
+                                              storageRef:(FIRStorageReference *)storageRef
+                                                 maxSize:(UInt64)size
+                                                     url:(NSURL *)url
+                                                 options:(SDWebImageOptions)options
+                                                 context:(SDWebImageContext *)context {
+  NSString *fileName = [NSString stringWithFormat:@"FUIStorageImage-%@", [NSUUID UUID].UUIDString];
+  NSURL *fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]];
+  __weak typeof(self) weakSelf = self;
+  // Set when the size limit is exceeded, which finishes the operation right away.
+  // The completion then runs for the cancelled task and must do nothing. Storage
+  // calls both handlers on its serial callback queue.
+  __block BOOL exceededMaxSize = NO;
+  FIRStorageDownloadTask *download = [storageRef writeToFile:fileURL completion:^(NSURL * _Nullable URL, NSError * _Nullable error) {
+    if (exceededMaxSize) {
+      [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+      return;
+    }
+    [weakSelf transferDidFinishForOperation:operation byteCount:operation.receivedSize];
+    if (error) {
+      [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+      [weakSelf removeOperation:operation];
+      [operation finishWithImage:nil data:nil error:error];
+      return;
+    }
+    // Map the file instead of reading it, so the decode doesn't need a copy of the
+    // whole object in memory. The mapping stays valid after the file is removed.
+    // SDWebImage writes the returned data to its disk cache itself.
+    NSError *readError;
+    NSData *data = [NSData dataWithContentsOfURL:fileURL
+                                         options:NSDataReadingMappedIfSafe
+                                           error:&readError];
+    [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+    if (!data) {
+      [weakSelf removeOperation:operation];
+      [operation finishWithImage:nil data:nil error:readError];
+      return;
+    }
+    [weakSelf decodeData:data forOperation:operation url:url options:options context:context];
+  }];
+  // Unlike dataWithMaxSize:completion:, writing to a file has no size limit, so
+  // enforce it as the data arrives.
+  __weak FIRStorageDownloadTask *weakDownload = download;
+  [download observeStatus:FIRStorageTaskStatusProgress handler:^(FIRStorageTaskSnapshot * _Nonnull snapshot) {
+    if (exceededMaxSize) {
+      return;
     }
     NSProgress *progress = snapshot.progress;
-    if (progressBlock) {
-      progressBlock((NSInteger)progress.completedUnitCount,
-                    (NSInteger)progress.totalUnitCount,
-                    url);
+    if ((UInt64)MAX(progress.totalUnitCount, progress.completedUnitCount) > size) {
+      exceededMaxSize = YES;
+      NSString *description =
+          [NSString stringWithFormat:@"Attempted to download object with size of %lld bytes, "
+                                     @"which exceeds the maximum size of %llu bytes.",
+                                     MAX(progress.totalUnitCount, progress.completedUnitCount), size];
+      NSError *error = [NSError errorWithDomain:@"FIRStorageErrorDomain"
+                                           code:FIRStorageErrorCodeDownloadSizeExceeded
+                                       userInfo:@{NSLocalizedDescriptionKey : description}];
+      [weakSelf transferDidFinishForOperation:operation byteCount:operation.receivedSize];
+      [weakSelf removeOperation:operation];
+      [operation finishWithImage:nil data:nil error:error];
+      [weakDownload cancel];
+      return;
     }
+    [operation sendProgressWithReceivedSize:(NSInteger)progress.completedUnitCount
+                               expectedSize:(NSInteger)progress.totalUnitCount];
+  }];
+  return download;
+}
+
+- (void)decodeData:(NSData *)data
+      forOperation:(FUIStorageImageLoadOperation *)operation
+               url:(NSURL *)url
+           options:(SDWebImageOptions)options
+           context:(SDWebImageContext *)context {
+  // Decode the image with data, skipping any partial decode that hasn't started.
+  NSOperation *partialDecode = operation.decodeOperation;
+  [partialDecode cancel];
+  __weak typeof(self) weakSelf = self;
+  operation.decodeOperation = [self.decodePool addDecodeWithPriority:operation.priority
+                                                          dependency:partialDecode
+                                                               block:^{
+    [operation.metrics markDecodeStarted];
+    UIImage *image = SDImageLoaderDecodeImageData(data, url, options, context);
+    [operation.metrics markDecodeFinished];
+    // SDWebImage stores the extended object alongside the image in its disk cache.
+    FUIStorageObjectVersion *objectVersion = operation.objectVersion;
+    if (image && objectVersion && !image.sd_extendedObject) {
+      image.sd_extendedObject = objectVersion;
+    }
+    // Requests made from now on start a new download, so every subscriber that
+    // joined this one receives the result.
+    [weakSelf removeOperation:operation];
+    [operation finishWithImage:image data:data error:nil];
   }];
-  
-  return (id<SDWebImageOperation>)download;
 }
 
 - (BOOL)shouldBlockFailedURLWithURL:(NSURL *)url error:(NSError *)error {
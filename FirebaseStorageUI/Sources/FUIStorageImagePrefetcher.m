@@ -0,0 +1,179 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImagePrefetcher.h"
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageReferenceCache.h"
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/NSURL+FirebaseStorage.h"
+#import "FirebaseStorageUI/Sources/FUIStorageDefine_Private.h"
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  @import FirebaseStorage;
+#endif
+
+@implementation FUIStorageImagePrefetcher {
+  // Loads through the shared manager, so prefetched images land in the same cache
+  // that `UIImageView (FirebaseStorage)` reads from.
+  SDWebImagePrefetcher *_prefetcher;
+}
+
+@synthesize storage = _storage;
+
++ (FUIStorageImagePrefetcher *)sharedPrefetcher {
+  static dispatch_once_t onceToken;
+  static FUIStorageImagePrefetcher *prefetcher;
+  dispatch_once(&onceToken, ^{
+    prefetcher = [[FUIStorageImagePrefetcher alloc] init];
+  });
+  return prefetcher;
+}
+
+- (instancetype)init {
+  return [self initWithLoader:FUIStorageImageLoader.sharedLoader];
+}
+
+- (instancetype)initWithLoader:(FUIStorageImageLoader *)loader {
+  self = [super init];
+  if (self) {
+    _loader = loader;
+    _maxImageSize = loader.defaultMaxImageSize;
+    _prefetcher = [[SDWebImagePrefetcher alloc] initWithImageManager:SDWebImageManager.sharedManager];
+    _prefetcher.maxConcurrentPrefetchCount = 3;
+    // Low priority keeps the downloads behind the ones for images being shown.
+    _prefetcher.options = SDWebImageLowPriority;
+    [self updatePrefetcherContext];
+  }
+  return self;
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)maxConcurrentPrefetchCount {
+  return _prefetcher.maxConcurrentPrefetchCount;
+}
+
+- (void)setMaxConcurrentPrefetchCount:(NSUInteger)maxConcurrentPrefetchCount {
+  _prefetcher.maxConcurrentPrefetchCount = maxConcurrentPrefetchCount;
+}
+
+- (void)setMaxImageSize:(UInt64)maxImageSize {
+  _maxImageSize = maxImageSize;
+  [self updatePrefetcherContext];
+}
+
+- (void)setContext:(SDWebImageContext *)context {
+  _context = [context copy];
+  [self updatePrefetcherContext];
+}
+
+- (FIRStorage *)storage {
+  if (!_storage) {
+    _storage = [FIRStorage storage];
+  }
+  return _storage;
+}
+
+- (void)setStorage:(FIRStorage *)storage {
+  _storage = storage;
+}
+
+- (void)updatePrefetcherContext {
+  SDWebImageMutableContext *context = [NSMutableDictionary dictionaryWithDictionary:self.context ?: @{}];
+  context[SDWebImageContextImageLoader] = self.loader;
+  context[SDWebImageContextFUIStorageMaxImageSize] = @(self.maxImageSize);
+  context[SDWebImageContextFUIStorageImagePriority] = @(FUIStorageImagePriorityPrefetch);
+  // Translated here for the same cache key as `UIImageView (FirebaseStorage)`.
+  _prefetcher.context = [FUIStorageImageContextApplyingTargetPixelSize(context) copy];
+}
+
+#pragma mark - Prefetching
+
+- (SDWebImagePrefetchToken *)prefetchReferences:(NSArray<FIRStorageReference *> *)references {
+  return [self prefetchReferences:references progress:nil completed:nil];
+}
+
+- (SDWebImagePrefetchToken *)prefetchReferences:(NSArray<FIRStorageReference *> *)references
+                                       progress:(SDWebImagePrefetcherProgressBlock)progressBlock
+                                      completed:(SDWebImagePrefetcherCompletionBlock)completionBlock {
+  NSMutableArray<NSURL *> *urls = [NSMutableArray arrayWithCapacity:references.count];
+  for (FIRStorageReference *reference in references) {
+    NSURL *url = [NSURL sd_URLWithStorageReference:reference];
+    if (url) {
+      [urls addObject:url];
+    }
+  }
+  return [_prefetcher prefetchURLs:urls progress:progressBlock completed:completionBlock];
+}
+
+- (SDWebImagePrefetchToken *)prefetchRowsInRange:(NSRange)range
+                                    ofCollection:(id)collection
+                                referenceKeyPath:(NSString *)keyPath {
+  return [self prefetchReferences:[self referencesInRange:range
+                                             ofCollection:collection
+                                         referenceKeyPath:keyPath]];
+}
+
+- (NSArray<FIRStorageReference *> *)referencesInRange:(NSRange)range
+                                         ofCollection:(id)collection
+                                     referenceKeyPath:(NSString *)keyPath {
+  NSParameterAssert([collection respondsToSelector:@selector(count)]);
+  NSParameterAssert([collection respondsToSelector:@selector(objectAtIndexedSubscript:)]);
+  NSUInteger count = [collection count];
+  if (range.location >= count) {
+    return @[];
+  }
+  NSUInteger end = MIN(NSMaxRange(range), count);
+  NSMutableArray<FIRStorageReference *> *references =
+      [NSMutableArray arrayWithCapacity:end - range.location];
+  for (NSUInteger i = range.location; i < end; i++) {
+    id value = [collection[i] valueForKeyPath:keyPath];
+    FIRStorageReference *reference = [self referenceForValue:value];
+    if (reference) {
+      [references addObject:reference];
+    }
+  }
+  return [references copy];
+}
+
+- (FIRStorageReference *)referenceForValue:(id)value {
+  if ([value isKindOfClass:[FIRStorageReference class]]) {
+    return value;
+  }
+  if ([value isKindOfClass:[NSString class]]) {
+    NSString *string = value;
+    if (string.length == 0) {
+      return nil;
+    }
+    if (![string hasPrefix:@"gs://"]) {
+      return [self.storage.reference child:string];
+    }
+    value = [NSURL URLWithString:string];
+  }
+  if ([value isKindOfClass:[NSURL class]] && [((NSURL *)value).scheme isEqualToString:@"gs"]) {
+    return [FUIStorageReferenceCache.sharedCache referenceForURL:value];
+  }
+  return nil;
+}
+
+- (void)cancelPrefetching {
+  [_prefetcher cancelPrefetching];
+}
+
+@end
@@ -0,0 +1,92 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  @import FirebaseStorage;
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Identifies one version of a Storage object by its generation, MD5 hash and update
+ * time. Versions are stored with cached images as their `sd_extendedObject`, so they
+ * are plain property lists.
+ */
+typedef NSDictionary<NSString *, id> FUIStorageObjectVersion;
+
+/**
+ * Returns the version described by the object's metadata.
+ */
+FOUNDATION_EXTERN FUIStorageObjectVersion *FUIStorageObjectVersionFromMetadata(FIRStorageMetadata *metadata);
+
+/**
+ * Returns whether an object is a version created by FUIStorageObjectVersionFromMetadata.
+ */
+FOUNDATION_EXTERN BOOL FUIStorageObjectIsVersion(id _Nullable object);
+
+/**
+ * Fetches and caches the current versions of Storage objects. Concurrent fetches
+ * for the same object share one metadata request. At most countLimit versions are
+ * kept, and a version older than the maxAge it's looked up with is removed.
+ */
+@interface FUIStorageObjectVersionCache : NSObject
+
+/**
+ * Initializes a cache holding up to countLimit versions.
+ */
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Initializes a cache holding up to 1000 versions.
+ */
+- (instancetype)init;
+
+/**
+ * The maximum number of versions kept. Like NSCache, the cache may evict versions
+ * before reaching this limit.
+ */
+@property (nonatomic, readonly) NSUInteger countLimit;
+
+/**
+ * The number of metadata requests made.
+ */
+@property (atomic, readonly) NSUInteger fetchCount;
+
+/**
+ * Calls completion with the object's current version, fetching the object's metadata
+ * unless a version fetched less than maxAge seconds ago is cached. The version is
+ * nil if the metadata couldn't be fetched. The completion is invoked on the queue
+ * Storage invokes callbacks on, or synchronously for cached versions.
+ */
+- (void)fetchVersionForReference:(FIRStorageReference *)reference
+                          maxAge:(NSTimeInterval)maxAge
+                      completion:(void (^)(FUIStorageObjectVersion *_Nullable version))completion;
+
+/**
+ * Forgets every cached version.
+ */
+- (void)removeAllVersions;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,139 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/FUIStorageObjectVersionCache.h"
+
+static NSString *const FUIStorageObjectVersionGenerationKey = @"FUIStorageGeneration";
+static NSString *const FUIStorageObjectVersionMD5HashKey = @"FUIStorageMD5Hash";
+static NSString *const FUIStorageObjectVersionUpdatedKey = @"FUIStorageUpdated";
+
+FUIStorageObjectVersion *FUIStorageObjectVersionFromMetadata(FIRStorageMetadata *metadata) {
+  return @{
+    FUIStorageObjectVersionGenerationKey: @(metadata.generation),
+    FUIStorageObjectVersionMD5HashKey: metadata.md5Hash ?: @"",
+    FUIStorageObjectVersionUpdatedKey: @(metadata.updated.timeIntervalSince1970),
+  };
+}
+
+BOOL FUIStorageObjectIsVersion(id object) {
+  return [object isKindOfClass:[NSDictionary class]]
+      && ((NSDictionary *)object)[FUIStorageObjectVersionGenerationKey] != nil;
+}
+
+@interface FUIStorageObjectVersionEntry : NSObject
+
+@property (nonatomic, readonly) FUIStorageObjectVersion *version;
+@property (nonatomic, readonly) NSTimeInterval fetchTime;
+
+@end
+
+@implementation FUIStorageObjectVersionEntry
+
+- (instancetype)initWithVersion:(FUIStorageObjectVersion *)version fetchTime:(NSTimeInterval)fetchTime {
+  self = [super init];
+  if (self) {
+    _version = [version copy];
+    _fetchTime = fetchTime;
+  }
+  return self;
+}
+
+@end
+
+@interface FUIStorageObjectVersionCache ()
+
+@property (atomic, readwrite) NSUInteger fetchCount;
+
+@end
+
+@implementation FUIStorageObjectVersionCache {
+  // Guards _pendingCompletions, and lookups and removals of expired versions.
+  NSLock *_lock;
+  NSCache<NSString *, FUIStorageObjectVersionEntry *> *_versions;
+  // Completions waiting on in-flight metadata requests, by object.
+  NSMutableDictionary<NSString *, NSMutableArray *> *_pendingCompletions;
+}
+
+- (instancetype)init {
+  return [self initWithCountLimit:1000];
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit {
+  self = [super init];
+  if (self) {
+    _countLimit = countLimit;
+    _lock = [[NSLock alloc] init];
+    _versions = [[NSCache alloc] init];
+    _versions.countLimit = countLimit;
+    _pendingCompletions = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (void)fetchVersionForReference:(FIRStorageReference *)reference
+                          maxAge:(NSTimeInterval)maxAge
+                      completion:(void (^)(FUIStorageObjectVersion *))completion {
+  NSString *key = [NSString stringWithFormat:@"%@/%@", reference.bucket, reference.fullPath];
+  NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+
+  [_lock lock];
+  FUIStorageObjectVersionEntry *entry = [_versions objectForKey:key];
+  if (entry && now - entry.fetchTime < maxAge) {
+    [_lock unlock];
+    completion(entry.version);
+    return;
+  }
+  if (entry) {
+    // Expired; it's replaced if the fetch below succeeds, and gone if it doesn't.
+    [_versions removeObjectForKey:key];
+  }
+  NSMutableArray *pending = _pendingCompletions[key];
+  if (pending) {
+    [pending addObject:[completion copy]];
+    [_lock unlock];
+    return;
+  }
+  _pendingCompletions[key] = [NSMutableArray arrayWithObject:[completion copy]];
+  self.fetchCount += 1;
+  [_lock unlock];
+
+  [reference metadataWithCompletion:^(FIRStorageMetadata * _Nullable metadata, NSError * _Nullable error) {
+    FUIStorageObjectVersion *version = metadata ? FUIStorageObjectVersionFromMetadata(metadata) : nil;
+    [self->_lock lock];
+    if (version) {
+      FUIStorageObjectVersionEntry *fetched =
+          [[FUIStorageObjectVersionEntry alloc] initWithVersion:version
+                                                      fetchTime:[NSProcessInfo processInfo].systemUptime];
+      [self->_versions setObject:fetched forKey:key];
+    }
+    NSArray *completions = self->_pendingCompletions[key];
+    [self->_pendingCompletions removeObjectForKey:key];
+    [self->_lock unlock];
+
+    for (void (^pendingCompletion)(FUIStorageObjectVersion *) in completions) {
+      pendingCompletion(version);
+    }
+  }];
+}
+
+- (void)removeAllVersions {
+  [_lock lock];
+  [_versions removeAllObjects];
+  [_lock unlock];
+}
+
+@end
@@ -0,0 +1,141 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageReferenceCache.h"
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/NSURL+FirebaseStorage.h"
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  @import FirebaseStorage;
+#endif
+
+@interface NSURL ()
+
+@property (nonatomic, strong, readwrite, nullable) FIRStorageReference *sd_storageReference;
+
+@end
+
+@implementation FUIStorageReferenceCache {
+  // Guards _storages. Apps use few buckets, so these are never evicted.
+  NSLock *_storagesLock;
+  NSMutableDictionary<NSString *, FIRStorage *> *_storages;
+
+  NSCache<NSURL *, FIRStorageReference *> *_references;
+  // Percent-encoded URL strings keyed by bucket and full path, which is cheaper to
+  // build than the URL itself. Only strings are cached, since the URLs handed out
+  // carry the caller's reference, which may belong to another app or Storage instance.
+  NSCache<NSString *, NSString *> *_URLStrings;
+}
+
++ (FUIStorageReferenceCache *)sharedCache {
+  static dispatch_once_t onceToken;
+  static FUIStorageReferenceCache *cache;
+  dispatch_once(&onceToken, ^{
+    cache = [[FUIStorageReferenceCache alloc] init];
+  });
+  return cache;
+}
+
+- (instancetype)init {
+  return [self initWithCountLimit:1000];
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit {
+  self = [super init];
+  if (self) {
+    _countLimit = countLimit;
+    _storagesLock = [[NSLock alloc] init];
+    _storages = [NSMutableDictionary dictionary];
+    _references = [[NSCache alloc] init];
+    _references.countLimit = countLimit;
+    _URLStrings = [[NSCache alloc] init];
+    _URLStrings.countLimit = countLimit;
+  }
+  return self;
+}
+
+- (FIRStorage *)storageForBucket:(NSString *)bucket {
+  [_storagesLock lock];
+  FIRStorage *storage = _storages[bucket];
+  [_storagesLock unlock];
+  if (storage) {
+    return storage;
+  }
+
+  storage = [FIRStorage storageWithURL:[NSString stringWithFormat:@"gs://%@", bucket]];
+  [_storagesLock lock];
+  // Another thread may have created it first; keep the first one.
+  FIRStorage *existing = _storages[bucket];
+  if (existing) {
+    storage = existing;
+  } else {
+    _storages[bucket] = storage;
+  }
+  [_storagesLock unlock];
+  return storage;
+}
+
+- (FIRStorageReference *)referenceForURL:(NSURL *)url {
+  FIRStorageReference *reference = [_references objectForKey:url];
+  if (reference) {
+    return reference;
+  }
+  if (url.host.length == 0) {
+    return nil;
+  }
+  reference = [[self storageForBucket:url.host] referenceWithPath:url.path];
+  if (reference) {
+    [_references setObject:reference forKey:url];
+  }
+  return reference;
+}
+
+- (NSURL *)URLForReference:(FIRStorageReference *)reference {
+  NSString *bucket = reference.bucket;
+  NSString *fullPath = reference.fullPath;
+  if (!bucket || !fullPath) {
+    return nil;
+  }
+  NSString *key = [NSString stringWithFormat:@"%@/%@", bucket, fullPath];
+  NSString *string = [_URLStrings objectForKey:key];
+  if (!string) {
+    // gs://bucket/path/to/object.txt
+    NSURLComponents *components = [[NSURLComponents alloc] initWithString:[NSString stringWithFormat:@"%@://%@/", @"gs", bucket]];
+    NSString *encodedPath = [fullPath stringByAddingPercentEncodingWithAllowedCharacters:[NSCharacterSet URLPathAllowedCharacterSet]];
+    components.path = [components.path stringByAppendingString:encodedPath];
+    string = components.URL.absoluteString;
+    if (!string) {
+      return nil;
+    }
+    [_URLStrings setObject:string forKey:key];
+  }
+
+  // A new URL each time, so that each carries its own reference.
+  NSURL *url = [NSURL URLWithString:string];
+  url.sd_storageReference = reference;
+  return url;
+}
+
+- (void)removeAllObjects {
+  [_references removeAllObjects];
+  [_URLStrings removeAllObjects];
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUIStorageImageLoadOperation;
+
+/**
+ * Decides when FUIStorageImageLoader's downloads start. Each bucket has at most
+ * maxConcurrentRequestsPerBucket downloads in flight; waiting downloads start in
+ * order of priority and, within a priority, newest first, since during a scroll the
+ * most recently requested rows are the ones on screen. Downloads can also be held
+ * back for startDelay, so requests for rows that scroll past are cancelled before
+ * they reach the network.
+ */
+@interface FUIStorageRequestScheduler : NSObject
+
+/**
+ * The maximum number of downloads in flight per bucket, or 0 for no limit.
+ */
+@property (atomic, assign) NSUInteger maxConcurrentRequestsPerBucket;
+
+/**
+ * How long a download waits before it may start, in seconds.
+ */
+@property (atomic, assign) NSTimeInterval startDelay;
+
+/**
+ * The number of downloads cancelled before they started.
+ */
+@property (atomic, readonly) NSUInteger unstartedCancellationCount;
+
+/**
+ * The number of bytes downloaded by downloads that were cancelled.
+ */
+@property (atomic, readonly) int64_t wastedByteCount;
+
+/**
+ * Schedules an operation's download. The start block is invoked once the download
+ * may start, either synchronously or on a private queue, unless the operation is
+ * cancelled first.
+ */
+- (void)scheduleOperation:(FUIStorageImageLoadOperation *)operation
+                   bucket:(NSString *)bucket
+                    start:(dispatch_block_t)startBlock;
+
+/**
+ * Releases the operation's slot once its download has finished, starting the next
+ * download.
+ */
+- (void)finishOperation:(FUIStorageImageLoadOperation *)operation;
+
+/**
+ * Drops a waiting operation, or releases the slot of a started one and counts the
+ * bytes it downloaded as wasted.
+ */
+- (void)cancelOperation:(FUIStorageImageLoadOperation *)operation;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,194 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/FUIStorageRequestScheduler.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadOperation.h"
+
+@interface FUIStorageScheduledRequest : NSObject
+
+@property (nonatomic, strong) FUIStorageImageLoadOperation *operation;
+@property (nonatomic, copy) NSString *bucket;
+@property (nonatomic, copy) dispatch_block_t startBlock;
+/// The system uptime at which the request may start.
+@property (nonatomic, assign) NSTimeInterval readyTime;
+/// Increases with every request, so newer requests can be started first.
+@property (nonatomic, assign) uint64_t sequence;
+
+@end
+
+@implementation FUIStorageScheduledRequest
+@end
+
+@interface FUIStorageRequestScheduler ()
+
+@property (atomic, readwrite) NSUInteger unstartedCancellationCount;
+@property (atomic, readwrite) int64_t wastedByteCount;
+
+@end
+
+@implementation FUIStorageRequestScheduler {
+  // Guards every ivar below.
+  NSLock *_lock;
+  NSMutableArray<FUIStorageScheduledRequest *> *_waiting;
+  // The bucket of every started operation that hasn't finished.
+  NSMapTable<FUIStorageImageLoadOperation *, NSString *> *_running;
+  NSCountedSet<NSString *> *_runningBuckets;
+  uint64_t _sequence;
+  // When the pending check for delayed requests fires, or 0 if none is pending.
+  NSTimeInterval _timerFireTime;
+
+  dispatch_queue_t _timerQueue;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _lock = [[NSLock alloc] init];
+    _waiting = [NSMutableArray array];
+    _running = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                     valueOptions:NSPointerFunctionsStrongMemory];
+    _runningBuckets = [[NSCountedSet alloc] init];
+    _timerQueue = dispatch_queue_create("com.firebaseui.storage.scheduler", DISPATCH_QUEUE_SERIAL);
+  }
+  return self;
+}
+
+- (void)scheduleOperation:(FUIStorageImageLoadOperation *)operation
+                   bucket:(NSString *)bucket
+                    start:(dispatch_block_t)startBlock {
+  FUIStorageScheduledRequest *request = [[FUIStorageScheduledRequest alloc] init];
+  request.operation = operation;
+  request.bucket = bucket ?: @"";
+  request.startBlock = startBlock;
+  request.readyTime = [NSProcessInfo processInfo].systemUptime + self.startDelay;
+
+  [_lock lock];
+  request.sequence = _sequence++;
+  [_waiting addObject:request];
+  NSArray<FUIStorageScheduledRequest *> *startable = [self dequeueStartableRequests];
+  [_lock unlock];
+  [self startRequests:startable];
+}
+
+- (void)finishOperation:(FUIStorageImageLoadOperation *)operation {
+  [_lock lock];
+  [self removeRunningOperation:operation];
+  NSArray<FUIStorageScheduledRequest *> *startable = [self dequeueStartableRequests];
+  [_lock unlock];
+  [self startRequests:startable];
+}
+
+- (void)cancelOperation:(FUIStorageImageLoadOperation *)operation {
+  [_lock lock];
+  NSUInteger index = [_waiting indexOfObjectPassingTest:^BOOL(FUIStorageScheduledRequest *request,
+                                                              NSUInteger idx,
+                                                              BOOL *stop) {
+    return request.operation == operation;
+  }];
+  if (index != NSNotFound) {
+    [_waiting removeObjectAtIndex:index];
+    self.unstartedCancellationCount += 1;
+  } else if ([self removeRunningOperation:operation]) {
+    self.wastedByteCount += operation.receivedSize;
+  }
+  NSArray<FUIStorageScheduledRequest *> *startable = [self dequeueStartableRequests];
+  [_lock unlock];
+  [self startRequests:startable];
+}
+
+#pragma mark - Private
+
+// Must be called with _lock held.
+- (BOOL)removeRunningOperation:(FUIStorageImageLoadOperation *)operation {
+  NSString *bucket = [_running objectForKey:operation];
+  if (!bucket) {
+    return NO;
+  }
+  [_running removeObjectForKey:operation];
+  [_runningBuckets removeObject:bucket];
+  return YES;
+}
+
+// Removes the requests that may start now from _waiting and marks them running.
+// Must be called with _lock held.
+- (NSArray<FUIStorageScheduledRequest *> *)dequeueStartableRequests {
+  NSUInteger limit = self.maxConcurrentRequestsPerBucket;
+  NSTimeInterval now = [NSProcessInfo processInfo].systemUptime;
+  NSMutableArray<FUIStorageScheduledRequest *> *startable = [NSMutableArray array];
+  while (YES) {
+    FUIStorageScheduledRequest *best = nil;
+    for (FUIStorageScheduledRequest *request in _waiting) {
+      if (request.readyTime > now) {
+        continue;
+      }
+      if (limit > 0 && [_runningBuckets countForObject:request.bucket] >= limit) {
+        continue;
+      }
+      // Priorities can be raised while waiting, when a visible request joins a prefetch.
+      FUIStorageImagePriority priority = request.operation.priority;
+      if (!best || priority > best.operation.priority ||
+          (priority == best.operation.priority && request.sequence > best.sequence)) {
+        best = request;
+      }
+    }
+    if (!best) {
+      break;
+    }
+    [_waiting removeObjectIdenticalTo:best];
+    [_running setObject:best.bucket forKey:best.operation];
+    [_runningBuckets addObject:best.bucket];
+    [startable addObject:best];
+  }
+  [self scheduleTimerWithNow:now];
+  return startable;
+}
+
+// Checks again once the earliest delayed request is ready. Requests waiting for a
+// slot are started when a slot is released instead. Must be called with _lock held.
+- (void)scheduleTimerWithNow:(NSTimeInterval)now {
+  NSTimeInterval fireTime = DBL_MAX;
+  for (FUIStorageScheduledRequest *request in _waiting) {
+    if (request.readyTime > now) {
+      fireTime = MIN(fireTime, request.readyTime);
+    }
+  }
+  if (fireTime == DBL_MAX || (_timerFireTime > 0 && _timerFireTime <= fireTime)) {
+    return;
+  }
+  _timerFireTime = fireTime;
+  __weak typeof(self) weakSelf = self;
+  int64_t delay = (int64_t)((fireTime - now) * NSEC_PER_SEC);
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), _timerQueue, ^{
+    [weakSelf timerDidFire];
+  });
+}
+
+- (void)timerDidFire {
+  [_lock lock];
+  _timerFireTime = 0;
+  NSArray<FUIStorageScheduledRequest *> *startable = [self dequeueStartableRequests];
+  [_lock unlock];
+  [self startRequests:startable];
+}
+
+- (void)startRequests:(NSArray<FUIStorageScheduledRequest *> *)requests {
+  for (FUIStorageScheduledRequest *request in requests) {
+    request.startBlock();
+  }
+}
+
+@end
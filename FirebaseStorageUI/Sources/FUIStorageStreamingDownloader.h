@@ -0,0 +1,92 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <SDWebImage/SDWebImage.h>
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  @import FirebaseStorage;
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUIStorageStreamingTask;
+
+typedef void (^FUIStorageStreamingProgressBlock)(FUIStorageStreamingTask *task,
+                                                 int64_t receivedSize,
+                                                 int64_t expectedSize);
+typedef void (^FUIStorageStreamingCompletionBlock)(NSData *_Nullable data, NSError *_Nullable error);
+
+/**
+ * A single streamed download of a Storage object. Cancelling it cancels the request,
+ * and the completion block isn't called afterwards.
+ */
+@interface FUIStorageStreamingTask : NSObject <SDWebImageOperation>
+
+/**
+ * Whether the task has been cancelled.
+ */
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns a copy of the bytes received so far.
+ */
+- (NSData *)receivedData;
+
+@end
+
+/**
+ * Streams Storage objects over HTTP so they can be decoded while they download,
+ * which FIRStorageDownloadTask doesn't allow. Each object's download URL is
+ * resolved with `-[FIRStorageReference downloadURLWithCompletion:]` once and then
+ * reused, and concurrent resolutions for the same object share one request.
+ * Progress blocks are invoked on a private serial queue, and completion blocks on
+ * that queue or the queue Storage invokes callbacks on.
+ */
+@interface FUIStorageStreamingDownloader : NSObject
+
+/**
+ * The number of download URLs resolved.
+ */
+@property (atomic, readonly) NSUInteger downloadURLFetchCount;
+
+- (instancetype)initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Starts streaming an object. The download fails with
+ * FIRStorageErrorCodeDownloadSizeExceeded once it's known to be larger than maxSize.
+ */
+- (FUIStorageStreamingTask *)streamReference:(FIRStorageReference *)reference
+                                     maxSize:(UInt64)maxSize
+                                    progress:(nullable FUIStorageStreamingProgressBlock)progressBlock
+                                  completion:(FUIStorageStreamingCompletionBlock)completionBlock;
+
+/**
+ * Lets running downloads finish and releases the session.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,328 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import "FirebaseStorageUI/Sources/FUIStorageStreamingDownloader.h"
+
+@interface FUIStorageStreamingTask ()
+
+@property (nonatomic, readonly) UInt64 maxSize;
+@property (nonatomic, readonly, copy, nullable) FUIStorageStreamingProgressBlock progressBlock;
+
+/// The error the response was rejected with, which takes precedence over the
+/// cancellation error the data task completes with.
+@property (atomic, strong, nullable) NSError *responseError;
+
+- (instancetype)initWithMaxSize:(UInt64)maxSize
+                       progress:(FUIStorageStreamingProgressBlock)progressBlock
+                     completion:(FUIStorageStreamingCompletionBlock)completionBlock NS_DESIGNATED_INITIALIZER;
+
+/// Returns NO, without setting the data task, if the task has been cancelled.
+- (BOOL)setDataTask:(NSURLSessionDataTask *)dataTask;
+
+/// Returns the number of bytes received so far.
+- (int64_t)appendData:(NSData *)data;
+
+- (void)finishWithData:(nullable NSData *)data error:(nullable NSError *)error;
+
+@end
+
+@implementation FUIStorageStreamingTask {
+  // Guards every ivar below.
+  NSLock *_lock;
+  NSMutableData *_data;
+  NSURLSessionDataTask *_dataTask;
+  FUIStorageStreamingCompletionBlock _completionBlock;
+  BOOL _cancelled;
+}
+
+- (instancetype)initWithMaxSize:(UInt64)maxSize
+                       progress:(FUIStorageStreamingProgressBlock)progressBlock
+                     completion:(FUIStorageStreamingCompletionBlock)completionBlock {
+  self = [super init];
+  if (self) {
+    _maxSize = maxSize;
+    _progressBlock = [progressBlock copy];
+    _completionBlock = [completionBlock copy];
+    _lock = [[NSLock alloc] init];
+    _data = [NSMutableData data];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (BOOL)isCancelled {
+  [_lock lock];
+  BOOL cancelled = _cancelled;
+  [_lock unlock];
+  return cancelled;
+}
+
+- (void)cancel {
+  [_lock lock];
+  if (_cancelled || !_completionBlock) {
+    [_lock unlock];
+    return;
+  }
+  _cancelled = YES;
+  _completionBlock = nil;
+  NSURLSessionDataTask *dataTask = _dataTask;
+  [_lock unlock];
+  [dataTask cancel];
+}
+
+- (BOOL)setDataTask:(NSURLSessionDataTask *)dataTask {
+  [_lock lock];
+  BOOL cancelled = _cancelled;
+  if (!cancelled) {
+    _dataTask = dataTask;
+  }
+  [_lock unlock];
+  return !cancelled;
+}
+
+- (NSData *)receivedData {
+  [_lock lock];
+  NSData *data = [_data copy];
+  [_lock unlock];
+  return data;
+}
+
+- (int64_t)appendData:(NSData *)data {
+  [_lock lock];
+  [_data appendData:data];
+  int64_t length = (int64_t)_data.length;
+  [_lock unlock];
+  return length;
+}
+
+- (void)finishWithData:(NSData *)data error:(NSError *)error {
+  [_lock lock];
+  FUIStorageStreamingCompletionBlock completionBlock = _completionBlock;
+  _completionBlock = nil;
+  [_lock unlock];
+  if (completionBlock) {
+    completionBlock(data, error);
+  }
+}
+
+@end
+
+@interface FUIStorageStreamingDownloader () <NSURLSessionDataDelegate>
+
+@property (atomic, readwrite) NSUInteger downloadURLFetchCount;
+
+@end
+
+@implementation FUIStorageStreamingDownloader {
+  NSURLSession *_session;
+  // Guards _tasks and _pendingURLCompletions.
+  NSLock *_lock;
+  NSMutableDictionary<NSNumber *, FUIStorageStreamingTask *> *_tasks;
+  // Completions waiting on in-flight download URL requests, by object.
+  NSMutableDictionary<NSString *, NSMutableArray *> *_pendingURLCompletions;
+  NSCache<NSString *, NSURL *> *_downloadURLs;
+}
+
+- (instancetype)initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration {
+  self = [super init];
+  if (self) {
+    _lock = [[NSLock alloc] init];
+    _tasks = [NSMutableDictionary dictionary];
+    _pendingURLCompletions = [NSMutableDictionary dictionary];
+    _downloadURLs = [[NSCache alloc] init];
+    NSOperationQueue *delegateQueue = [[NSOperationQueue alloc] init];
+    delegateQueue.maxConcurrentOperationCount = 1;
+    delegateQueue.name = @"com.firebaseui.storage.streaming";
+    _session = [NSURLSession sessionWithConfiguration:configuration
+                                             delegate:self
+                                        delegateQueue:delegateQueue];
+  }
+  return self;
+}
+
+- (instancetype)init {
+  NSException *e =
+    [NSException exceptionWithName:@"FIRUnavailableMethodException"
+                            reason:@"-init is unavailable. Please use the designated initializer instead."
+                          userInfo:nil];
+  @throw e;
+}
+
+- (void)invalidate {
+  [_session finishTasksAndInvalidate];
+}
+
+- (FUIStorageStreamingTask *)streamReference:(FIRStorageReference *)reference
+                                     maxSize:(UInt64)maxSize
+                                    progress:(FUIStorageStreamingProgressBlock)progressBlock
+                                  completion:(FUIStorageStreamingCompletionBlock)completionBlock {
+  FUIStorageStreamingTask *task = [[FUIStorageStreamingTask alloc] initWithMaxSize:maxSize
+                                                                          progress:progressBlock
+                                                                        completion:completionBlock];
+  NSString *key = [NSString stringWithFormat:@"%@/%@", reference.bucket, reference.fullPath];
+  [self downloadURLForReference:reference key:key completion:^(NSURL *URL, NSError *error) {
+    if (!URL) {
+      [task finishWithData:nil error:error];
+      return;
+    }
+    NSURLSessionDataTask *dataTask = [self->_session dataTaskWithURL:URL];
+    dataTask.taskDescription = key;
+    [self->_lock lock];
+    self->_tasks[@(dataTask.taskIdentifier)] = task;
+    [self->_lock unlock];
+    if (![task setDataTask:dataTask]) {
+      [self->_lock lock];
+      [self->_tasks removeObjectForKey:@(dataTask.taskIdentifier)];
+      [self->_lock unlock];
+      return;
+    }
+    [dataTask resume];
+  }];
+  return task;
+}
+
+- (void)downloadURLForReference:(FIRStorageReference *)reference
+                            key:(NSString *)key
+                     completion:(void (^)(NSURL *_Nullable URL, NSError *_Nullable error))completion {
+  NSURL *URL = [_downloadURLs objectForKey:key];
+  if (URL) {
+    completion(URL, nil);
+    return;
+  }
+  [_lock lock];
+  NSMutableArray *pending = _pendingURLCompletions[key];
+  if (pending) {
+    [pending addObject:[completion copy]];
+    [_lock unlock];
+    return;
+  }
+  _pendingURLCompletions[key] = [NSMutableArray arrayWithObject:[completion copy]];
+  self.downloadURLFetchCount += 1;
+  [_lock unlock];
+
+  [reference downloadURLWithCompletion:^(NSURL * _Nullable URL, NSError * _Nullable error) {
+    if (URL) {
+      [self->_downloadURLs setObject:URL forKey:key];
+    }
+    [self->_lock lock];
+    NSArray *completions = self->_pendingURLCompletions[key];
+    [self->_pendingURLCompletions removeObjectForKey:key];
+    [self->_lock unlock];
+    for (void (^pendingCompletion)(NSURL *, NSError *) in completions) {
+      pendingCompletion(URL, error);
+    }
+  }];
+}
+
+- (FUIStorageStreamingTask *)taskForDataTask:(NSURLSessionTask *)dataTask {
+  [_lock lock];
+  FUIStorageStreamingTask *task = _tasks[@(dataTask.taskIdentifier)];
+  [_lock unlock];
+  return task;
+}
+
+- (NSError *)sizeExceededErrorWithSize:(int64_t)size maxSize:(UInt64)maxSize {
+  NSString *description =
+      [NSString stringWithFormat:@"Attempted to download object with size of %lld bytes, "
+                                 @"which exceeds the maximum size of %llu bytes.", size, maxSize];
+  return [NSError errorWithDomain:@"FIRStorageErrorDomain"
+                             code:FIRStorageErrorCodeDownloadSizeExceeded
+                         userInfo:@{NSLocalizedDescriptionKey : description}];
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+didReceiveResponse:(NSURLResponse *)response
+ completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler {
+  FUIStorageStreamingTask *task = [self taskForDataTask:dataTask];
+  NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]]
+      ? ((NSHTTPURLResponse *)response).statusCode : 200;
+  if (statusCode >= 400) {
+    NSInteger code;
+    NSString *domain = @"FIRStorageErrorDomain";
+    if (statusCode == 404) {
+      code = FIRStorageErrorCodeObjectNotFound;
+    } else if (statusCode == 401 || statusCode == 403) {
+      code = FIRStorageErrorCodeUnauthorized;
+    } else {
+      domain = SDWebImageErrorDomain;
+      code = SDWebImageErrorInvalidDownloadStatusCode;
+    }
+    task.responseError = [NSError errorWithDomain:domain
+                                             code:code
+                                         userInfo:@{SDWebImageErrorDownloadStatusCodeKey : @(statusCode)}];
+    completionHandler(NSURLSessionResponseCancel);
+    return;
+  }
+  if (response.expectedContentLength > 0 && (UInt64)response.expectedContentLength > task.maxSize) {
+    task.responseError = [self sizeExceededErrorWithSize:response.expectedContentLength
+                                                 maxSize:task.maxSize];
+    completionHandler(NSURLSessionResponseCancel);
+    return;
+  }
+  completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+    didReceiveData:(NSData *)data {
+  FUIStorageStreamingTask *task = [self taskForDataTask:dataTask];
+  if (!task || task.isCancelled) {
+    return;
+  }
+  int64_t receivedSize = [task appendData:data];
+  if ((UInt64)receivedSize > task.maxSize) {
+    task.responseError = [self sizeExceededErrorWithSize:receivedSize maxSize:task.maxSize];
+    [dataTask cancel];
+    return;
+  }
+  if (task.progressBlock) {
+    task.progressBlock(task, receivedSize, MAX(dataTask.response.expectedContentLength, 0));
+  }
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)dataTask
+didCompleteWithError:(NSError *)error {
+  FUIStorageStreamingTask *task = [self taskForDataTask:dataTask];
+  [_lock lock];
+  [_tasks removeObjectForKey:@(dataTask.taskIdentifier)];
+  [_lock unlock];
+  if (!task) {
+    return;
+  }
+  NSError *responseError = task.responseError;
+  if ([responseError.domain isEqualToString:@"FIRStorageErrorDomain"] &&
+      (responseError.code == FIRStorageErrorCodeObjectNotFound ||
+       responseError.code == FIRStorageErrorCodeUnauthorized)) {
+    // The download URL's token may have been revoked, or the object replaced.
+    [_downloadURLs removeObjectForKey:dataTask.taskDescription];
+  }
+  error = responseError ?: error;
+  [task finishWithData:error ? nil : [task receivedData] error:error];
+}
+
+@end
@@ -15,6 +15,7 @@
 //
 
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/NSURL+FirebaseStorage.h"
+#import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageReferenceCache.h"
 #import <objc/runtime.h>
 
 #if __has_include(<FirebaseStorage/FirebaseStorage.h>)
@@ -36,22 +37,8 @@
 }
 
 + (instancetype)sd_URLWithStorageReference:(FIRStorageReference *)storageRef {
-  if (!storageRef.bucket || !storageRef.fullPath) {
-    return nil;
-  }
   // gs://bucket/path/to/object.txt
-  NSURLComponents *components = [[NSURLComponents alloc] initWithString:[NSString stringWithFormat:@"%@://%@/", @"gs", storageRef.bucket]];
-  NSString *encodedPath = [storageRef.fullPath stringByAddingPercentEncodingWithAllowedCharacters:[NSCharacterSet URLPathAllowedCharacterSet]];
-  components.path = [components.path stringByAppendingString:encodedPath];
-  
-  NSURL *url = components.URL;
-  if (!url) {
-    return nil;
-  }
-  
-  url.sd_storageReference = storageRef;
-  
-  return url;
+  return [FUIStorageReferenceCache.sharedCache URLForReference:storageRef];
 }
 
 @end
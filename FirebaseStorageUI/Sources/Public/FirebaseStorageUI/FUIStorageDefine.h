@@ -21,3 +21,36 @@
  *   exceeds this size, an error will be raised in the completion block. (NSNumber *)
  */
 FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageMaxImageSize;
+
+/**
+ * The size, in pixels, to decode the image to. The image is downsampled while it's
+ *   decoded so that it fits in this size with its aspect ratio preserved, instead of
+ *   being decoded at full size. Images smaller than this size are not scaled up.
+ *   The target size is part of the image's cache key, so each size is cached
+ *   separately. (NSValue *, containing a CGSize)
+ *
+ *   `sd_setImageWithStorageReference:` and FUIStorageImageLoader translate this
+ *   option into SDWebImage's thumbnail decoding options. When loading through
+ *   SDWebImage's own view APIs, use SDWebImageContextImageThumbnailPixelSize
+ *   instead so SDWebImage can include the size in the cache key.
+ */
+FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageTargetPixelSize;
+
+/**
+ * How urgently an image load's work should be scheduled relative to other loads.
+ */
+typedef NS_ENUM(NSInteger, FUIStorageImagePriority) {
+  /// Work that nothing is waiting on.
+  FUIStorageImagePriorityBackground = 0,
+  /// Images that are expected to be shown soon, like rows about to scroll on screen.
+  FUIStorageImagePriorityPrefetch = 1,
+  /// Images for views that are currently on screen.
+  FUIStorageImagePriorityVisible = 2,
+} NS_SWIFT_NAME(StorageImagePriority);
+
+/**
+ * The priority of an image load, as an FUIStorageImagePriority raw value. Defaults to
+ *   FUIStorageImagePriorityVisible, or FUIStorageImagePriorityBackground for loads
+ *   with the SDWebImageLowPriority option. (NSNumber *)
+ */
+FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextFUIStorageImagePriority;
@@ -0,0 +1,91 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+#import "FUIStorageDefine.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A bounded pool of threads that decodes images downloaded by FUIStorageImageLoader.
+ * Decodes are started in priority order, so images for on-screen views are decoded
+ * before prefetched ones, and decodes for loads that are cancelled before they
+ * start are dropped without running.
+ */
+NS_SWIFT_NAME(StorageImageDecodePool)
+@interface FUIStorageImageDecodePool : NSObject
+
+/**
+ * The pool used by loaders unless they're given another one. It runs one decode per
+ * active processor.
+ */
+@property (nonatomic, class, readonly) FUIStorageImageDecodePool *sharedPool;
+
+/**
+ * The maximum number of images decoded at once.
+ */
+@property (nonatomic, readonly) NSUInteger maxConcurrentDecodeCount;
+
+/**
+ * The number of decodes waiting to start.
+ */
+@property (nonatomic, readonly) NSUInteger queuedDecodeCount;
+
+/**
+ * The highest value queuedDecodeCount has reached since the statistics were reset.
+ */
+@property (nonatomic, readonly) NSUInteger peakQueuedDecodeCount;
+
+/**
+ * The number of decodes that ran since the statistics were reset.
+ */
+@property (nonatomic, readonly) NSUInteger completedDecodeCount;
+
+/**
+ * The number of decodes dropped because their loads were cancelled before they
+ * started, since the statistics were reset.
+ */
+@property (nonatomic, readonly) NSUInteger droppedDecodeCount;
+
+/**
+ * The average time decodes that ran spent waiting to start, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval averageQueueLatency;
+
+/**
+ * The average time completed decodes took to run, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval averageDecodeDuration;
+
+/**
+ * Initializes a pool that runs up to the given number of decodes at once.
+ */
+- (instancetype)initWithMaxConcurrentDecodeCount:(NSUInteger)maxConcurrentDecodeCount NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Initializes a pool that runs one decode per active processor.
+ */
+- (instancetype)init;
+
+/**
+ * Resets every statistic except queuedDecodeCount.
+ */
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,234 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FUIStorageImageLoader;
+
+/**
+ * How an image load ended.
+ */
+typedef NS_ENUM(NSInteger, FUIStorageImageLoadOutcome) {
+  /// The object was downloaded and decoded.
+  FUIStorageImageLoadOutcomeDownloaded = 0,
+  /// The cached image was revalidated and kept without downloading the object.
+  FUIStorageImageLoadOutcomeNotModified = 1,
+  /// The load failed. See the metrics' error.
+  FUIStorageImageLoadOutcomeFailed = 2,
+  /// Every request waiting on the load was cancelled.
+  FUIStorageImageLoadOutcomeCancelled = 3,
+  /// The request joined a load already in flight, and ended with it. The error is the
+  /// shared load's, if it failed.
+  FUIStorageImageLoadOutcomeCoalesced = 4,
+} NS_SWIFT_NAME(StorageImageLoadOutcome);
+
+/**
+ * Timings and byte counts for one load of a Storage object by FUIStorageImageLoader.
+ * A request that joins a load already in flight is counted in that load's
+ * coalescedRequestCount, and reports metrics of its own with the coalesced outcome
+ * when the load ends, or the cancelled outcome if it's cancelled first. Those only
+ * cover resolving and the total duration. Durations are in seconds, and are 0 for
+ * phases the load didn't reach.
+ */
+NS_SWIFT_NAME(StorageImageLoadMetrics)
+@interface FUIStorageImageLoadMetrics : NSObject
+
+/**
+ * The URL of the first request for the object.
+ */
+@property (nonatomic, readonly) NSURL *URL;
+
+/**
+ * How the load ended.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadOutcome outcome;
+
+/**
+ * The error the load failed with, if any.
+ */
+@property (nonatomic, readonly, nullable) NSError *error;
+
+/**
+ * The number of requests that joined the load while it was in flight.
+ */
+@property (nonatomic, readonly) NSUInteger coalescedRequestCount;
+
+/**
+ * The number of bytes downloaded.
+ */
+@property (nonatomic, readonly) int64_t receivedByteCount;
+
+/**
+ * The size of the object, if the download reported it.
+ */
+@property (nonatomic, readonly) int64_t expectedByteCount;
+
+/**
+ * The time spent resolving the Storage reference and, when revalidating, the
+ * object's version.
+ */
+@property (nonatomic, readonly) NSTimeInterval resolveDuration;
+
+/**
+ * The time the download waited for the loader's scheduler to start it.
+ */
+@property (nonatomic, readonly) NSTimeInterval queueDuration;
+
+/**
+ * The time from the start of the download to its first bytes.
+ */
+@property (nonatomic, readonly) NSTimeInterval timeToFirstByte;
+
+/**
+ * The time from the first bytes to the end of the download.
+ */
+@property (nonatomic, readonly) NSTimeInterval transferDuration;
+
+/**
+ * The time the final decode took to run, excluding time spent waiting in the
+ * decode pool.
+ */
+@property (nonatomic, readonly) NSTimeInterval decodeDuration;
+
+/**
+ * The time from the first request to the end of the load.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * Receives the metrics of every load of a loader. The loader only measures loads
+ * while it has an observer.
+ */
+NS_SWIFT_NAME(StorageImageLoadMetricsObserver)
+@protocol FUIStorageImageLoadMetricsObserver <NSObject>
+
+/**
+ * Called once when a load ends, on an arbitrary queue.
+ */
+- (void)imageLoader:(FUIStorageImageLoader *)loader didCollectMetrics:(FUIStorageImageLoadMetrics *)metrics;
+
+@end
+
+/**
+ * A thread-safe histogram of durations, with buckets whose bounds double from 1ms
+ * up to about a minute.
+ */
+NS_SWIFT_NAME(StorageImageLoadHistogram)
+@interface FUIStorageImageLoadHistogram : NSObject
+
+/**
+ * The number of durations recorded.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * The number of durations in each bucket. Bucket i holds durations up to
+ * 2^i milliseconds, and the last bucket holds everything longer.
+ */
+@property (nonatomic, readonly) NSArray<NSNumber *> *bucketCounts;
+
+/**
+ * Records a duration, in seconds.
+ */
+- (void)recordDuration:(NSTimeInterval)duration;
+
+/**
+ * Returns the upper bound, in seconds, of the bucket containing the given
+ * percentile (0-100) of recorded durations, or 0 if nothing has been recorded.
+ * The last bucket has no upper bound, so its lower bound is returned.
+ */
+- (NSTimeInterval)durationAtPercentile:(double)percentile;
+
+/**
+ * Forgets every recorded duration.
+ */
+- (void)reset;
+
+@end
+
+/**
+ * An observer that aggregates metrics into counters and histograms.
+ * @code
+ FUIStorageImageLoadMetricsAggregator *aggregator = [[FUIStorageImageLoadMetricsAggregator alloc] init];
+ FUIStorageImageLoader.sharedLoader.metricsObserver = aggregator;
+ // Later
+ NSLog(@"p95 time to first byte: %f", [aggregator.timeToFirstByteHistogram durationAtPercentile:95]);
+ * @endcode
+ */
+NS_SWIFT_NAME(StorageImageLoadMetricsAggregator)
+@interface FUIStorageImageLoadMetricsAggregator : NSObject <FUIStorageImageLoadMetricsObserver>
+
+/**
+ * The resolve durations of loads. Loads only record the phases they reached.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *resolveHistogram;
+
+/**
+ * The time downloads waited for the scheduler.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *queueHistogram;
+
+/**
+ * The time downloads took to receive their first bytes.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *timeToFirstByteHistogram;
+
+/**
+ * The time downloads took from their first bytes to their last.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *transferHistogram;
+
+/**
+ * The time final decodes took to run.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *decodeHistogram;
+
+/**
+ * The total duration of loads that didn't fail or get cancelled, including requests
+ * that joined a load in flight.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoadHistogram *totalHistogram;
+
+/**
+ * Returns the number of loads that ended with the given outcome.
+ */
+- (NSUInteger)loadCountForOutcome:(FUIStorageImageLoadOutcome)outcome;
+
+/**
+ * The number of requests that joined loads in flight.
+ */
+@property (nonatomic, readonly) NSUInteger coalescedRequestCount;
+
+/**
+ * The total number of bytes downloaded.
+ */
+@property (nonatomic, readonly) int64_t receivedByteCount;
+
+/**
+ * Resets every counter and histogram.
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -17,6 +17,8 @@
 #import <SDWebImage/SDWebImage.h>
 #import "FUIStorageDefine.h"
 #import "NSURL+FirebaseStorage.h"
+#import "FUIStorageImageDecodePool.h"
+#import "FUIStorageImageLoadMetrics.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -44,6 +46,105 @@ NS_SWIFT_NAME(StorageImageLoader)
  */
 @property (nonatomic, assign) UInt64 defaultMaxImageSize;
 
+/**
+ * Whether downloads are written to a temporary file instead of being accumulated in
+ * memory, so large images don't need to be held in memory while they download, and
+ * the maximum image size is enforced as data arrives. Once the download finishes the
+ * file is memory-mapped and removed, and the mapped data is decoded and handed to
+ * SDWebImage. The file isn't moved into SDWebImage's disk cache: SDWebImage stores
+ * the data a loader returns itself, so it writes its own copy. Loads that use
+ * SDWebImageProgressiveLoad are always streamed into memory. Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL streamsDownloadsToDisk;
+
+/**
+ * The minimum time between partial decodes of a progressive load, in seconds. Each
+ * partial decode decodes everything received so far, so decoding after every chunk
+ * would mostly redo work. Defaults to 0.1.
+ */
+@property (nonatomic, assign) NSTimeInterval progressiveDecodeInterval;
+
+/**
+ * The configuration of the session that progressive loads are streamed with.
+ * FIRStorageDownloadTask doesn't expose data as it arrives, so loads that use
+ * SDWebImageProgressiveLoad resolve the object's download URL once and stream it
+ * over HTTP instead. Defaults to the default session configuration.
+ */
+@property (nonatomic, copy) NSURLSessionConfiguration *streamingSessionConfiguration;
+
+/**
+ * Whether the loader keeps track of the version of each object it downloads, so
+ * cached images can be revalidated instead of downloaded again. When enabled, the
+ * object's metadata is fetched before each download and its generation, MD5 hash
+ * and update time are stored with the cached image. Loads using
+ * SDWebImageRefreshCached then only download the object if it has changed since the
+ * cached image was downloaded; otherwise the cached image is kept. Defaults to NO.
+ *
+ * The metadata request is made before the download and waited on, so the first
+ * download of each object, and the first after revalidationInterval has passed,
+ * pays an extra round trip to Storage.
+ */
+@property (nonatomic, assign) BOOL revalidatesCachedImages;
+
+/**
+ * How long fetched object metadata is reused for revalidation, in seconds, so
+ * refreshing an image costs at most one metadata request per object per interval.
+ * Defaults to 300.
+ */
+@property (nonatomic, assign) NSTimeInterval revalidationInterval;
+
+/**
+ * The pool downloaded images are decoded in. Defaults to the shared pool, so every
+ * loader competes for the same bounded set of threads. The priority of each load
+ * can be set with SDWebImageContextFUIStorageImagePriority.
+ */
+@property (nonatomic, strong) FUIStorageImageDecodePool *decodePool;
+
+/**
+ * The maximum number of downloads in flight per bucket, or 0 for no limit. Waiting
+ * downloads start in order of priority (see SDWebImageContextFUIStorageImagePriority)
+ * and, within a priority, newest first, so during a fast scroll the rows that just
+ * came on screen are loaded before rows that have already scrolled past.
+ * Defaults to 6.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentDownloadsPerBucket;
+
+/**
+ * How long a download waits before it starts, in seconds. Requests for rows that
+ * scroll past within this window are cancelled before they reach the network.
+ * Defaults to 0.
+ */
+@property (nonatomic, assign) NSTimeInterval downloadStartDelay;
+
+/**
+ * The number of downloads that were cancelled before they started.
+ */
+@property (nonatomic, readonly) NSUInteger unstartedCancellationCount;
+
+/**
+ * The number of bytes received by downloads that were cancelled after they started.
+ */
+@property (nonatomic, readonly) int64_t wastedByteCount;
+
+/**
+ * Receives timings, byte counts and the outcome of each load. Loads aren't measured
+ * while there's no observer. The observer isn't retained.
+ */
+@property (atomic, weak, nullable) id<FUIStorageImageLoadMetricsObserver> metricsObserver;
+
+/**
+ * The number of downloads the loader has started.
+ */
+@property (nonatomic, readonly) NSUInteger downloadCount;
+
+/**
+ * The number of requests that joined a download already in flight instead of
+ * starting their own. Requests for the same object with the same maximum size and
+ * decoding options share one download and one decode, and the download is only
+ * cancelled once every request sharing it has been cancelled.
+ */
+@property (nonatomic, readonly) NSUInteger coalescedRequestCount;
+
 /**
  The global shared instance for Firebase Storage loader.
  */
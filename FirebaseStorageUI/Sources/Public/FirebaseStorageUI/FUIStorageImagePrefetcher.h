@@ -0,0 +1,136 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <SDWebImage/SDWebImage.h>
+#import "FUIStorageImageLoader.h"
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  // Firebase 8.x (CocoaPods)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  // Firebase 9.0+ (CocoaPods)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  // Swift Package Manager: forward declarations only.
+  @class FIRStorage;
+  @class FIRStorageReference;
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Downloads and decodes Storage images into SDWebImage's cache ahead of time, so
+ * they're ready by the time they're bound with `UIImageView (FirebaseStorage)`.
+ * Prefetches run at FUIStorageImagePriorityPrefetch, behind images that are being
+ * shown, and only a few run at a time.
+ * @code
+ // In UITableViewDataSourcePrefetching
+ NSRange upcoming = NSMakeRange(indexPaths.firstObject.row, indexPaths.count);
+ self.prefetchToken = [FUIStorageImagePrefetcher.sharedPrefetcher prefetchRowsInRange:upcoming
+                                                                         ofCollection:self.array
+                                                                     referenceKeyPath:@"value.photoURL"];
+ * @endcode
+ */
+NS_SWIFT_NAME(StorageImagePrefetcher)
+@interface FUIStorageImagePrefetcher : NSObject
+
+/**
+ * A prefetcher that uses the shared loader.
+ */
+@property (nonatomic, class, readonly) FUIStorageImagePrefetcher *sharedPrefetcher;
+
+/**
+ * The loader images are downloaded with.
+ */
+@property (nonatomic, readonly) FUIStorageImageLoader *loader;
+
+/**
+ * The maximum number of images downloaded at once. Defaults to 3.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentPrefetchCount;
+
+/**
+ * The maximum image download size, in bytes. Defaults to the loader's
+ * defaultMaxImageSize.
+ */
+@property (nonatomic, assign) UInt64 maxImageSize;
+
+/**
+ * Additional context for each prefetch. Images are cached under keys that depend on
+ * their context, so use the same context, such as SDWebImageContextFUIStorageTargetPixelSize,
+ * that the images will be shown with.
+ */
+@property (nonatomic, copy, nullable) SDWebImageContext *context;
+
+/**
+ * The Storage instance that paths found by prefetchRowsInRange:ofCollection:referenceKeyPath:
+ * are relative to. Defaults to the default app's Storage instance.
+ */
+@property (nonatomic, strong, null_resettable) FIRStorage *storage;
+
+/**
+ * Initializes a prefetcher that downloads images with the given loader.
+ */
+- (instancetype)initWithLoader:(FUIStorageImageLoader *)loader NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Initializes a prefetcher that uses the shared loader.
+ */
+- (instancetype)init;
+
+/**
+ * Prefetches a batch of images. Returns a token that cancels the prefetches of this
+ * batch that haven't finished, or nil if there's nothing to prefetch.
+ */
+- (nullable SDWebImagePrefetchToken *)prefetchReferences:(NSArray<FIRStorageReference *> *)references;
+
+/**
+ * Prefetches a batch of images. The progress block is called as each image finishes,
+ * and the completion block once the whole batch has finished, with the number of
+ * images that couldn't be loaded.
+ */
+- (nullable SDWebImagePrefetchToken *)prefetchReferences:(NSArray<FIRStorageReference *> *)references
+                                                progress:(nullable SDWebImagePrefetcherProgressBlock)progressBlock
+                                               completed:(nullable SDWebImagePrefetcherCompletionBlock)completionBlock;
+
+/**
+ * Prefetches the images of upcoming rows of a collection, such as an FUIArray or an
+ * FUIBatchedArray. See referencesInRange:ofCollection:referenceKeyPath:.
+ */
+- (nullable SDWebImagePrefetchToken *)prefetchRowsInRange:(NSRange)range
+                                             ofCollection:(id)collection
+                                         referenceKeyPath:(NSString *)keyPath;
+
+/**
+ * Returns the references for rows of a collection. The collection must respond to
+ * `count` and `objectAtIndexedSubscript:`, like NSArray, FUIArray and
+ * FUIBatchedArray; the range is clipped to its count. Each row's value for the key
+ * path may be a FIRStorageReference, a `gs://` URL or URL string, or a path relative
+ * to the prefetcher's Storage instance. Rows without such a value are skipped.
+ */
+- (NSArray<FIRStorageReference *> *)referencesInRange:(NSRange)range
+                                         ofCollection:(id)collection
+                                     referenceKeyPath:(NSString *)keyPath;
+
+/**
+ * Cancels every prefetch.
+ */
+- (void)cancelPrefetching;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,91 @@
+//
+//  Copyright (c) 2019 Google Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+
+#import <Foundation/Foundation.h>
+
+#if __has_include(<FirebaseStorage/FirebaseStorage.h>)
+  // Firebase 8.x (CocoaPods)
+  #import <FirebaseStorage/FirebaseStorage.h>
+#elif __has_include(<FirebaseStorage/FirebaseStorage-Swift.h>)
+  // Firebase 9.0+ (CocoaPods)
+  #import <FirebaseStorage/FirebaseStorage-Swift.h>
+#else
+  // Swift Package Manager: forward declarations only.
+  @class FIRStorage;
+  @class FIRStorageReference;
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A bounded, thread-safe cache of the objects needed to go between `gs://` URLs and
+ * Storage references. `NSURL sd_URLWithStorageReference:` and FUIStorageImageLoader use
+ * the shared cache, so binding the same reference to a view again doesn't re-encode
+ * its path, and loading a URL that was restored from a cache key doesn't look up the
+ * Storage instance and reference again.
+ */
+NS_SWIFT_NAME(StorageReferenceCache)
+@interface FUIStorageReferenceCache : NSObject
+
+/**
+ * The cache used by FirebaseStorageUI.
+ */
+@property (nonatomic, class, readonly) FUIStorageReferenceCache *sharedCache;
+
+/**
+ * The maximum number of URLs and references kept in each direction. Like NSCache,
+ * the cache may evict entries before reaching this limit.
+ */
+@property (nonatomic, readonly) NSUInteger countLimit;
+
+/**
+ * Initializes a cache holding up to countLimit URLs and references in each direction.
+ */
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Initializes a cache holding up to 1000 URLs and references in each direction.
+ */
+- (instancetype)init;
+
+/**
+ * Returns the Storage instance for a bucket, creating it with `+[FIRStorage storageWithURL:]`
+ * if it isn't cached.
+ */
+- (FIRStorage *)storageForBucket:(NSString *)bucket;
+
+/**
+ * Returns the reference a `gs://` URL points to, or nil if the URL has no bucket.
+ */
+- (nullable FIRStorageReference *)referenceForURL:(NSURL *)url;
+
+/**
+ * Returns the `gs://` URL of a reference, or nil if the reference has no bucket or
+ * path. Only the URL's encoded string is cached: each call returns a new URL whose
+ * `sd_storageReference` is the given reference, so references to the same path from
+ * different apps or Storage instances keep their own settings.
+ */
+- (nullable NSURL *)URLForReference:(FIRStorageReference *)reference;
+
+/**
+ * Removes every cached URL and reference. Storage instances are kept.
+ */
+- (void)removeAllObjects;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -26,5 +26,9 @@ FOUNDATION_EXPORT const unsigned char FirebaseStorageUIVersionString[];
 #import "UIImageView+FirebaseStorage.h"
 #import "FUIStorageImageLoader.h"
 #import "FUIStorageDefine.h"
+#import "FUIStorageImageDecodePool.h"
 #import "NSURL+FirebaseStorage.h"
+#import "FUIStorageReferenceCache.h"
+#import "FUIStorageImagePrefetcher.h"
+#import "FUIStorageImageLoadMetrics.h"
 #import "FIRStorageDownloadTask+SDWebImage.h"
@@ -55,7 +55,8 @@ NS_ASSUME_NONNULL_BEGIN
 @interface UIImageView (FirebaseStorage)
 
 /**
- * The current download task, if the image view is downloading an image.
+ * The current download task, if the image view is downloading an image. Progressive
+ * loads are streamed without a download task, so this is nil for them.
  */
 @property (nonatomic, readonly, nullable) FIRStorageDownloadTask *sd_currentDownloadTask;
 
@@ -169,6 +170,7 @@ NS_ASSUME_NONNULL_BEGIN
  * @param placeholder     An image to display while the download is in progress.
  * @param options         The options to use when downloading the image. @see SDWebImageOptions for the possible values.
  * @param context         A context contains different options to perform specify changes or processes, see `SDWebImageContextOption`. This hold the extra objects which `options` enum can not hold. For example, you can use [.customManager] to use a custom manager with the desired cache instance for this image request.
+ *   Use `SDWebImageContextFUIStorageTargetPixelSize` to decode a small image, like an avatar, at the size it's displayed at.
  * @param progressBlock   A closure to handle the progress change during the image downloading. The closure args are `receivedSize` `expectedSize` and `storageRef`
  *   The progress block is executed on a background queue.
  * @param completionBlock A closure to handle events when the image finishes downloading.
@@ -16,6 +16,8 @@
 
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/UIImageView+FirebaseStorage.h"
 #import "FirebaseStorageUI/Sources/Public/FirebaseStorageUI/FUIStorageImageLoader.h"
+#import "FirebaseStorageUI/Sources/FUIStorageDefine_Private.h"
+#import "FirebaseStorageUI/Sources/FUIStorageImageLoadOperation.h"
 
 #if __has_include(<FirebaseStorage/FirebaseStorage.h>)
   #import <FirebaseStorage/FirebaseStorage.h>
@@ -122,8 +124,11 @@
   }
   mutableContext[SDWebImageContextImageLoader] = FUIStorageImageLoader.sharedLoader;
   mutableContext[SDWebImageContextFUIStorageMaxImageSize] = @(size);
+  // Translated here rather than in the loader so that SDWebImage caches each target
+  // size under its own key.
+  SDWebImageContext *imageContext = FUIStorageImageContextApplyingTargetPixelSize(mutableContext);
   
-  [self sd_setImageWithURL:url placeholderImage:placeholder options:options context:[mutableContext copy] progress:^(NSInteger receivedSize, NSInteger expectedSize, NSURL * _Nullable targetURL) {
+  [self sd_setImageWithURL:url placeholderImage:placeholder options:options context:[imageContext copy] progress:^(NSInteger receivedSize, NSInteger expectedSize, NSURL * _Nullable targetURL) {
     if (progressBlock) {
       progressBlock(receivedSize, expectedSize, storageRef);
     }
@@ -140,6 +145,14 @@
   SDWebImageCombinedOperation *operation = [self sd_imageLoadOperationForKey:NSStringFromClass(self.class)];
   if (operation) {
     id<SDWebImageOperation> loaderOperation = operation.loaderOperation;
+    // Revalidated loads only have a download once the object turned out to have changed.
+    if ([loaderOperation isKindOfClass:[FUIStorageImageRevalidationOperation class]]) {
+      loaderOperation = ((FUIStorageImageRevalidationOperation *)loaderOperation).loadOperation;
+    }
+    // Downloads may be shared between image views, so the loader hands out tokens.
+    if ([loaderOperation isKindOfClass:[FUIStorageImageLoadToken class]]) {
+      return ((FUIStorageImageLoadToken *)loaderOperation).downloadTask;
+    }
     // This is a protocol, check the class
     if ([loaderOperation isKindOfClass:[FIRStorageDownloadTask class]]) {
       return (FIRStorageDownloadTask *)loaderOperation;
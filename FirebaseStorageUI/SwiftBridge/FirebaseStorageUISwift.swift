@@ -9,6 +9,7 @@ extension UIImageView {
   public func sd_setImageWithStorageReference(
     _ storageRef: StorageReference,
     maxImageSize size: UInt64? = nil,
+    targetPixelSize: CGSize? = nil,
     placeholderImage placeholder: UIImage? = nil,
     options: SDWebImageOptions = [],
     context: [SDWebImageContextOption: Any]? = nil,
@@ -17,6 +18,7 @@ extension UIImageView {
     sd_setImageWithStorageReference(
       storageRef,
       maxImageSize: size,
+      targetPixelSize: targetPixelSize,
       placeholderImage: placeholder,
       options: options,
       context: context,
@@ -28,6 +30,7 @@ extension UIImageView {
   public func sd_setImageWithStorageReference(
     _ storageRef: StorageReference,
     maxImageSize size: UInt64? = nil,
+    targetPixelSize: CGSize? = nil,
     placeholderImage placeholder: UIImage? = nil,
     options: SDWebImageOptions = [],
     context: [SDWebImageContextOption: Any]? = nil,
@@ -39,6 +42,15 @@ extension UIImageView {
     var ctx = context ?? [:]
     ctx[.imageLoader] = StorageImageLoader.shared
     ctx[.fuiStorageMaxImageSize] = size ?? StorageImageLoader.shared.defaultMaxImageSize
+    // Decode straight to the displayed size. SDWebImage includes the thumbnail size
+    // in the cache key, so each size is cached separately.
+    let targetSize = targetPixelSize ?? (ctx[.fuiStorageTargetPixelSize] as? NSValue)?.cgSizeValue
+    if let targetSize, ctx[.imageThumbnailPixelSize] == nil {
+      ctx[.imageThumbnailPixelSize] = NSValue(cgSize: targetSize)
+      if ctx[.imagePreserveAspectRatio] == nil {
+        ctx[.imagePreserveAspectRatio] = true
+      }
+    }
 
     let sdProgress: SDImageLoaderProgressBlock? = progressBlock.map { block in
       { received, expected, _ in block(Int(received), Int(expected), storageRef) }